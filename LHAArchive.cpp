@@ -0,0 +1,799 @@
+// LHAArchive.cpp: implementation of the LHAArchive class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef LHAPACK_STANDALONE
+#include "stdafx.h"
+#endif
+#include "LHAArchive.h"
+#include "LHADecode.h"
+#include "LHAListing.h"
+#include "LHAThreadPool.h"
+#include "LHAStats.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#define make_dir(path)  _mkdir(path)
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#define make_dir(path)  mkdir(path, 0777)
+#endif
+
+#define LHA_PATHSEP     0xff    /* path separator of the filename in lha header */
+
+#define SIG_METHOD      2       /* I_METHOD: where every header level has its method */
+#define SIG_LEVEL       20      /* I_HEADER_LEVEL */
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SCAN_HAVE_SIMD
+#define SSE2_TARGET     __attribute__((target("sse2")))
+#define AVX2_TARGET     __attribute__((target("avx2")))
+#define lowest_bit(m)   __builtin_ctz(m)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define SCAN_HAVE_SIMD
+#define SSE2_TARGET
+#define AVX2_TARGET
+static inline int lowest_bit(unsigned int m)
+{
+    unsigned long i;
+    _BitScanForward(&i, m);
+    return (int)i;
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+LHAArchive::LHAArchive()
+{
+	base    = NULL;
+	length  = 0;
+	opened  = false;
+	strict  = false;
+	members = NULL;
+}
+
+LHAArchive::~LHAArchive()
+{
+	close();
+}
+
+/*
+ * Map the whole archive read-only.  Members are parsed straight out of
+ * the mapping, so listing a multi-GB archive only touches its headers.
+ */
+bool LHAArchive::open(const char *path)
+{
+	close();
+
+	if (!map.open(path, LHAFileMap::ACCESS_SEQUENTIAL))
+		return false;
+
+	base   = map.data();
+	length = map.size();
+	opened = true;
+	return true;
+}
+
+void LHAArchive::close()
+{
+	map.close();
+	base   = NULL;
+	length = 0;
+	opened = false;
+	delete members;
+	members = NULL;
+}
+
+/*
+ * Parse the header at `offset'.  Fails at the end mark, on a bad or
+ * truncated header (in strict mode, also one failing its checksum or
+ * header CRC) and when the packed data would run past the end of the
+ * file.
+ */
+bool LHAArchive::read_entry(size_t offset, LHAEntry *entry, LHAHeader *hdr) const
+{
+	return read_entry(offset, entry, hdr, strict ? LHA_PARSE_STRICT : 0);
+}
+
+bool LHAArchive::read_entry(size_t offset, LHAEntry *entry, LHAHeader *hdr, int flags) const
+{
+	size_t dataoffset;
+
+	if (base == NULL || offset >= length)
+		return false;
+
+	if (!LHAPack::parse_header(base + offset, base + length, hdr, &dataoffset, flags))
+		return false;
+
+	if (dataoffset > length - offset ||
+	    hdr->packed_size > length - offset - dataoffset)
+		return false;
+
+	entry->header     = hdr;
+	entry->offset     = offset;
+	entry->dataoffset = dataoffset;
+	entry->data       = base + offset + dataoffset;
+	return true;
+}
+
+LHAArchive::iterator LHAArchive::begin()
+{
+	return iterator(this, 0);
+}
+
+LHAArchive::iterator LHAArchive::end()
+{
+	return iterator();
+}
+
+/*
+ * The member whose header starts at `offset', e.g. from an LHAIndex;
+ * end() if there is no valid header there.  Iterating on from it walks
+ * the rest of the archive.
+ */
+LHAArchive::iterator LHAArchive::at(size_t offset)
+{
+	return iterator(this, offset);
+}
+
+/*
+ * The member named `name' (as spelled in its header; the first, if there
+ * are several) or the index'th member, end() if there is none.  The first
+ * call lists the archive once; from then on only the one header is
+ * parsed, so a lookup costs the same whatever the size of the archive.
+ * Pass the entry to extract() for its contents.
+ */
+LHAArchive::iterator LHAArchive::open_member(const char *name)
+{
+	const LHAListEntry *e;
+
+	if (name == NULL || !opened)
+		return end();
+
+	e = listing().find(name);
+	return e ? at((size_t)e->offset) : end();
+}
+
+LHAArchive::iterator LHAArchive::open_member(size_t index)
+{
+	if (!opened || index >= listing().size())
+		return end();
+
+	return at((size_t)(*members)[index].offset);
+}
+
+const LHAListing &LHAArchive::listing()
+{
+	if (members == NULL) {
+		members = new LHAListing;
+		members->read(*this);
+	}
+	return *members;
+}
+
+/*
+ * Decode one member into buf (entry.header->original_size bytes) and
+ * check its CRC.
+ */
+bool LHAArchive::extract(const LHAEntry &entry, char *buf)
+{
+	LHADecoderContext decoder;
+
+	if (!decoder->decode(entry.header, entry.data, buf))
+		return false;
+
+	if (entry.header->has_crc && decoder->crc != entry.header->crc) {
+		LHA_STAT_CRC_FAILURE();
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Decode one member a piece at a time into proc, holding no more than the
+ * decoder's window however large the member is.  A stored member is
+ * handed over in one piece straight from the mapping.  False if proc
+ * aborts, or the data is corrupt, or the CRC is wrong; what proc has been
+ * handed by then is to be thrown away.
+ */
+bool LHAArchive::extract(const LHAEntry &entry, LHAOutputProc proc, void *param)
+{
+	const LHAHeader *hdr = entry.header;
+	int             method = LHADecoder::method_number(hdr->method);
+	uint64_t        done = 0;
+	size_t          used;
+
+	LHADecoderContext decoder;
+
+	if (decoder->pass_through(method, entry.data, hdr->packed_size, hdr->original_size)) {
+		if (hdr->original_size && !proc(param, entry.data, hdr->original_size))
+			return false;
+	}
+	else {
+		if (!decoder->begin_stream(method, hdr->packed_size, hdr->original_size, proc, param))
+			return false;
+		while (done < hdr->packed_size) {
+			if (!decoder->stream(entry.data + done, (size_t)(hdr->packed_size - done), &used) || used == 0)
+				return false;
+			done += used;
+		}
+		if (!decoder->end_stream())
+			return false;
+	}
+
+	if (hdr->has_crc && decoder->crc != hdr->crc) {
+		LHA_STAT_CRC_FAILURE();
+		return false;
+	}
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Parallel extraction
+//////////////////////////////////////////////////////////////////////
+
+struct ExtractWorker {
+    std::vector<char>   buf;
+};
+
+/* where a member is and how big; the tasks parse its header again */
+struct MemberRef {
+    size_t      offset;
+    uint64_t    original_size;
+};
+
+struct ExtractJob {
+    const LHAArchive            *archive;
+    std::vector<MemberRef>      members;
+    std::vector<ExtractWorker>  workers;
+    LHAExtractProc              proc;
+    void                        *param;
+    std::atomic<int>            failures;
+};
+
+static bool larger_member(const MemberRef &a, const MemberRef &b)
+{
+    return a.original_size > b.original_size;
+}
+
+static bool append_output(void *param, const void *buf, size_t len)
+{
+    std::vector<char> *out = (std::vector<char> *)param;
+
+    out->insert(out->end(), (const char *)buf, (const char *)buf + len);
+    return true;
+}
+
+/*
+ * Decode a member into w.buf.  Every method is streamed and the buffer
+ * grows with what the decoder actually produces, so that a header
+ * claiming gigabytes for a few bytes of data gets nothing allocated; the
+ * buffer keeps its capacity from one member to the next.
+ */
+static bool decode_member(LHADecoder &decoder, const LHAEntry &entry, ExtractWorker &w)
+{
+    const LHAHeader *hdr    = entry.header;
+    int             method  = LHADecoder::method_number(hdr->method);
+    uint64_t        done    = 0;
+    size_t          used;
+
+    w.buf.clear();
+    if (!decoder.begin_stream(method, hdr->packed_size, hdr->original_size, append_output, &w.buf))
+        return false;
+    while (done < hdr->packed_size) {
+        if (!decoder.stream(entry.data + done, (size_t)(hdr->packed_size - done), &used) || used == 0)
+            return false;
+        done += used;
+    }
+    if (!decoder.end_stream())
+        return false;
+    w.buf.push_back(0);         /* never empty */
+    return true;
+}
+
+void LHAArchive::extract_task(void *param, size_t task, int worker)
+{
+    ExtractJob    *job = (ExtractJob *)param;
+    ExtractWorker &w   = job->workers[worker];
+    LHAEntry      entry;
+    LHAHeader     hdr;
+    const char    *buf = NULL;
+    bool          ok   = true;
+
+    /* the scan in extract_all() parsed this header already, with the same flags */
+    if (!job->archive->read_entry(job->members[task].offset, &entry, &hdr)) {
+        job->failures++;
+        return;
+    }
+
+    int method = LHADecoder::method_number(hdr.method);
+
+    if (method != LZHDIRS_METHOD_NUM) {
+        LHADecoderContext decoder;
+
+        /* a stored member goes to proc straight from the mapping */
+        if (decoder->pass_through(method, entry.data, hdr.packed_size, hdr.original_size)) {
+            buf = entry.data;
+        }
+        else {
+            ok  = decode_member(*decoder, entry, w);
+            buf = w.buf.empty() ? NULL : &w.buf[0];
+        }
+        if (ok && hdr.has_crc && decoder->crc != hdr.crc) {
+            LHA_STAT_CRC_FAILURE();
+            ok = false;
+        }
+        if (!ok)
+            buf = NULL;     /* a streamed member may have stopped short */
+    }
+
+    if (job->proc) {
+        LHA_STAT_SCOPE(LHA_STAT_OUTPUT);
+        LHA_STAT_BYTES(buf ? hdr.original_size : 0);
+        if (!job->proc(job->param, &entry, buf, ok))
+            ok = false;
+    }
+    if (!ok)
+        job->failures++;
+}
+
+/*
+ * Decode and CRC-check every member on `threads' workers (0: one per
+ * CPU) and hand each one to proc.  One scan collects where the members
+ * are, and each task parses its own header again, so that nothing the
+ * size of a header is kept per member; members are scheduled largest
+ * first.  Returns the number of members that failed.
+ */
+int LHAArchive::extract_all(LHAExtractProc proc, void *param, int threads)
+{
+	ExtractJob job;
+	MemberRef  m;
+	size_t     i;
+
+	for (iterator it = begin(); it != end(); ++it) {
+		m.offset        = it->offset;
+		m.original_size = it->header->original_size;
+		job.members.push_back(m);
+	}
+	std::stable_sort(job.members.begin(), job.members.end(), larger_member);
+
+	LHAThreadPool pool(threads);
+	ExtractWorker idle = { std::vector<char>() };
+	std::vector<size_t> order(job.members.size());
+
+	for (i = 0; i < order.size(); i++)
+		order[i] = i;
+	job.archive  = this;
+	job.workers.assign(pool.threads(), idle);
+	job.proc     = proc;
+	job.param    = param;
+	job.failures = 0;
+
+	pool.run(extract_task, &job, order.empty() ? NULL : &order[0], order.size());
+
+	LHAStats::report();
+	return job.failures;
+}
+
+/*
+ * Member name -> path below dir.  Separators may be '/', '\\' or 0xff;
+ * absolute paths and ".." components are refused.
+ */
+bool LHAArchive::output_path(const char *dir, const char *name, std::string *path)
+{
+    std::string part;
+    const unsigned char *p = (const unsigned char *)name;
+
+    *path = dir;
+    for (;; p++) {
+        if (*p == '/' || *p == '\\' || *p == LHA_PATHSEP || *p == '\0') {
+            if (part == "..")
+                return false;
+            if (!part.empty() && part != ".") {
+                *path += '/';
+                *path += part;
+            }
+            part.clear();
+            if (*p == '\0')
+                break;
+        }
+        else if (*p == ':')
+            return false;       /* drive letter */
+        else
+            part += (char)*p;
+    }
+    return path->size() > strlen(dir);
+}
+
+void LHAArchive::make_dirs(const std::string &path)
+{
+    for (size_t i = 1; i < path.size(); i++)
+        if (path[i] == '/')
+            make_dir(path.substr(0, i).c_str());
+    make_dir(path.c_str());
+}
+
+static bool write_member(void *param, const LHAEntry *entry, const char *buf, bool ok)
+{
+    std::string path;
+    FILE        *fp;
+
+    if (!ok || !LHAArchive::output_path((const char *)param, entry->header->name, &path))
+        return false;
+
+    if (buf == NULL) {
+        LHAArchive::make_dirs(path);        /* -lhd- */
+        return true;
+    }
+
+    LHAArchive::make_dirs(path.substr(0, path.rfind('/')));
+    fp = fopen(path.c_str(), "wb");
+    if (fp == NULL)
+        return false;
+    ok = fwrite(buf, 1, entry->header->original_size, fp) == entry->header->original_size;
+    return fclose(fp) == 0 && ok;
+}
+
+/* Extract every member into files below dir. */
+int LHAArchive::extract_all(const char *dir, int threads)
+{
+	make_dirs(dir);
+	return extract_all(write_member, (void *)dir, threads);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Recovery
+//////////////////////////////////////////////////////////////////////
+
+/*
+ * Signature scan.  A method name, "-lh?-" or "-lz?-", starts every header
+ * at SIG_METHOD; the scan stops at the first p with '-', 'l' and '-' at
+ * p[0], p[1] and p[4], or returns end if there is none before end - 4.
+ * The vector kernels test 16 or 32 positions per step, so that damaged
+ * stretches go by at memory speed; candidates are rare enough in packed
+ * data that checking them costs next to nothing.
+ */
+typedef const char *(*ScanProc)(const char *p, const char *end);
+
+static const char *scan_generic(const char *p, const char *end)
+{
+    for (; end - p > 4; p++)
+        if (p[0] == '-' && p[1] == 'l' && p[4] == '-')
+            return p;
+    return end;
+}
+
+#ifdef SCAN_HAVE_SIMD
+SSE2_TARGET
+static const char *scan_sse2(const char *p, const char *end)
+{
+    const __m128i dash = _mm_set1_epi8('-');
+    const __m128i ell  = _mm_set1_epi8('l');
+
+    for (; end - p >= 16 + 4; p += 16) {
+        __m128i hit = _mm_and_si128(
+            _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), dash),
+                          _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + 1)), ell)),
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + 4)), dash));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(hit);
+        if (mask)
+            return p + lowest_bit(mask);
+    }
+    return scan_generic(p, end);
+}
+
+AVX2_TARGET
+static const char *scan_avx2(const char *p, const char *end)
+{
+    const __m256i dash = _mm256_set1_epi8('-');
+    const __m256i ell  = _mm256_set1_epi8('l');
+
+    for (; end - p >= 32 + 4; p += 32) {
+        __m256i hit = _mm256_and_si256(
+            _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)p), dash),
+                             _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + 1)), ell)),
+            _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + 4)), dash));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(hit);
+        if (mask)
+            return p + lowest_bit(mask);
+    }
+    return scan_sse2(p, end);
+}
+#endif /* SCAN_HAVE_SIMD */
+
+/* by LHADecoder::Kernel */
+static const ScanProc scan_procs[] = {
+    scan_generic,
+#ifdef SCAN_HAVE_SIMD
+    scan_sse2,
+    scan_avx2,
+#else
+    scan_generic,
+    scan_generic,
+#endif
+};
+
+/*
+ * Offset of the first place in [from, to) where data[0, length) could
+ * hold a header: a method signature, and a level byte of 0 to 3.  `to' if
+ * there is none.  Nothing else is checked.  Candidates come from the
+ * signature scan of `kernel' (an unsupported one falls back to the
+ * generic scan); all kernels find the same ones.
+ */
+size_t LHAArchive::find_candidate(const char *data, size_t length, size_t from, size_t to,
+                                  LHADecoder::Kernel kernel)
+{
+	const char *stop, *p;
+
+	if (!LHADecoder::kernel_supported(kernel))
+		kernel = LHADecoder::KERNEL_GENERIC;
+	ScanProc scan = scan_procs[kernel];
+
+	if (to > length)
+		to = length;
+	if (data == NULL || from >= to || length - from < SIG_LEVEL + 1)
+		return to;
+
+	/* the scan stops short of `stop' - 4, i.e. of a header at `to' */
+	stop = data + (length - to < SIG_METHOD + 4 ? length : to + SIG_METHOD + 4);
+	for (p = data + from + SIG_METHOD; ; p++) {
+		p = scan(p, stop);
+		if (p == stop || data + length - p <= SIG_LEVEL - SIG_METHOD)
+			return to;          /* none, or too near the end for a header */
+		if ((unsigned char)p[SIG_LEVEL - SIG_METHOD] <= 3)
+			return (size_t)(p - SIG_METHOD - data);
+	}
+}
+
+/*
+ * Offset of the first header at or after `offset' in data[0, length) that
+ * passes a strict parse (level 0/1 checksum, level 2/3 header CRC) and
+ * whose packed data lies inside; length if there is none.
+ */
+size_t LHAArchive::find_header(const char *data, size_t length, size_t offset, LHADecoder::Kernel kernel)
+{
+	LHAHeader hdr;
+	size_t    at, dataoffset;
+
+	for (at = offset; (at = find_candidate(data, length, at, length, kernel)) < length; at++) {
+		if (LHADecoder::method_number(data + at + SIG_METHOD) == UNKNOWN_METHOD_NUM)
+			continue;
+		if (LHAPack::parse_header(data + at, data + length, &hdr, &dataoffset, LHA_PARSE_STRICT | LHA_PARSE_LAZY) &&
+		    dataoffset <= length - at && hdr.packed_size <= length - at - dataoffset)
+			return at;
+	}
+	return length;
+}
+
+/*
+ * The first member at or after `offset' with a sound header, skipping
+ * any damage before it; end() if there is none.  Iteration goes on from
+ * there as usual, so a walk that a bad header at `bad' has stopped is
+ * picked up again with
+ *
+ *     it = archive.recover(bad + 1);
+ */
+LHAArchive::iterator LHAArchive::recover(size_t offset)
+{
+	if (!opened)
+		return end();
+	return at(find_header(base, length, offset));
+}
+
+//////////////////////////////////////////////////////////////////////
+// Testing
+//////////////////////////////////////////////////////////////////////
+
+struct TestJob {
+    const LHAArchive            *archive;
+    std::vector<MemberRef>      members;
+    LHATestProc                 proc;
+    void                        *param;
+    std::atomic<int>            failures;
+};
+
+static bool discard_output(void *param, const void *buf, size_t len)
+{
+    (void)param;
+    (void)buf;
+    (void)len;
+    return true;
+}
+
+/*
+ * Decode one member for its CRC alone.  Stored members are checked where
+ * they lie; the rest go through the decoder's window and are handed to
+ * discard_output() a window at a time, so that memory use does not
+ * depend on what the header says.
+ */
+static int test_member(const LHAEntry &entry)
+{
+    const LHAHeader   *hdr    = entry.header;
+    int               method  = LHADecoder::method_number(hdr->method);
+    uint64_t          done    = 0;
+    size_t            used;
+    LHADecoderContext decoder;
+
+    if (method == UNKNOWN_METHOD_NUM)
+        return LHA_TEST_METHOD;
+
+    if (decoder->pass_through(method, entry.data, hdr->packed_size, hdr->original_size)) {
+        /* checked in place */
+    }
+    else {
+        if (!decoder->begin_stream(method, hdr->packed_size, hdr->original_size, discard_output, NULL))
+            return LHA_TEST_CORRUPT;
+        while (done < hdr->packed_size) {
+            if (!decoder->stream(entry.data + done, (size_t)(hdr->packed_size - done), &used) || used == 0)
+                return LHA_TEST_CORRUPT;
+            done += used;
+        }
+        if (!decoder->end_stream())
+            return LHA_TEST_CORRUPT;
+    }
+
+    if (hdr->has_crc && decoder->crc != hdr->crc) {
+        LHA_STAT_CRC_FAILURE();
+        return LHA_TEST_CRC;
+    }
+    return LHA_TEST_OK;
+}
+
+void LHAArchive::test_task(void *param, size_t task, int worker)
+{
+    TestJob   *job = (TestJob *)param;
+    LHAEntry  entry;
+    LHAHeader hdr;
+    int       result;
+
+    (void)worker;
+
+    /* parsed again in full: the walk that found it kept only the offset */
+    if (!job->archive->read_entry(job->members[task].offset, &entry, &hdr, 0)) {
+        entry.header     = NULL;
+        entry.offset     = job->members[task].offset;
+        entry.dataoffset = 0;
+        entry.data       = NULL;
+        result = LHA_TEST_HEADER;
+    }
+    else
+        result = test_member(entry);
+
+    if (result != LHA_TEST_OK)
+        job->failures++;
+    if (job->proc)
+        job->proc(job->param, &entry, result);
+}
+
+/*
+ * Check every member without writing anything: each header's checksum
+ * or header CRC (level 2 and 3), then the CRC-16 of the decoded data,
+ * on `threads' workers (0: one per CPU), largest member first.  The
+ * output is thrown away as it is decoded, so memory use does not grow
+ * with the members.  proc, if given, hears about every member.  Returns
+ * the number of members that failed, each stretch of damage between
+ * members counting as one.
+ */
+int LHAArchive::test_all(LHATestProc proc, void *param, int threads)
+{
+	TestJob             job;
+	LHAEntry            entry;
+	LHAHeader           hdr;
+	size_t              offset = 0, next, i;
+	MemberRef           m;
+	std::vector<size_t> damage;
+
+	/*
+	 * Collect the offsets; the headers are parsed again by the tasks.
+	 * The walk checks each header, so that a damaged one cannot send it
+	 * past the members after it on a size that is not there.  Where it
+	 * runs into anything but the end mark (a 0 with no sound header
+	 * after it), the damage is noted and the walk goes on from the next
+	 * sound header.
+	 */
+	for (;;) {
+		while (read_entry(offset, &entry, &hdr, LHA_PARSE_STRICT | LHA_PARSE_LAZY)) {
+			m.offset        = offset;
+			m.original_size = hdr.original_size;
+			job.members.push_back(m);
+			offset += entry.dataoffset + (size_t)hdr.packed_size;
+		}
+		if (!opened || offset >= length)
+			break;
+		next = find_header(base, length, offset + 1);
+		if (base[offset] == 0 && next == length)
+			break;              /* the end mark */
+		damage.push_back(offset);
+		offset = next;
+	}
+	std::stable_sort(job.members.begin(), job.members.end(), larger_member);
+
+	LHAThreadPool pool(threads);
+	std::vector<size_t> order(job.members.size());
+
+	for (i = 0; i < order.size(); i++)
+		order[i] = i;
+	job.archive  = this;
+	job.proc     = proc;
+	job.param    = param;
+	job.failures = 0;
+
+	pool.run(test_task, &job, order.empty() ? NULL : &order[0], order.size());
+
+	for (i = 0; i < damage.size(); i++) {
+		entry.header     = NULL;
+		entry.offset     = damage[i];
+		entry.dataoffset = 0;
+		entry.data       = NULL;
+		job.failures++;
+		if (proc)
+			proc(param, &entry, LHA_TEST_HEADER);
+	}
+
+	LHAStats::report();
+	return job.failures;
+}
+
+//////////////////////////////////////////////////////////////////////
+// LHAArchive::iterator
+//////////////////////////////////////////////////////////////////////
+
+LHAArchive::iterator::iterator()
+{
+	archive          = NULL;
+	entry.header     = NULL;
+	entry.offset     = 0;
+	entry.dataoffset = 0;
+	entry.data       = NULL;
+}
+
+LHAArchive::iterator::iterator(LHAArchive *archive, size_t offset)
+{
+	this->archive = archive;
+	read(offset);
+}
+
+LHAArchive::iterator::iterator(const iterator &it)
+{
+	*this = it;
+}
+
+LHAArchive::iterator &LHAArchive::iterator::operator=(const iterator &it)
+{
+	archive      = it.archive;
+	entry        = it.entry;
+	header       = it.header;
+	entry.header = &header;
+	return *this;
+}
+
+void LHAArchive::iterator::read(size_t offset)
+{
+	if (!archive->read_entry(offset, &entry, &header))
+		archive = NULL;
+}
+
+LHAArchive::iterator &LHAArchive::iterator::operator++()
+{
+	if (archive)
+		read(entry.offset + entry.dataoffset + header.packed_size);
+	return *this;
+}
+
+bool LHAArchive::iterator::operator==(const iterator &it) const
+{
+	if (archive == NULL || it.archive == NULL)
+		return archive == it.archive;
+	return archive == it.archive && entry.offset == it.entry.offset;
+}
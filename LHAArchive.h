@@ -0,0 +1,138 @@
+// LHAArchive.h: interface for the LHAArchive class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#if !defined(AFX_LHAARCHIVE_H__B50E0752_CF6C_4421_8DEA_0503FEDB4D4C__INCLUDED_)
+#define AFX_LHAARCHIVE_H__B50E0752_CF6C_4421_8DEA_0503FEDB4D4C__INCLUDED_
+
+#if _MSC_VER > 1000
+#pragma once
+#endif // _MSC_VER > 1000
+
+#include <stddef.h>
+#include <iterator>
+#include <string>
+
+#include "LHAPack.h"
+#include "LHADecode.h"
+
+class LHAListing;
+
+/*
+ * One member of a mapped archive.  `data' points at the packed bytes
+ * inside the mapping (header->packed_size of them); nothing is copied.
+ * `header' stays valid until the iterator that produced it moves on.
+ */
+typedef struct LHAEntry {
+    const LHAHeader *header;
+    size_t          offset;         /* of the header, from the archive start */
+    size_t          dataoffset;     /* of the packed data, from the header */
+    const char      *data;
+} LHAEntry;
+
+/*
+ * Receives each member from extract_all(), on a worker thread.  buf holds
+ * header->original_size bytes (NULL for a directory); ok is false, and
+ * buf NULL, if the member could not be decoded or failed its CRC.  Return
+ * false if the member could not be stored.
+ */
+typedef bool (*LHAExtractProc)(void *param, const LHAEntry *entry, const char *buf, bool ok);
+
+/* what test_all() found */
+#define LHA_TEST_OK             0
+#define LHA_TEST_HEADER         1   /* bad header, checksum or header CRC */
+#define LHA_TEST_METHOD         2   /* unknown method */
+#define LHA_TEST_CORRUPT        3   /* the packed data does not decode */
+#define LHA_TEST_CRC            4   /* decodes, but to the wrong CRC */
+
+/*
+ * Receives each member from test_all(), on a worker thread, with one of
+ * the LHA_TEST_* results.  For LHA_TEST_HEADER entry->header is NULL and
+ * entry->offset is where the bad header starts.  A header that cannot be
+ * read at all is reported once, and the walk resumes at the next sound
+ * header (see recover()).
+ */
+typedef void (*LHATestProc)(void *param, const LHAEntry *entry, int result);
+
+class LHAArchive
+{
+public:
+	class iterator
+	{
+	public:
+		typedef std::forward_iterator_tag  iterator_category;
+		typedef LHAEntry                   value_type;
+		typedef ptrdiff_t                  difference_type;
+		typedef const LHAEntry *           pointer;
+		typedef const LHAEntry &           reference;
+
+		iterator();
+		iterator(const iterator &it);
+		iterator &operator=(const iterator &it);
+
+		reference operator*() const  { return entry; }
+		pointer   operator->() const { return &entry; }
+		iterator &operator++();
+		iterator  operator++(int)    { iterator it(*this); ++*this; return it; }
+
+		bool operator==(const iterator &it) const;
+		bool operator!=(const iterator &it) const { return !(*this == it); }
+	private:
+		friend class LHAArchive;
+		iterator(LHAArchive *archive, size_t offset);
+		void read(size_t offset);
+
+		LHAArchive *archive;        /* NULL at the end */
+		LHAEntry    entry;
+		LHAHeader   header;
+	};
+
+	bool open(const char *path);
+	void close();
+	bool is_open() const      { return opened; }
+	const char *data() const  { return base; }
+	size_t size() const       { return length; }
+	int64_t modified() const  { return map.modified(); }
+	void set_strict(bool strict) { this->strict = strict; }  /* verify header checksums */
+
+	iterator begin();
+	iterator end();
+	iterator at(size_t offset);
+	iterator open_member(const char *name);
+	iterator open_member(size_t index);
+	iterator recover(size_t offset);
+	static size_t find_header(const char *data, size_t length, size_t offset,
+	                          LHADecoder::Kernel kernel = LHADecoder::best_kernel());
+	static size_t find_candidate(const char *data, size_t length, size_t from, size_t to,
+	                             LHADecoder::Kernel kernel = LHADecoder::best_kernel());
+
+	bool extract(const LHAEntry &entry, char *buf);
+	bool extract(const LHAEntry &entry, LHAOutputProc proc, void *param);
+	int  extract_all(LHAExtractProc proc, void *param, int threads = 0);
+	int  extract_all(const char *dir, int threads = 0);
+	int  test_all(LHATestProc proc = NULL, void *param = NULL, int threads = 0);
+
+	static bool output_path(const char *dir, const char *name, std::string *path);
+	static void make_dirs(const std::string &path);
+
+	LHAArchive();
+	virtual ~LHAArchive();
+private:
+	bool read_entry(size_t offset, LHAEntry *entry, LHAHeader *hdr) const;
+	bool read_entry(size_t offset, LHAEntry *entry, LHAHeader *hdr, int flags) const;
+	const LHAListing &listing();
+	static void extract_task(void *param, size_t task, int worker);
+	static void test_task(void *param, size_t task, int worker);
+
+	const char  *base;
+	size_t      length;
+	bool        opened;
+	bool        strict;
+	LHAFileMap  map;
+	LHAListing  *members;       /* read on the first open_member() */
+
+	LHAArchive(const LHAArchive &);
+	LHAArchive &operator=(const LHAArchive &);
+};
+
+#endif // !defined(AFX_LHAARCHIVE_H__B50E0752_CF6C_4421_8DEA_0503FEDB4D4C__INCLUDED_)
@@ -0,0 +1,190 @@
+// LHAColumns.cpp: implementation of the LHAColumns class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef LHAPACK_STANDALONE
+#include "stdafx.h"
+#endif
+#include "LHAColumns.h"
+#include "LHAArchive.h"
+#include "LHADecode.h"
+#include "LHAThreadPool.h"
+
+#include <string.h>
+
+struct ScanJob {
+    const char *const       *paths;
+    std::vector<LHAColumns> parts;  /* one per archive */
+    std::vector<char>       opened;
+};
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+LHAColumns::LHAColumns()
+{
+	narchives = 0;
+}
+
+LHAColumns::~LHAColumns()
+{
+}
+
+void LHAColumns::clear()
+{
+	packed.clear();
+	original.clear();
+	methods.clear();
+	crcs.clear();
+	mtimes.clear();
+	archive_ids.clear();
+	name_offsets.clear();
+	names.clear();
+	narchives = 0;
+}
+
+/* room for `members' more members with `name_bytes' of names between them */
+void LHAColumns::reserve(size_t members, size_t name_bytes)
+{
+	members += size();
+	packed.reserve(members);
+	original.reserve(members);
+	methods.reserve(members);
+	crcs.reserve(members);
+	mtimes.reserve(members);
+	archive_ids.reserve(members);
+	name_offsets.reserve(members);
+	names.reserve(names.size() + name_bytes);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Scanning
+//////////////////////////////////////////////////////////////////////
+
+/*
+ * Append the members of the archive at path.  False if it cannot be
+ * opened; a bad header ends its listing, as with LHAArchive::iterator.
+ * Either way the archive takes the next archive() number.
+ */
+bool LHAColumns::add(const char *path)
+{
+	LHAFileMap map;
+	uint32_t   id = (uint32_t)narchives++;
+
+	if (!map.open(path, LHAFileMap::ACCESS_RANDOM))
+		return false;
+
+	scan(map.data(), map.size(), id);
+	return true;
+}
+
+bool LHAColumns::add(LHAArchive &archive)
+{
+	uint32_t id = (uint32_t)narchives++;
+
+	if (!archive.is_open())
+		return false;
+
+	scan(archive.data(), archive.size(), id);
+	return true;
+}
+
+/*
+ * Add count archives on `threads' workers (0: one per CPU).  Each is
+ * scanned into columns of its own; these are appended in the order
+ * given, so the result is the same as add() on each in turn.  Returns
+ * the number that could not be opened.
+ */
+int LHAColumns::add_all(const char *const *paths, size_t count, int threads)
+{
+	std::vector<size_t> tasks;
+	ScanJob             job;
+	size_t              i;
+	int                 failures = 0;
+
+	if (count == 0)
+		return 0;
+
+	job.paths = paths;
+	job.parts = std::vector<LHAColumns>(count);
+	job.opened.assign(count, 0);
+	for (i = 0; i < count; i++)
+		tasks.push_back(i);
+
+	LHAThreadPool pool(threads);
+	pool.run(scan_task, &job, &tasks[0], count);
+
+	size_t members = 0, name_bytes = 0;
+	for (i = 0; i < count; i++) {
+		members    += job.parts[i].size();
+		name_bytes += job.parts[i].names.size();
+	}
+	reserve(members, name_bytes);
+
+	for (i = 0; i < count; i++) {
+		append(job.parts[i], (uint32_t)narchives++);
+		if (!job.opened[i])
+			failures++;
+	}
+	return failures;
+}
+
+void LHAColumns::scan_task(void *param, size_t task, int worker)
+{
+	ScanJob *job = (ScanJob *)param;
+
+	(void)worker;
+	job->opened[task] = job->parts[task].add(job->paths[task]) ? 1 : 0;
+}
+
+/*
+ * Walk the headers from the start of the mapping, jumping over the packed
+ * data of each member.  One LHAHeader is reused for all of them, parsed
+ * lazily: none of the columns come from the extended header records it
+ * skips.
+ */
+void LHAColumns::scan(const char *base, size_t length, uint32_t id)
+{
+	LHAHeader hdr;
+	size_t    offset = 0, dataoffset, len;
+
+	while (offset < length) {
+		if (!LHAPack::parse_header(base + offset, base + length, &hdr, &dataoffset, LHA_PARSE_LAZY))
+			break;
+		if (dataoffset > length - offset ||
+		    hdr.packed_size > length - offset - dataoffset)
+			break;
+
+		len = strlen(hdr.name);
+		packed.push_back(hdr.packed_size);
+		original.push_back(hdr.original_size);
+		methods.push_back((signed char)LHADecoder::method_number(hdr.method));
+		crcs.push_back((uint16_t)hdr.crc);
+		mtimes.push_back(hdr.unix_last_modified_stamp);
+		archive_ids.push_back(id);
+		name_offsets.push_back(names.size());
+		names.insert(names.end(), hdr.name, hdr.name + len + 1);
+
+		offset += dataoffset + hdr.packed_size;
+	}
+}
+
+/* the members of part, as archive `id', with their names rebased */
+void LHAColumns::append(const LHAColumns &part, uint32_t id)
+{
+	uint64_t base = names.size();
+	size_t   first = size(), i;
+
+	packed.insert(packed.end(), part.packed.begin(), part.packed.end());
+	original.insert(original.end(), part.original.begin(), part.original.end());
+	methods.insert(methods.end(), part.methods.begin(), part.methods.end());
+	crcs.insert(crcs.end(), part.crcs.begin(), part.crcs.end());
+	mtimes.insert(mtimes.end(), part.mtimes.begin(), part.mtimes.end());
+	archive_ids.insert(archive_ids.end(), part.size(), id);
+	name_offsets.insert(name_offsets.end(), part.name_offsets.begin(), part.name_offsets.end());
+	names.insert(names.end(), part.names.begin(), part.names.end());
+
+	for (i = first; i < size(); i++)
+		name_offsets[i] += base;
+}
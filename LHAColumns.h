@@ -0,0 +1,79 @@
+// LHAColumns.h: interface for the LHAColumns class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#if !defined(AFX_LHACOLUMNS_H__A88C8CB0_8CBD_4566_8820_5FAF7F2A1604__INCLUDED_)
+#define AFX_LHACOLUMNS_H__A88C8CB0_8CBD_4566_8820_5FAF7F2A1604__INCLUDED_
+
+#if _MSC_VER > 1000
+#pragma once
+#endif // _MSC_VER > 1000
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+class LHAArchive;
+
+/*
+ * Header-only inventory of any number of archives, one array per field.
+ *
+ * Member i of the whole batch is packed_size()[i], original_size()[i],
+ * method_id()[i] and so on, with its name in one shared arena; a pass
+ * over a single field reads nothing else.  Only the headers are parsed:
+ * add(path) maps the archive for random access, so the packed data in
+ * between is neither read nor faulted in.  The arrays grow geometrically,
+ * or are sized once with reserve(); nothing is allocated per member.
+ *
+ *     LHAColumns c;
+ *     c.add_all(paths, npaths, 8);
+ *     for (i = 0; i < c.size(); i++)
+ *         total += c.original_size()[i];
+ */
+class LHAColumns
+{
+public:
+	bool add(const char *path);
+	bool add(LHAArchive &archive);
+	int  add_all(const char *const *paths, size_t count, int threads = 0);
+	void reserve(size_t members, size_t name_bytes);
+	void clear();
+
+	size_t size() const                     { return packed.size(); }
+	size_t archives() const                 { return narchives; }
+
+	/* size() entries each */
+	const uint64_t    *packed_size() const      { return packed.data(); }
+	const uint64_t    *original_size() const    { return original.data(); }
+	const signed char *method_id() const        { return methods.data(); }      /* *_METHOD_NUM */
+	const uint16_t    *crc() const              { return crcs.data(); }
+	const int64_t     *mtime() const            { return mtimes.data(); }       /* unix time stamp */
+	const uint32_t    *archive() const          { return archive_ids.data(); }  /* counts add() calls */
+	const uint64_t    *name_offset() const      { return name_offsets.data(); } /* into name_arena() */
+
+	const char *name_arena() const          { return names.data(); }
+	size_t name_arena_size() const          { return names.size(); }
+	const char *name(size_t i) const        { return &names[name_offsets[i]]; }
+
+	LHAColumns();
+	virtual ~LHAColumns();
+private:
+	void scan(const char *base, size_t length, uint32_t id);
+	void append(const LHAColumns &part, uint32_t id);
+	static void scan_task(void *param, size_t task, int worker);
+
+	std::vector<uint64_t>       packed;
+	std::vector<uint64_t>       original;
+	std::vector<signed char>    methods;
+	std::vector<uint16_t>       crcs;
+	std::vector<int64_t>        mtimes;
+	std::vector<uint32_t>       archive_ids;
+	std::vector<uint64_t>       name_offsets;
+	std::vector<char>           names;      /* NUL-terminated, back to back */
+	size_t                      narchives;
+
+	LHAColumns(const LHAColumns &);
+	LHAColumns &operator=(const LHAColumns &);
+};
+
+#endif // !defined(AFX_LHACOLUMNS_H__A88C8CB0_8CBD_4566_8820_5FAF7F2A1604__INCLUDED_)
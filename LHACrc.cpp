@@ -0,0 +1,303 @@
+// LHACrc.cpp: implementation of the LHACrc class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef LHAPACK_STANDALONE
+#include "stdafx.h"
+#endif
+#include "LHACrc.h"
+#include "LHAStats.h"
+
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define CRC_HAVE_PCLMUL
+#define PCLMUL_TARGET       __attribute__((target("sse2,pclmul")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CRC_HAVE_PCLMUL
+#define PCLMUL_TARGET
+#endif
+
+#define CRCPOLY             0xA001      /* CRC-16 (x^16+x^15+x^2+1) */
+#define CRCPOLY_NORMAL      0x18005     /* same, not reflected, with x^16 */
+
+#define PCLMUL_MIN_LENGTH   64
+
+//////////////////////////////////////////////////////////////////////
+// Tables
+//////////////////////////////////////////////////////////////////////
+
+/*
+ * crctable[0] is the classic byte-wise table.  crctable[k][i] is the CRC
+ * of byte i followed by k zero bytes, so 8 or 16 input bytes are folded in
+ * with one lookup each (slicing-by-8/16).
+ *
+ * Everything here is computed by the compiler and lands in read-only
+ * data: no setup on first use, nothing to synchronize between threads.
+ */
+struct CrcTables {
+    uint16_t crctable[16][256];
+
+    /* x^(D+63) and x^(D-1) mod P, bit reflected, for folding D bits ahead */
+    uint64_t fold128[2];
+    uint64_t fold512[2];
+
+    constexpr CrcTables();
+};
+
+static constexpr uint64_t xpow_mod_reflected(unsigned int n)
+{
+    uint64_t     r = 0;
+    unsigned int x = 1, i = 0;
+
+    for (i = 0; i < n; i++) {
+        x <<= 1;
+        if (x & 0x10000)
+            x ^= CRCPOLY_NORMAL;
+    }
+    for (i = 0; i < 16; i++)
+        if (x & (1U << i))
+            r |= (uint64_t)1 << (63 - i);
+    return r;
+}
+
+constexpr CrcTables::CrcTables()
+    : crctable(), fold128(), fold512()
+{
+    unsigned int i = 0, j = 0, r = 0;
+
+    for (i = 0; i <= 0xff; i++) {
+        r = i;
+        for (j = 0; j < 8; j++)
+            if (r & 1)
+                r = (r >> 1) ^ CRCPOLY;
+            else
+                r >>= 1;
+        crctable[0][i] = (uint16_t)r;
+    }
+    for (i = 0; i <= 0xff; i++)
+        for (j = 1; j < 16; j++)
+            crctable[j][i] = (uint16_t)((crctable[j - 1][i] >> 8) ^
+                                        crctable[0][crctable[j - 1][i] & 0xff]);
+
+    fold128[0] = xpow_mod_reflected(128 + 63);
+    fold128[1] = xpow_mod_reflected(128 - 1);
+    fold512[0] = xpow_mod_reflected(512 + 63);
+    fold512[1] = xpow_mod_reflected(512 - 1);
+}
+
+static constexpr CrcTables crc_tables;
+
+static inline const CrcTables &tables()
+{
+    return crc_tables;
+}
+
+static inline uint64_t load_le64(const unsigned char *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Engines
+//////////////////////////////////////////////////////////////////////
+
+static unsigned int crc_bytewise(unsigned int crc, const unsigned char *p, size_t n)
+{
+    const uint16_t *t = tables().crctable[0];
+
+    while (n-- > 0)
+        crc = t[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+static unsigned int crc_slice8(unsigned int crc, const unsigned char *p, size_t n)
+{
+    const uint16_t (*t)[256] = tables().crctable;
+
+    while (n >= 8) {
+        uint64_t v = load_le64(p) ^ crc;
+        crc = t[7][ v        & 0xff] ^ t[6][(v >>  8) & 0xff] ^
+              t[5][(v >> 16) & 0xff] ^ t[4][(v >> 24) & 0xff] ^
+              t[3][(v >> 32) & 0xff] ^ t[2][(v >> 40) & 0xff] ^
+              t[1][(v >> 48) & 0xff] ^ t[0][ v >> 56        ];
+        p += 8;
+        n -= 8;
+    }
+    return crc_bytewise(crc, p, n);
+}
+
+static unsigned int crc_slice16(unsigned int crc, const unsigned char *p, size_t n)
+{
+    const uint16_t (*t)[256] = tables().crctable;
+
+    while (n >= 16) {
+        uint64_t v = load_le64(p) ^ crc;
+        uint64_t w = load_le64(p + 8);
+        crc = t[15][ v        & 0xff] ^ t[14][(v >>  8) & 0xff] ^
+              t[13][(v >> 16) & 0xff] ^ t[12][(v >> 24) & 0xff] ^
+              t[11][(v >> 32) & 0xff] ^ t[10][(v >> 40) & 0xff] ^
+              t[ 9][(v >> 48) & 0xff] ^ t[ 8][ v >> 56        ] ^
+              t[ 7][ w        & 0xff] ^ t[ 6][(w >>  8) & 0xff] ^
+              t[ 5][(w >> 16) & 0xff] ^ t[ 4][(w >> 24) & 0xff] ^
+              t[ 3][(w >> 32) & 0xff] ^ t[ 2][(w >> 40) & 0xff] ^
+              t[ 1][(w >> 48) & 0xff] ^ t[ 0][ w >> 56        ];
+        p += 16;
+        n -= 16;
+    }
+    return crc_bytewise(crc, p, n);
+}
+
+#ifdef CRC_HAVE_PCLMUL
+/*
+ * Carry-less multiply folding.
+ *
+ * A 128-bit chunk A = H*x^64 + L (H = first 8 bytes, reflected) followed by
+ * D more bits is congruent, mod P, to H*(x^(D+64) mod P) + L*(x^D mod P)
+ * placed D bits later.  Each product is at most 80 bits wide, so it can be
+ * xored into the chunk D bits ahead; the reflected multiply shifts the
+ * product by one bit, which the x^(D+63) / x^(D-1) constants absorb.  Four
+ * lanes fold 512 bits ahead, then one lane folds 128 bits ahead, and the
+ * last 128-bit remainder runs through the table.
+ */
+PCLMUL_TARGET
+static inline __m128i crc_fold(__m128i x, __m128i k)
+{
+    return _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00),
+                         _mm_clmulepi64_si128(x, k, 0x11));
+}
+
+PCLMUL_TARGET
+static unsigned int crc_pclmul(unsigned int crc, const unsigned char *p, size_t n)
+{
+    const CrcTables &t = tables();
+    __m128i x0, x1, x2, x3, k;
+    unsigned char rest[16];
+
+    if (n < PCLMUL_MIN_LENGTH)
+        return crc_slice16(crc, p, n);
+
+    x0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(p +  0)), _mm_cvtsi32_si128((int)crc));
+    x1 = _mm_loadu_si128((const __m128i *)(p + 16));
+    x2 = _mm_loadu_si128((const __m128i *)(p + 32));
+    x3 = _mm_loadu_si128((const __m128i *)(p + 48));
+    p += 64;
+    n -= 64;
+
+    k = _mm_set_epi64x((long long)t.fold512[1], (long long)t.fold512[0]);
+    while (n >= 64) {
+        x0 = _mm_xor_si128(crc_fold(x0, k), _mm_loadu_si128((const __m128i *)(p +  0)));
+        x1 = _mm_xor_si128(crc_fold(x1, k), _mm_loadu_si128((const __m128i *)(p + 16)));
+        x2 = _mm_xor_si128(crc_fold(x2, k), _mm_loadu_si128((const __m128i *)(p + 32)));
+        x3 = _mm_xor_si128(crc_fold(x3, k), _mm_loadu_si128((const __m128i *)(p + 48)));
+        p += 64;
+        n -= 64;
+    }
+
+    k  = _mm_set_epi64x((long long)t.fold128[1], (long long)t.fold128[0]);
+    x0 = _mm_xor_si128(crc_fold(x0, k), x1);
+    x0 = _mm_xor_si128(crc_fold(x0, k), x2);
+    x0 = _mm_xor_si128(crc_fold(x0, k), x3);
+    while (n >= 16) {
+        x0 = _mm_xor_si128(crc_fold(x0, k), _mm_loadu_si128((const __m128i *)p));
+        p += 16;
+        n -= 16;
+    }
+
+    _mm_storeu_si128((__m128i *)rest, x0);
+    crc = crc_slice16(0, rest, sizeof(rest));
+    return crc_bytewise(crc, p, n);
+}
+
+static bool cpu_has_pclmul()
+{
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2") && __builtin_cpu_supports("pclmul");
+#else
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) && (info[2] & (1 << 1));   /* SSE2, PCLMULQDQ */
+#endif
+}
+#endif /* CRC_HAVE_PCLMUL */
+
+//////////////////////////////////////////////////////////////////////
+// LHACrc
+//////////////////////////////////////////////////////////////////////
+
+bool LHACrc::engine_supported(Engine engine)
+{
+	switch (engine) {
+	case CRC_BYTEWISE:
+	case CRC_SLICE8:
+	case CRC_SLICE16:
+	    return true;
+	case CRC_PCLMUL:
+#ifdef CRC_HAVE_PCLMUL
+	    {
+	        static const bool has_pclmul = cpu_has_pclmul();
+	        return has_pclmul;
+	    }
+#else
+	    return false;
+#endif
+	}
+	return false;
+}
+
+LHACrc::Engine LHACrc::engine()
+{
+	static const Engine best = engine_supported(CRC_PCLMUL) ? CRC_PCLMUL : CRC_SLICE16;
+	return best;
+}
+
+const char *LHACrc::engine_name(Engine engine)
+{
+	switch (engine) {
+	case CRC_BYTEWISE: return "bytewise";
+	case CRC_SLICE8:   return "slice8";
+	case CRC_SLICE16:  return "slice16";
+	case CRC_PCLMUL:   return "pclmul";
+	}
+	return "unknown";
+}
+
+unsigned int LHACrc::calccrc(Engine engine, unsigned int crc, const void *p, size_t n)
+{
+	const unsigned char *q = (const unsigned char *)p;
+
+	crc &= 0xffff;
+	switch (engine) {
+	case CRC_BYTEWISE:
+	    return crc_bytewise(crc, q, n);
+	case CRC_SLICE8:
+	    return crc_slice8(crc, q, n);
+	case CRC_PCLMUL:
+#ifdef CRC_HAVE_PCLMUL
+	    if (engine_supported(CRC_PCLMUL))
+	        return crc_pclmul(crc, q, n);
+#endif
+	    /* fall through */
+	case CRC_SLICE16:
+	default:
+	    return crc_slice16(crc, q, n);
+	}
+}
+
+unsigned int LHACrc::calccrc(unsigned int crc, const void *p, size_t n)
+{
+	static const Engine best = engine();
+	LHA_STAT_SCOPE(LHA_STAT_CRC);
+
+	LHA_STAT_BYTES(n);
+	return calccrc(best, crc, p, n);
+}
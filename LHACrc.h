@@ -0,0 +1,48 @@
+// LHACrc.h: interface for the LHACrc class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#if !defined(AFX_LHACRC_H__8C2968D1_2A00_4BA0_9A58_CC48A8D69120__INCLUDED_)
+#define AFX_LHACRC_H__8C2968D1_2A00_4BA0_9A58_CC48A8D69120__INCLUDED_
+
+#if _MSC_VER > 1000
+#pragma once
+#endif // _MSC_VER > 1000
+
+#include <stddef.h>
+
+/*
+ * CRC-16 (x^16+x^15+x^2+1, reflected, initial value 0) as used for the
+ * file and header CRCs of LHA archives.
+ *
+ * calccrc() picks the fastest engine for this CPU on the first call:
+ * carry-less multiply folding where PCLMULQDQ is available, otherwise
+ * slicing-by-16.  Every engine gives the same result as the byte-wise
+ * table, so a CRC may be carried from one call to the next.
+ */
+class LHACrc
+{
+public:
+	enum Engine {
+	    CRC_BYTEWISE,
+	    CRC_SLICE8,
+	    CRC_SLICE16,
+	    CRC_PCLMUL
+	};
+
+	static unsigned int calccrc(unsigned int crc, const void *p, size_t n);
+	static unsigned int calccrc(Engine engine, unsigned int crc, const void *p, size_t n);
+	static Engine       engine();
+	static bool         engine_supported(Engine engine);
+	static const char  *engine_name(Engine engine);
+
+	/* streaming use */
+	LHACrc() : crc(0) {}
+	void         reset()                        { crc = 0; }
+	void         update(const void *p, size_t n) { crc = calccrc(crc, p, n); }
+	unsigned int value() const                  { return crc; }
+private:
+	unsigned int crc;
+};
+
+#endif // !defined(AFX_LHACRC_H__8C2968D1_2A00_4BA0_9A58_CC48A8D69120__INCLUDED_)
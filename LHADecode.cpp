@@ -0,0 +1,1668 @@
+// LHADecode.cpp: implementation of the LHADecoder class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef LHAPACK_STANDALONE
+#include "stdafx.h"
+#endif
+#include "LHAPack.h"
+#include "LHADecode.h"
+#include "LHACrc.h"
+#include "LHAStats.h"
+
+#define MAXMATCH            256     /* formerly F (not more than UCHAR_MAX + 1) */
+#define THRESHOLD           3       /* choose optimal value */
+
+#define NC                  (UCHAR_MAX + MAXMATCH + 2 - THRESHOLD)
+#define CBIT                9       /* smallest integer such that (1 << CBIT) > NC */
+#define NT                  (16 + 3)
+#define TBIT                5       /* smallest integer such that (1 << TBIT) > NT */
+#define NPT                 LZH_NPT
+
+#define TBL_SUBTABLE        0x80000000U
+#define TBL_LEAF(sym, len)  ((uint32_t)(sym) | ((uint32_t)(len) << 16))
+#define TBL_SYMBOL(e)       ((e) & 0xffff)
+#define TBL_LENGTH(e)       (((e) >> 16) & 0xff)
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define DECODE_HAVE_SIMD
+#define SSE2_TARGET         __attribute__((target("sse2")))
+#define AVX2_TARGET         __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define DECODE_HAVE_SIMD
+#define SSE2_TARGET
+#define AVX2_TARGET
+#endif
+
+#define MATCH_SLACK         32      /* a match copy may write this far past its end */
+#define WINDOW_SIZE         ((1 << 16) + LZH_STREAM_FLUSH + MAXMATCH + MATCH_SLACK)
+
+/*
+ * The code tree of -lh1-, updated after every character as in LHa's
+ * dhuf.c.  Nodes are numbered in order of falling frequency from the
+ * root, 0.  The two children of an inner node are consecutive; `child'
+ * holds the higher number (bit 0 goes there, bit 1 to the one below) and
+ * in a leaf the complement of its character.  Nodes of equal frequency
+ * form a block, whose lowest numbered node is edge[block].
+ *
+ * Each node's fields share one 8-byte record, so the swaps and counts on
+ * the way up from a leaf touch one cache line per node, not one per
+ * field, and all the nodes fit in 5 KB.
+ */
+#define DYN_ROOT            0
+
+typedef struct DynNode {
+    uint16_t    freq;
+    int16_t     child;
+    int16_t     parent;
+    int16_t     block;
+} DynNode;
+
+struct LHADynTree {
+    DynNode     node[LZH_DYN_TREESIZE];
+    int16_t     edge[LZH_DYN_TREESIZE];     /* first node of each block */
+    int16_t     stock[LZH_DYN_TREESIZE];    /* free block numbers, from `avail' on */
+    int16_t     s_node[LZH_DYN_NCHAR];      /* the leaf of each character */
+    int         avail;
+};
+
+//////////////////////////////////////////////////////////////////////
+// Bit reader
+//////////////////////////////////////////////////////////////////////
+
+static inline uint64_t load_be64(const unsigned char *p)
+{
+    return ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) |
+           ((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32) |
+           ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) |
+           ((uint64_t)p[6] <<  8) |  (uint64_t)p[7];
+}
+
+static inline void init_getbits(LHABitReader &br, const unsigned char *src, size_t len)
+{
+    br.start    = src;
+    br.ptr      = src;
+    br.end      = src + len;
+    br.bitbuf   = 0;
+    br.bitcount = 0;
+}
+
+/* make at least 56 bits available in `bitbuf' */
+static inline void fillbuf(LHABitReader &br)
+{
+    if (br.end - br.ptr >= 8) {
+        br.bitbuf   |= load_be64(br.ptr) >> br.bitcount;
+        br.ptr      += (63 - br.bitcount) >> 3;
+        br.bitcount |= 56;
+    }
+    else {
+        while (br.bitcount <= 56) {
+            uint64_t c = (br.ptr < br.end) ? *br.ptr : 0;
+            br.ptr++;               /* keeps counting past the end */
+            br.bitbuf   |= c << (56 - br.bitcount);
+            br.bitcount += 8;
+        }
+    }
+}
+
+static inline unsigned int peekbits(const LHABitReader &br, int n)
+{
+    return (unsigned int)(br.bitbuf >> (64 - n));
+}
+
+static inline void skipbits(LHABitReader &br, int n)
+{
+    br.bitbuf  <<= n;
+    br.bitcount -= n;
+}
+
+/* n must be 1 .. 16; refills on its own (not for the hot loop) */
+static inline unsigned int getbits(LHABitReader &br, int n)
+{
+    unsigned int x;
+
+    if (br.bitcount < n)
+        fillbuf(br);
+    x = peekbits(br, n);
+    skipbits(br, n);
+    return x;
+}
+
+/* bits taken from the input so far, including the zero padding */
+static inline size_t consumed_bits(const LHABitReader &br)
+{
+    return (size_t)(br.ptr - br.start) * 8 - br.bitcount;
+}
+
+static inline unsigned int decode_symbol(LHABitReader &br, const uint32_t *table, int tablebits)
+{
+    uint32_t e = table[br.bitbuf >> (64 - tablebits)];
+
+    if (e & TBL_SUBTABLE)
+        e = table[(e & 0xffff) + (unsigned int)((br.bitbuf << tablebits) >> (64 - (16 - tablebits)))];
+    skipbits(br, TBL_LENGTH(e));
+    return TBL_SYMBOL(e);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Kernels
+//////////////////////////////////////////////////////////////////////
+
+/*
+ * Match copy: `length' bytes from `from' to `op', where from < op.  When
+ * the two overlap the bytes repeat with period op - from, as with a
+ * byte-by-byte copy.  Copies go by whole words or vectors and may write
+ * up to MATCH_SLACK - 1 bytes past op + length.
+ */
+typedef unsigned char *(*MatchCopyProc)(unsigned char *op, const unsigned char *from, size_t length);
+
+/* count[len] = symbols with a code of len bits; false if any len > 16 */
+typedef bool (*CountLengthsProc)(const unsigned char *bitlen, int nchar, unsigned int *count);
+
+/* n (a power of 2) table entries set to e */
+typedef void (*FillTableProc)(uint32_t *p, uint32_t e, unsigned int n);
+
+static unsigned char *copy_match_generic(unsigned char *op, const unsigned char *from, size_t length)
+{
+    unsigned char *end = op + length;
+
+    if (op - from >= 8) {
+        do {
+            memcpy(op, from, 8);
+            op   += 8;
+            from += 8;
+        } while (op < end);
+    }
+    else {
+        while (op < end)
+            *op++ = *from++;
+    }
+    return end;
+}
+
+static bool count_lengths_generic(const unsigned char *bitlen, int nchar, unsigned int *count)
+{
+    int i;
+
+    for (i = 0; i <= 16; i++)
+        count[i] = 0;
+    for (i = 0; i < nchar; i++) {
+        if (bitlen[i] > 16)
+            return false;
+        count[bitlen[i]]++;
+    }
+    return true;
+}
+
+static void fill_table_generic(uint32_t *p, uint32_t e, unsigned int n)
+{
+    while (n--)
+        *p++ = e;
+}
+
+#ifdef DECODE_HAVE_SIMD
+/*
+ * A period shorter than the vector: write the first `dist' bytes one by
+ * one, dist being the smallest multiple of the period not below width,
+ * so that the vector copies after it only read bytes already written.
+ */
+static inline size_t widen_period(unsigned char *op, const unsigned char *from, size_t width)
+{
+    size_t period = op - from;
+    size_t dist   = period;
+    size_t i;
+
+    while (dist < width)
+        dist += period;
+    for (i = 0; i < dist; i++)
+        op[i] = from[i];
+    return dist;
+}
+
+SSE2_TARGET
+static inline unsigned char *copy_sse2(unsigned char *op, const unsigned char *from, unsigned char *end)
+{
+    if (op - from == 1) {
+        __m128i v = _mm_set1_epi8((char)*from);
+        do {
+            _mm_storeu_si128((__m128i *)op, v);
+            op += 16;
+        } while (op < end);
+        return end;
+    }
+    if (op - from < 16) {
+        size_t dist = widen_period(op, from, 16);
+        from = op;
+        op  += dist;
+    }
+    while (op < end) {
+        _mm_storeu_si128((__m128i *)op, _mm_loadu_si128((const __m128i *)from));
+        op   += 16;
+        from += 16;
+    }
+    return end;
+}
+
+SSE2_TARGET
+static unsigned char *copy_match_sse2(unsigned char *op, const unsigned char *from, size_t length)
+{
+    return copy_sse2(op, from, op + length);
+}
+
+AVX2_TARGET
+static unsigned char *copy_match_avx2(unsigned char *op, const unsigned char *from, size_t length)
+{
+    unsigned char *end = op + length;
+
+    if (op - from < 32)
+        return copy_sse2(op, from, end);
+    do {
+        _mm256_storeu_si256((__m256i *)op, _mm256_loadu_si256((const __m256i *)from));
+        op   += 32;
+        from += 32;
+    } while (op < end);
+    return end;
+}
+
+/*
+ * Per length, compare all the lengths against it a vector at a time and
+ * sum the matches per lane; a lane sees at most nchar / 16 matches, well
+ * inside a byte for the tables here (nchar <= LZH_NC).
+ */
+SSE2_TARGET
+static bool count_lengths_sse2(const unsigned char *bitlen, int nchar, unsigned int *count)
+{
+    int      nvec = nchar / 16;
+    int      i, len;
+    unsigned int total = 0;
+    __m128i  max = _mm_setzero_si128();
+
+    for (i = 0; i < nvec; i++)
+        max = _mm_max_epu8(max, _mm_loadu_si128((const __m128i *)bitlen + i));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(max, _mm_set1_epi8(16)), _mm_set1_epi8(16))) != 0xffff)
+        return false;
+
+    for (len = 1; len <= 16; len++) {
+        __m128i want = _mm_set1_epi8((char)len);
+        __m128i acc  = _mm_setzero_si128();
+        for (i = 0; i < nvec; i++)
+            acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)bitlen + i), want));
+        acc = _mm_sad_epu8(acc, _mm_setzero_si128());
+        count[len] = (unsigned int)(_mm_cvtsi128_si32(acc) + _mm_extract_epi16(acc, 4));
+        total += count[len];
+    }
+    count[0] = nvec * 16 - total;
+
+    for (i = nvec * 16; i < nchar; i++) {
+        if (bitlen[i] > 16)
+            return false;
+        count[bitlen[i]]++;
+    }
+    return true;
+}
+
+AVX2_TARGET
+static bool count_lengths_avx2(const unsigned char *bitlen, int nchar, unsigned int *count)
+{
+    int      nvec = nchar / 32;
+    int      i, len;
+    unsigned int total = 0;
+    __m256i  max = _mm256_setzero_si256();
+
+    for (i = 0; i < nvec; i++)
+        max = _mm256_max_epu8(max, _mm256_loadu_si256((const __m256i *)bitlen + i));
+    if ((unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(max, _mm256_set1_epi8(16)),
+                                                            _mm256_set1_epi8(16))) != 0xffffffffU)
+        return false;
+
+    for (len = 1; len <= 16; len++) {
+        __m256i want = _mm256_set1_epi8((char)len);
+        __m256i acc  = _mm256_setzero_si256();
+        for (i = 0; i < nvec; i++)
+            acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)bitlen + i), want));
+        acc = _mm256_sad_epu8(acc, _mm256_setzero_si256());
+        __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        count[len] = (unsigned int)(_mm_cvtsi128_si32(sum) + _mm_extract_epi16(sum, 4));
+        total += count[len];
+    }
+    count[0] = nvec * 32 - total;
+
+    for (i = nvec * 32; i < nchar; i++) {
+        if (bitlen[i] > 16)
+            return false;
+        count[bitlen[i]]++;
+    }
+    return true;
+}
+
+SSE2_TARGET
+static void fill_table_sse2(uint32_t *p, uint32_t e, unsigned int n)
+{
+    if (n < 4) {
+        while (n--)
+            *p++ = e;
+        return;
+    }
+    __m128i v = _mm_set1_epi32((int)e);
+    for (; n; n -= 4, p += 4)
+        _mm_storeu_si128((__m128i *)p, v);
+}
+
+AVX2_TARGET
+static void fill_table_avx2(uint32_t *p, uint32_t e, unsigned int n)
+{
+    if (n < 8) {
+        while (n--)
+            *p++ = e;
+        return;
+    }
+    __m256i v = _mm256_set1_epi32((int)e);
+    for (; n; n -= 8, p += 8)
+        _mm256_storeu_si256((__m256i *)p, v);
+}
+
+static bool cpu_has_sse2()
+{
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#else
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#endif
+}
+
+static bool cpu_has_avx2()
+{
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    int info[4];
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+        return false;       /* no OSXSAVE or AVX */
+    if ((_xgetbv(0) & 6) != 6)
+        return false;       /* the OS does not save the ymm registers */
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#endif
+}
+#endif /* DECODE_HAVE_SIMD */
+
+struct KernelProcs {
+    MatchCopyProc       copy_match;
+    CountLengthsProc    count_lengths;
+    FillTableProc       fill_table;
+};
+
+/* by LHADecoder::Kernel */
+static const KernelProcs kernel_procs[] = {
+    { copy_match_generic, count_lengths_generic, fill_table_generic },
+#ifdef DECODE_HAVE_SIMD
+    { copy_match_sse2,    count_lengths_sse2,    fill_table_sse2    },
+    { copy_match_avx2,    count_lengths_avx2,    fill_table_avx2    },
+#else
+    { copy_match_generic, count_lengths_generic, fill_table_generic },
+    { copy_match_generic, count_lengths_generic, fill_table_generic },
+#endif
+};
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+LHADecoder::LHADecoder()
+{
+	kernel    = best_kernel();
+	blocksize = 0;
+	np        = 0;
+	pbit      = 0;
+	crc       = 0;
+	dyn       = NULL;
+
+	stream_method   = UNKNOWN_METHOD_NUM;
+	stream_packed   = 0;
+	stream_original = 0;
+	stream_total    = 0;
+	stream_flags    = 0;
+	stream_proc     = NULL;
+	stream_param    = NULL;
+	stream_failed   = true;
+	stream_in       = NULL;
+	window          = NULL;
+	dicsiz          = 0;
+	wpos            = 0;
+	wflushed        = 0;
+	wclean          = 0;
+	wdirty          = 0;
+	memset(&stream_br, 0, sizeof(stream_br));
+	pool_next       = NULL;
+}
+
+LHADecoder::~LHADecoder()
+{
+	delete[] stream_in;
+	delete[] window;
+	delete dyn;
+}
+
+bool LHADecoder::kernel_supported(Kernel kernel)
+{
+	switch (kernel) {
+	case KERNEL_GENERIC:
+	    return true;
+#ifdef DECODE_HAVE_SIMD
+	case KERNEL_SSE2:
+	    {
+	        static const bool has_sse2 = cpu_has_sse2();
+	        return has_sse2;
+	    }
+	case KERNEL_AVX2:
+	    {
+	        static const bool has_avx2 = cpu_has_avx2();
+	        return has_avx2;
+	    }
+#else
+	case KERNEL_SSE2:
+	case KERNEL_AVX2:
+	    return false;
+#endif
+	}
+	return false;
+}
+
+LHADecoder::Kernel LHADecoder::best_kernel()
+{
+	static const Kernel best = kernel_supported(KERNEL_AVX2) ? KERNEL_AVX2 :
+	                           kernel_supported(KERNEL_SSE2) ? KERNEL_SSE2 : KERNEL_GENERIC;
+	return best;
+}
+
+const char *LHADecoder::kernel_name(Kernel kernel)
+{
+	switch (kernel) {
+	case KERNEL_GENERIC: return "generic";
+	case KERNEL_SSE2:    return "sse2";
+	case KERNEL_AVX2:    return "avx2";
+	}
+	return "unknown";
+}
+
+bool LHADecoder::set_kernel(Kernel kernel)
+{
+	if (!kernel_supported(kernel))
+		return false;
+	this->kernel = kernel;
+	return true;
+}
+
+int LHADecoder::method_number(const char *method)
+{
+	static const char *methods[] = {
+	    LZHUFF0_METHOD, LZHUFF1_METHOD, LZHUFF2_METHOD, LZHUFF3_METHOD,
+	    LZHUFF4_METHOD, LZHUFF5_METHOD, LZHUFF6_METHOD, LZHUFF7_METHOD,
+	    LARC_METHOD,    LARC5_METHOD,   LARC4_METHOD,   LZHDIRS_METHOD
+	};
+
+	for (int i = 0; i < (int)(sizeof(methods) / sizeof(methods[0])); i++)
+	    if (memcmp(method, methods[i], METHOD_TYPE_STORAGE) == 0)
+	        return i;
+
+	return UNKNOWN_METHOD_NUM;
+}
+
+/*
+ * Build a canonical Huffman decode table (see LHADecode.h for the layout)
+ * from the code lengths.  Codes are assigned in order of length, then
+ * symbol, as in the original make_table().  Returns false unless the
+ * lengths describe a complete prefix code.
+ */
+bool LHADecoder::make_table(int nchar, const unsigned char *bitlen, int tablebits, uint32_t *table)
+{
+	const KernelProcs &k = kernel_procs[kernel];
+	unsigned int count[17], start[18];
+	unsigned int i, len, code, avail;
+	int          sym;
+
+	int subbits = 16 - tablebits;
+
+	if (!k.count_lengths(bitlen, nchar, count))
+	    return false;
+
+	start[1] = 0;
+	for (i = 1; i <= 16; i++)
+	    start[i + 1] = start[i] + (count[i] << (16 - i));
+	if (start[17] != 0x10000)
+	    return false;           /* over-subscribed or incomplete */
+
+	for (i = 1; i <= 16; i++)
+	    start[i] >>= 16 - i;    /* first code of each length */
+
+	memset(table, 0, sizeof(uint32_t) << tablebits);
+
+	avail = 1 << tablebits;     /* next free sub table */
+	for (sym = 0; sym < nchar; sym++) {
+	    len = bitlen[sym];
+	    if (len == 0)
+	        continue;
+	    code = start[len]++;
+
+	    if (len <= (unsigned int)tablebits)
+	        k.fill_table(table + (code << (tablebits - len)), TBL_LEAF(sym, len), 1 << (tablebits - len));
+	    else {
+	        unsigned int root = code >> (len - tablebits);
+	        unsigned int base;
+
+	        if ((table[root] & TBL_SUBTABLE) == 0) {
+	            table[root] = TBL_SUBTABLE | avail;
+	            avail += 1 << subbits;
+	        }
+	        base = (table[root] & 0xffff) +
+	               ((code & ((1 << (len - tablebits)) - 1)) << (16 - len));
+	        k.fill_table(table + base, TBL_LEAF(sym, len), 1 << (16 - len));
+	    }
+	}
+
+	return true;
+}
+
+bool LHADecoder::read_pt_len(LHABitReader &br, int nn, int nbit, int i_special)
+{
+	int i, c, n;
+
+	n = getbits(br, nbit);
+	if (n == 0) {
+	    c = getbits(br, nbit);
+	    if (c >= nn)
+	        return false;
+	    for (i = 0; i < nn; i++)
+	        pt_len[i] = 0;
+	    for (i = 0; i < (1 << LZH_PTTABLE_BITS); i++)
+	        pt_table[i] = TBL_LEAF(c, 0);
+	    return true;
+	}
+	if (n > nn)
+	    return false;
+
+	i = 0;
+	while (i < n) {
+	    fillbuf(br);
+	    c = peekbits(br, 3);
+	    if (c != 7)
+	        skipbits(br, 3);
+	    else {
+	        unsigned int mask = 1 << (16 - 4);
+	        unsigned int bits = peekbits(br, 16);
+	        while (mask & bits) {
+	            mask >>= 1;
+	            c++;
+	        }
+	        if (c > 16)
+	            return false;
+	        skipbits(br, c - 3);
+	    }
+	    pt_len[i++] = c;
+	    if (i == i_special) {
+	        c = getbits(br, 2);
+	        if (i + c > nn)
+	            return false;
+	        while (--c >= 0)
+	            pt_len[i++] = 0;
+	    }
+	}
+	while (i < nn)
+	    pt_len[i++] = 0;
+
+	return make_table(nn, pt_len, LZH_PTTABLE_BITS, pt_table);
+}
+
+bool LHADecoder::read_c_len(LHABitReader &br)
+{
+	int i, c, n;
+
+	n = getbits(br, CBIT);
+	if (n == 0) {
+	    c = getbits(br, CBIT);
+	    if (c >= NC)
+	        return false;
+	    for (i = 0; i < NC; i++)
+	        c_len[i] = 0;
+	    for (i = 0; i < (1 << LZH_CTABLE_BITS); i++)
+	        c_table[i] = TBL_LEAF(c, 0);
+	    return true;
+	}
+	if (n > NC)
+	    return false;
+
+	i = 0;
+	while (i < n) {
+	    fillbuf(br);
+	    c = decode_symbol(br, pt_table, LZH_PTTABLE_BITS);
+	    if (c <= 2) {
+	        if (c == 0)
+	            c = 1;
+	        else if (c == 1)
+	            c = getbits(br, 4) + 3;
+	        else
+	            c = getbits(br, CBIT) + 20;
+	        if (i + c > NC)
+	            return false;
+	        while (--c >= 0)
+	            c_len[i++] = 0;
+	    }
+	    else
+	        c_len[i++] = c - 2;
+	}
+	while (i < NC)
+	    c_len[i++] = 0;
+
+	return make_table(NC, c_len, LZH_CTABLE_BITS, c_table);
+}
+
+bool LHADecoder::read_block_header(LHABitReader &br)
+{
+	blocksize = getbits(br, 16);
+	if (!read_pt_len(br, NT, TBIT, 3))
+	    return false;
+	if (!read_c_len(br))
+	    return false;
+	return read_pt_len(br, np, pbit, -1);
+}
+
+/*
+ * The tail of a match: `length' bytes from `offset' back, cut to the room
+ * left in the output, without the kernel's slack.  Bytes from before the
+ * start of the output come from the initial dictionary `dict', its last
+ * `dicsiz' bytes being those just before dst (NULL: all spaces).
+ */
+static unsigned char *copy_match_tail(unsigned char *dst, unsigned char *op, unsigned char *op_end,
+                                      size_t offset, size_t length,
+                                      const unsigned char *dict, size_t dicsiz)
+{
+    if (length > (size_t)(op_end - op))
+        length = op_end - op;
+
+    if (offset <= (size_t)(op - dst)) {
+        const unsigned char *from = op - offset;
+        if (offset >= length) {
+            memcpy(op, from, length);
+            op += length;
+        }
+        else {
+            while (length--)
+                *op++ = *from++;
+        }
+    }
+    else {
+        ptrdiff_t pos = (op - dst) - (ptrdiff_t)offset;
+        while (length--) {
+            *op++ = (pos >= 0) ? dst[pos] : dict ? dict[pos + (ptrdiff_t)dicsiz] : ' ';
+            pos++;
+        }
+    }
+    return op;
+}
+
+/*
+ * -lh5-, -lh6-, -lh7-: LZSS with static Huffman coded blocks.
+ *
+ * The whole member is decoded straight into `dst', which doubles as the
+ * sliding dictionary.  A reference before the start of the output reads
+ * the initial dictionary contents (spaces), as in the original LHa.
+ * Matches are copied by the kernel's vector copy while MATCH_SLACK bytes
+ * of room are left behind them, and byte by byte in the last few.
+ */
+bool LHADecoder::decode_lzhuf(int dicbit, LHABitReader &br, unsigned char *dst, size_t original_size)
+{
+	unsigned char *op      = dst;
+	unsigned char *op_end  = dst + original_size;
+	unsigned char *crc_ptr = dst;   /* output not yet in `crc' */
+	MatchCopyProc copy_match = kernel_procs[kernel].copy_match;
+
+	np        = dicbit + 1;
+	pbit      = (np < 16) ? 4 : 5;     /* -lh4-,5- : 4, -lh6-,7- : 5 */
+	blocksize = 0;
+
+	while (op < op_end) {
+	    unsigned int c;
+
+	    if (blocksize == 0) {
+	        /* CRC the previous block while it is still in cache */
+	        crc     = LHACrc::calccrc(crc, crc_ptr, op - crc_ptr);
+	        crc_ptr = op;
+	        if (!read_block_header(br))
+	            return false;
+	    }
+	    blocksize--;
+
+	    fillbuf(br);
+	    c = decode_symbol(br, c_table, LZH_CTABLE_BITS);
+	    if (c <= UCHAR_MAX) {
+	        *op++ = (unsigned char)c;
+	        continue;
+	    }
+
+	    /* match */
+	    size_t length = c - (UCHAR_MAX + 1 - THRESHOLD);
+	    size_t offset = decode_symbol(br, pt_table, LZH_PTTABLE_BITS);
+	    if (offset > 1) {
+	        int extra = (int)offset - 1;
+	        offset = ((size_t)1 << extra) + peekbits(br, extra);
+	        skipbits(br, extra);
+	    }
+	    offset++;
+
+	    if (offset <= (size_t)(op - dst) && (size_t)(op_end - op) >= length + MATCH_SLACK)
+	        op = copy_match(op, op - offset, length);
+	    else
+	        op = copy_match_tail(dst, op, op_end, offset, length, NULL, 0);
+	}
+
+	crc = LHACrc::calccrc(crc, crc_ptr, op - crc_ptr);
+
+	/* the last code must not run past the end of the packed data */
+	return consumed_bits(br) <= (size_t)(br.end - br.start) * 8;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Legacy methods
+//////////////////////////////////////////////////////////////////////
+
+#define LH1_DICSIZ          0x1000
+#define LARC_DICSIZ         0x800   /* -lzs- */
+#define LARC5_DICSIZ        0x1000  /* -lz5- */
+
+/* every character once: a balanced tree of leaves of frequency 1 */
+static void dyn_start(LHADynTree *t)
+{
+    DynNode *n = t->node;
+    int     i, j, f;
+
+    memset(t, 0, sizeof(*t));
+    for (i = 0; i < LZH_DYN_TREESIZE; i++)
+        t->stock[i] = (int16_t)i;
+    for (i = 0, j = LZH_DYN_NCHAR * 2 - 2; i < LZH_DYN_NCHAR; i++, j--) {
+        n[j].freq    = 1;
+        n[j].child   = (int16_t)~i;
+        n[j].block   = 1;
+        t->s_node[i] = (int16_t)j;
+    }
+    t->avail   = 2;
+    t->edge[1] = LZH_DYN_NCHAR - 1;
+
+    for (i = LZH_DYN_NCHAR * 2 - 2; j >= 0; i -= 2, j--) {
+        f = n[j].freq = n[i].freq + n[i - 1].freq;
+        n[j].child = (int16_t)i;
+        n[i].parent = n[i - 1].parent = (int16_t)j;
+        if (f == n[j + 1].freq)
+            t->edge[n[j].block = n[j + 1].block] = (int16_t)j;
+        else
+            t->edge[n[j].block = t->stock[t->avail++]] = (int16_t)j;
+    }
+}
+
+/* halve the frequencies of nodes start .. end - 1 and rebuild that tree */
+static void dyn_reconst(LHADynTree *t, int start, int end)
+{
+    DynNode      *n = t->node;
+    int          i, j, k, l, b = 0;
+    unsigned int f, g;
+
+    /* the leaves, halved, to the front; all the blocks freed */
+    for (i = j = start; i < end; i++) {
+        if ((k = n[i].child) < 0) {
+            n[j].freq  = (uint16_t)((n[i].freq + 1) / 2);
+            n[j].child = (int16_t)k;
+            j++;
+        }
+        if (t->edge[b = n[i].block] == i)
+            t->stock[--t->avail] = (int16_t)b;
+    }
+
+    /* from the back, merge the lowest pairs in among the leaves */
+    j--;
+    i = end - 1;
+    l = end - 2;
+    while (i >= start) {
+        while (i >= l) {
+            n[i].freq  = n[j].freq;
+            n[i].child = n[j].child;
+            i--, j--;
+        }
+        f = n[l].freq + n[l + 1].freq;
+        for (k = start; f < n[k].freq; k++)
+            ;
+        while (j >= k) {
+            n[i].freq  = n[j].freq;
+            n[i].child = n[j].child;
+            i--, j--;
+        }
+        n[i].freq  = (uint16_t)f;
+        n[i].child = (int16_t)(l + 1);
+        i--;
+        l -= 2;
+    }
+
+    /* parents, leaves and blocks */
+    f = 0;
+    for (i = start; i < end; i++) {
+        j = n[i].child;
+        if (j < 0)
+            t->s_node[~j] = (int16_t)i;
+        else
+            n[j].parent = n[j - 1].parent = (int16_t)i;
+        if ((g = n[i].freq) == f)
+            n[i].block = (int16_t)b;
+        else {
+            t->edge[b = n[i].block = t->stock[t->avail++]] = (int16_t)i;
+            f = g;
+        }
+    }
+}
+
+/*
+ * Count one more use of node p, first swapping it with the first node of
+ * its block so that the numbering stays in order of frequency.  Returns
+ * the parent, the next node up to count.
+ */
+static inline int dyn_swap_inc(LHADynTree *t, int p)
+{
+    DynNode *n = t->node;
+    int     b = n[p].block;
+    int     q = t->edge[b];
+    int     r, s;
+
+    if (q != p) {
+        r = n[p].child;
+        s = n[q].child;
+        n[p].child = (int16_t)s;
+        n[q].child = (int16_t)r;
+        if (r >= 0)
+            n[r].parent = n[r - 1].parent = (int16_t)q;
+        else
+            t->s_node[~r] = (int16_t)q;
+        if (s >= 0)
+            n[s].parent = n[s - 1].parent = (int16_t)p;
+        else
+            t->s_node[~s] = (int16_t)p;
+        p = q;
+    }
+    else if (b != n[p + 1].block) {
+        /* alone in its block: it joins the block above or keeps its own */
+        if (++n[p].freq == n[p - 1].freq) {
+            t->stock[--t->avail] = (int16_t)b;
+            n[p].block = n[p - 1].block;
+        }
+        return n[p].parent;
+    }
+
+    /* p leaves its block */
+    t->edge[b]++;
+    if (++n[p].freq == n[p - 1].freq)
+        n[p].block = n[p - 1].block;
+    else
+        t->edge[n[p].block = t->stock[t->avail++]] = (int16_t)p;
+    return n[p].parent;
+}
+
+static inline void dyn_update(LHADynTree *t, int c)
+{
+    int q;
+
+    if (t->node[DYN_ROOT].freq == 0x8000)
+        dyn_reconst(t, 0, LZH_DYN_NCHAR * 2 - 1);
+    t->node[DYN_ROOT].freq++;
+
+    q = t->s_node[c];
+    do {
+        q = dyn_swap_inc(t, q);
+    } while (q != DYN_ROOT);
+}
+
+/* walk down from the root a bit at a time, then count the character */
+static inline int dyn_decode(LHADynTree *t, LHABitReader &br)
+{
+    const DynNode *n = t->node;
+    int           c  = n[DYN_ROOT].child;
+
+    do {
+        if (br.bitcount == 0)
+            fillbuf(br);
+        c = n[c - (int)(br.bitbuf >> 63)].child;
+        skipbits(br, 1);
+    } while (c > 0);
+
+    c = ~c;
+    dyn_update(t, c);
+    return c;
+}
+
+/*
+ * -lz5- starts from a dictionary of runs and ramps, as LArc did:
+ * 13 copies of each byte value, 0 .. 255, 255 .. 0, 128 zeros, spaces.
+ */
+struct Lz5Dictionary {
+    unsigned char text[LARC5_DICSIZ];
+
+    Lz5Dictionary()
+    {
+        int i;
+
+        memset(text, ' ', sizeof(text));
+        for (i = 0; i < 256; i++)
+            memset(&text[i * 13 + 18], i, 13);
+        for (i = 0; i < 256; i++)
+            text[256 * 13 + 18 + i] = (unsigned char)i;
+        for (i = 0; i < 256; i++)
+            text[256 * 13 + 256 + 18 + i] = (unsigned char)(255 - i);
+        memset(&text[256 * 13 + 512 + 18], 0, 128);
+    }
+};
+
+static const Lz5Dictionary lz5_dictionary;
+
+/*
+ * A position in LArc's ring dictionary as a distance back from the
+ * output: the ring started at output position 0 and wraps every dicsiz
+ * bytes, a match at the current position reading the byte dicsiz back.
+ */
+static inline size_t ring_offset(size_t pos, size_t ring, size_t dicsiz)
+{
+    return ((pos - ring - 1) & (dicsiz - 1)) + 1;
+}
+
+/*
+ * -lh1-: LZSS with a 4 KB dictionary, adaptive Huffman coded characters
+ * and match lengths, and positions in a fixed code (6 bits by table, 6
+ * more verbatim).
+ */
+bool LHADecoder::start_lh1()
+{
+	int i;
+
+	/* the position code of LHarc 1.x (ready_made(0) in LHa's shuf.c) */
+	for (i = 0; i < 64; i++)
+	    pt_len[i] = (i < 1) ? 3 : (i < 4) ? 4 : (i < 12) ? 5 : (i < 24) ? 6 : (i < 48) ? 7 : 8;
+	if (!make_table(64, pt_len, LZH_PTTABLE_BITS, pt_table))
+	    return false;
+
+	if (dyn == NULL)
+	    dyn = new LHADynTree;
+	dyn_start(dyn);
+	return true;
+}
+
+bool LHADecoder::decode_lh1(LHABitReader &br, unsigned char *dst, size_t original_size)
+{
+	unsigned char *op     = dst;
+	unsigned char *op_end = dst + original_size;
+	MatchCopyProc copy_match = kernel_procs[kernel].copy_match;
+
+	if (!start_lh1())
+	    return false;
+
+	while (op < op_end) {
+	    unsigned int c = dyn_decode(dyn, br);
+
+	    if (c <= UCHAR_MAX) {
+	        *op++ = (unsigned char)c;
+	        continue;
+	    }
+
+	    size_t length = c - (UCHAR_MAX + 1 - THRESHOLD);
+	    fillbuf(br);
+	    size_t offset = (size_t)decode_symbol(br, pt_table, LZH_PTTABLE_BITS) << 6;
+	    offset += peekbits(br, 6) + 1;
+	    skipbits(br, 6);
+
+	    if (offset <= (size_t)(op - dst) && (size_t)(op_end - op) >= length + MATCH_SLACK)
+	        op = copy_match(op, op - offset, length);
+	    else
+	        op = copy_match_tail(dst, op, op_end, offset, length, NULL, 0);
+	}
+
+	crc = LHACrc::calccrc(0, dst, original_size);
+	return consumed_bits(br) <= (size_t)(br.end - br.start) * 8;
+}
+
+/*
+ * -lzs- (LArc): LZSS with a 2 KB dictionary.  A 1 bit and a character,
+ * or a 0 bit, 11 bits of dictionary position and 4 of length - 2.
+ */
+bool LHADecoder::decode_lzs(LHABitReader &br, unsigned char *dst, size_t original_size)
+{
+	unsigned char *op     = dst;
+	unsigned char *op_end = dst + original_size;
+	MatchCopyProc copy_match = kernel_procs[kernel].copy_match;
+
+	while (op < op_end) {
+	    unsigned int code;
+
+	    fillbuf(br);
+	    if (peekbits(br, 1)) {
+	        *op++ = (unsigned char)peekbits(br, 9);
+	        skipbits(br, 9);
+	        continue;
+	    }
+
+	    code = peekbits(br, 16);
+	    skipbits(br, 16);
+	    size_t length = (code & 0x0f) + 2;
+	    size_t offset = ring_offset(op - dst, (code >> 4) + 17, LARC_DICSIZ);
+
+	    if (offset <= (size_t)(op - dst) && (size_t)(op_end - op) >= length + MATCH_SLACK)
+	        op = copy_match(op, op - offset, length);
+	    else
+	        op = copy_match_tail(dst, op, op_end, offset, length, NULL, 0);
+	}
+
+	crc = LHACrc::calccrc(0, dst, original_size);
+	return consumed_bits(br) <= (size_t)(br.end - br.start) * 8;
+}
+
+/*
+ * -lz5- (LArc): LZSS with a 4 KB dictionary, byte aligned.  A flag byte
+ * (bit 0 first) tells for each of the next 8 items whether it is a
+ * character (1) or two bytes of match: 12 bits of dictionary position,
+ * the top 4 in the high half of the second byte, and 4 of length - 3.
+ */
+bool LHADecoder::decode_lz5(const unsigned char *src, size_t packed_size, unsigned char *dst, size_t original_size)
+{
+	const unsigned char *ip     = src;
+	const unsigned char *ip_end = src + packed_size;
+	unsigned char       *op     = dst;
+	unsigned char       *op_end = dst + original_size;
+	unsigned int        flags   = 0;    /* above the flags left, a 1 */
+	MatchCopyProc copy_match = kernel_procs[kernel].copy_match;
+
+	while (op < op_end) {
+	    if (flags <= 1) {
+	        if (ip >= ip_end)
+	            return false;
+	        flags = *ip++ | 0x100;
+	    }
+
+	    if (flags & 1) {
+	        if (ip >= ip_end)
+	            return false;
+	        *op++ = *ip++;
+	    }
+	    else {
+	        if (ip_end - ip < 2)
+	            return false;
+	        size_t length = (ip[1] & 0x0f) + THRESHOLD;
+	        size_t offset = ring_offset(op - dst, ip[0] + ((size_t)(ip[1] & 0xf0) << 4) + 18, LARC5_DICSIZ);
+	        ip += 2;
+
+	        if (offset <= (size_t)(op - dst) && (size_t)(op_end - op) >= length + MATCH_SLACK)
+	            op = copy_match(op, op - offset, length);
+	        else
+	            op = copy_match_tail(dst, op, op_end, offset, length, lz5_dictionary.text, LARC5_DICSIZ);
+	    }
+	    flags >>= 1;
+	}
+
+	crc = LHACrc::calccrc(0, dst, original_size);
+	return true;
+}
+
+bool LHADecoder::decode(int method, const unsigned char *src, size_t packed_size,
+                        unsigned char *dst, size_t original_size)
+{
+	LHABitReader br;
+	LHA_STAT_SCOPE(LHA_STAT_DECODE);
+
+	init_getbits(br, src, packed_size);
+	crc = 0;
+	LHA_STAT_BYTES(original_size);
+
+	switch (method) {
+	case LZHUFF0_METHOD_NUM:
+	case LARC4_METHOD_NUM:
+	    if (packed_size != original_size)
+	        return false;
+	    if (original_size)
+	        memcpy(dst, src, original_size);
+	    crc = LHACrc::calccrc(0, dst, original_size);
+	    return true;
+	case LZHUFF1_METHOD_NUM:
+	    return decode_lh1(br, dst, original_size);
+	case LARC_METHOD_NUM:
+	    return decode_lzs(br, dst, original_size);
+	case LARC5_METHOD_NUM:
+	    return decode_lz5(src, packed_size, dst, original_size);
+	case LZHUFF5_METHOD_NUM:
+	    return decode_lzhuf(13, br, dst, original_size);
+	case LZHUFF6_METHOD_NUM:
+	    return decode_lzhuf(15, br, dst, original_size);
+	case LZHUFF7_METHOD_NUM:
+	    return decode_lzhuf(16, br, dst, original_size);
+	case LZHDIRS_METHOD_NUM:
+	    return packed_size == 0 && original_size == 0;
+	default:
+	    return false;
+	}
+}
+
+/*
+ * A stored member (-lh0-, -lz4-, or -lhd- with no data) is its own packed
+ * data.  Check the sizes and CRC it where it lies, so that the caller can
+ * take the contents straight from `src' with nothing copied.  False for
+ * any other method, and for sizes that disagree.
+ */
+bool LHADecoder::pass_through(int method, const void *src, size_t packed_size, size_t original_size)
+{
+	crc = 0;
+	switch (method) {
+	case LZHUFF0_METHOD_NUM:
+	case LARC4_METHOD_NUM:
+	    {
+	        LHA_STAT_SCOPE(LHA_STAT_DECODE);
+
+	        if (packed_size != original_size || (src == NULL && original_size))
+	            return false;
+	        crc = LHACrc::calccrc(0, src, original_size);
+	        LHA_STAT_BYTES(original_size);
+	    }
+	    return true;
+	case LZHDIRS_METHOD_NUM:
+	    return packed_size == 0 && original_size == 0;
+	default:
+	    return false;
+	}
+}
+
+/*
+ * Decode one member.  `src' points at the packed data (the header start
+ * plus LHAPack::dataoffset), `dst' must hold hdr->original_size bytes.
+ */
+bool LHADecoder::decode(const LHAHeader *hdr, const char *src, char *dst)
+{
+	if (hdr == NULL || src == NULL || (dst == NULL && hdr->original_size))
+	    return false;
+
+	return decode(method_number(hdr->method),
+	              (const unsigned char *)src, hdr->packed_size,
+	              (unsigned char *)dst, hdr->original_size);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Streaming
+//////////////////////////////////////////////////////////////////////
+
+bool LHADecoder::stream_supported(int method)
+{
+	switch (method) {
+	case LZHUFF0_METHOD_NUM:
+	case LZHUFF1_METHOD_NUM:
+	case LZHUFF5_METHOD_NUM:
+	case LZHUFF6_METHOD_NUM:
+	case LZHUFF7_METHOD_NUM:
+	case LARC_METHOD_NUM:
+	case LARC5_METHOD_NUM:
+	case LARC4_METHOD_NUM:
+	case LZHDIRS_METHOD_NUM:
+	    return true;
+	default:
+	    return false;
+	}
+}
+
+/*
+ * Start decoding a member whose packed data will arrive in pieces, for
+ * input that cannot be mapped or seeked (a pipe, a socket).  Each piece
+ * goes to stream(); the decoded output is handed to `proc' as it is
+ * made, so no more than LZH_STREAM_INPUT bytes of input and a dictionary
+ * plus LZH_STREAM_FLUSH bytes of output are held, whatever the member
+ * size.  end_stream() says whether it all decoded; `crc' is then set.
+ */
+bool LHADecoder::begin_stream(int method, uint64_t packed_size, uint64_t original_size,
+                              LHAOutputProc proc, void *param)
+{
+	int dicbit;
+
+	stream_failed = true;
+	if (!stream_supported(method) || proc == NULL)
+	    return false;
+	if (method == LARC4_METHOD_NUM)
+	    method = LZHUFF0_METHOD_NUM;       /* stored, all the same */
+	if (method == LZHUFF0_METHOD_NUM && packed_size != original_size)
+	    return false;
+	if (method == LZHDIRS_METHOD_NUM && (packed_size || original_size))
+	    return false;
+
+	stream_method   = method;
+	stream_packed   = packed_size;
+	stream_original = original_size;
+	stream_total    = original_size;
+	stream_proc     = proc;
+	stream_param    = param;
+	crc             = 0;
+
+	switch (method) {
+	case LZHUFF1_METHOD_NUM: dicbit = 12; break;   /* LH1_DICSIZ */
+	case LARC_METHOD_NUM:    dicbit = 11; break;   /* LARC_DICSIZ */
+	case LARC5_METHOD_NUM:   dicbit = 12; break;   /* LARC5_DICSIZ */
+	case LZHUFF5_METHOD_NUM: dicbit = 13; break;
+	case LZHUFF6_METHOD_NUM: dicbit = 15; break;
+	case LZHUFF7_METHOD_NUM: dicbit = 16; break;
+	default:
+	    stream_failed = false;
+	    return true;
+	}
+
+	if (stream_in == NULL)
+	    stream_in = new unsigned char[LZH_STREAM_INPUT];
+	if (window == NULL) {
+	    window = new unsigned char[WINDOW_SIZE];
+	    wclean = 0;
+	    wdirty = WINDOW_SIZE;
+	}
+	else if (wpos + MATCH_SLACK > wdirty) {
+	    wdirty = wpos + MATCH_SLACK;    /* what the last member wrote */
+	}
+
+	np        = dicbit + 1;
+	pbit      = (np < 16) ? 4 : 5;
+	blocksize = 0;
+	dicsiz    = (size_t)1 << dicbit;
+
+	/*
+	 * The initial dictionary is all spaces.  Only what earlier members
+	 * wrote below dicsiz needs clearing: a member that never slid its
+	 * window left [0, dicsiz) alone, so a run of small members clears
+	 * nothing at all.
+	 */
+	if (wclean < dicsiz && wclean < wdirty)
+	    memset(window + wclean, ' ', (wdirty < dicsiz ? wdirty : dicsiz) - wclean);
+	if (wdirty <= dicsiz)
+	    wdirty = dicsiz;
+	wclean    = dicsiz;
+	wpos      = dicsiz;
+	wflushed  = dicsiz;
+	init_getbits(stream_br, stream_in, 0);
+
+	switch (method) {
+	case LZHUFF1_METHOD_NUM:
+	    if (!start_lh1())
+	        return false;
+	    break;
+	case LARC5_METHOD_NUM:
+	    memcpy(window, lz5_dictionary.text, LARC5_DICSIZ);
+	    wclean       = 0;
+	    stream_flags = 0;
+	    break;
+	}
+
+	stream_failed = false;
+	return true;
+}
+
+/*
+ * Take the next piece of packed data.  Takes no more than the member has
+ * left, and no more than there is room for; `*used' says how much was
+ * taken and the caller passes the rest again.  False once the data is
+ * found corrupt or the output proc has aborted.
+ */
+bool LHADecoder::stream(const void *buf, size_t len, size_t *used)
+{
+	size_t n;
+	LHA_STAT_SCOPE(LHA_STAT_DECODE);
+
+	LHA_STAT_CALLS(0);              /* end_stream() counts the member */
+	*used = 0;
+	if (stream_failed)
+	    return false;
+	if (len > stream_packed)
+	    len = (size_t)stream_packed;
+
+	switch (stream_method) {
+	case LZHUFF0_METHOD_NUM:
+	    if (len) {
+	        crc = LHACrc::calccrc(crc, buf, len);
+	        if (!stream_proc(stream_param, buf, len)) {
+	            stream_failed = true;
+	            return false;
+	        }
+	    }
+	    stream_packed   -= len;
+	    stream_original -= len;
+	    *used = len;
+	    LHA_STAT_BYTES(len);
+	    return true;
+	case LZHDIRS_METHOD_NUM:
+	    return true;
+	}
+
+	/* move what is left unread to the front, then top up behind it */
+	LHABitReader &br = stream_br;
+	size_t left = br.ptr < br.end ? br.end - br.ptr : 0;
+
+	memmove(stream_in, br.ptr, left);
+	br.ptr   = stream_in;
+	br.start = stream_in;
+	br.end   = stream_in + left;
+
+	n = LZH_STREAM_INPUT - left;
+	if (n > len)
+	    n = len;
+	if (n)
+	    memcpy(stream_in + left, buf, n);
+	br.end        += n;
+	stream_packed -= n;
+	*used = n;
+
+	uint64_t before = stream_original;
+	bool     ok;
+
+	switch (stream_method) {
+	case LZHUFF1_METHOD_NUM: ok = stream_lh1(stream_packed == 0); break;
+	case LARC_METHOD_NUM:    ok = stream_lzs(stream_packed == 0); break;
+	case LARC5_METHOD_NUM:   ok = stream_lz5(stream_packed == 0); break;
+	default:                 ok = stream_lzhuf(stream_packed == 0); break;
+	}
+	if (!ok) {
+	    stream_failed = true;
+	    return false;
+	}
+	LHA_STAT_BYTES(before - stream_original);
+	(void)before;
+	return true;
+}
+
+/* false unless the member decoded completely and took all its packed data */
+bool LHADecoder::end_stream()
+{
+	size_t used;
+
+	LHA_STAT_COUNT(LHA_STAT_DECODE, 1, 0);
+	if (stream_failed || stream_packed)
+	    return false;
+	if (stream_original && !stream(NULL, 0, &used))
+	    return false;
+	if (stream_original)
+	    return false;
+
+	switch (stream_method) {
+	case LZHUFF1_METHOD_NUM:
+	case LZHUFF5_METHOD_NUM:
+	case LZHUFF6_METHOD_NUM:
+	case LZHUFF7_METHOD_NUM:
+	case LARC_METHOD_NUM:
+	    /* the last code must not run past the end of the packed data */
+	    return (stream_br.ptr - stream_br.end) * 8 <= (ptrdiff_t)stream_br.bitcount;
+	}
+	return true;
+}
+
+/*
+ * Decode what the input in hand allows.  Until the last of the packed
+ * data is in (`last'), stops while fewer than LZH_STREAM_LOOKAHEAD bytes
+ * are left, so that no code (nor block header) is read past what has
+ * arrived.  The window holds the dictionary, then the new output; once
+ * LZH_STREAM_FLUSH bytes have been added they are handed on and the last
+ * dictionary's worth slid back to the start.
+ */
+bool LHADecoder::stream_lzhuf(bool last)
+{
+	LHABitReader &br = stream_br;
+	MatchCopyProc copy_match = kernel_procs[kernel].copy_match;
+
+	while (stream_original) {
+	    unsigned int c;
+
+	    if (!last && br.end - br.ptr < LZH_STREAM_LOOKAHEAD)
+	        return true;
+	    if ((br.ptr - br.end) * 8 > (ptrdiff_t)br.bitcount)
+	        return false;       /* past the end: the sizes are wrong */
+
+	    if (blocksize == 0 && !read_block_header(br))
+	        return false;
+	    blocksize--;
+
+	    fillbuf(br);
+	    c = decode_symbol(br, c_table, LZH_CTABLE_BITS);
+	    if (c <= UCHAR_MAX) {
+	        window[wpos++] = (unsigned char)c;
+	        stream_original--;
+	    }
+	    else {
+	        size_t length = c - (UCHAR_MAX + 1 - THRESHOLD);
+	        size_t offset = decode_symbol(br, pt_table, LZH_PTTABLE_BITS);
+	        if (offset > 1) {
+	            int extra = (int)offset - 1;
+	            offset = ((size_t)1 << extra) + peekbits(br, extra);
+	            skipbits(br, extra);
+	        }
+	        offset++;
+
+	        if (offset > dicsiz)
+	            return false;   /* wpos >= dicsiz, so anything closer is in the window */
+	        if (length > stream_original)
+	            length = (size_t)stream_original;
+	        copy_match(window + wpos, window + wpos - offset, length);
+	        wpos            += length;
+	        stream_original -= length;
+	    }
+
+	    if (wpos >= dicsiz + LZH_STREAM_FLUSH && !flush_window(true))
+	        return false;
+	}
+
+	return flush_window(false);
+}
+
+/*
+ * The legacy methods go through the same window, their dictionary (2 or
+ * 4 KB) at its start: spaces, or for -lz5- LArc's runs and ramps, which
+ * begin_stream() put there.  A position in LArc's ring is taken from the
+ * count of bytes decoded so far, as decode_lzs() and decode_lz5() take it
+ * from the output.
+ */
+bool LHADecoder::stream_lh1(bool last)
+{
+	LHABitReader &br = stream_br;
+	MatchCopyProc copy_match = kernel_procs[kernel].copy_match;
+
+	while (stream_original) {
+	    unsigned int c;
+
+	    if (!last && br.end - br.ptr < LZH_STREAM_LOOKAHEAD)
+	        return true;
+	    if ((br.ptr - br.end) * 8 > (ptrdiff_t)br.bitcount)
+	        return false;       /* past the end: the sizes are wrong */
+
+	    c = dyn_decode(dyn, br);
+	    if (c <= UCHAR_MAX) {
+	        window[wpos++] = (unsigned char)c;
+	        stream_original--;
+	    }
+	    else {
+	        size_t length = c - (UCHAR_MAX + 1 - THRESHOLD);
+	        fillbuf(br);
+	        size_t offset = (size_t)decode_symbol(br, pt_table, LZH_PTTABLE_BITS) << 6;
+	        offset += peekbits(br, 6) + 1;
+	        skipbits(br, 6);
+
+	        if (length > stream_original)
+	            length = (size_t)stream_original;
+	        copy_match(window + wpos, window + wpos - offset, length);     /* offset <= dicsiz */
+	        wpos            += length;
+	        stream_original -= length;
+	    }
+
+	    if (wpos >= dicsiz + LZH_STREAM_FLUSH && !flush_window(true))
+	        return false;
+	}
+
+	return flush_window(false);
+}
+
+bool LHADecoder::stream_lzs(bool last)
+{
+	LHABitReader &br = stream_br;
+	MatchCopyProc copy_match = kernel_procs[kernel].copy_match;
+
+	while (stream_original) {
+	    unsigned int code;
+
+	    if (!last && br.end - br.ptr < LZH_STREAM_LOOKAHEAD)
+	        return true;
+	    if ((br.ptr - br.end) * 8 > (ptrdiff_t)br.bitcount)
+	        return false;       /* past the end: the sizes are wrong */
+
+	    fillbuf(br);
+	    if (peekbits(br, 1)) {
+	        window[wpos++] = (unsigned char)peekbits(br, 9);
+	        skipbits(br, 9);
+	        stream_original--;
+	    }
+	    else {
+	        code = peekbits(br, 16);
+	        skipbits(br, 16);
+	        size_t length = (code & 0x0f) + 2;
+	        size_t offset = ring_offset((size_t)(stream_total - stream_original), (code >> 4) + 17, LARC_DICSIZ);
+
+	        if (length > stream_original)
+	            length = (size_t)stream_original;
+	        copy_match(window + wpos, window + wpos - offset, length);
+	        wpos            += length;
+	        stream_original -= length;
+	    }
+
+	    if (wpos >= dicsiz + LZH_STREAM_FLUSH && !flush_window(true))
+	        return false;
+	}
+
+	return flush_window(false);
+}
+
+/* byte aligned: the bit reader's `ptr' is the input, its bit buffer unused */
+bool LHADecoder::stream_lz5(bool last)
+{
+	LHABitReader        &br = stream_br;
+	const unsigned char *&ip = br.ptr;
+	MatchCopyProc copy_match = kernel_procs[kernel].copy_match;
+
+	while (stream_original) {
+	    if (!last && br.end - ip < LZH_STREAM_LOOKAHEAD)
+	        return true;
+
+	    if (stream_flags <= 1) {
+	        if (ip >= br.end)
+	            return false;
+	        stream_flags = *ip++ | 0x100;
+	    }
+
+	    if (stream_flags & 1) {
+	        if (ip >= br.end)
+	            return false;
+	        window[wpos++] = *ip++;
+	        stream_original--;
+	    }
+	    else {
+	        if (br.end - ip < 2)
+	            return false;
+	        size_t length = (ip[1] & 0x0f) + THRESHOLD;
+	        size_t offset = ring_offset((size_t)(stream_total - stream_original),
+	                                    ip[0] + ((size_t)(ip[1] & 0xf0) << 4) + 18, LARC5_DICSIZ);
+	        ip += 2;
+
+	        if (length > stream_original)
+	            length = (size_t)stream_original;
+	        copy_match(window + wpos, window + wpos - offset, length);
+	        wpos            += length;
+	        stream_original -= length;
+	    }
+	    stream_flags >>= 1;
+
+	    if (wpos >= dicsiz + LZH_STREAM_FLUSH && !flush_window(true))
+	        return false;
+	}
+
+	return flush_window(false);
+}
+
+bool LHADecoder::flush_window(bool slide)
+{
+	size_t n = wpos - wflushed;
+
+	if (n == 0)
+	    return true;
+	crc = LHACrc::calccrc(crc, window + wflushed, n);
+	if (!stream_proc(stream_param, window + wflushed, n))
+	    return false;
+	if (!slide) {
+	    wflushed = wpos;        /* the member is done; nothing more to make room for */
+	    return true;
+	}
+
+	if (wpos + MATCH_SLACK > wdirty)
+	    wdirty = wpos + MATCH_SLACK;
+	wclean   = 0;
+	memmove(window, window + wpos - dicsiz, dicsiz);
+	wpos     = dicsiz;
+	wflushed = dicsiz;
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Decoder contexts
+//////////////////////////////////////////////////////////////////////
+
+/* a thread's idle decoders, linked through pool_next */
+struct DecoderPool {
+    LHADecoder  *head;
+    int         count;
+
+    DecoderPool() : head(NULL), count(0) {}
+    ~DecoderPool() { LHADecoderContext::trim(); }
+};
+
+static thread_local DecoderPool decoder_pool;
+
+LHADecoderContext::LHADecoderContext()
+{
+	DecoderPool &pool = decoder_pool;
+
+	if (pool.head) {
+		decoder        = pool.head;
+		pool.head      = decoder->pool_next;
+		decoder->pool_next = NULL;
+		pool.count--;
+	}
+	else {
+		decoder = new LHADecoder;
+	}
+}
+
+LHADecoderContext::~LHADecoderContext()
+{
+	DecoderPool &pool = decoder_pool;
+
+	if (pool.count >= LZH_CONTEXT_POOL) {
+		delete decoder;
+		return;
+	}
+	decoder->kernel    = LHADecoder::best_kernel();    /* undo set_kernel() */
+	decoder->pool_next = pool.head;
+	pool.head          = decoder;
+	pool.count++;
+}
+
+/* free the calling thread's idle decoders */
+void LHADecoderContext::trim()
+{
+	DecoderPool &pool = decoder_pool;
+
+	while (pool.head) {
+		LHADecoder *next = pool.head->pool_next;
+		delete pool.head;
+		pool.head = next;
+	}
+	pool.count = 0;
+}
@@ -0,0 +1,213 @@
+// LHADecode.h: interface for the LHADecoder class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#if !defined(AFX_LHADECODE_H__153F669E_4F67_4B1C_889A_3F12E5A33C30__INCLUDED_)
+#define AFX_LHADECODE_H__153F669E_4F67_4B1C_889A_3F12E5A33C30__INCLUDED_
+
+#if _MSC_VER > 1000
+#pragma once
+#endif // _MSC_VER > 1000
+
+#include <stddef.h>
+#include <stdint.h>
+#include <limits.h>
+
+struct LHAHeader;
+struct LHADynTree;
+
+/* compression methods (LHAHeader::method) */
+#define LZHUFF0_METHOD          "-lh0-"
+#define LZHUFF1_METHOD          "-lh1-"
+#define LZHUFF2_METHOD          "-lh2-"
+#define LZHUFF3_METHOD          "-lh3-"
+#define LZHUFF4_METHOD          "-lh4-"
+#define LZHUFF5_METHOD          "-lh5-"
+#define LZHUFF6_METHOD          "-lh6-"
+#define LZHUFF7_METHOD          "-lh7-"
+#define LARC_METHOD             "-lzs-"
+#define LARC5_METHOD            "-lz5-"
+#define LARC4_METHOD            "-lz4-"
+#define LZHDIRS_METHOD          "-lhd-"
+
+#define LZHUFF0_METHOD_NUM      0
+#define LZHUFF1_METHOD_NUM      1
+#define LZHUFF2_METHOD_NUM      2
+#define LZHUFF3_METHOD_NUM      3
+#define LZHUFF4_METHOD_NUM      4
+#define LZHUFF5_METHOD_NUM      5
+#define LZHUFF6_METHOD_NUM      6
+#define LZHUFF7_METHOD_NUM      7
+#define LARC_METHOD_NUM         8
+#define LARC5_METHOD_NUM        9
+#define LARC4_METHOD_NUM        10
+#define LZHDIRS_METHOD_NUM      11
+#define UNKNOWN_METHOD_NUM      (-1)
+
+/* streaming decode (begin_stream()) */
+#define LZH_STREAM_INPUT        0x10000 /* packed bytes buffered */
+#define LZH_STREAM_LOOKAHEAD    0x1000  /* more than a block header or a symbol can take */
+#define LZH_STREAM_FLUSH        0x10000 /* decoded bytes handed on at a time */
+
+/* receives output in pieces; return false to abort */
+typedef bool (*LHAOutputProc)(void *param, const void *buf, size_t len);
+
+/* static Huffman coding (-lh4- .. -lh7-) table sizes */
+#define LZH_NC                  510     /* UCHAR_MAX + MAXMATCH + 2 - THRESHOLD */
+#define LZH_NT                  19      /* 16 + 3 */
+#define LZH_NPT                 0x80
+#define LZH_CTABLE_BITS         12
+#define LZH_PTTABLE_BITS        8
+
+/* -lh1- adaptive Huffman coding of characters and match lengths */
+#define LZH_DYN_NCHAR           314     /* UCHAR_MAX + 1 + 60 + 1 - THRESHOLD */
+#define LZH_DYN_TREESIZE        (LZH_DYN_NCHAR * 2)
+
+/*
+ * decode tables
+ *
+ * A code of up to `tablebits' bits is resolved by a single lookup of the
+ * next `tablebits' bits of input.  Longer codes (up to 16 bits) take one
+ * more lookup into a sub table appended to the root table.
+ *
+ *  31    30 .. 24   23 .. 16      15 .. 0
+ * | sub |   ---   | code length | symbol            |   leaf
+ * | sub |   ---   |     ---     | sub table offset  |   link
+ */
+#define LZH_CTABLE_SIZE         ((1 << LZH_CTABLE_BITS) + LZH_NC * (1 << (16 - LZH_CTABLE_BITS)))
+#define LZH_PTTABLE_SIZE        ((1 << LZH_PTTABLE_BITS) + LZH_NT * (1 << (16 - LZH_PTTABLE_BITS)))
+
+/*
+ * bit reader
+ *
+ * `bitbuf' is a 64-bit reservoir holding the next `bitcount' bits of the
+ * input MSB first, so one refill covers a whole literal/match (c-code,
+ * p-code and its extra bits take at most 47 bits).  Input past the end of
+ * the packed data reads as zero bits, as in the original LHa.
+ */
+typedef struct LHABitReader {
+    const unsigned char *ptr;
+    const unsigned char *end;
+    const unsigned char *start;
+    uint64_t            bitbuf;
+    int                 bitcount;
+} LHABitReader;
+
+/*
+ * Match copy and table build kernels.  The decoder uses the fastest one
+ * this CPU supports unless told otherwise with set_kernel(); all of them
+ * give the same output.
+ */
+class LHADecoder
+{
+public:
+	enum Kernel {
+	    KERNEL_GENERIC,
+	    KERNEL_SSE2,
+	    KERNEL_AVX2
+	};
+
+	static Kernel      best_kernel();
+	static bool        kernel_supported(Kernel kernel);
+	static const char *kernel_name(Kernel kernel);
+	bool               set_kernel(Kernel kernel);
+
+	bool decode(const LHAHeader *hdr, const char *src, char *dst);
+	bool decode(int method, const unsigned char *src, size_t packed_size,
+	            unsigned char *dst, size_t original_size);
+	bool pass_through(int method, const void *src, size_t packed_size, size_t original_size);
+	static int method_number(const char *method);
+
+	static bool stream_supported(int method);
+	bool begin_stream(int method, uint64_t packed_size, uint64_t original_size,
+	                  LHAOutputProc proc, void *param);
+	bool stream(const void *buf, size_t len, size_t *used);
+	bool end_stream();
+
+	LHADecoder();
+	virtual ~LHADecoder();
+public:
+	unsigned int    crc;    /* CRC-16 of the last decoded member */
+private:
+	bool decode_lzhuf(int dicbit, LHABitReader &br, unsigned char *dst, size_t original_size);
+	bool start_lh1();
+	bool decode_lh1(LHABitReader &br, unsigned char *dst, size_t original_size);
+	bool decode_lzs(LHABitReader &br, unsigned char *dst, size_t original_size);
+	bool decode_lz5(const unsigned char *src, size_t packed_size, unsigned char *dst, size_t original_size);
+	bool read_block_header(LHABitReader &br);
+	bool read_pt_len(LHABitReader &br, int nn, int nbit, int i_special);
+	bool read_c_len(LHABitReader &br);
+	bool make_table(int nchar, const unsigned char *bitlen, int tablebits, uint32_t *table);
+	bool stream_lzhuf(bool last);
+	bool stream_lh1(bool last);
+	bool stream_lzs(bool last);
+	bool stream_lz5(bool last);
+	bool flush_window(bool slide);
+
+	Kernel          kernel;
+	unsigned int    blocksize;
+	int             np;
+	int             pbit;
+
+	unsigned char   c_len[LZH_NC];
+	unsigned char   pt_len[LZH_NPT];
+	uint32_t        c_table[LZH_CTABLE_SIZE];
+	uint32_t        pt_table[LZH_PTTABLE_SIZE];
+	LHADynTree      *dyn;               /* -lh1- code tree, made on first use */
+
+	/* streaming state */
+	int             stream_method;
+	uint64_t        stream_packed;      /* packed bytes still to come */
+	uint64_t        stream_original;    /* bytes still to decode */
+	uint64_t        stream_total;       /* bytes in all */
+	unsigned int    stream_flags;       /* -lz5- flags left, above them a 1 */
+	LHAOutputProc   stream_proc;
+	void            *stream_param;
+	bool            stream_failed;
+	LHABitReader    stream_br;
+	unsigned char   *stream_in;         /* LZH_STREAM_INPUT bytes */
+	unsigned char   *window;            /* dictionary, then up to LZH_STREAM_FLUSH new bytes */
+	size_t          dicsiz;
+	size_t          wpos;               /* next byte decoded */
+	size_t          wflushed;           /* first byte not handed on */
+	size_t          wclean;             /* window is all spaces outside */
+	size_t          wdirty;             /*   [wclean, wdirty) */
+
+	LHADecoder      *pool_next;         /* LHADecoderContext's free list */
+	friend class LHADecoderContext;
+
+	LHADecoder(const LHADecoder &);
+	LHADecoder &operator=(const LHADecoder &);
+};
+
+/*
+ * A decoder on loan from the calling thread's pool for as long as the
+ * context lives.  Window and table memory stay with the decoder between
+ * loans, and a decoder resets itself at the start of every member, so
+ * taking one per member costs neither an allocation nor a clear once the
+ * thread has a decoder to hand out.  At most LZH_CONTEXT_POOL idle ones
+ * are kept per thread; they are freed when the thread exits, or by
+ * trim().  A context must be destroyed on the thread that made it.
+ *
+ *     LHADecoderContext decoder;
+ *     ok = decoder->decode(&hdr, p + dataoffset, buf) && decoder->crc == hdr.crc;
+ */
+#define LZH_CONTEXT_POOL        4
+
+class LHADecoderContext
+{
+public:
+	LHADecoder *operator->() const  { return decoder; }
+	LHADecoder &operator*() const   { return *decoder; }
+	static void trim();
+
+	LHADecoderContext();
+	virtual ~LHADecoderContext();
+private:
+	LHADecoder  *decoder;
+
+	LHADecoderContext(const LHADecoderContext &);
+	LHADecoderContext &operator=(const LHADecoderContext &);
+};
+
+#endif // !defined(AFX_LHADECODE_H__153F669E_4F67_4B1C_889A_3F12E5A33C30__INCLUDED_)
@@ -0,0 +1,708 @@
+// LHAEncode.cpp: implementation of the LHAEncoder class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef LHAPACK_STANDALONE
+#include "stdafx.h"
+#endif
+#include "LHAEncode.h"
+#include "LHACrc.h"
+
+#include <string.h>
+#include <algorithm>
+
+#define MAXMATCH            256     /* formerly F (not more than UCHAR_MAX + 1) */
+#define THRESHOLD           3       /* choose optimal value */
+
+#define NC                  (UCHAR_MAX + MAXMATCH + 2 - THRESHOLD)
+#define CBIT                9       /* smallest integer such that (1 << CBIT) > NC */
+#define NT                  (16 + 3)
+#define TBIT                5       /* smallest integer such that (1 << TBIT) > NT */
+
+#define HASH_BITS           15
+#define HASH_SIZE           (1 << HASH_BITS)
+#define NIL                 (-1)
+
+#define MIN_LOOKAHEAD       (MAXMATCH + THRESHOLD + 1)
+#define MAX_DICBIT          16
+#define MAX_BUFSIZ          (2 * (1 << MAX_DICBIT) + MIN_LOOKAHEAD)
+#define TOO_FAR             4096    /* a 3-byte match further back costs more than it saves */
+
+#define HASH(p)     ((((uint32_t)(p)[0] << 16 | (uint32_t)(p)[1] << 8 | (p)[2]) * 2654435761U) \
+                     >> (32 - HASH_BITS))
+
+/*
+ * level  chain  nice  lazy
+ *
+ * Greedy levels hash the inside of a match only up to `max_lazy' bytes;
+ * lazy levels stop looking for a better match once the pending one is
+ * `max_lazy' long.
+ */
+static const struct {
+    int     max_chain;
+    int     nice_length;
+    int     max_lazy;
+    bool    lazy;
+} level_config[LZH_LEVEL_MAX + 1] = {
+    {    0,   0,   0, false },  /* not used */
+    {    4,   8,   4, false },
+    {    8,  16,   5, false },
+    {   32,  32,   6, false },
+    {   16,  16,   4, true  },
+    {   32,  32,  16, true  },
+    {  128, 128,  16, true  },
+    {  256, 128,  32, true  },
+    { 1024, 256, 128, true  },
+    { 4096, 256, 256, true  },
+};
+
+static inline int bit_length(unsigned int x)
+{
+#if defined(__GNUC__)
+    return x ? 32 - __builtin_clz(x) : 0;
+#else
+    int n = 0;
+    while (x) {
+        n++;
+        x >>= 1;
+    }
+    return n;
+#endif
+}
+
+static inline uint64_t load64(const unsigned char *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/* length of the common prefix of a and b, up to max_len */
+static inline int match_length(const unsigned char *a, const unsigned char *b, int max_len)
+{
+    int len = 0;
+
+#if defined(__GNUC__)
+    while (len + 8 <= max_len) {
+        uint64_t x = load64(a + len) ^ load64(b + len);
+        if (x) {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+            return len + (__builtin_clzll(x) >> 3);
+#else
+            return len + (__builtin_ctzll(x) >> 3);
+#endif
+        }
+        len += 8;
+    }
+#endif
+    while (len < max_len && a[len] == b[len])
+        len++;
+    return len;
+}
+
+struct FreqLess {
+    const unsigned int *freq;
+    bool operator()(int a, int b) const { return freq[a] < freq[b]; }
+};
+
+/*
+ * Huffman code lengths for freq[0 .. n-1], limited to 16 bits, and the
+ * canonical codes for them.  Returns n if at least two symbols occur;
+ * otherwise the symbol that does (0 if none), with every length 0.
+ *
+ * Lengths beyond 16 are clamped and the code is made complete again as
+ * LHa does: a 16-bit code is dropped and the longest shorter code split
+ * in two, until the Kraft sum is exact.  The least frequent symbols then
+ * get the longest codes.
+ */
+static int make_tree(int n, const unsigned int *freq, unsigned char *len, uint16_t *code)
+{
+    int          sorted[NC], parent[2 * NC], depth[2 * NC];
+    unsigned int weight[2 * NC], len_cnt[17], start[18], cum;
+    int          m = 0, i, k, leaf, node, next;
+    FreqLess     less;
+
+    for (i = 0; i < n; i++) {
+        len[i] = 0;
+        if (freq[i])
+            sorted[m++] = i;
+    }
+    if (m < 2)
+        return m ? sorted[0] : 0;
+
+    less.freq = freq;
+    std::stable_sort(sorted, sorted + m, less);
+
+    /* two queues: leaves by weight, then internal nodes as they are made */
+    for (i = 0; i < m; i++)
+        weight[i] = freq[sorted[i]];
+    leaf = 0;
+    node = next = m;
+    while (next < 2 * m - 1) {
+        int a, b;
+
+        a = (leaf < m && (node >= next || weight[leaf] <= weight[node])) ? leaf++ : node++;
+        b = (leaf < m && (node >= next || weight[leaf] <= weight[node])) ? leaf++ : node++;
+        weight[next] = weight[a] + weight[b];
+        parent[a] = parent[b] = next;
+        next++;
+    }
+
+    depth[2 * m - 2] = 0;
+    for (i = 2 * m - 3; i >= 0; i--)
+        depth[i] = depth[parent[i]] + 1;
+
+    for (i = 0; i <= 16; i++)
+        len_cnt[i] = 0;
+    for (i = 0; i < m; i++)
+        len_cnt[depth[i] < 16 ? depth[i] : 16]++;
+
+    cum = 0;
+    for (i = 16; i > 0; i--)
+        cum += len_cnt[i] << (16 - i);
+    while (cum != (1U << 16)) {
+        len_cnt[16]--;
+        for (i = 15; i > 0; i--) {
+            if (len_cnt[i] != 0) {
+                len_cnt[i]--;
+                len_cnt[i + 1] += 2;
+                break;
+            }
+        }
+        cum--;
+    }
+
+    k = 0;
+    for (i = 16; i > 0; i--) {
+        unsigned int c = len_cnt[i];
+        while (c--)
+            len[sorted[k++]] = (unsigned char)i;
+    }
+
+    start[1] = 0;
+    for (i = 1; i <= 16; i++)
+        start[i + 1] = (start[i] + len_cnt[i]) << 1;
+    for (i = 0; i < n; i++)
+        code[i] = len[i] ? (uint16_t)start[len[i]]++ : 0;
+
+    return n;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+LHAEncoder::LHAEncoder()
+{
+	proc          = NULL;
+	param         = NULL;
+	failed        = false;
+	text          = NULL;
+	head          = NULL;
+	prev          = NULL;
+	c_buf         = NULL;
+	p_buf         = NULL;
+	crc           = 0;
+	original_size = 0;
+	packed_size   = 0;
+}
+
+LHAEncoder::~LHAEncoder()
+{
+	delete[] text;
+	delete[] head;
+	delete[] prev;
+	delete[] c_buf;
+	delete[] p_buf;
+}
+
+bool LHAEncoder::method_supported(int method)
+{
+	return method == LZHUFF5_METHOD_NUM ||
+	       method == LZHUFF6_METHOD_NUM ||
+	       method == LZHUFF7_METHOD_NUM;
+}
+
+/*
+ * Start a member.  level runs from LZH_LEVEL_MIN (fastest) to
+ * LZH_LEVEL_MAX (smallest); the packed stream goes to proc.
+ */
+bool LHAEncoder::begin(int method, int level, LHAOutputProc proc, void *param)
+{
+	int i;
+
+	switch (method) {
+	case LZHUFF5_METHOD_NUM: dicbit = 13; break;
+	case LZHUFF6_METHOD_NUM: dicbit = 15; break;
+	case LZHUFF7_METHOD_NUM: dicbit = 16; break;
+	default:
+	    return false;
+	}
+	if (level < LZH_LEVEL_MIN)
+		level = LZH_LEVEL_MIN;
+	if (level > LZH_LEVEL_MAX)
+		level = LZH_LEVEL_MAX;
+
+	/* sized for the largest dictionary and kept for the next member */
+	if (text == NULL) {
+		text  = new unsigned char[MAX_BUFSIZ + 8];
+		head  = new int32_t[HASH_SIZE];
+		prev  = new int32_t[MAX_BUFSIZ];
+		c_buf = new uint16_t[LZH_BLOCK_SYMBOLS];
+		p_buf = new uint16_t[LZH_BLOCK_SYMBOLS];
+		memset(text, 0, MAX_BUFSIZ + 8);
+	}
+
+	dicsiz = 1 << dicbit;
+	bufsiz = 2 * dicsiz + MIN_LOOKAHEAD;
+	np     = dicbit + 1;
+	pbit   = np < 16 ? 4 : 5;
+
+	for (i = 0; i < HASH_SIZE; i++)
+		head[i] = NIL;
+	pos    = 0;
+	avail  = 0;
+	hashed = 0;
+
+	max_chain       = level_config[level].max_chain;
+	nice_length     = level_config[level].nice_length;
+	max_lazy        = level_config[level].max_lazy;
+	lazy            = level_config[level].lazy;
+	match_available = false;
+	prev_length     = THRESHOLD - 1;
+	prev_dist       = 0;
+
+	c_count = 0;
+	p_count = 0;
+	memset(c_freq, 0, sizeof(c_freq));
+	memset(p_freq, 0, sizeof(p_freq));
+
+	bitbuf        = 0;
+	bitcount      = 0;
+	outpos        = 0;
+	crc           = 0;
+	original_size = 0;
+	packed_size   = 0;
+	failed        = false;
+
+	this->proc  = proc;
+	this->param = param;
+	return true;
+}
+
+bool LHAEncoder::write(const void *buf, size_t len)
+{
+	const unsigned char *p = (const unsigned char *)buf;
+
+	if (failed)
+		return false;
+
+	crc = LHACrc::calccrc(crc, p, len);
+	original_size += len;
+
+	while (len > 0 && !failed) {
+		size_t n;
+
+		if (avail == bufsiz)
+			slide();
+		n = (size_t)(bufsiz - avail);
+		if (n > len)
+			n = len;
+		memcpy(text + avail, p, n);
+		avail += (int)n;
+		p     += n;
+		len   -= n;
+
+		compress(false);
+	}
+	return !failed;
+}
+
+/* encode what is left, send the last block and flush the bit stream */
+bool LHAEncoder::finish()
+{
+	compress(true);
+	if (c_count)
+		send_block();
+	flush_bits();
+	flush_output();
+	return !failed;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Match finding
+//////////////////////////////////////////////////////////////////////
+
+inline void LHAEncoder::insert_hash(int i)
+{
+	uint32_t h;
+
+	if (i + THRESHOLD > avail)
+		return;
+	h       = HASH(text + i);
+	prev[i] = head[h];
+	head[h] = i;
+}
+
+/*
+ * Drop the oldest dicsiz bytes.  Only called with pos >= dicsiz, so the
+ * whole dictionary behind pos survives.
+ */
+void LHAEncoder::slide()
+{
+	int i;
+
+	memmove(text, text + dicsiz, avail - dicsiz);
+	pos    -= dicsiz;
+	avail  -= dicsiz;
+	hashed -= dicsiz;
+
+	for (i = 0; i < HASH_SIZE; i++)
+		head[i] = head[i] >= dicsiz ? head[i] - dicsiz : NIL;
+	for (i = 0; i < hashed; i++)
+		prev[i] = prev[i + dicsiz] >= dicsiz ? prev[i + dicsiz] - dicsiz : NIL;
+}
+
+/*
+ * Longest match for the (hashed) position cur that beats prev_len, up
+ * to max_len bytes and less than dicsiz back.  Returns prev_len if there
+ * is none.
+ */
+int LHAEncoder::longest_match(int cur, int max_len, int prev_len, int *dist)
+{
+	const unsigned char *scan  = text + cur;
+	int                 best   = prev_len;
+	int                 chain  = max_chain;
+	int                 limit  = cur > dicsiz - 1 ? cur - (dicsiz - 1) : 0;
+	int                 m;
+
+	if (best >= max_len)
+		return best;
+
+	for (m = prev[cur]; m >= limit && chain-- > 0; m = prev[m]) {
+		const unsigned char *match = text + m;
+		int len;
+
+		if (match[best] != scan[best] || match[0] != scan[0] || match[1] != scan[1])
+			continue;
+
+		len = match_length(scan, match, max_len);
+		if (len > best) {
+			best  = len;
+			*dist = cur - m;
+			if (len >= nice_length || len >= max_len)
+				break;
+		}
+	}
+	return best;
+}
+
+/*
+ * Encode while at least MIN_LOOKAHEAD bytes are ahead of pos (all of
+ * them if flush), so every match can reach its full length.
+ */
+void LHAEncoder::compress(bool flush)
+{
+	while (!failed) {
+		int lookahead = avail - pos;
+		int max_len, len, dist = 0;
+
+		if (flush ? lookahead <= 0 : lookahead < MIN_LOOKAHEAD)
+			break;
+		max_len = lookahead < MAXMATCH ? lookahead : MAXMATCH;
+
+		while (hashed <= pos)
+			insert_hash(hashed++);
+
+		if (!lazy) {
+			len = THRESHOLD - 1;
+			if (max_len >= THRESHOLD)
+				len = longest_match(pos, max_len, THRESHOLD - 1, &dist);
+			if (len == THRESHOLD && dist > TOO_FAR)
+				len = THRESHOLD - 1;
+
+			if (len >= THRESHOLD) {
+				output_match(len, dist);
+				if (len <= max_lazy) {
+					while (hashed < pos + len)
+						insert_hash(hashed++);
+				}
+				else
+					hashed = pos + len;
+				pos += len;
+			}
+			else {
+				output_literal(text[pos]);
+				pos++;
+			}
+			continue;
+		}
+
+		/* lazy evaluation: the match at pos - 1 waits for this one */
+		len = THRESHOLD - 1;
+		if (prev_length < max_lazy && max_len >= THRESHOLD) {
+			len = longest_match(pos, max_len, prev_length, &dist);
+			if (len <= prev_length || (len == THRESHOLD && dist > TOO_FAR))
+				len = THRESHOLD - 1;
+		}
+
+		if (match_available && prev_length >= THRESHOLD && len <= prev_length) {
+			int end = pos - 1 + prev_length;
+
+			output_match(prev_length, prev_dist);
+			while (hashed < end)
+				insert_hash(hashed++);
+			pos             = end;
+			match_available = false;
+			prev_length     = THRESHOLD - 1;
+		}
+		else {
+			if (match_available)
+				output_literal(text[pos - 1]);
+			match_available = true;
+			prev_length     = len;
+			prev_dist       = dist;
+			pos++;
+		}
+	}
+
+	if (flush && match_available) {
+		if (prev_length >= THRESHOLD)
+			output_match(prev_length, prev_dist);
+		else
+			output_literal(text[pos - 1]);
+		match_available = false;
+		prev_length     = THRESHOLD - 1;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Huffman blocks
+//////////////////////////////////////////////////////////////////////
+
+inline void LHAEncoder::output_literal(int c)
+{
+	c_buf[c_count++] = (uint16_t)c;
+	c_freq[c]++;
+	if (c_count == LZH_BLOCK_SYMBOLS)
+		send_block();
+}
+
+inline void LHAEncoder::output_match(int len, int dist)
+{
+	int c = len + (UCHAR_MAX + 1 - THRESHOLD);
+	int p = dist - 1;
+
+	c_buf[c_count++] = (uint16_t)c;
+	p_buf[p_count++] = (uint16_t)p;
+	c_freq[c]++;
+	p_freq[bit_length(p)]++;
+	if (c_count == LZH_BLOCK_SYMBOLS)
+		send_block();
+}
+
+/*
+ * block
+ *
+ *   16      number of symbols
+ *   t-tree  code lengths of the c-length codes (TBIT count, 3-bit/unary)
+ *   c-tree  code lengths of literals and lengths, run-length coded
+ *   p-tree  code lengths of the position classes (pbit count)
+ *   ...     symbols; a match is followed by its position class and the
+ *           low bits of the position
+ *
+ * A tree with a single symbol is sent as a count of 0 and that symbol.
+ */
+void LHAEncoder::send_block()
+{
+	unsigned int i, j;
+	int          root;
+
+	putbits(16, c_count);
+
+	root = make_tree(NC, c_freq, c_len, c_code);
+	if (root >= NC) {
+		int n = NC;
+
+		memset(t_freq, 0, sizeof(t_freq));
+		while (n > 0 && c_len[n - 1] == 0)
+			n--;
+		for (i = 0; i < (unsigned int)n; ) {
+			int k = c_len[i++];
+
+			if (k == 0) {
+				int count = 1;
+				while (i < (unsigned int)n && c_len[i] == 0) {
+					i++;
+					count++;
+				}
+				if (count <= 2)
+					t_freq[0] += count;
+				else if (count <= 18)
+					t_freq[1]++;
+				else if (count == 19) {
+					t_freq[0]++;
+					t_freq[1]++;
+				}
+				else
+					t_freq[2]++;
+			}
+			else
+				t_freq[k + 2]++;
+		}
+
+		root = make_tree(NT, t_freq, pt_len, pt_code);
+		if (root >= NT)
+			write_pt_len(NT, TBIT, 3);
+		else {
+			putbits(TBIT, 0);
+			putbits(TBIT, root);
+		}
+		write_c_len();
+	}
+	else {
+		putbits(TBIT, 0);
+		putbits(TBIT, 0);
+		putbits(CBIT, 0);
+		putbits(CBIT, root);
+	}
+
+	root = make_tree(np, p_freq, pt_len, pt_code);
+	if (root >= np)
+		write_pt_len(np, pbit, -1);
+	else {
+		putbits(pbit, 0);
+		putbits(pbit, root);
+	}
+
+	for (i = 0, j = 0; i < c_count; i++) {
+		unsigned int c = c_buf[i];
+
+		putbits(c_len[c], c_code[c]);
+		if (c > UCHAR_MAX) {
+			unsigned int p = p_buf[j++];
+			int          k = bit_length(p);
+
+			putbits(pt_len[k], pt_code[k]);
+			if (k > 1)
+				putbits(k - 1, p);
+		}
+	}
+
+	c_count = 0;
+	p_count = 0;
+	memset(c_freq, 0, sizeof(c_freq));
+	memset(p_freq, 0, sizeof(p_freq));
+}
+
+/* lengths up to 6 in 3 bits, longer ones as (len - 3) bits 1..10 */
+void LHAEncoder::write_pt_len(int n, int nbit, int i_special)
+{
+	int i, k;
+
+	while (n > 0 && pt_len[n - 1] == 0)
+		n--;
+	putbits(nbit, n);
+
+	i = 0;
+	while (i < n) {
+		k = pt_len[i++];
+		if (k <= 6)
+			putbits(3, k);
+		else
+			putbits(k - 3, (1U << (k - 3)) - 2);
+		if (i == i_special) {
+			while (i < 6 && pt_len[i] == 0)
+				i++;
+			putbits(2, i - 3);
+		}
+	}
+}
+
+/* c lengths through the t-tree: 0 and 1 (+4 bits) and 2 (+CBIT) are zero runs */
+void LHAEncoder::write_c_len()
+{
+	int i, k, n, count;
+
+	n = NC;
+	while (n > 0 && c_len[n - 1] == 0)
+		n--;
+	putbits(CBIT, n);
+
+	i = 0;
+	while (i < n) {
+		k = c_len[i++];
+		if (k == 0) {
+			count = 1;
+			while (i < n && c_len[i] == 0) {
+				i++;
+				count++;
+			}
+			if (count <= 2) {
+				for (k = 0; k < count; k++)
+					putbits(pt_len[0], pt_code[0]);
+			}
+			else if (count <= 18) {
+				putbits(pt_len[1], pt_code[1]);
+				putbits(4, count - 3);
+			}
+			else if (count == 19) {
+				putbits(pt_len[0], pt_code[0]);
+				putbits(pt_len[1], pt_code[1]);
+				putbits(4, 15);
+			}
+			else {
+				putbits(pt_len[2], pt_code[2]);
+				putbits(CBIT, count - 20);
+			}
+		}
+		else
+			putbits(pt_len[k + 2], pt_code[k + 2]);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Bit writer
+//////////////////////////////////////////////////////////////////////
+
+/* n must be 0 .. 16; only the low n bits of x are written */
+inline void LHAEncoder::putbits(int n, unsigned int x)
+{
+	if (n == 0)
+		return;
+
+	bitbuf   |= (uint64_t)(x & ((1U << n) - 1)) << (64 - n - bitcount);
+	bitcount += n;
+	if (bitcount >= 32) {
+		outbuf[outpos++] = (unsigned char)(bitbuf >> 56);
+		outbuf[outpos++] = (unsigned char)(bitbuf >> 48);
+		outbuf[outpos++] = (unsigned char)(bitbuf >> 40);
+		outbuf[outpos++] = (unsigned char)(bitbuf >> 32);
+		bitbuf  <<= 32;
+		bitcount -= 32;
+		if (outpos > LZH_OUTBUF_SIZE - 4)
+			flush_output();
+	}
+}
+
+/* pad the last byte with zero bits */
+void LHAEncoder::flush_bits()
+{
+	while (bitcount > 0) {
+		outbuf[outpos++] = (unsigned char)(bitbuf >> 56);
+		bitbuf  <<= 8;
+		bitcount -= 8;
+	}
+	bitbuf   = 0;
+	bitcount = 0;
+}
+
+void LHAEncoder::flush_output()
+{
+	if (outpos == 0)
+		return;
+	if (!failed && !proc(param, outbuf, outpos))
+		failed = true;
+	packed_size += outpos;
+	outpos = 0;
+}
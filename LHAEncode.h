@@ -0,0 +1,115 @@
+// LHAEncode.h: interface for the LHAEncoder class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#if !defined(AFX_LHAENCODE_H__066E56E6_72BC_4C82_AE0E_9DAF4BE8ED2D__INCLUDED_)
+#define AFX_LHAENCODE_H__066E56E6_72BC_4C82_AE0E_9DAF4BE8ED2D__INCLUDED_
+
+#if _MSC_VER > 1000
+#pragma once
+#endif // _MSC_VER > 1000
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "LHADecode.h"
+
+#define LZH_LEVEL_MIN           1       /* fastest */
+#define LZH_LEVEL_MAX           9       /* smallest */
+#define LZH_LEVEL_DEFAULT       6
+
+#define LZH_BLOCK_SYMBOLS       0x4000  /* literals and matches per Huffman block */
+#define LZH_OUTBUF_SIZE         0x8000
+
+/*
+ * Streaming -lh5-/-lh6-/-lh7- compressor.
+ *
+ * Input passes through a window of twice the dictionary size.  Matches
+ * are found on hash chains over 3-byte prefixes; the level bounds the
+ * chain walk and turns on lazy evaluation (a match is deferred if the
+ * next position has a longer one).  Every LZH_BLOCK_SYMBOLS tokens are
+ * sent as one static Huffman block with length-limited canonical codes,
+ * the format LHADecoder reads.  The CRC-16 of the input is taken as it
+ * is fed in.
+ *
+ *     begin(LZHUFF5_METHOD_NUM, level, proc, param);
+ *     while (...) write(buf, n);
+ *     finish();                // crc, original_size, packed_size
+ */
+class LHAEncoder
+{
+public:
+	bool begin(int method, int level, LHAOutputProc proc, void *param);
+	bool write(const void *buf, size_t len);
+	bool finish();
+	static bool method_supported(int method);
+	LHAEncoder();
+	virtual ~LHAEncoder();
+public:
+	unsigned int    crc;            /* CRC-16 of the input so far */
+	uint64_t        original_size;
+	uint64_t        packed_size;
+private:
+	void compress(bool flush);
+	int  longest_match(int cur, int max_len, int prev_len, int *dist);
+	void insert_hash(int i);
+	void slide();
+	void output_literal(int c);
+	void output_match(int len, int dist);
+	void send_block();
+	void write_pt_len(int n, int nbit, int i_special);
+	void write_c_len();
+	void putbits(int n, unsigned int x);
+	void flush_bits();
+	void flush_output();
+
+	LHAOutputProc   proc;
+	void            *param;
+	bool            failed;
+
+	/* window */
+	int             dicbit;
+	int             dicsiz;
+	int             bufsiz;         /* 2 * dicsiz + lookahead */
+	unsigned char   *text;
+	int32_t         *head;          /* newest position of each hash */
+	int32_t         *prev;          /* older position with the same hash */
+	int             pos;            /* next position to encode */
+	int             avail;          /* end of the input in text */
+	int             hashed;         /* positions below this are hashed */
+
+	/* level */
+	int             max_chain;
+	int             nice_length;
+	int             max_lazy;       /* greedy: longest match whose tail is hashed */
+	bool            lazy;
+	bool            match_available;
+	int             prev_length;
+	int             prev_dist;
+
+	/* current block */
+	uint16_t        *c_buf;
+	uint16_t        *p_buf;
+	unsigned int    c_count;
+	unsigned int    p_count;
+	unsigned int    c_freq[LZH_NC];
+	unsigned int    p_freq[LZH_NPT];
+	unsigned int    t_freq[LZH_NT];
+	int             np;
+	int             pbit;
+	unsigned char   c_len[LZH_NC];
+	unsigned char   pt_len[LZH_NPT];
+	uint16_t        c_code[LZH_NC];
+	uint16_t        pt_code[LZH_NPT];
+
+	/* output */
+	uint64_t        bitbuf;         /* pending bits, MSB first */
+	int             bitcount;
+	unsigned char   outbuf[LZH_OUTBUF_SIZE];
+	size_t          outpos;
+
+	LHAEncoder(const LHAEncoder &);
+	LHAEncoder &operator=(const LHAEncoder &);
+};
+
+#endif // !defined(AFX_LHAENCODE_H__066E56E6_72BC_4C82_AE0E_9DAF4BE8ED2D__INCLUDED_)
@@ -0,0 +1,235 @@
+// LHAIndex.cpp: implementation of the LHAIndex class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef LHAPACK_STANDALONE
+#include "stdafx.h"
+#endif
+#include "LHAIndex.h"
+#include "LHAArchive.h"
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/*
+ * index file
+ *
+ *   offset  size  field
+ *  -----------------------------------------
+ *        0     8  magic "LHAINDEX"
+ *        8     4  byte order (0x01020304 as written)
+ *       12     4  version
+ *       16     8  archive size
+ *       24     8  archive modification time
+ *       32     4  number of members
+ *       36     4  number of hash slots (a power of 2)
+ *       40     4  size of the name arena
+ *       44     4  sizeof(LHAListEntry)
+ *  -----------------------------------------
+ *       48     8 * slots        hash, member index + 1
+ *              56 * members     LHAListEntry
+ *              names            NUL-terminated, back to back
+ */
+#define INDEX_MAGIC         "LHAINDEX"
+#define INDEX_BYTE_ORDER    0x01020304
+#define INDEX_VERSION       1
+
+struct IndexFileHeader {
+    char        magic[8];
+    uint32_t    byte_order;
+    uint32_t    version;
+    uint64_t    archive_size;
+    int64_t     archive_modified;
+    uint32_t    count;
+    uint32_t    nslots;
+    uint32_t    names_size;
+    uint32_t    entry_size;
+};
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+LHAIndex::LHAIndex()
+{
+	slots      = NULL;
+	entries    = NULL;
+	names      = NULL;
+	count      = 0;
+	nslots     = 0;
+	names_size = 0;
+}
+
+LHAIndex::~LHAIndex()
+{
+	close();
+}
+
+void LHAIndex::close()
+{
+	map.close();
+	slots      = NULL;
+	entries    = NULL;
+	names      = NULL;
+	count      = 0;
+	nslots     = 0;
+	names_size = 0;
+}
+
+/*
+ * Map the index at path.  Fails if it is missing, damaged, from another
+ * version or byte order, or was built from a different state of archive
+ * (size or modification time); build() it again then.
+ */
+bool LHAIndex::open(const char *path, const LHAArchive &archive)
+{
+	close();
+
+	if (!archive.is_open() || !map.open(path, LHAFileMap::ACCESS_RANDOM))
+		return false;
+
+	if (!attach(archive)) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool LHAIndex::attach(const LHAArchive &archive)
+{
+	IndexFileHeader h;
+	uint64_t        need;
+
+	if (map.size() < sizeof(h))
+		return false;
+	memcpy(&h, map.data(), sizeof(h));
+
+	if (memcmp(h.magic, INDEX_MAGIC, sizeof(h.magic)) != 0 ||
+	    h.byte_order != INDEX_BYTE_ORDER ||
+	    h.version    != INDEX_VERSION ||
+	    h.entry_size != sizeof(LHAListEntry))
+		return false;
+
+	if (h.archive_size != archive.size() || h.archive_modified != archive.modified())
+		return false;       /* stale */
+
+	if (h.nslots == 0 || (h.nslots & (h.nslots - 1)) != 0 || h.count >= h.nslots)
+		return false;
+
+	need = sizeof(h) + (uint64_t)h.nslots * sizeof(Slot) +
+	       (uint64_t)h.count * sizeof(LHAListEntry) + h.names_size;
+	if (need != map.size())
+		return false;
+
+	slots      = (const Slot *)(map.data() + sizeof(h));
+	entries    = (const LHAListEntry *)(slots + h.nslots);
+	names      = (const char *)(entries + h.count);
+	count      = h.count;
+	nslots     = h.nslots;
+	names_size = h.names_size;
+	return true;
+}
+
+/*
+ * The member called name (the full path, as in LHAHeader::name), or NULL.
+ * With several members of that name, the first in the archive.
+ */
+const LHAListEntry *LHAIndex::find(const char *name) const
+{
+	size_t   len;
+	uint32_t h;
+	size_t   i;
+
+	if (slots == NULL)
+		return NULL;
+
+	len = strlen(name);
+	h   = LHAListing::hash_name(name, len);
+
+	for (i = h & (nslots - 1); slots[i].entry; i = (i + 1) & (nslots - 1)) {
+		const LHAListEntry *e;
+
+		if (slots[i].hash != h || slots[i].entry > count)
+			continue;
+		e = &entries[slots[i].entry - 1];
+		if (e->name_length == len && (uint64_t)e->name + len < names_size &&
+		    memcmp(names + e->name, name, len) == 0)
+			return e;
+	}
+	return NULL;
+}
+
+/*
+ * List archive and write its index to path, then open it.  The file is
+ * written under a temporary name and renamed into place, so a reader
+ * never maps half an index.
+ */
+bool LHAIndex::build(const char *path, LHAArchive &archive)
+{
+	LHAListing          listing;
+	IndexFileHeader     h;
+	std::vector<Slot>   table;
+	std::string         tmp = std::string(path) + ".tmp";
+	FILE                *fp;
+	size_t              i, n;
+	bool                ok;
+
+	close();
+
+	if (!listing.read(archive) || listing.size() > UINT32_MAX / 2)
+		return false;
+
+	for (n = 8; n < listing.size() * 2; n <<= 1)
+		;
+	table.resize(n);
+	memset(&table[0], 0, n * sizeof(Slot));
+
+	for (i = 0; i < listing.size(); i++) {
+		const LHAListEntry &e = listing[i];
+		uint32_t hash = LHAListing::hash_name(listing.name(i), e.name_length);
+		size_t   j;
+
+		for (j = hash & (n - 1); table[j].entry; j = (j + 1) & (n - 1))
+			;
+		table[j].hash  = hash;
+		table[j].entry = (uint32_t)i + 1;
+	}
+
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, INDEX_MAGIC, sizeof(h.magic));
+	h.byte_order       = INDEX_BYTE_ORDER;
+	h.version          = INDEX_VERSION;
+	h.archive_size     = archive.size();
+	h.archive_modified = archive.modified();
+	h.count            = (uint32_t)listing.size();
+	h.nslots           = (uint32_t)n;
+	h.names_size       = (uint32_t)listing.names.size();
+	h.entry_size       = sizeof(LHAListEntry);
+
+	fp = fopen(tmp.c_str(), "wb");
+	if (fp == NULL)
+		return false;
+	ok = fwrite(&h, sizeof(h), 1, fp) == 1 &&
+	     fwrite(&table[0], sizeof(Slot), n, fp) == n &&
+	     (listing.entries.empty() ||
+	      fwrite(&listing.entries[0], sizeof(LHAListEntry), listing.entries.size(), fp) == listing.entries.size()) &&
+	     (listing.names.empty() ||
+	      fwrite(&listing.names[0], 1, listing.names.size(), fp) == listing.names.size());
+	if (fclose(fp) != 0)
+		ok = false;
+
+#ifdef _WIN32
+	if (ok)
+		ok = MoveFileExA(tmp.c_str(), path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	if (ok)
+		ok = rename(tmp.c_str(), path) == 0;
+#endif
+	if (!ok) {
+		remove(tmp.c_str());
+		return false;
+	}
+
+	return open(path, archive);
+}
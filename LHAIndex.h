@@ -0,0 +1,69 @@
+// LHAIndex.h: interface for the LHAIndex class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#if !defined(AFX_LHAINDEX_H__A0507EC6_9AE1_4638_95A5_7B5BCD103695__INCLUDED_)
+#define AFX_LHAINDEX_H__A0507EC6_9AE1_4638_95A5_7B5BCD103695__INCLUDED_
+
+#if _MSC_VER > 1000
+#pragma once
+#endif // _MSC_VER > 1000
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "LHAPort.h"
+#include "LHAListing.h"
+
+class LHAArchive;
+
+/*
+ * Persistent member index kept next to an archive ("sidecar").
+ *
+ * build() lists the archive once and writes a hash table of the member
+ * names, the LHAListEntry of every member and the names themselves to
+ * one file.  open() maps that file and checks that it was built from an
+ * archive of the same size and modification time; find() is then one
+ * hash probe, with no header of the archive read.  Pass the entry's
+ * offset to LHAArchive::at() to get at the member.
+ *
+ * The file is in host byte order and is rebuilt rather than converted
+ * when that does not match.
+ */
+class LHAIndex
+{
+public:
+	bool open(const char *path, const LHAArchive &archive);
+	bool build(const char *path, LHAArchive &archive);
+	void close();
+	bool is_open() const                                { return map.is_open(); }
+
+	const LHAListEntry *find(const char *name) const;
+	size_t size() const                                 { return count; }
+	const LHAListEntry &operator[](size_t i) const      { return entries[i]; }
+	const char *name(size_t i) const                    { return names + entries[i].name; }
+	const char *name(const LHAListEntry &entry) const   { return names + entry.name; }
+
+	LHAIndex();
+	virtual ~LHAIndex();
+private:
+	struct Slot {
+	    uint32_t    hash;
+	    uint32_t    entry;          /* index + 1; 0: empty */
+	};
+
+	bool attach(const LHAArchive &archive);
+
+	LHAFileMap          map;
+	const Slot          *slots;
+	const LHAListEntry  *entries;
+	const char          *names;
+	size_t              count;
+	size_t              nslots;     /* a power of 2 */
+	size_t              names_size;
+
+	LHAIndex(const LHAIndex &);
+	LHAIndex &operator=(const LHAIndex &);
+};
+
+#endif // !defined(AFX_LHAINDEX_H__A0507EC6_9AE1_4638_95A5_7B5BCD103695__INCLUDED_)
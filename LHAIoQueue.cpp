@@ -0,0 +1,403 @@
+// LHAIoQueue.cpp: implementation of the LHAIoQueue class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef LHAPACK_STANDALONE
+#include "stdafx.h"
+#endif
+#include "LHAIoQueue.h"
+
+#include <errno.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(IORING_FEAT_RW_CUR_POS)
+#define IOQ_HAVE_URING
+#endif
+#endif
+#endif
+
+enum {
+    IOQ_READ,
+    IOQ_WRITE,
+    IOQ_NOP
+};
+
+//////////////////////////////////////////////////////////////////////
+// Synchronous I/O
+//////////////////////////////////////////////////////////////////////
+
+int64_t LHAIoQueue::read_at(int fd, void *buf, size_t len, uint64_t offset)
+{
+#ifdef _WIN32
+    int n;
+
+    if (_lseeki64(fd, (__int64)offset, SEEK_SET) < 0)
+        return -errno;
+    n = _read(fd, buf, (unsigned int)len);
+    return n < 0 ? -errno : n;
+#else
+    ssize_t n;
+
+    do
+        n = pread(fd, buf, len, (off_t)offset);
+    while (n < 0 && errno == EINTR);
+    return n < 0 ? -errno : n;
+#endif
+}
+
+int64_t LHAIoQueue::write_at(int fd, const void *buf, size_t len, uint64_t offset)
+{
+#ifdef _WIN32
+    int n;
+
+    if (_lseeki64(fd, (__int64)offset, SEEK_SET) < 0)
+        return -errno;
+    n = _write(fd, buf, (unsigned int)len);
+    return n < 0 ? -errno : n;
+#else
+    ssize_t n;
+
+    do
+        n = pwrite(fd, buf, len, (off_t)offset);
+    while (n < 0 && errno == EINTR);
+    return n < 0 ? -errno : n;
+#endif
+}
+
+#ifdef IOQ_HAVE_URING
+/*
+ * The kernel takes at most what is in the submission queue, so asking it
+ * to submit a whole ring's worth submits exactly what is there.
+ */
+static int ring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+LHAIoQueue::LHAIoQueue()
+{
+	ring_fd      = -1;
+	pending      = 0;
+	sq_ring      = NULL;
+	cq_ring      = NULL;
+	sqes         = NULL;
+	sq_ring_size = 0;
+	cq_ring_size = 0;
+	sqes_size    = 0;
+	sq_head      = NULL;
+	sq_tail      = NULL;
+	sq_mask      = NULL;
+	sq_entries   = NULL;
+	sq_array     = NULL;
+	cq_head      = NULL;
+	cq_tail      = NULL;
+	cq_mask      = NULL;
+	cqes         = NULL;
+}
+
+LHAIoQueue::~LHAIoQueue()
+{
+	close();
+}
+
+/*
+ * Set up for `entries' outstanding requests, on an io_uring if async and
+ * the system has one, synchronously otherwise.
+ */
+bool LHAIoQueue::open(unsigned entries, bool async)
+{
+	close();
+
+#ifdef IOQ_HAVE_URING
+	if (async && entries && open_ring(entries))
+		return true;
+#else
+	(void)entries;
+	(void)async;
+#endif
+	return true;
+}
+
+bool LHAIoQueue::open_ring(unsigned entries)
+{
+#ifdef IOQ_HAVE_URING
+	struct io_uring_params p;
+	int fd;
+
+	memset(&p, 0, sizeof(p));
+	fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+	if (fd < 0)
+		return false;               /* no io_uring, or not allowed to use it */
+	if ((p.features & IORING_FEAT_RW_CUR_POS) == 0) {
+		::close(fd);                /* before 5.6: no IORING_OP_READ/WRITE */
+		return false;
+	}
+
+	sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (sq_ring_size < cq_ring_size)
+			sq_ring_size = cq_ring_size;
+		cq_ring_size = 0;           /* shares the sq ring mapping */
+	}
+	sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+
+	ring_fd = fd;
+	sq_ring = mmap(NULL, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if (sq_ring == MAP_FAILED) {
+		sq_ring = NULL;
+		close();
+		return false;
+	}
+	if (cq_ring_size) {
+		cq_ring = mmap(NULL, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		if (cq_ring == MAP_FAILED) {
+			cq_ring = NULL;
+			close();
+			return false;
+		}
+	}
+	sqes = mmap(NULL, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (sqes == MAP_FAILED) {
+		sqes = NULL;
+		close();
+		return false;
+	}
+
+	char *sq = (char *)sq_ring;
+	char *cq = cq_ring ? (char *)cq_ring : (char *)sq_ring;
+
+	sq_head    = (unsigned *)(sq + p.sq_off.head);
+	sq_tail    = (unsigned *)(sq + p.sq_off.tail);
+	sq_mask    = (unsigned *)(sq + p.sq_off.ring_mask);
+	sq_entries = (unsigned *)(sq + p.sq_off.ring_entries);
+	sq_array   = (unsigned *)(sq + p.sq_off.array);
+	cq_head    = (unsigned *)(cq + p.cq_off.head);
+	cq_tail    = (unsigned *)(cq + p.cq_off.tail);
+	cq_mask    = (unsigned *)(cq + p.cq_off.ring_mask);
+	cqes       = cq + p.cq_off.cqes;
+	return true;
+#else
+	(void)entries;
+	return false;
+#endif
+}
+
+void LHAIoQueue::close()
+{
+#ifdef IOQ_HAVE_URING
+	if (sqes)
+		munmap(sqes, sqes_size);
+	if (cq_ring)
+		munmap(cq_ring, cq_ring_size);
+	if (sq_ring)
+		munmap(sq_ring, sq_ring_size);
+	if (ring_fd >= 0)
+		::close(ring_fd);
+#endif
+	ring_fd = -1;
+	pending = 0;
+	sq_ring = NULL;
+	cq_ring = NULL;
+	sqes    = NULL;
+
+	std::lock_guard<std::mutex> guard(lock);
+	done.clear();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Requests
+//////////////////////////////////////////////////////////////////////
+
+/* read up to len (at most LHA_IO_MAX) bytes at offset */
+bool LHAIoQueue::read(int fd, void *buf, size_t len, uint64_t offset, uint64_t tag)
+{
+	return queue(IOQ_READ, fd, buf, len, offset, tag);
+}
+
+/* write up to len (at most LHA_IO_MAX) bytes at offset */
+bool LHAIoQueue::write(int fd, const void *buf, size_t len, uint64_t offset, uint64_t tag)
+{
+	return queue(IOQ_WRITE, fd, buf, len, offset, tag);
+}
+
+/* a request that does nothing but complete: wakes up wait() */
+bool LHAIoQueue::nop(uint64_t tag)
+{
+	return queue(IOQ_NOP, -1, NULL, 0, 0, tag);
+}
+
+bool LHAIoQueue::queue(int op, int fd, const void *buf, size_t len, uint64_t offset, uint64_t tag)
+{
+	if (len > LHA_IO_MAX)
+		return false;
+
+#ifdef IOQ_HAVE_URING
+	if (ring_fd >= 0) {
+		std::lock_guard<std::mutex> guard(lock);
+		struct io_uring_sqe *sqe;
+		unsigned tail = *sq_tail, index;
+
+		if (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= *sq_entries) {
+			ring_enter(ring_fd, *sq_entries, 0, 0);
+			if (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= *sq_entries)
+				return false;       /* more outstanding than the ring was opened for */
+		}
+
+		index = tail & *sq_mask;
+		sqe   = (struct io_uring_sqe *)sqes + index;
+		memset(sqe, 0, sizeof(*sqe));
+		sqe->opcode    = op == IOQ_READ  ? IORING_OP_READ :
+		                 op == IOQ_WRITE ? IORING_OP_WRITE : IORING_OP_NOP;
+		sqe->fd        = fd;
+		sqe->addr      = (uint64_t)(uintptr_t)buf;
+		sqe->len       = (uint32_t)len;
+		sqe->off       = offset;
+		sqe->user_data = tag;
+
+		sq_array[index] = index;
+		__atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+		__atomic_fetch_add(&pending, 1, __ATOMIC_RELEASE);
+		return true;
+	}
+#endif
+
+	int64_t result = 0;
+
+	if (op == IOQ_READ)
+		result = read_at(fd, (void *)buf, len, offset);
+	else if (op == IOQ_WRITE)
+		result = write_at(fd, buf, len, offset);
+	complete(tag, result);
+	return true;
+}
+
+void LHAIoQueue::complete(uint64_t tag, int64_t result)
+{
+	Completion c = { tag, result };
+
+	std::lock_guard<std::mutex> guard(lock);
+	done.push_back(c);
+	posted.notify_one();
+}
+
+/* hand the queued requests to the kernel */
+bool LHAIoQueue::submit()
+{
+#ifdef IOQ_HAVE_URING
+	if (ring_fd >= 0) {
+		int r;
+
+		do
+			r = ring_enter(ring_fd, *sq_entries, 0, 0);
+		while (r < 0 && errno == EINTR);
+		/* EAGAIN, EBUSY: left in the ring for the next wait() to submit */
+		return r >= 0 || errno == EAGAIN || errno == EBUSY;
+	}
+#endif
+	return true;
+}
+
+/* the next completion; blocks until there is one */
+bool LHAIoQueue::wait(uint64_t *tag, int64_t *result)
+{
+#ifdef IOQ_HAVE_URING
+	if (ring_fd >= 0) {
+		while (!reap(tag, result))
+			if (ring_enter(ring_fd, *sq_entries, 1, IORING_ENTER_GETEVENTS) < 0 &&
+			    errno != EINTR && errno != EAGAIN && errno != EBUSY)
+				return false;
+		return true;
+	}
+#endif
+
+	std::unique_lock<std::mutex> guard(lock);
+	while (done.empty())
+		posted.wait(guard);
+	*tag    = done.front().tag;
+	*result = done.front().result;
+	done.pop_front();
+	return true;
+}
+
+/* the next completion if there is one already */
+bool LHAIoQueue::poll(uint64_t *tag, int64_t *result)
+{
+#ifdef IOQ_HAVE_URING
+	if (ring_fd >= 0)
+		return reap(tag, result);
+#endif
+
+	std::lock_guard<std::mutex> guard(lock);
+	if (done.empty())
+		return false;
+	*tag    = done.front().tag;
+	*result = done.front().result;
+	done.pop_front();
+	return true;
+}
+
+/*
+ * Wait for every request queued so far and throw the completions away,
+ * after which the kernel is done with their buffers.  False if the ring
+ * fails first; then it may still be using them until close().  Called
+ * from the thread that waits.
+ */
+bool LHAIoQueue::drain()
+{
+#ifdef IOQ_HAVE_URING
+	if (ring_fd >= 0) {
+		uint64_t tag;
+		int64_t  result;
+
+		while (__atomic_load_n(&pending, __ATOMIC_ACQUIRE)) {
+			if (reap(&tag, &result))
+				continue;
+			if (ring_enter(ring_fd, *sq_entries, 1, IORING_ENTER_GETEVENTS) < 0 &&
+			    errno != EINTR && errno != EAGAIN && errno != EBUSY)
+				return false;
+		}
+	}
+#endif
+
+	std::lock_guard<std::mutex> guard(lock);
+	done.clear();
+	return true;
+}
+
+bool LHAIoQueue::reap(uint64_t *tag, int64_t *result)
+{
+#ifdef IOQ_HAVE_URING
+	unsigned head = *cq_head;       /* only the reaping thread moves it */
+
+	if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+		return false;
+
+	struct io_uring_cqe *cqe = (struct io_uring_cqe *)cqes + (head & *cq_mask);
+	*tag    = cqe->user_data;
+	*result = cqe->res;
+	__atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+	__atomic_fetch_sub(&pending, 1, __ATOMIC_RELEASE);
+	return true;
+#else
+	(void)tag;
+	(void)result;
+	return false;
+#endif
+}
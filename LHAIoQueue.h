@@ -0,0 +1,93 @@
+// LHAIoQueue.h: interface for the LHAIoQueue class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#if !defined(AFX_LHAIOQUEUE_H__41E4E17B_2FEE_4DA4_9A2C_BA2BA60FFAE4__INCLUDED_)
+#define AFX_LHAIOQUEUE_H__41E4E17B_2FEE_4DA4_9A2C_BA2BA60FFAE4__INCLUDED_
+
+#if _MSC_VER > 1000
+#pragma once
+#endif // _MSC_VER > 1000
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+#define LHA_IO_MAX              0x40000000  /* largest single read or write */
+
+/*
+ * Queue of positioned reads and writes with completions.
+ *
+ * On Linux the requests go to an io_uring, driven with the raw system
+ * calls; elsewhere, or where the kernel refuses one, each request is done
+ * on the spot with pread()/pwrite() and its completion queued.  Either
+ * way the caller sees the same thing: requests carry a tag, and wait()
+ * returns the tag and result (bytes transferred, or -errno) of one that
+ * has finished; poll() does the same without blocking.  A read or write
+ * may transfer less than asked for.
+ *
+ * Requests may be queued and submitted from any thread; wait() and poll()
+ * must only be called from one.  The caller keeps no more than `entries'
+ * requests outstanding.
+ */
+class LHAIoQueue
+{
+public:
+	bool open(unsigned entries, bool async = true);
+	void close();
+	bool is_async() const   { return ring_fd >= 0; }
+
+	bool read(int fd, void *buf, size_t len, uint64_t offset, uint64_t tag);
+	bool write(int fd, const void *buf, size_t len, uint64_t offset, uint64_t tag);
+	bool nop(uint64_t tag);
+	bool submit();
+	bool wait(uint64_t *tag, int64_t *result);
+	bool poll(uint64_t *tag, int64_t *result);
+	bool drain();
+
+	/* synchronous, as the fallback does them */
+	static int64_t read_at(int fd, void *buf, size_t len, uint64_t offset);
+	static int64_t write_at(int fd, const void *buf, size_t len, uint64_t offset);
+
+	LHAIoQueue();
+	virtual ~LHAIoQueue();
+private:
+	struct Completion {
+		uint64_t    tag;
+		int64_t     result;
+	};
+
+	bool open_ring(unsigned entries);
+	bool reap(uint64_t *tag, int64_t *result);
+	bool queue(int op, int fd, const void *buf, size_t len, uint64_t offset, uint64_t tag);
+	void complete(uint64_t tag, int64_t result);
+
+	std::mutex                  lock;       /* submission side */
+	std::condition_variable     posted;     /* a synchronous completion was queued */
+	std::deque<Completion>      done;
+
+	int             ring_fd;
+	unsigned        pending;    /* ring requests queued and not yet reaped */
+	void            *sq_ring;
+	void            *cq_ring;
+	void            *sqes;
+	size_t          sq_ring_size;
+	size_t          cq_ring_size;
+	size_t          sqes_size;
+	unsigned        *sq_head;
+	unsigned        *sq_tail;
+	unsigned        *sq_mask;
+	unsigned        *sq_entries;
+	unsigned        *sq_array;
+	unsigned        *cq_head;
+	unsigned        *cq_tail;
+	unsigned        *cq_mask;
+	void            *cqes;
+
+	LHAIoQueue(const LHAIoQueue &);
+	LHAIoQueue &operator=(const LHAIoQueue &);
+};
+
+#endif // !defined(AFX_LHAIOQUEUE_H__41E4E17B_2FEE_4DA4_9A2C_BA2BA60FFAE4__INCLUDED_)
@@ -0,0 +1,264 @@
+// LHAListing.cpp: implementation of the LHAListing class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef LHAPACK_STANDALONE
+#include "stdafx.h"
+#endif
+#include "LHAListing.h"
+#include "LHAArchive.h"
+#include "LHADecode.h"
+#include "LHAThreadPool.h"
+
+#include <string.h>
+
+#define LIST_CHUNK_MIN      (4 << 20)   /* smallest slice read_parallel() gives a task */
+
+/* read_parallel(): the headers found in one slice of the archive */
+struct ListChunk {
+    size_t      from;
+    size_t      to;
+    LHAListing  part;       /* by offset */
+};
+
+struct ListJob {
+    const char              *base;
+    size_t                  length;
+    int                     flags;
+    std::vector<ListChunk>  chunks;
+};
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+LHAListing::LHAListing()
+{
+}
+
+LHAListing::~LHAListing()
+{
+}
+
+void LHAListing::clear()
+{
+	entries.clear();
+	names.clear();
+	slots.clear();
+}
+
+/*
+ * List every member of archive, replacing what was listed before.  Stops
+ * at the end mark or the first bad header, like LHAArchive::iterator;
+ * returns false only if the archive is not open or the arena is full.
+ */
+bool LHAListing::read(LHAArchive &archive)
+{
+	clear();
+	if (!archive.is_open())
+		return false;
+
+	for (LHAArchive::iterator it = archive.begin(); it != archive.end(); ++it)
+		if (!append(it->header, it->offset, it->dataoffset))
+			return false;
+	return true;
+}
+
+/*
+ * read() on `threads' workers (0: one per CPU), for archives so large
+ * that following the chain of headers one after the other is the slow
+ * part.  The file is cut into slices, and each worker scans its slices
+ * for headers (LHAArchive::find_candidate()) and parses whatever it
+ * finds, strictly, so that checksums and header CRCs weed out chance
+ * matches in the packed data.  The chain is then followed from the first
+ * header as read() would: each next header is taken from what the
+ * workers parsed at exactly that offset, and parsed on the spot only
+ * if they have nothing there.  The listing is the same as read()'s.
+ *
+ * Every byte of the archive is read, where read() touches only the
+ * headers: this pays when the latency of one dependent read after
+ * another, not bandwidth, is what limits listing.  On one thread, or
+ * for an archive too small to slice, it is read() itself, and no
+ * workers are started.
+ */
+bool LHAListing::read_parallel(LHAArchive &archive, int threads)
+{
+	ListJob             job;
+	std::vector<size_t> tasks;
+	size_t              chunk, i, c;
+	uint64_t            offset = 0;
+
+	if (threads <= 0)
+		threads = (int)std::thread::hardware_concurrency();
+	if (!archive.is_open() || threads < 2 || archive.size() < 2 * (size_t)LIST_CHUNK_MIN)
+		return read(archive);
+
+	LHAThreadPool pool(threads);
+
+	clear();
+	job.base   = archive.data();
+	job.length = archive.size();
+	job.flags  = LHA_PARSE_STRICT;
+
+	/* a few slices per worker, so that a slow one holds up nobody */
+	chunk = job.length / ((size_t)pool.threads() * 4) + 1;
+	if (chunk < LIST_CHUNK_MIN)
+		chunk = LIST_CHUNK_MIN;
+	job.chunks = std::vector<ListChunk>((job.length + chunk - 1) / chunk);
+	for (i = 0; i < job.chunks.size(); i++) {
+		job.chunks[i].from = i * chunk;
+		job.chunks[i].to   = i + 1 < job.chunks.size() ? (i + 1) * chunk : job.length;
+		tasks.push_back(i);
+	}
+	pool.run(scan_task, &job, &tasks[0], tasks.size());
+
+	/* stitch: the next header is where the last one's packed data ends */
+	std::vector<size_t> next(job.chunks.size(), 0);
+	for (;;) {
+		if (offset >= job.length)
+			break;
+		c = (size_t)offset / chunk;
+
+		const LHAListing &part = job.chunks[c].part;
+		for (i = next[c]; i < part.size() && part[i].offset < offset; i++)
+			;
+		next[c] = i;
+
+		if (i < part.size() && part[i].offset == offset) {
+			if (!append(part, i))
+				return false;
+		}
+		else {
+			LHAArchive::iterator it = archive.at((size_t)offset);
+			if (it == archive.end())
+				break;
+			if (!append(it->header, it->offset, it->dataoffset))
+				return false;
+		}
+		const LHAListEntry &e = entries.back();
+		offset = e.offset + e.dataoffset + e.packed_size;
+	}
+	return true;
+}
+
+void LHAListing::scan_task(void *param, size_t task, int worker)
+{
+	ListJob   *job   = (ListJob *)param;
+	ListChunk &chunk = job->chunks[task];
+	LHAHeader hdr;
+	size_t    at, dataoffset;
+
+	(void)worker;
+	for (at = chunk.from; ; at++) {
+		at = LHAArchive::find_candidate(job->base, job->length, at, chunk.to);
+		if (at >= chunk.to)
+			break;
+		if (LHAPack::parse_header(job->base + at, job->base + job->length, &hdr, &dataoffset, job->flags) &&
+		    dataoffset <= job->length - at && hdr.packed_size <= job->length - at - dataoffset)
+			chunk.part.append(&hdr, at, dataoffset);
+	}
+}
+
+/* add one member; false if the arena is full */
+bool LHAListing::append(const LHAHeader *hdr, uint64_t offset, size_t dataoffset)
+{
+	size_t       len = strlen(hdr->name);
+	LHAListEntry e;
+
+	if (names.size() + len + 1 > UINT32_MAX)
+		return false;
+
+	memset(&e, 0, sizeof(e));       /* the padding goes into index files too */
+	e.offset        = offset;
+	e.packed_size   = hdr->packed_size;
+	e.original_size = hdr->original_size;
+	e.last_modified = hdr->unix_last_modified_stamp;
+	e.name          = (uint32_t)names.size();
+	e.dataoffset    = (uint32_t)dataoffset;
+	e.name_length   = (uint16_t)len;
+	e.crc           = (uint16_t)hdr->crc;
+	e.unix_mode     = hdr->unix_mode;
+	e.method        = (signed char)LHADecoder::method_number(hdr->method);
+	e.header_level  = hdr->header_level;
+	e.attribute     = hdr->attribute;
+	e.has_crc       = hdr->has_crc ? 1 : 0;
+
+	entries.push_back(e);
+	names.insert(names.end(), hdr->name, hdr->name + len + 1);
+	slots.clear();
+	return true;
+}
+
+/* add entry i of part, name and all */
+bool LHAListing::append(const LHAListing &part, size_t i)
+{
+	LHAListEntry e = part.entries[i];
+
+	if (names.size() + e.name_length + 1 > UINT32_MAX)
+		return false;
+
+	const char *name = &part.names[e.name];
+	e.name = (uint32_t)names.size();
+	entries.push_back(e);
+	names.insert(names.end(), name, name + e.name_length + 1);
+	slots.clear();
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Lookup
+//////////////////////////////////////////////////////////////////////
+
+/* FNV-1a */
+uint32_t LHAListing::hash_name(const char *name, size_t len)
+{
+	uint32_t h = 2166136261U;
+
+	while (len--) {
+		h ^= (unsigned char)*name++;
+		h *= 16777619U;
+	}
+	return h;
+}
+
+/* open addressing, at most half full */
+void LHAListing::hash_names() const
+{
+	size_t i, j, n;
+
+	for (n = 8; n < entries.size() * 2; n <<= 1)
+		;
+	slots.assign(n, 0);
+
+	for (i = 0; i < entries.size(); i++) {
+		const LHAListEntry &e = entries[i];
+
+		for (j = hash_name(&names[e.name], e.name_length) & (n - 1); slots[j]; j = (j + 1) & (n - 1))
+			;
+		slots[j] = (uint32_t)i + 1;
+	}
+}
+
+/*
+ * The member named `name', spelled as in its header; the first of them
+ * if the archive holds the name more than once.  NULL if there is none.
+ */
+const LHAListEntry *LHAListing::find(const char *name) const
+{
+	size_t len = strlen(name);
+	size_t n, i;
+
+	if (entries.empty())
+		return NULL;
+	if (slots.empty())
+		hash_names();
+
+	n = slots.size();
+	for (i = hash_name(name, len) & (n - 1); slots[i]; i = (i + 1) & (n - 1)) {
+		const LHAListEntry &e = entries[slots[i] - 1];
+
+		if (e.name_length == len && memcmp(&names[e.name], name, len) == 0)
+			return &e;
+	}
+	return NULL;
+}
@@ -0,0 +1,76 @@
+// LHAListing.h: interface for the LHAListing class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#if !defined(AFX_LHALISTING_H__9C507F9D_E373_44B5_BC1D_CB294E87757B__INCLUDED_)
+#define AFX_LHALISTING_H__9C507F9D_E373_44B5_BC1D_CB294E87757B__INCLUDED_
+
+#if _MSC_VER > 1000
+#pragma once
+#endif // _MSC_VER > 1000
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+class LHAArchive;
+struct LHAHeader;
+
+/*
+ * One member in a listing: the numeric header fields only.  The name is
+ * kept in the listing's string arena, so an entry is 56 bytes however
+ * long the path is.
+ */
+typedef struct LHAListEntry {
+    uint64_t        offset;         /* of the header, from the archive start */
+    uint64_t        packed_size;
+    uint64_t        original_size;
+    int64_t         last_modified;  /* unix time stamp */
+    uint32_t        name;           /* offset of the name in the arena */
+    uint32_t        dataoffset;     /* of the packed data, from the header */
+    uint16_t        name_length;
+    uint16_t        crc;            /* file CRC */
+    uint16_t        unix_mode;
+    signed char     method;         /* *_METHOD_NUM, UNKNOWN_METHOD_NUM */
+    unsigned char   header_level;
+    unsigned char   attribute;
+    unsigned char   has_crc;
+} LHAListEntry;
+
+/*
+ * Directory of an archive, built in one pass over its headers.  Costs
+ * sizeof(LHAListEntry) plus the name and its terminator per member; the
+ * full LHAHeader is only ever held for the member being parsed.  The
+ * name table behind find() is built on its first call.
+ */
+class LHAListing
+{
+public:
+	bool read(LHAArchive &archive);
+	bool read_parallel(LHAArchive &archive, int threads = 0);
+	bool append(const LHAHeader *hdr, uint64_t offset, size_t dataoffset);
+	void clear();
+
+	size_t size() const                                 { return entries.size(); }
+	const LHAListEntry &operator[](size_t i) const      { return entries[i]; }
+	const char *name(size_t i) const                    { return &names[entries[i].name]; }
+	const char *name(const LHAListEntry &entry) const   { return &names[entry.name]; }
+	const LHAListEntry *find(const char *name) const;
+
+	static uint32_t hash_name(const char *name, size_t len);
+
+	LHAListing();
+	virtual ~LHAListing();
+private:
+	friend class LHAIndex;
+
+	void hash_names() const;
+	bool append(const LHAListing &part, size_t i);
+	static void scan_task(void *param, size_t task, int worker);
+
+	std::vector<LHAListEntry>   entries;
+	std::vector<char>           names;      /* NUL-terminated, back to back */
+	mutable std::vector<uint32_t> slots;    /* entry index + 1, 0: empty; a power of 2 */
+};
+
+#endif // !defined(AFX_LHALISTING_H__9C507F9D_E373_44B5_BC1D_CB294E87757B__INCLUDED_)
@@ -2,60 +2,68 @@
 //
 //////////////////////////////////////////////////////////////////////
 
+#ifndef LHAPACK_STANDALONE
 #include "stdafx.h"
+#endif
 #include "LHAPack.h"
+#include "LHADecode.h"
+#include "LHACrc.h"
+#include "LHAStats.h"
+
+#include <atomic>
 
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
 
-#define CRCPOLY             0xA001      /* CRC-16 (x^16+x^15+x^2+1) */
 #define INITIALIZE_CRC(crc) ((crc) = 0)
-#define UPDATE_CRC(crc, c)  (crctable[((crc) ^ (c)) & 0xFF] ^ ((crc) >> CHAR_BIT))
 
-#define LZHEADER_STORAGE 4096
+/*
+ * Where one header is being read or written.  It lives on the stack of
+ * the call that parses the header, so nothing in the LHAPack object
+ * changes while parsing and any number of threads may parse at once.
+ */
+struct LHACursor {
+    char        *get_ptr;   /* next field to read (or write) */
+    char        *mem_ptr;   /* end of the header read so far */
+    const char  *mem_end;   /* end of the readable range; NULL: unchecked */
+    int         flags;      /* LHA_PARSE_* */
+    bool        has_hcrc;   /* a header crc record was read */
+};
+
+/* read_extended(): the records LHA_PARSE_LAZY passed over, and no others */
+#define PARSE_DEFERRED          0x100
 
-#define GET_BYTE()       (*get_ptr++ & 0xff)
+#define GET_BYTE()       (*cur->get_ptr++ & 0xff)
 
 #define get_byte()       GET_BYTE()
-#define setup_get(PTR)   (get_ptr    = (PTR))
-#define skip_bytes(len)  (get_ptr   += (len))
+#define setup_get(PTR)   (cur->get_ptr    = (PTR))
+#define skip_bytes(len)  (cur->get_ptr   += (len))
 
-#define put_ptr          get_ptr
+#define put_ptr          cur->get_ptr
 #define setup_put(PTR)   ( put_ptr   = (PTR))
 #define put_byte(c)      (*put_ptr++ = (char)(c))
 
 LHAPack::LHAPack()
 {
-	make_crctable();
 	generic_format = false;
+	dataoffset     = 0;
+	modified_stamp = 0;
 }
 
 LHAPack::~LHAPack()
 {
-
 }
 
-void LHAPack::make_crctable()
+unsigned int LHAPack::calccrc(unsigned int crc, const unsigned char *p, unsigned int n)
 {
-	unsigned int    i, j, r;
-	
-    for (i = 0; i <= UCHAR_MAX; i++) {
-        r = i;
-        for (j = 0; j < CHAR_BIT; j++)
-            if (r & 1)
-                r = (r >> 1) ^ CRCPOLY;
-            else
-                r >>= 1;
-			crctable[i] = r;
-    }
+	return LHACrc::calccrc(crc, p, n);
 }
 
-unsigned int LHAPack::calccrc(unsigned int crc, unsigned char *p, unsigned int n)
+/* true if len bytes at p lie inside the range given to get_header() */
+bool LHAPack::readable(const LHACursor *cur, const char *p, size_t len)
 {
-	while (n-- > 0)
-        crc = UPDATE_CRC(crc, *p++);
-    return crc;
+	return NULL == cur->mem_end || (p <= cur->mem_end && len <= (size_t)(cur->mem_end - p));
 }
 
 int LHAPack::calc_sum(char *p, int len)
@@ -65,7 +73,7 @@ int LHAPack::calc_sum(char *p, int len)
     return sum & 0xff;
 }
 
-int LHAPack::get_word()
+int LHAPack::get_word(LHACursor *cur)
 {
 	int b0, b1;
     int w;
@@ -77,13 +85,13 @@ int LHAPack::get_word()
     return w;
 }
 
-void LHAPack::put_word(unsigned int v)
+void LHAPack::put_word(LHACursor *cur, unsigned int v)
 {
 	put_byte(v);
     put_byte(v >> 8);
 }
 
-long LHAPack::get_longword()
+long LHAPack::get_longword(LHACursor *cur)
 {
 	long b0, b1, b2, b3;
     long l;
@@ -97,7 +105,7 @@ long LHAPack::get_longword()
     return l;
 }
 
-void LHAPack::put_longword(long v)
+void LHAPack::put_longword(LHACursor *cur, long v)
 {
 	put_byte(v);
     put_byte(v >> 8);
@@ -105,21 +113,238 @@ void LHAPack::put_longword(long v)
     put_byte(v >> 24);
 }
 
-int LHAPack::get_bytes(char *buf, int len, int size)
+int LHAPack::get_bytes(LHACursor *cur, char *buf, int len, int size)
 {
-	for (int i = 0; i < len && i < size; i++)
-        buf[i] = get_ptr[i];
+	int i;
+
+	for (i = 0; i < len && i < size; i++)
+        buf[i] = cur->get_ptr[i];
 	
-    get_ptr += len;
+    cur->get_ptr += len;
     return i;
 }
 
-void LHAPack::put_bytes(char *buf, int len)
+void LHAPack::put_bytes(LHACursor *cur, const char *buf, int len)
 {	
     for (int i = 0; i < len; i++)
         put_byte(buf[i]);
 }
 
+/*
+ * The rules of the local time zone, a year at a time.  mktime() and
+ * localtime() take a lock and read the zone rules on every call; instead
+ * each year's offsets from UTC, with the instants they change at, are
+ * found once (localtime() a day at a time, then halving the day the
+ * offset changed in) and a time stamp then converts with a lookup.  A
+ * change undone within the day it was made in is missed.  Years beyond
+ * the table, and a year with more changes than it holds, go to the C
+ * library every time.  The zone must not change meanwhile.
+ */
+#define TIME_FIRST_YEAR     1970
+#define TIME_LAST_YEAR      2107    /* the last the MS-DOS format holds */
+#define TIME_MAX_CHANGES    8
+
+struct ZoneYear {
+    int     count;                          /* offsets; 0: not to be used */
+    int64_t start[TIME_MAX_CHANGES + 2];    /* UTC; start[count]: next January 1 */
+    long    offset[TIME_MAX_CHANGES + 1];   /* local time minus UTC */
+};
+
+struct ZoneTable {
+    std::atomic<ZoneYear *> years[TIME_LAST_YEAR - TIME_FIRST_YEAR + 1];
+
+    ~ZoneTable()
+    {
+        for (size_t i = 0; i < sizeof(years) / sizeof(years[0]); i++)
+            delete years[i].load();
+    }
+};
+
+static ZoneTable zone;
+
+static int64_t floor_div(int64_t a, int64_t b)
+{
+    return a / b - (a % b < 0 ? 1 : 0);
+}
+
+/* days since 1970-01-01 of a proleptic Gregorian date */
+static int64_t days_from_civil(int64_t y, unsigned m, unsigned d)
+{
+    int64_t  era;
+    unsigned yoe, doy, doe;
+
+    y  -= m <= 2;
+    era = (y >= 0 ? y : y - 399) / 400;
+    yoe = (unsigned)(y - era * 400);
+    doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+/* the year of a day counted from 1970-01-01 */
+static int64_t year_of(int64_t days)
+{
+    int64_t y = 1970 + floor_div(days, days < 0 ? 365 : 366);   /* never too late */
+
+    while (days_from_civil(y + 1, 1, 1) <= days)
+        y++;
+    return y;
+}
+
+/* mktime() of a local time in seconds since 1970-01-01 local */
+static time_t local_to_utc(int64_t local)
+{
+    int64_t days = floor_div(local, 86400);
+    int     rem  = (int)(local - days * 86400);
+    tm      lt;
+
+    memset(&lt, 0, sizeof(lt));
+    lt.tm_year  = 70;
+    lt.tm_mday  = (int)(days + 1);
+    lt.tm_hour  = rem / 3600;
+    lt.tm_min   = rem / 60 % 60;
+    lt.tm_sec   = rem % 60;
+    lt.tm_isdst = -1;
+    return mktime(&lt);
+}
+
+/* local time minus UTC at t, from localtime() */
+static bool utc_to_offset(time_t t, long *offset)
+{
+    tm lt;
+
+#ifdef _WIN32
+    if (localtime_s(&lt, &t) != 0)
+        return false;
+#else
+    if (localtime_r(&t, &lt) == NULL)
+        return false;
+#endif
+    *offset = (long)((days_from_civil(lt.tm_year + 1900, lt.tm_mon + 1, lt.tm_mday) * 86400 +
+                      lt.tm_hour * 3600 + lt.tm_min * 60 + lt.tm_sec) - (int64_t)t);
+    return true;
+}
+
+/* the offsets of one year; zy->count stays 0 if they cannot all be had */
+static void read_zone_year(int64_t year, ZoneYear *zy)
+{
+    int64_t first = days_from_civil(year, 1, 1) * 86400;
+    int64_t end   = days_from_civil(year + 1, 1, 1) * 86400;
+    int64_t day, lo, hi, mid;
+    long    offset, next, at;
+    int     n = 1;
+
+    zy->count = 0;
+    if (!utc_to_offset((time_t)first, &offset))
+        return;
+    zy->start[0]  = first;
+    zy->offset[0] = offset;
+
+    for (day = first + 86400; day <= end; day += 86400) {
+        if (!utc_to_offset((time_t)day, &next))
+            return;
+
+        /* the first second of each new offset since the day before */
+        for (lo = day - 86400; offset != next; lo = hi) {
+            hi = day;
+            while (hi - lo > 1) {
+                mid = lo + (hi - lo) / 2;
+                if (!utc_to_offset((time_t)mid, &at))
+                    return;
+                if (at == offset)
+                    lo = mid;
+                else
+                    hi = mid;
+            }
+            if (!utc_to_offset((time_t)hi, &offset))
+                return;
+            if (hi == end)
+                break;              /* next year's */
+            if (n > TIME_MAX_CHANGES)
+                return;
+            zy->start[n]  = hi;
+            zy->offset[n] = offset;
+            n++;
+        }
+    }
+
+    zy->start[n] = end;
+    zy->count    = n;
+}
+
+/* the offsets of a year, read on first use; NULL outside the table */
+static const ZoneYear *zone_year(int64_t year)
+{
+    ZoneYear *zy, *expected = NULL;
+
+    if (year < TIME_FIRST_YEAR || year > TIME_LAST_YEAR)
+        return NULL;
+
+    std::atomic<ZoneYear *> &slot = zone.years[year - TIME_FIRST_YEAR];
+
+    if ((zy = slot.load(std::memory_order_acquire)) == NULL) {
+        zy = new ZoneYear;
+        read_zone_year(year, zy);
+        if (!slot.compare_exchange_strong(expected, zy, std::memory_order_acq_rel)) {
+            delete zy;      /* another thread was first */
+            zy = expected;
+        }
+    }
+    return zy->count ? zy : NULL;
+}
+
+/*
+ * Local time minus UTC, for a local time.  A local time that falls in no
+ * interval (skipped when the clocks went forward) or in two (repeated
+ * when they went back) is left to mktime(), as are those the table does
+ * not cover.
+ */
+static bool local_offset(int64_t local, long *offset)
+{
+    int64_t         days  = floor_div(local, 86400);
+    int64_t         year  = year_of(days - 2);      /* offsets are under a day */
+    int64_t         last  = year_of(days + 2);
+    int             found = 0;
+    const ZoneYear  *zy;
+    time_t          t;
+
+    for (; year <= last; year++) {
+        if ((zy = zone_year(year)) == NULL) {
+            found = 0;
+            break;
+        }
+        for (int i = 0; i < zy->count; i++) {
+            int64_t utc = local - zy->offset[i];
+            if (utc >= zy->start[i] && utc < zy->start[i + 1]) {
+                *offset = zy->offset[i];
+                found++;
+            }
+        }
+    }
+    if (found == 1)
+        return true;
+
+    t = local_to_utc(local);
+    if (t == (time_t)-1)
+        return false;
+    *offset = (long)(local - (int64_t)t);
+    return true;
+}
+
+/* local time minus UTC, at the UTC time t */
+static bool utc_offset(time_t t, long *offset)
+{
+    const ZoneYear *zy = zone_year(year_of(floor_div((int64_t)t, 86400)));
+    int            i;
+
+    if (zy == NULL)
+        return utc_to_offset(t, offset);
+    for (i = zy->count - 1; i > 0 && zy->start[i] > (int64_t)t; i--)
+        ;
+    *offset = zy->offset[i];
+    return true;
+}
+
 /*
 * Generic (MS-DOS style) time stamp format (localtime):
 *
@@ -129,44 +354,52 @@ void LHAPack::put_bytes(char *buf, int len)
 *  15 14 13 12 11 10  9  8  7  6  5  4  3  2  1  0
 * |<--- hour --->|<---- minute --->|<- second/2 ->|
 *
+*  Fields out of range carry over as they would through mktime(): month
+*  13 is January of the next year, day 0 the last day of the month before.
  */
-
 time_t LHAPack::generic_to_unix_stamp(long t)
 {
 	#define subbits(n, off, len) (((n) >> (off)) & ((1 << (len))-1))
 
-	tm lt;
+	int64_t year  = subbits(t, 25, 7) + 1980;
+	int64_t month = subbits(t, 21, 4) - 1;
+	int64_t local;
+	long    offset;
 
-    lt.tm_sec  = subbits(t,  0, 5) * 2;
-    lt.tm_min  = subbits(t,  5, 6);
-    lt.tm_hour = subbits(t, 11, 5);
-    lt.tm_mday = subbits(t, 16, 5);
-    lt.tm_mon  = subbits(t, 21, 4) - 1;
-    lt.tm_year = subbits(t, 25, 7) + 80;
-    lt.tm_isdst = -1;
-	
-    return mktime(&lt);
+	year  += floor_div(month, 12);
+	month -= floor_div(month, 12) * 12;
+
+	local = (days_from_civil(year, (unsigned)month + 1, 1) + subbits(t, 16, 5) - 1) * 86400 +
+	        subbits(t, 11, 5) * 3600 + subbits(t, 5, 6) * 60 + subbits(t, 0, 5) * 2;
+
+	if (!local_offset(local, &offset))
+		return (time_t)-1;
+	return (time_t)(local - offset);
 }
 
+/* times before 1980, which the format cannot hold, become 1980-01-01 00:00 */
 long LHAPack::unix_to_generic_stamp(time_t t)
 {
- 	SYSTEMTIME st = unix_to_win32_systemtime(t);
- 	
-     st.wYear  -= 80;
-     st.wMonth += 1;
- 	
-     return ((long)(st.wYear << 25) + (st.wMonth  << 21) + (st.wDay << 16) +
-		           (st.wHour << 11) + (st.wMinute << 5)  + (st.wSecond / 2));
+	SYSTEMTIME st = unix_to_win32_systemtime(t);
+
+	if (st.wYear < 1980)
+		return (long)(1 << 21 | 1 << 16);
+	if (st.wYear > 1980 + 127)
+		st.wYear = 1980 + 127;
+
+	return (long)(((unsigned long)(st.wYear - 1980) << 25) + ((unsigned long)st.wMonth << 21) +
+	              ((unsigned long)st.wDay << 16) + ((unsigned long)st.wHour << 11) +
+	              ((unsigned long)st.wMinute << 5) + (st.wSecond / 2));
 }
 
-unsigned long LHAPack::wintime_to_unix_stamp()
+unsigned long LHAPack::wintime_to_unix_stamp(LHACursor *cur)
 {
-	unsigned __int64 t;
-    unsigned __int64 epoch = ((unsigned __int64)0x019db1de << 32) + 0xd53e8000;
+	uint64_t t;
+    uint64_t epoch = ((uint64_t)0x019db1de << 32) + 0xd53e8000;
 	/* 0x019db1ded53e8000ULL: 1970-01-01 00:00:00 (UTC) */
 	
-    t = (unsigned long)get_longword();
-    t |= (unsigned __int64)(unsigned long)get_longword() << 32;
+    t = (unsigned long)get_longword(cur);
+    t |= (uint64_t)(unsigned long)get_longword(cur) << 32;
     t = (t - epoch) / 10000000;
     return (unsigned long)t;
 }
@@ -184,18 +417,69 @@ FILETIME LHAPack::unix_to_win32_filetime(time_t t)
 	return ft;
 }
 
+/* the local time at t */
 SYSTEMTIME LHAPack::unix_to_win32_systemtime(time_t t)
 {
-	FILETIME ft,lt;
+	FILETIME ft;
 	SYSTEMTIME st;
-	
-	ft = unix_to_win32_filetime(t);
-	LocalFileTimeToFileTime(&ft,&lt);
-	FileTimeToSystemTime(&lt, &st);
+	long offset;
+
+	if (!utc_offset(t, &offset))
+		offset = 0;
+	ft = unix_to_win32_filetime((time_t)(t + offset));
+	if (!FileTimeToSystemTime(&ft, &st)) {
+		/* before 1601, which a FILETIME cannot hold: 1601-01-01 00:00, a Monday */
+		memset(&st, 0, sizeof(st));
+		st.wYear      = 1601;
+		st.wMonth     = 1;
+		st.wDay       = 1;
+		st.wDayOfWeek = 1;
+	}
 
 	return st;
 }
 
+/* the time stamp of the last header read, converted when asked for */
+SYSTEMTIME LHAPack::win32_systemtime() const
+{
+	return unix_to_win32_systemtime(modified_stamp);
+}
+
+/* shortest contents of the known extended header types */
+static size_t ext_min_size(int ext_type)
+{
+	switch (ext_type)
+	{
+	case 0:    return 2;    /* header crc */
+	case 0x40: return 2;    /* MS-DOS attribute */
+	case 0x41: return 24;   /* Windows time stamp */
+	case 0x50: return 2;    /* UNIX permission */
+	case 0x51: return 4;    /* UNIX gid and uid */
+	case 0x54: return 4;    /* UNIX last modified time */
+	default:   return 0;
+	}
+}
+
+/*
+ * Types LHA_PARSE_LAZY leaves to read_extended(): everything but the
+ * name and the time stamp, which a listing needs.
+ */
+static bool ext_deferred(int ext_type)
+{
+	switch (ext_type)
+	{
+	case 0:                 /* header crc */
+	case 0x40:              /* MS-DOS attribute */
+	case 0x50:              /* UNIX permission */
+	case 0x51:              /* UNIX gid and uid */
+	case 0x52:              /* UNIX group name */
+	case 0x53:              /* UNIX user name */
+	    return true;
+	default:
+	    return false;
+	}
+}
+
 /*
 * extended header
 *
@@ -214,141 +498,158 @@ SYSTEMTIME LHAPack::unix_to_win32_systemtime(time_t t)
 *  on level 3 header:
 *    size field is 4 bytes
 */
-int LHAPack::get_extended_header(LHAHeader *hdr, size_t header_size, unsigned int *hcrc)
+int LHAPack::get_extended_header(LHACursor *cur, LHAHeader *hdr, size_t header_size, unsigned int *hcrc)
 {
-	char data[LZHEADER_STORAGE];
+	static const unsigned char zero_crc[2] = {0, 0};
+
+	char *data;
 	char dirname[FILENAME_LENGTH];
 
 	int i;
 	int ext_type;
+	bool decode;
     int name_length;    
     int dir_length = 0;            
     int n = 1 + hdr->size_field_length; /* `ext-type' + `next-header size' */
 
-	int whole_size = header_size;
+	size_t whole_size = header_size;
 
     if (hdr->header_level == 0)
         return 0;
 
+    LHA_STAT_SCOPE(LHA_STAT_EXTENDED);
     name_length = strlen(hdr->name);
 
     while (header_size) 
 	{
-        setup_get(data);
-        if (sizeof(data) < header_size) 
-		{
-            return 1;
-        }
-
-		if(IsBadReadPtr(mem_ptr,header_size) != 0)
-		{
-			return 1;
-		}
+		/* the record, including the next size field, is read in place */
+		if (header_size < (size_t)n || !readable(cur, cur->mem_ptr, header_size))
+			return -1;
 
-		memcpy(data,mem_ptr,header_size);
-		mem_ptr += header_size;
+		data = cur->mem_ptr;
+		cur->mem_ptr += header_size;
+        setup_get(data);
 
         ext_type = get_byte();
-        switch (ext_type) 
-		{
-        case 0:
-            /* header crc (CRC-16) */
-            hdr->header_crc = get_word();
-
-            /* clear buffer for CRC calculation. */
-            data[1] = data[2] = 0;
-            skip_bytes(header_size - n - 2);
-            break;
-        case 1:
-            /* filename */
-            name_length = get_bytes(hdr->name, header_size-n, sizeof(hdr->name)-1);
-            hdr->name[name_length] = 0;
-            break;
-        case 2:
-            /* directory */
-            dir_length = get_bytes(dirname, header_size-n, sizeof(dirname)-1);
-            dirname[dir_length] = 0;
-            break;
-        case 0x40:
-            /* MS-DOS attribute */
-            hdr->attribute = get_word();
-            break;
-        case 0x41:
-            /* Windows time stamp (FILETIME structure) */
-            /* it is time in 100 nano seconds since 1601-01-01 00:00:00 */
-
-            skip_bytes(8); /* create time is ignored */
-
-            /* set last modified time */
-            if (hdr->header_level >= 2)
-                skip_bytes(8);  /* time_t has been already set */
-            else
-                hdr->unix_last_modified_stamp = wintime_to_unix_stamp();
-
-            skip_bytes(8); /* last access time is ignored */
-
-            break;
-        case 0x50:
-            /* UNIX permission */
-            hdr->unix_mode = get_word();
-            break;
-        case 0x51:
-            /* UNIX gid and uid */
-            hdr->unix_gid = get_word();
-            hdr->unix_uid = get_word();
-            break;
-        case 0x52:
-            /* UNIX group name */
-            i = get_bytes(hdr->group, header_size-n, sizeof(hdr->group)-1);
-            hdr->group[i] = '\0';
-            break;
-        case 0x53:
-            /* UNIX user name */
-            i = get_bytes(hdr->user, header_size-n, sizeof(hdr->user)-1);
-            hdr->user[i] = '\0';
-            break;
-        case 0x54:
-            /* UNIX last modified time */
-            hdr->unix_last_modified_stamp = (time_t) get_longword();
-            break;
-        default:
-            /* other headers */
-            /* 0x39: multi-disk header
-               0x3f: uncompressed comment
-               0x42: 64bit large file size
-               0x48-0x4f(?): reserved for authenticity verification
-               0x7d: encapsulation
-               0x7e: extended attribute - platform information
-               0x7f: extended attribute - permission, owner-id and timestamp
-                     (level 3 on OS/2)
-               0xc4: compressed comment (dict size: 4096)
-               0xc5: compressed comment (dict size: 8192)
-               0xc6: compressed comment (dict size: 16384)
-               0xc7: compressed comment (dict size: 32768)
-               0xc8: compressed comment (dict size: 65536)
-               0xd0-0xdf(?): operating systemm specific information
-               0xfc: encapsulation (another opinion)
-               0xfe: extended attribute - platform information(another opinion)
-               0xff: extended attribute - permission, owner-id and timestamp
-                     (level 3 on UNLHA32) */
+		if (header_size < n + ext_min_size(ext_type))
+			return -1;
+
+        if (cur->flags & PARSE_DEFERRED)
+            decode = ext_deferred(ext_type);
+        else if ((cur->flags & LHA_PARSE_LAZY) && ext_deferred(ext_type)) {
+            decode = hcrc && ext_type == 0;     /* strict still checks it */
+            hdr->extend_pending = TRUE;
+        }
+        else
+            decode = true;
+
+        if (decode) {
+            switch (ext_type) 
+			{
+            case 0:
+                /* header crc (CRC-16) */
+                hdr->header_crc = get_word(cur);
+                cur->has_hcrc   = true;
+                break;
+            case 1:
+                /* filename */
+                name_length = get_bytes(cur, hdr->name, header_size-n, sizeof(hdr->name)-1);
+                hdr->name[name_length] = 0;
+                break;
+            case 2:
+                /* directory */
+                dir_length = get_bytes(cur, dirname, header_size-n, sizeof(dirname)-1);
+                dirname[dir_length] = 0;
+                break;
+            case 0x40:
+                /* MS-DOS attribute */
+                hdr->attribute = get_word(cur);
+                break;
+            case 0x41:
+                /* Windows time stamp (FILETIME structure) */
+                /* it is time in 100 nano seconds since 1601-01-01 00:00:00 */
+
+                skip_bytes(8); /* create time is ignored */
+
+                /* set last modified time */
+                if (hdr->header_level >= 2)
+                    skip_bytes(8);  /* time_t has been already set */
+                else
+                    hdr->unix_last_modified_stamp = wintime_to_unix_stamp(cur);
+
+                skip_bytes(8); /* last access time is ignored */
+
+                break;
+            case 0x50:
+                /* UNIX permission */
+                hdr->unix_mode = get_word(cur);
+                break;
+            case 0x51:
+                /* UNIX gid and uid */
+                hdr->unix_gid = get_word(cur);
+                hdr->unix_uid = get_word(cur);
+                break;
+            case 0x52:
+                /* UNIX group name */
+                i = get_bytes(cur, hdr->group, header_size-n, sizeof(hdr->group)-1);
+                hdr->group[i] = '\0';
+                break;
+            case 0x53:
+                /* UNIX user name */
+                i = get_bytes(cur, hdr->user, header_size-n, sizeof(hdr->user)-1);
+                hdr->user[i] = '\0';
+                break;
+            case 0x54:
+                /* UNIX last modified time */
+                hdr->unix_last_modified_stamp = (time_t) get_longword(cur);
+                break;
+            default:
+                /* other headers */
+                /* 0x39: multi-disk header
+                   0x3f: uncompressed comment
+                   0x42: 64bit large file size
+                   0x48-0x4f(?): reserved for authenticity verification
+                   0x7d: encapsulation
+                   0x7e: extended attribute - platform information
+                   0x7f: extended attribute - permission, owner-id and timestamp
+                         (level 3 on OS/2)
+                   0xc4: compressed comment (dict size: 4096)
+                   0xc5: compressed comment (dict size: 8192)
+                   0xc6: compressed comment (dict size: 16384)
+                   0xc7: compressed comment (dict size: 32768)
+                   0xc8: compressed comment (dict size: 65536)
+                   0xd0-0xdf(?): operating systemm specific information
+                   0xfc: encapsulation (another opinion)
+                   0xfe: extended attribute - platform information(another opinion)
+                   0xff: extended attribute - permission, owner-id and timestamp
+                         (level 3 on UNLHA32) */
             
-            skip_bytes(header_size - n);
-            break;
+                skip_bytes(header_size - n);
+                break;
+            }
         }
 
-        if (hcrc)
+        if (hcrc && ext_type == 0)
+		{
+            /* the CRC field itself counts as zero */
+            *hcrc = calccrc(*hcrc, (unsigned char*)data, 1);
+            *hcrc = calccrc(*hcrc, zero_crc, 2);
+            *hcrc = calccrc(*hcrc, (unsigned char*)data + 3, header_size - 3);
+		}
+        else if (hcrc)
             *hcrc = calccrc(*hcrc, (unsigned char*)data, header_size);
 
+        setup_get(data + header_size - hdr->size_field_length);
         if (hdr->size_field_length == 2)
-            whole_size += header_size = get_word();
+            whole_size += header_size = get_word(cur);
         else
-            whole_size += header_size = get_longword();
+            whole_size += header_size = get_longword(cur);
     }
 
     /* concatenate dirname and filename */
     if (dir_length) 
 	{
-        if (name_length + dir_length >= sizeof(hdr->name))
+        if ((size_t)(name_length + dir_length) >= sizeof(hdr->name))
 		{
             name_length = sizeof(hdr->name) - dir_length - 1;
             hdr->name[name_length] = 0;
@@ -358,7 +659,8 @@ int LHAPack::get_extended_header(LHAHeader *hdr, size_t header_size, unsigned in
         name_length += dir_length;
     }
 
-    return whole_size;	
+    LHA_STAT_BYTES(whole_size);
+    return (int)whole_size;	
 }
 
 #define I_HEADER_SIZE           0               /* level 0,1,2   */
@@ -451,7 +753,7 @@ int LHAPack::get_extended_header(LHAHeader *hdr, size_t header_size, unsigned in
  *
  */
 
-bool LHAPack::get_header_level0(LHAHeader *hdr, char *data)
+bool LHAPack::get_header_level0(LHACursor *cur, LHAHeader *hdr, char *data)
 {
 	int i;
 	int checksum;
@@ -466,24 +768,25 @@ bool LHAPack::get_header_level0(LHAHeader *hdr, char *data)
     hdr->size_field_length = 2; /* in bytes */
     hdr->header_size       = header_size;    
 	
-	memcpy(data + COMMON_HEADER_SIZE,mem_ptr,header_size + 2 - COMMON_HEADER_SIZE);
-	mem_ptr += header_size + 2 - COMMON_HEADER_SIZE;
+	if (header_size + 2 < I_GENERIC_HEADER_SIZE - 2 || !readable(cur, data, header_size + 2))
+		return false;
+	cur->mem_ptr = data + header_size + 2;
 	
-	if (calc_sum(data + I_METHOD, header_size) != checksum) 
-	{
-		
-	}
+	if ((cur->flags & LHA_PARSE_STRICT) && calc_sum(data + I_METHOD, header_size) != checksum)
+		return false;
 	
-    get_bytes(hdr->method, 5, sizeof(hdr->method));
+    get_bytes(cur, hdr->method, 5, sizeof(hdr->method));
 	
-    hdr->packed_size              = get_longword();
-    hdr->original_size            = get_longword();
-    hdr->unix_last_modified_stamp = generic_to_unix_stamp(get_longword());
+    hdr->packed_size              = get_longword(cur);
+    hdr->original_size            = get_longword(cur);
+    hdr->unix_last_modified_stamp = generic_to_unix_stamp(get_longword(cur));
     hdr->attribute                = get_byte(); /* MS-DOS attribute */
     hdr->header_level             = get_byte();
     name_length                   = get_byte();
 	
-    i = get_bytes(hdr->name, name_length, sizeof(hdr->name)-1);
+	if (I_GENERIC_HEADER_SIZE - 2 + (size_t)name_length > header_size + 2)
+		return false;
+    i = get_bytes(cur, hdr->name, name_length, sizeof(hdr->name)-1);
     hdr->name[i] = '\0';
 	
     /* defaults for other type */
@@ -507,7 +810,7 @@ bool LHAPack::get_header_level0(LHAHeader *hdr, char *data)
     }
 	
     hdr->has_crc = TRUE;
-    hdr->crc     = get_word();
+    hdr->crc     = get_word(cur);
 	
     if (extend_size == 0)
         return true;
@@ -520,10 +823,10 @@ bool LHAPack::get_header_level0(LHAHeader *hdr, char *data)
         if (extend_size >= 11) 
 		{
             hdr->minor_version            = get_byte();
-            hdr->unix_last_modified_stamp = (time_t) get_longword();
-            hdr->unix_mode                = get_word();
-            hdr->unix_uid                 = get_word();
-            hdr->unix_gid                 = get_word();
+            hdr->unix_last_modified_stamp = (time_t) get_longword(cur);
+            hdr->unix_mode                = get_word(cur);
+            hdr->unix_uid                 = get_word(cur);
+            hdr->unix_gid                 = get_word(cur);
 			
             extend_size -= 11;
         }
@@ -571,7 +874,7 @@ bool LHAPack::get_header_level0(LHAHeader *hdr, char *data)
  *
  */
 
-bool LHAPack::get_header_level1(LHAHeader *hdr, char *data)
+bool LHAPack::get_header_level1(LHACursor *cur, LHAHeader *hdr, char *data)
 {
 	int i, dummy;
 	int checksum;
@@ -586,22 +889,24 @@ bool LHAPack::get_header_level1(LHAHeader *hdr, char *data)
     hdr->size_field_length = 2; /* in bytes */
     hdr->header_size       = header_size;    
 	
-	memcpy(data + COMMON_HEADER_SIZE,mem_ptr,header_size + 2 - COMMON_HEADER_SIZE);
-	mem_ptr += header_size + 2 - COMMON_HEADER_SIZE;
+	if (header_size + 2 < I_LEVEL1_HEADER_SIZE || !readable(cur, data, header_size + 2))
+		return false;
+	cur->mem_ptr = data + header_size + 2;
 	
-    if (calc_sum(data + I_METHOD, header_size) != checksum) {
-        //return false;
-    }
+    if ((cur->flags & LHA_PARSE_STRICT) && calc_sum(data + I_METHOD, header_size) != checksum)
+        return false;
 	
-    get_bytes(hdr->method, 5, sizeof(hdr->method));
-    hdr->packed_size              = get_longword(); /* skip size */
-    hdr->original_size            = get_longword();
-    hdr->unix_last_modified_stamp = generic_to_unix_stamp(get_longword());
+    get_bytes(cur, hdr->method, 5, sizeof(hdr->method));
+    hdr->packed_size              = get_longword(cur); /* skip size */
+    hdr->original_size            = get_longword(cur);
+    hdr->unix_last_modified_stamp = generic_to_unix_stamp(get_longword(cur));
     hdr->attribute                = get_byte(); /* 0x20 fixed */
     hdr->header_level             = get_byte();
 	
     name_length = get_byte();
-    i = get_bytes(hdr->name, name_length, sizeof(hdr->name)-1);
+	if (I_LEVEL1_HEADER_SIZE + (size_t)name_length > header_size + 2)
+		return false;
+    i = get_bytes(cur, hdr->name, name_length, sizeof(hdr->name)-1);
     hdr->name[i] = '\0';
 	
     /* defaults for other type */
@@ -609,16 +914,17 @@ bool LHAPack::get_header_level1(LHAHeader *hdr, char *data)
     hdr->unix_gid    = 0;
     hdr->unix_uid    = 0;	
     hdr->has_crc     = TRUE;
-    hdr->crc         = get_word();
+    hdr->crc         = get_word(cur);
     hdr->extend_type = get_byte();
 	
     dummy = header_size+2 - name_length - I_LEVEL1_HEADER_SIZE;
     if (dummy > 0)
         skip_bytes(dummy); /* skip old style extend header */
 	
-    extend_size = get_word();
-    extend_size = get_extended_header(hdr, extend_size, 0);
-    if (extend_size == -1)
+    extend_size = get_word(cur);
+    hdr->extend_offset = (unsigned int)(cur->mem_ptr - data);
+    extend_size = get_extended_header(cur, hdr, extend_size, 0);
+    if (extend_size == -1 || (size_t)extend_size > hdr->packed_size)
         return false;
 	
     /* On level 1 header, size fields should be adjusted. */
@@ -659,32 +965,32 @@ bool LHAPack::get_header_level1(LHAHeader *hdr, char *data)
  * -------------------------------------------------
  *
  */
-bool LHAPack::get_header_level2(LHAHeader *hdr, char *data)
+bool LHAPack::get_header_level2(LHACursor *cur, LHAHeader *hdr, char *data)
 {    
 	int padding;
     int extend_size;    
     unsigned int hcrc;
+    bool strict = (cur->flags & LHA_PARSE_STRICT) != 0;
 
 	size_t header_size;
 	
-	header_size = get_word();
+	header_size = get_word(cur);
 
     hdr->size_field_length = 2; /* in bytes */
     hdr->header_size       = header_size;
 	
 	//֤ڴǷɶ
-	if(IsBadReadPtr(mem_ptr,I_LEVEL2_HEADER_SIZE - COMMON_HEADER_SIZE) != 0)
+	if (header_size < I_LEVEL2_HEADER_SIZE || !readable(cur, data, header_size))
 	{
 		return false;
 	}
 	
-	memcpy(data + COMMON_HEADER_SIZE,mem_ptr,I_LEVEL2_HEADER_SIZE - COMMON_HEADER_SIZE);   
-	mem_ptr += I_LEVEL2_HEADER_SIZE - COMMON_HEADER_SIZE;
+	cur->mem_ptr = data + I_LEVEL2_HEADER_SIZE;
 	
-    get_bytes(hdr->method, 5, sizeof(hdr->method));
-    hdr->packed_size              = get_longword();
-    hdr->original_size            = get_longword();
-    hdr->unix_last_modified_stamp = get_longword();
+    get_bytes(cur, hdr->method, 5, sizeof(hdr->method));
+    hdr->packed_size              = get_longword(cur);
+    hdr->original_size            = get_longword(cur);
+    hdr->unix_last_modified_stamp = get_longword(cur);
     hdr->attribute                = get_byte(); /* reserved */
     hdr->header_level             = get_byte();
 	
@@ -694,25 +1000,29 @@ bool LHAPack::get_header_level2(LHAHeader *hdr, char *data)
     hdr->unix_uid                 = 0;
 	
     hdr->has_crc                  = TRUE;
-    hdr->crc                      = get_word();
+    hdr->crc                      = get_word(cur);
     hdr->extend_type              = get_byte();
-    extend_size                   = get_word();
+    extend_size                   = get_word(cur);
 	
     INITIALIZE_CRC(hcrc);
-    hcrc = calccrc(hcrc, (unsigned char*)data, get_ptr - data);
+    if (strict)
+        hcrc = calccrc(hcrc, (unsigned char*)data, cur->get_ptr - data);
 	
-    extend_size = get_extended_header(hdr, extend_size, &hcrc);
+    hdr->extend_offset = (unsigned int)(cur->mem_ptr - data);
+    extend_size = get_extended_header(cur, hdr, extend_size, strict ? &hcrc : NULL);
     if (extend_size == -1)
         return false;
 	
     padding = header_size - I_LEVEL2_HEADER_SIZE - extend_size;
-    while (padding--)           /* padding should be 0 or 1 */
-        hcrc = UPDATE_CRC(hcrc, *mem_ptr++);
+    if (padding < 0)
+        return false;
+    /* padding should be 0 or 1 */
+    if (strict)
+        hcrc = calccrc(hcrc, (unsigned char*)cur->mem_ptr, padding);
+    cur->mem_ptr += padding;
 	
-    if (hdr->header_crc != hcrc)
-	{
-
-	}
+    if (strict && cur->has_hcrc && hdr->header_crc != hcrc)
+		return false;
 	
 	return true;
 }
@@ -744,23 +1054,25 @@ bool LHAPack::get_header_level2(LHAHeader *hdr, char *data)
  * -------------------------------------------------
  *
  */
-bool LHAPack::get_header_level3(LHAHeader *hdr, char *data)
+bool LHAPack::get_header_level3(LHACursor *cur, LHAHeader *hdr, char *data)
 {
     int extend_size;
     int padding;
     unsigned int hcrc;
+    bool strict = (cur->flags & LHA_PARSE_STRICT) != 0;
 
 	size_t header_size;
 	
-    hdr->size_field_length = get_word();
+    hdr->size_field_length = get_word(cur);
 	
-	memcpy(data + COMMON_HEADER_SIZE,mem_ptr,I_LEVEL3_HEADER_SIZE - COMMON_HEADER_SIZE); 
-	mem_ptr += I_LEVEL3_HEADER_SIZE - COMMON_HEADER_SIZE;
+	if (!readable(cur, data, I_LEVEL3_HEADER_SIZE))
+		return false;
+	cur->mem_ptr = data + I_LEVEL3_HEADER_SIZE;
 	
-    get_bytes(hdr->method, 5, sizeof(hdr->method));
-    hdr->packed_size              = get_longword();
-    hdr->original_size            = get_longword();
-    hdr->unix_last_modified_stamp = get_longword();
+    get_bytes(cur, hdr->method, 5, sizeof(hdr->method));
+    hdr->packed_size              = get_longword(cur);
+    hdr->original_size            = get_longword(cur);
+    hdr->unix_last_modified_stamp = get_longword(cur);
     hdr->attribute                = get_byte(); /* reserved */
     hdr->header_level             = get_byte();
 	
@@ -770,74 +1082,230 @@ bool LHAPack::get_header_level3(LHAHeader *hdr, char *data)
     hdr->unix_uid    = 0;
 	
     hdr->has_crc     = TRUE;
-    hdr->crc         = get_word();
+    hdr->crc         = get_word(cur);
     hdr->extend_type = get_byte();
-    hdr->header_size = header_size = get_longword();
-    extend_size      = get_longword();
+    hdr->header_size = header_size = get_longword(cur);
+    extend_size      = get_longword(cur);
+
+	if (hdr->size_field_length != 4 ||
+		header_size < I_LEVEL3_HEADER_SIZE || !readable(cur, data, header_size))
+		return false;
 	
     INITIALIZE_CRC(hcrc);
-    hcrc = calccrc(hcrc, (unsigned char*)data, get_ptr - data);
+    if (strict)
+        hcrc = calccrc(hcrc, (unsigned char*)data, cur->get_ptr - data);
 	
-    extend_size = get_extended_header(hdr, extend_size, &hcrc);
+    hdr->extend_offset = (unsigned int)(cur->mem_ptr - data);
+    extend_size = get_extended_header(cur, hdr, extend_size, strict ? &hcrc : NULL);
     if (extend_size == -1)
         return false;
 	
     padding = header_size - I_LEVEL3_HEADER_SIZE - extend_size;
-    while (padding--)           /* padding should be 0 */
-        hcrc = UPDATE_CRC(hcrc, *mem_ptr++);
+    if (padding < 0)
+        return false;
+    /* padding should be 0 */
+    if (strict)
+        hcrc = calccrc(hcrc, (unsigned char*)cur->mem_ptr, padding);
+    cur->mem_ptr += padding;
 	
-    if (hdr->header_crc != hcrc)
-    {
-
-	}
+    if (strict && cur->has_hcrc && hdr->header_crc != hcrc)
+		return false;
 	
 	return true;
 }
 
+/*
+ * Zero the numeric fields and empty the strings.  The string buffers are
+ * most of the 2.5 KB of an LHAHeader and are always written NUL-terminated,
+ * so they are not cleared whole.
+ */
+static void clear_header(LHAHeader *hdr)
+{
+	memset(hdr, 0, offsetof(LHAHeader, name));
+	memset(&hdr->crc, 0, offsetof(LHAHeader, user) - offsetof(LHAHeader, crc));
+	hdr->name[0]     = '\0';
+	hdr->realname[0] = '\0';
+	hdr->user[0]     = '\0';
+	hdr->group[0]    = '\0';
+}
+
+/*
+ * Parse the header at pBegin; no byte at or past pEnd is read, so a
+ * truncated archive fails here instead of faulting.
+ */
+bool LHAPack::get_header(const char *pBegin, const char *pEnd, LHAHeader *hdr)
+{
+	size_t offset;
+
+	if (!parse_header(pBegin, pEnd, hdr, &offset))
+		return false;
+
+	modified_stamp = hdr->unix_last_modified_stamp;
+	dataoffset     = (int)offset;
+	return true;
+}
+
+/* The caller vouches that the whole header at pMem is readable. */
 bool LHAPack::get_header(const char *pMem, LHAHeader *hdr)
 {
+	size_t offset;
+
 	if(NULL==pMem)	return false;
-	mem_ptr = (char*)pMem;
 
+	if (!read_header(pMem, NULL, hdr, &offset, 0))
+		return false;
+
+	modified_stamp = hdr->unix_last_modified_stamp;
+	dataoffset     = (int)offset;
+	return true;
+}
+
+/*
+ * Reentrant form of get_header(): touches nothing but its arguments, so
+ * any number of threads may call it at once.  *dataoffset receives the
+ * offset of the packed data from pBegin.
+ *
+ * flags:
+ *   LHA_PARSE_LAZY    decode only the name and the time stamp from the
+ *                     extended headers; the rest (attribute, UNIX mode,
+ *                     ids and names, header crc) waits for read_extended()
+ *   LHA_PARSE_STRICT  fail on a wrong level 0/1 header checksum or
+ *                     level 2/3 header CRC, which are otherwise ignored
+ */
+bool LHAPack::parse_header(const char *pBegin, const char *pEnd, LHAHeader *hdr, size_t *dataoffset, int flags)
+{
+	if (NULL == pBegin || NULL == pEnd || pBegin >= pEnd)
+		return false;
+
+	return read_header(pBegin, pEnd, hdr, dataoffset, flags & (LHA_PARSE_LAZY | LHA_PARSE_STRICT));
+}
+
+/*
+ * Decode the extended header fields a lazy parse_header() of the same
+ * bytes passed over.  Nothing to do (and true) if there were none.
+ */
+bool LHAPack::read_extended(const char *pBegin, const char *pEnd, LHAHeader *hdr)
+{
+	LHACursor c;
+	LHACursor *cur = &c;
+	size_t    size;
+
+	if (!hdr->extend_pending)
+		return true;
+	if (NULL == pBegin || NULL == pEnd || hdr->extend_offset > (size_t)(pEnd - pBegin))
+		return false;
+
+	cur->mem_ptr  = (char *)pBegin + hdr->extend_offset;
+	cur->mem_end  = pEnd;
+	cur->flags    = PARSE_DEFERRED;
+	cur->has_hcrc = false;
+
+	/* the size of the first record ends the base header */
+	if (!readable(cur, cur->mem_ptr - hdr->size_field_length, hdr->size_field_length))
+		return false;
+	setup_get(cur->mem_ptr - hdr->size_field_length);
+	size = hdr->size_field_length == 2 ? (size_t)get_word(cur) : (size_t)(unsigned long)get_longword(cur);
+
+	if (get_extended_header(cur, hdr, size, NULL) == -1)
+		return false;
+	hdr->extend_pending = FALSE;
+	return true;
+}
+
+/*
+ * Length of the header at p, including any extended headers, judged from
+ * the `avail' bytes there are so far; for input read a piece at a time,
+ * where parse_header() cannot be handed the whole header up front.  If
+ * that is more than avail, read up to it and ask again (a level 1 header
+ * is only known a link of its extended header chain at a time).  0 for
+ * the end mark, a level this cannot read, or a header longer than
+ * LZHEADER_LENGTH_MAX.
+ */
+size_t LHAPack::header_length(const char *p, size_t avail)
+{
+	const unsigned char *u = (const unsigned char *)p;
+	size_t length, next;
+
+	if (avail < 1)
+		return 1;
+	if (u[0] == 0)
+		return 0;               /* end of archive */
+	if (avail < COMMON_HEADER_SIZE)
+		return COMMON_HEADER_SIZE;
+
+	switch (u[I_HEADER_LEVEL]) {
+	case 0:
+		return (size_t)u[0] + 2;
+	case 1:
+		length = (size_t)u[0] + 2;
+		if (length < I_LEVEL1_HEADER_SIZE)
+			return 0;
+		/* the base header and each extended header end with the size of the next */
+		while (avail >= length) {
+			next = u[length - 2] | (u[length - 1] << 8);
+			if (next == 0)
+				return length;
+			if (next < 3 || length + next > LZHEADER_LENGTH_MAX)
+				return 0;
+			length += next;
+		}
+		return length;
+	case 2:
+		length = u[0] | (u[1] << 8);
+		return length < I_LEVEL2_HEADER_SIZE ? 0 : length;
+	case 3:
+		if (avail < I_LEVEL3_HEADER_SIZE)
+			return I_LEVEL3_HEADER_SIZE;
+		length = u[24] | (u[25] << 8) | ((size_t)u[26] << 16) | ((size_t)u[27] << 24);
+		if (length < I_LEVEL3_HEADER_SIZE || length > LZHEADER_LENGTH_MAX)
+			return 0;
+		return length;
+	default:
+		return 0;
+	}
+}
+
+bool LHAPack::read_header(const char *pMem, const char *pEnd, LHAHeader *hdr, size_t *dataoffset, int flags)
+{
 	//ȡLZH Packļͷ
-	int   end_mark;	
-	char  data[LZHEADER_STORAGE] = {0};   
-	
+	char      *data = (char*)pMem;
+	LHACursor c;
+	LHACursor *cur  = &c;
+	LHA_STAT_SCOPE(LHA_STAT_HEADER);
+
+	cur->mem_ptr  = data;
+	cur->mem_end  = pEnd;
+	cur->flags    = flags;
+	cur->has_hcrc = false;
 	setup_get(data);	
-    memset(hdr, 0, sizeof(LHAHeader));    	
+    clear_header(hdr);
 
-    if ((end_mark = *mem_ptr++) == 0) 
+    if (!readable(cur, data, 1) || data[0] == 0) 
 	{
         return false;           /* finish */
     }
-	
-    data[0] = end_mark;
 
-	//֤ڴǷɶ
-	if(IsBadReadPtr(mem_ptr,COMMON_HEADER_SIZE - 1) != 0)
+	if (!readable(cur, data, COMMON_HEADER_SIZE))
 	{
 		return false;
 	}
-
-	memcpy(data+1,mem_ptr,COMMON_HEADER_SIZE - 1);
-	mem_ptr += COMMON_HEADER_SIZE - 1;
   
     switch (data[I_HEADER_LEVEL]) 
 	{
     case 0:
-        if (get_header_level0(hdr, data) == FALSE)
+        if (get_header_level0(cur, hdr, data) == FALSE)
             return false;
         break;
     case 1:
-        if (get_header_level1(hdr, data) == FALSE)
+        if (get_header_level1(cur, hdr, data) == FALSE)
             return false;
         break;
     case 2:
-        if (get_header_level2(hdr, data) == FALSE)
+        if (get_header_level2(cur, hdr, data) == FALSE)
             return false;
         break;
     case 3:
-        if (get_header_level3(hdr, data) == FALSE)
+        if (get_header_level3(cur, hdr, data) == FALSE)
             return false;
         break;
     default:
@@ -845,13 +1313,35 @@ bool LHAPack::get_header(const char *pMem, LHAHeader *hdr)
         return false;
     }
 
-	/* unix time stamp conversion */
-	win32_systemtime = unix_to_win32_systemtime(hdr->unix_last_modified_stamp);
-	dataoffset       = mem_ptr - pMem;
+	if (dataoffset)
+		*dataoffset = cur->mem_ptr - pMem;
+	LHA_STAT_BYTES(cur->mem_ptr - pMem);
 
     return true;
 }
 
+/*
+ * Decode the member whose header get_header() has just read at pMem.
+ * buf must hold hdr->original_size bytes.  Fails on a CRC mismatch.
+ */
+bool LHAPack::extract(const char *pMem, const LHAHeader *hdr, char *buf)
+{
+	if (NULL == pMem || NULL == hdr)
+		return false;
+
+	LHADecoderContext decoder;     /* this thread's, reused member to member */
+
+	if (!decoder->decode(hdr, pMem + dataoffset, buf))
+		return false;
+
+	if (hdr->has_crc && decoder->crc != hdr->crc)
+	{
+		LHA_STAT_CRC_FAILURE();
+		return false;
+	}
+	return true;
+}
+
 #define CURRENT_UNIX_MINOR_VERSION      0x00
 #define LHA_PATHSEP                     0xff    /* path separator of the
                                                 filename in lha header.
@@ -859,45 +1349,66 @@ bool LHAPack::get_header(const char *pMem, LHAHeader *hdr)
 												'unsigned char' or 'int',
                                                 that is not '\xff', but 0xff. */
 
-void LHAPack::write_unix_info(LHAHeader *hdr)
+void LHAPack::write_unix_info(LHACursor *cur, LHAHeader *hdr)
 {
     /* UNIX specific informations */
 	
-    put_word(5);            /* size */
+    put_word(cur, 5);            /* size */
     put_byte(0x50);         /* permission */
-    put_word(hdr->unix_mode);
+    put_word(cur, hdr->unix_mode);
 	
-    put_word(7);            /* size */
+    put_word(cur, 7);            /* size */
     put_byte(0x51);         /* gid and uid */
-    put_word(hdr->unix_gid);
-    put_word(hdr->unix_uid);
+    put_word(cur, hdr->unix_gid);
+    put_word(cur, hdr->unix_uid);
 	
     if (hdr->group[0]) 
 	{
         int len = strlen(hdr->group);
-        put_word(len + 3);  /* size */
+        put_word(cur, len + 3);  /* size */
         put_byte(0x52);     /* group name */
-        put_bytes(hdr->group, len);
+        put_bytes(cur, hdr->group, len);
     }
 	
     if (hdr->user[0])
 	{
         int len = strlen(hdr->user);
-        put_word(len + 3);  /* size */
+        put_word(cur, len + 3);  /* size */
         put_byte(0x53);     /* user name */
-        put_bytes(hdr->user, len);
+        put_bytes(cur, hdr->user, len);
     }
 	
     if (hdr->header_level == 1) 
 	{
-        put_word(7);        /* size */
+        put_word(cur, 7);        /* size */
         put_byte(0x54);     /* time stamp */
-        put_longword(hdr->unix_last_modified_stamp);
+        put_longword(cur, hdr->unix_last_modified_stamp);
     }
 }
 
+/*
+ * Write hdr at data (LZHEADER_STORAGE bytes) in the format of its
+ * header_level, 0 to 2; pathname separates directories with LHA_PATHSEP.
+ * Returns the header length, 0 for a level there is no writer for.
+ */
+size_t LHAPack::write_header(LHAHeader *hdr, char *data, char *pathname)
+{
+	switch (hdr->header_level) {
+	case 0:
+		return write_header_level0(hdr, data, pathname);
+	case 1:
+		return write_header_level1(hdr, data, pathname);
+	case 2:
+		return write_header_level2(hdr, data, pathname);
+	default:
+		return 0;
+	}
+}
+
 size_t LHAPack::write_header_level0(LHAHeader *hdr, char* data, char* pathname)
 {
+    LHACursor c;
+    LHACursor *cur = &c;
     int    limit;
     int    name_length;
     size_t header_size;
@@ -907,10 +1418,10 @@ size_t LHAPack::write_header_level0(LHAHeader *hdr, char* data, char* pathname)
 	
     put_byte(0x00);             /* header size */
     put_byte(0x00);             /* check sum */
-    put_bytes(hdr->method, 5);
-    put_longword(hdr->packed_size);
-    put_longword(hdr->original_size);
-    put_longword(unix_to_generic_stamp(hdr->unix_last_modified_stamp));
+    put_bytes(cur, hdr->method, 5);
+    put_longword(cur, hdr->packed_size);
+    put_longword(cur, hdr->original_size);
+    put_longword(cur, unix_to_generic_stamp(hdr->unix_last_modified_stamp));
     put_byte(hdr->attribute);
     put_byte(hdr->header_level); /* level 0 */
 	
@@ -926,8 +1437,8 @@ size_t LHAPack::write_header_level0(LHAHeader *hdr, char* data, char* pathname)
         name_length = limit;
     }
     put_byte(name_length);
-    put_bytes(pathname, name_length);
-    put_word(hdr->crc);
+    put_bytes(cur, pathname, name_length);
+    put_word(cur, hdr->crc);
 	
     if (generic_format) 
 	{
@@ -940,10 +1451,10 @@ size_t LHAPack::write_header_level0(LHAHeader *hdr, char* data, char* pathname)
         /* write old-style extend header */
         put_byte(EXTEND_UNIX);
         put_byte(CURRENT_UNIX_MINOR_VERSION);
-        put_longword(hdr->unix_last_modified_stamp);
-        put_word(hdr->unix_mode);
-        put_word(hdr->unix_uid);
-        put_word(hdr->unix_gid);
+        put_longword(cur, hdr->unix_last_modified_stamp);
+        put_word(cur, hdr->unix_mode);
+        put_word(cur, hdr->unix_uid);
+        put_word(cur, hdr->unix_gid);
 		
         /* size of extended header is 12 */
         header_size = I_LEVEL0_HEADER_SIZE + name_length - 2;
@@ -956,8 +1467,11 @@ size_t LHAPack::write_header_level0(LHAHeader *hdr, char* data, char* pathname)
 
 size_t LHAPack::write_header_level1(LHAHeader *hdr, char* data, char* pathname)
 {
+    LHACursor c;
+    LHACursor *cur = &c;
     int    name_length, dir_length, limit;
-    char   *basename, *dirname;
+    char   *basename;
+    const char *dirname;
     size_t header_size;
     char   *extend_header_top;
     size_t extend_header_size;
@@ -983,10 +1497,10 @@ size_t LHAPack::write_header_level1(LHAHeader *hdr, char* data, char* pathname)
 	
     put_byte(0x00);             /* header size */
     put_byte(0x00);             /* check sum */
-    put_bytes(hdr->method, 5);
-    put_longword(hdr->packed_size);
-    put_longword(hdr->original_size);
-    put_longword(unix_to_generic_stamp(hdr->unix_last_modified_stamp));
+    put_bytes(cur, hdr->method, 5);
+    put_longword(cur, hdr->packed_size);
+    put_longword(cur, hdr->original_size);
+    put_longword(cur, unix_to_generic_stamp(hdr->unix_last_modified_stamp));
     put_byte(0x20);
     put_byte(hdr->header_level); /* level 1 */
 	
@@ -999,10 +1513,10 @@ size_t LHAPack::write_header_level1(LHAHeader *hdr, char* data, char* pathname)
     else 
 	{
         put_byte(name_length);
-        put_bytes(basename, name_length);
+        put_bytes(cur, basename, name_length);
     }
 	
-    put_word(hdr->crc);
+    put_word(cur, hdr->crc);
 	
     if (generic_format)
         put_byte(0x00);
@@ -1018,22 +1532,22 @@ size_t LHAPack::write_header_level1(LHAHeader *hdr, char* data, char* pathname)
 	
     if (name_length > limit) 
 	{
-        put_word(name_length + 3); /* size */
+        put_word(cur, name_length + 3); /* size */
         put_byte(0x01);         /* filename */
-        put_bytes(basename, name_length);
+        put_bytes(cur, basename, name_length);
     }
 	
     if (dir_length > 0) 
 	{
-        put_word(dir_length + 3); /* size */
+        put_word(cur, dir_length + 3); /* size */
         put_byte(0x02);         /* dirname */
-        put_bytes(dirname, dir_length);
+        put_bytes(cur, dirname, dir_length);
     }
 	
     if (!generic_format)
-        write_unix_info(hdr);
+        write_unix_info(cur, hdr);
 	
-    put_word(0x0000);           /* next header size */
+    put_word(cur, 0x0000);           /* next header size */
 	
     extend_header_size = put_ptr - extend_header_top;
     /* On level 1 header, the packed size field is contains the ext-header */
@@ -1041,7 +1555,7 @@ size_t LHAPack::write_header_level1(LHAHeader *hdr, char* data, char* pathname)
 	
     /* put 'skip size' */
     setup_put(data + I_PACKED_SIZE);
-    put_longword(hdr->packed_size);
+    put_longword(cur, hdr->packed_size);
 	
     data[I_HEADER_SIZE] = header_size;
     data[I_HEADER_CHECKSUM] = calc_sum(data + I_METHOD, header_size);
@@ -1051,10 +1565,12 @@ size_t LHAPack::write_header_level1(LHAHeader *hdr, char* data, char* pathname)
 
 size_t LHAPack::write_header_level2(LHAHeader *hdr, char* data, char* pathname)
 {
+    LHACursor c;
+    LHACursor *cur = &c;
     int    name_length, dir_length;
-    char   *basename, *dirname;
+    char   *basename;
+    const char *dirname;
     size_t header_size;
-    char   *extend_header_top;
     char   *headercrc_ptr;
 
     unsigned int hcrc;
@@ -1078,15 +1594,15 @@ size_t LHAPack::write_header_level2(LHAHeader *hdr, char* data, char* pathname)
     setup_put(data);
     memset(data, 0, LZHEADER_STORAGE);
 	
-    put_word(0x0000);           /* header size */
-    put_bytes(hdr->method, 5);
-    put_longword(hdr->packed_size);
-    put_longword(hdr->original_size);
-    put_longword(hdr->unix_last_modified_stamp);
+    put_word(cur, 0x0000);           /* header size */
+    put_bytes(cur, hdr->method, 5);
+    put_longword(cur, hdr->packed_size);
+    put_longword(cur, hdr->original_size);
+    put_longword(cur, hdr->unix_last_modified_stamp);
     put_byte(0x20);
     put_byte(hdr->header_level); /* level 2 */
 	
-    put_word(hdr->crc);
+    put_word(cur, hdr->crc);
 	
     if (generic_format)
         put_byte(0x00);
@@ -1095,31 +1611,29 @@ size_t LHAPack::write_header_level2(LHAHeader *hdr, char* data, char* pathname)
 	
     /* write extend header from here. */
 	
-    extend_header_top = put_ptr+2; /* +2 for the field `next header size' */
-	
     /* write common header */
-    put_word(5);
+    put_word(cur, 5);
     put_byte(0x00);
     headercrc_ptr = put_ptr;
-    put_word(0x0000);           /* header CRC */
+    put_word(cur, 0x0000);           /* header CRC */
 	
     /* write filename and dirname */
     /* must have this header, even if the name_length is 0. */
-    put_word(name_length + 3);  /* size */
+    put_word(cur, name_length + 3);  /* size */
     put_byte(0x01);             /* filename */
-    put_bytes(basename, name_length);
+    put_bytes(cur, basename, name_length);
 	
     if (dir_length > 0)
 	{
-        put_word(dir_length + 3); /* size */
+        put_word(cur, dir_length + 3); /* size */
         put_byte(0x02);         /* dirname */
-        put_bytes(dirname, dir_length);
+        put_bytes(cur, dirname, dir_length);
     }
 	
     if (!generic_format)
-        write_unix_info(hdr);
+        write_unix_info(cur, hdr);
 	
-    put_word(0x0000);           /* next header size */
+    put_word(cur, 0x0000);           /* next header size */
 	
     header_size = put_ptr - data;
     if ((header_size & 0xff) == 0) 
@@ -1132,13 +1646,13 @@ size_t LHAPack::write_header_level2(LHAHeader *hdr, char* data, char* pathname)
 	
     /* put header size */
     setup_put(data + I_HEADER_SIZE);
-    put_word(header_size);
+    put_word(cur, header_size);
 	
     /* put header CRC in extended header */
     INITIALIZE_CRC(hcrc);
     hcrc = calccrc(hcrc, (unsigned char*)data, (unsigned int) header_size);
     setup_put(headercrc_ptr);
-    put_word(hcrc);
+    put_word(cur, hcrc);
 	
     return header_size;
 }
@@ -12,10 +12,20 @@
 #include <time.h>
 #include <limits.h>
 
+#include "LHAPort.h"
+
 #define METHOD_TYPE_STORAGE     5
 #define FILENAME_LENGTH         1024
+#define LZHEADER_STORAGE        4096    /* largest header write_header_level*() makes */
+#define LZHEADER_LENGTH_MAX     0x100000 /* largest header header_length() accepts */
+
+/* parse_header() flags */
+#define LHA_PARSE_LAZY          0x01    /* leave most extended header fields to read_extended() */
+#define LHA_PARSE_STRICT        0x02    /* verify the header checksum / header CRC */
 
+#ifndef CHAR_BIT
 #define CHAR_BIT 8
+#endif
 //#define UCHAR_MAX ((1<<(sizeof(unsigned char)*8))-1)
 
 
@@ -34,6 +44,8 @@ typedef struct LHAHeader {
     unsigned int    header_crc; /* header CRC */
     unsigned char   extend_type;
     unsigned char   minor_version;
+    unsigned int    extend_offset;  /* of the first extended header, from the header start */
+    BOOL            extend_pending; /* fields left for read_extended() */
 
     /* extend_type == EXTEND_UNIX  and convert from other type. */
     time_t          unix_last_modified_stamp;	
@@ -44,45 +56,56 @@ typedef struct LHAHeader {
     char            group[256];
 }  LHAHeader;
 
+struct LHACursor;
+
 class LHAPack  
 {
 public:
+	bool extract(const char *pMem, const LHAHeader *hdr, char *buf);
+	bool get_header(const char *pBegin, const char *pEnd, LHAHeader *hdr);
 	bool get_header(const char *pMem, LHAHeader *hdr);
-	int calc_sum(char *p,int len);
+	static bool parse_header(const char *pBegin, const char *pEnd, LHAHeader *hdr, size_t *dataoffset, int flags = 0);
+	static bool read_extended(const char *pBegin, const char *pEnd, LHAHeader *hdr);
+	static size_t header_length(const char *p, size_t avail);
+	size_t write_header(LHAHeader *hdr, char *data, char *pathname);
+	static SYSTEMTIME unix_to_win32_systemtime(time_t t);
+	SYSTEMTIME win32_systemtime() const;
+	static int calc_sum(char *p,int len);
 	LHAPack();
 	virtual ~LHAPack();
 public:
 	/* extend for me. */
-	SYSTEMTIME      win32_systemtime;
 	int             dataoffset;
 	bool            generic_format;
 private:
-	SYSTEMTIME unix_to_win32_systemtime(time_t t);
-	FILETIME unix_to_win32_filetime(time_t t);
-	unsigned int calccrc(unsigned int crc, unsigned char *p, unsigned int n);
-	void make_crctable();
-	bool get_header_level3(LHAHeader *hdr, char *data);
-	bool get_header_level2(LHAHeader *hdr, char *data);
-	bool get_header_level1(LHAHeader *hdr, char *data);
-	bool get_header_level0(LHAHeader *hdr, char* data);
-	void write_unix_info(LHAHeader *hdr);
+	time_t          modified_stamp;     /* for win32_systemtime() */
+	static FILETIME unix_to_win32_filetime(time_t t);
+	static unsigned int calccrc(unsigned int crc, const unsigned char *p, unsigned int n);
+	static bool read_header(const char *pMem, const char *pEnd, LHAHeader *hdr, size_t *dataoffset, int flags);
+	static bool readable(const LHACursor *cur, const char *p, size_t len);
+	static bool get_header_level3(LHACursor *cur, LHAHeader *hdr, char *data);
+	static bool get_header_level2(LHACursor *cur, LHAHeader *hdr, char *data);
+	static bool get_header_level1(LHACursor *cur, LHAHeader *hdr, char *data);
+	static bool get_header_level0(LHACursor *cur, LHAHeader *hdr, char* data);
+	static void write_unix_info(LHACursor *cur, LHAHeader *hdr);
 	size_t write_header_level0(LHAHeader *hdr, char* data, char* pathname);
 	size_t write_header_level1(LHAHeader *hdr, char* data, char* pathname);
 	size_t write_header_level2(LHAHeader *hdr, char* data, char* pathname);
-	int get_extended_header(LHAHeader *hdr, size_t header_size, unsigned int *hcrc);
-	unsigned long wintime_to_unix_stamp();
-	long unix_to_generic_stamp(time_t t);
-	time_t generic_to_unix_stamp(long t);
-	void put_bytes(char* buf, int len);
-	int get_bytes(char *buf, int len, int size);
-	void put_longword(long v);
-	long get_longword();
-	void put_word(unsigned int v);
-	int get_word();
-	
-	char    *get_ptr;
-	char    *mem_ptr;
-	unsigned int crctable[UCHAR_MAX + 1];
+	static int get_extended_header(LHACursor *cur, LHAHeader *hdr, size_t header_size, unsigned int *hcrc);
+	static unsigned long wintime_to_unix_stamp(LHACursor *cur);
+	static long unix_to_generic_stamp(time_t t);
+	static time_t generic_to_unix_stamp(long t);
+	static void put_bytes(LHACursor *cur, const char* buf, int len);
+	static int get_bytes(LHACursor *cur, char *buf, int len, int size);
+	static void put_longword(LHACursor *cur, long v);
+	static long get_longword(LHACursor *cur);
+	static void put_word(LHACursor *cur, unsigned int v);
+	static int get_word(LHACursor *cur);
+
+	friend class LHAWriter;
+
+	LHAPack(const LHAPack &);
+	LHAPack &operator=(const LHAPack &);
 
 };
 
@@ -0,0 +1,512 @@
+// LHAPipeline.cpp: implementation of the LHAPipeline class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef LHAPACK_STANDALONE
+#include "stdafx.h"
+#endif
+#include "LHAPipeline.h"
+#include "LHAArchive.h"
+#include "LHADecode.h"
+#include "LHAThreadPool.h"
+#include "LHAStats.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#define open_read(path)     _open(path, _O_RDONLY | _O_BINARY)
+#define open_write(path)    _open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE)
+#define close_file(fd)      _close(fd)
+#define file_stat           _stati64
+#define file_fstat(fd, st)  _fstati64(fd, st)
+#else
+#include <unistd.h>
+#define open_read(path)     ::open(path, O_RDONLY | O_CLOEXEC)
+#define open_write(path)    ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666)
+#define close_file(fd)      ::close(fd)
+#define file_stat           stat
+#define file_fstat(fd, st)  fstat(fd, st)
+#endif
+
+#define SCAN_CHUNK          0x10000     /* headers are read this much at a time */
+#define SCAN_MAX            0x100000    /* largest header looked for */
+
+/* request tags: the member index and what was asked for */
+enum {
+    TAG_READ,
+    TAG_DECODED,
+    TAG_WRITE
+};
+#define MAKE_TAG(i, kind)   (((uint64_t)(i) << 2) | (kind))
+#define TAG_MEMBER(tag)     ((size_t)((tag) >> 2))
+#define TAG_KIND(tag)       ((int)((tag) & 3))
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+LHAPipeline::LHAPipeline()
+{
+	fd           = -1;
+	depth        = PIPELINE_QUEUE_DEPTH;
+	buffer_limit = PIPELINE_BUFFER_LIMIT;
+	async        = true;
+}
+
+LHAPipeline::~LHAPipeline()
+{
+	close();
+}
+
+/* open the archive at path and list its members */
+bool LHAPipeline::open(const char *path)
+{
+	struct file_stat st;
+
+	close();
+
+	fd = open_read(path);
+	if (fd < 0)
+		return false;
+	if (file_fstat(fd, &st) != 0 || !scan((uint64_t)st.st_size)) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void LHAPipeline::close()
+{
+	io.close();
+	if (fd >= 0)
+		close_file(fd);
+	fd = -1;
+	members.clear();
+}
+
+/*
+ * Walk the headers the way LHAArchive::iterator does, reading them into a
+ * buffer SCAN_CHUNK at a time so runs of small members cost one read.  A
+ * header that does not parse from a buffer starting at it is given twice
+ * the room, up to SCAN_MAX, before it is taken for the end of the archive.
+ */
+bool LHAPipeline::scan(uint64_t length)
+{
+	std::vector<char> buf;
+	LHAHeader         *hdr   = new LHAHeader;
+	uint64_t          base   = 0, offset = 0;
+	size_t            got    = 0, want = SCAN_CHUNK;
+	size_t            dataoffset;
+	bool              ok     = true;
+
+	while (offset < length) {
+		bool buffered = offset >= base && offset < base + got;
+
+		if (buffered && buf[(size_t)(offset - base)] == 0)
+			break;                      /* end mark */
+
+		if (!buffered ||
+		    !LHAPack::parse_header(&buf[(size_t)(offset - base)], &buf[0] + got, hdr, &dataoffset)) {
+			if (base == offset) {
+				if (base + got >= length || want >= SCAN_MAX)
+					break;              /* a bad header */
+				want *= 2;
+			}
+			else
+				want = SCAN_CHUNK;
+
+			size_t  n = (size_t)(length - offset < want ? length - offset : want);
+			int64_t r;
+
+			buf.resize(n);
+			r = LHAIoQueue::read_at(fd, &buf[0], n, offset);
+			if (r <= 0) {
+				ok = false;
+				break;
+			}
+			base = offset;
+			got  = (size_t)r;
+			continue;
+		}
+
+		if (dataoffset > length - offset || hdr->packed_size > length - offset - dataoffset)
+			break;
+		if (!members.append(hdr, offset, dataoffset)) {
+			ok = false;
+			break;
+		}
+		offset += dataoffset + hdr->packed_size;
+	}
+
+	delete hdr;
+	return ok;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Extraction
+//////////////////////////////////////////////////////////////////////
+
+/* a member between its first read and its last write */
+struct PipelineMember {
+    std::vector<char>   packed;
+    std::vector<char>   data;
+    uint64_t            done;       /* bytes read, then bytes written */
+    int                 out;        /* output file */
+    bool                ok;         /* decoded and its CRC matched */
+};
+
+struct PipelineJob {
+    const LHAListing                *members;
+    LHAIoQueue                      *io;
+    int                             fd;
+    const char                      *dir;
+    unsigned                        depth;
+    size_t                          buffer_limit;
+    std::vector<PipelineMember *>   active;     /* by member index, NULL when not in flight */
+    int                             failures;   /* I/O thread only */
+    bool                            drained;    /* the queue holds no request for a member's buffers */
+
+    std::mutex                      lock;
+    std::condition_variable         wake;
+    std::deque<size_t>              decode;     /* read in, waiting for a worker */
+    bool                            finished;
+};
+
+static uint64_t member_cost(const LHAListEntry &e)
+{
+    return e.packed_size + e.original_size;
+}
+
+static bool read_next(PipelineJob *job, size_t i)
+{
+    const LHAListEntry &e = (*job->members)[i];
+    PipelineMember     *m = job->active[i];
+    uint64_t           left = e.packed_size - m->done;
+
+    return job->io->read(job->fd, &m->packed[(size_t)m->done], (size_t)(left < LHA_IO_MAX ? left : LHA_IO_MAX),
+                         e.offset + e.dataoffset + m->done, MAKE_TAG(i, TAG_READ));
+}
+
+static bool write_next(PipelineJob *job, size_t i)
+{
+    const LHAListEntry &e = (*job->members)[i];
+    PipelineMember     *m = job->active[i];
+    uint64_t           left = e.original_size - m->done;
+
+    return job->io->write(m->out, &m->data[(size_t)m->done], (size_t)(left < LHA_IO_MAX ? left : LHA_IO_MAX),
+                          m->done, MAKE_TAG(i, TAG_WRITE));
+}
+
+static void queue_decode(PipelineJob *job, size_t i)
+{
+    std::lock_guard<std::mutex> hold(job->lock);
+    job->decode.push_back(i);
+    job->wake.notify_one();
+}
+
+/* the member leaves the pipeline; always returns true */
+static bool finish(PipelineJob *job, size_t i, bool ok)
+{
+    PipelineMember *m = job->active[i];
+
+    if (m->out >= 0 && close_file(m->out) != 0)
+        ok = false;
+    if (!ok)
+        job->failures++;
+    else
+        LHA_STAT_COUNT(LHA_STAT_OUTPUT, 1, (*job->members)[i].original_size);    /* no time: the writes overlap */
+    delete m;
+    job->active[i] = NULL;
+    return true;
+}
+
+/*
+ * Put member i in flight: its first read, or straight to a worker when
+ * it has no packed data.  Directories are made on the spot.  Returns
+ * false if the member is not in flight.
+ */
+static bool start(PipelineJob *job, size_t i)
+{
+    const LHAListEntry &e = (*job->members)[i];
+    PipelineMember     *m;
+    std::string        path;
+
+    if (e.method == LZHDIRS_METHOD_NUM) {
+        if (LHAArchive::output_path(job->dir, job->members->name(i), &path))
+            LHAArchive::make_dirs(path);
+        else
+            job->failures++;
+        return false;
+    }
+
+    m       = new PipelineMember;
+    m->done = 0;
+    m->out  = -1;
+    m->ok   = false;
+    m->packed.resize((size_t)e.packed_size + 1);
+    job->active[i] = m;
+
+    if (e.packed_size == 0)
+        queue_decode(job, i);
+    else if (!read_next(job, i))
+        return !finish(job, i, false);
+    return true;
+}
+
+static bool open_output(PipelineJob *job, size_t i)
+{
+    PipelineMember *m = job->active[i];
+    std::string    path;
+
+    if (!LHAArchive::output_path(job->dir, job->members->name(i), &path))
+        return false;
+    LHAArchive::make_dirs(path.substr(0, path.rfind('/')));
+    m->out = open_write(path.c_str());
+    return m->out >= 0;
+}
+
+/* act on one completion; true when its member has left the pipeline */
+static bool complete(PipelineJob *job, uint64_t tag, int64_t result)
+{
+    size_t             i = TAG_MEMBER(tag);
+    const LHAListEntry &e = (*job->members)[i];
+    PipelineMember     *m = job->active[i];
+
+    switch (TAG_KIND(tag)) {
+    case TAG_READ:
+        if (result <= 0)
+            return finish(job, i, false);
+        m->done += result;
+        if (m->done < e.packed_size)
+            return read_next(job, i) ? false : finish(job, i, false);
+        queue_decode(job, i);
+        return false;
+
+    case TAG_DECODED:
+        if (!m->ok || !open_output(job, i))
+            return finish(job, i, false);
+        m->done = 0;
+        if (e.original_size == 0)
+            return finish(job, i, true);
+        return write_next(job, i) ? false : finish(job, i, false);
+
+    case TAG_WRITE:
+        if (result <= 0)
+            return finish(job, i, false);
+        m->done += result;
+        if (m->done < e.original_size)
+            return write_next(job, i) ? false : finish(job, i, false);
+        return finish(job, i, true);
+    }
+    return false;
+}
+
+/*
+ * The I/O thread: keep reads going for the members ahead, within the
+ * queue depth and the buffer limit, then take every completion that is
+ * in before submitting again, so the writes of all the members decoded
+ * meanwhile go to the kernel together.
+ */
+static void io_loop(PipelineJob *job)
+{
+    const LHAListing &members = *job->members;
+    size_t           count    = members.size();
+    size_t           next     = 0, inflight = 0;
+    uint64_t         buffered = 0, tag;
+    int64_t          result;
+    bool             failed   = false;
+
+    for (;;) {
+        while (next < count) {
+            uint64_t cost = member_cost(members[next]);
+
+            if (inflight && (inflight >= job->depth || buffered + cost > job->buffer_limit))
+                break;
+            if (start(job, next)) {
+                inflight++;
+                buffered += cost;
+            }
+            next++;
+        }
+        if (inflight == 0)
+            break;
+
+        job->io->submit();
+        if (!job->io->wait(&tag, &result)) {
+            failed = true;
+            break;
+        }
+        do {
+            if (complete(job, tag, result)) {
+                inflight--;
+                buffered -= member_cost(members[TAG_MEMBER(tag)]);
+            }
+        } while (job->io->poll(&tag, &result));
+    }
+
+    /* left over only if the queue failed */
+    job->failures += (int)(inflight + count - next);
+
+    {
+        std::lock_guard<std::mutex> hold(job->lock);
+        job->finished = true;
+        if (failed)
+            job->decode.clear();    /* read in: nothing of theirs is queued */
+        job->wake.notify_all();
+    }
+
+    /*
+     * Reads and writes for the members still in flight may be queued
+     * yet, into buffers that extract_all() frees once this returns:
+     * wait for them first.
+     */
+    if (failed)
+        job->drained = job->io->drain();
+}
+
+static bool append_output(void *param, const void *buf, size_t len)
+{
+    std::vector<char> *out = (std::vector<char> *)param;
+
+    out->insert(out->end(), (const char *)buf, (const char *)buf + len);
+    return true;
+}
+
+/*
+ * Decode member i's packed data into m->data.  The decoder streams it, so
+ * that the buffer grows with what is actually decoded: a header claiming
+ * gigabytes for a few bytes of data gets no more than the buffer limit
+ * reserved, and fails when its data runs out.
+ */
+static bool decode_member(PipelineJob *job, LHADecoder &decoder, const LHAListEntry &e, PipelineMember *m)
+{
+    uint64_t done = 0;
+    size_t   used;
+
+    m->data.clear();
+    m->data.reserve((size_t)(e.original_size < job->buffer_limit ? e.original_size : job->buffer_limit));
+    if (!decoder.begin_stream(e.method, e.packed_size, e.original_size, append_output, &m->data))
+        return false;
+    while (done < e.packed_size) {
+        if (!decoder.stream(&m->packed[(size_t)done], (size_t)(e.packed_size - done), &used) || used == 0)
+            return false;
+        done += used;
+    }
+    return decoder.end_stream();
+}
+
+/* a decode worker: decode members as they are read in */
+static void decode_loop(PipelineJob *job)
+{
+    size_t i;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> hold(job->lock);
+            while (job->decode.empty() && !job->finished)
+                job->wake.wait(hold);
+            if (job->decode.empty())
+                break;
+            i = job->decode.front();
+            job->decode.pop_front();
+        }
+
+        const LHAListEntry &e = (*job->members)[i];
+        PipelineMember     *m = job->active[i];
+
+        LHADecoderContext decoder;
+
+        if (decoder->pass_through(e.method, &m->packed[0], (size_t)e.packed_size, (size_t)e.original_size)) {
+            /* stored: what was read is what gets written */
+            m->ok = true;
+            m->data.swap(m->packed);
+        }
+        else
+            m->ok = decode_member(job, *decoder, e, m);
+        if (m->ok && e.has_crc && decoder->crc != e.crc) {
+            LHA_STAT_CRC_FAILURE();
+            m->ok = false;
+        }
+        std::vector<char>().swap(m->packed);
+
+        {
+            std::lock_guard<std::mutex> hold(job->lock);
+            if (job->finished)
+                continue;           /* the queue failed; nobody is waiting */
+        }
+        while (!job->io->nop(MAKE_TAG(i, TAG_DECODED)))
+            job->io->submit();      /* cannot happen within the queue depth */
+        job->io->submit();
+    }
+}
+
+static void pipeline_task(void *param, size_t task, int)
+{
+    if (task == 0)
+        io_loop((PipelineJob *)param);
+    else
+        decode_loop((PipelineJob *)param);
+}
+
+/*
+ * Extract every member into files below dir, decoding on `threads'
+ * threads (0: one per CPU) besides the one doing the I/O.  Returns the
+ * number of members that could not be extracted.
+ */
+int LHAPipeline::extract_all(const char *dir, int threads)
+{
+	PipelineJob         job;
+	std::vector<size_t> loops;
+	size_t              i;
+
+	if (fd < 0)
+		return 0;
+
+	if (threads <= 0)
+		threads = (int)std::thread::hardware_concurrency();
+	if (threads <= 0)
+		threads = 1;
+
+	/* at most one request per member in flight */
+	io.open(depth, async);
+	LHAArchive::make_dirs(dir);
+
+	job.members      = &members;
+	job.io           = &io;
+	job.fd           = fd;
+	job.dir          = dir;
+	job.depth        = depth;
+	job.buffer_limit = buffer_limit;
+	job.failures     = 0;
+	job.drained      = true;
+	job.finished     = false;
+	job.active.assign(members.size(), NULL);
+
+	/* the I/O loop and one decode loop per thread, each on its own worker */
+	LHAThreadPool pool(threads + 1);
+	for (i = 0; i <= (size_t)threads; i++)
+		loops.push_back(i);
+	pool.run(pipeline_task, &job, &loops[0], loops.size());
+
+	/*
+	 * A ring that failed and could not be drained may still be reading
+	 * into the buffers of the members left in flight: tear it down, and
+	 * leave those buffers to it rather than free them under the kernel.
+	 */
+	if (!job.drained)
+		io.close();
+	else
+		for (i = 0; i < job.active.size(); i++)
+			delete job.active[i];
+
+	LHAStats::report();
+	return job.failures;
+}
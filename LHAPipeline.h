@@ -0,0 +1,68 @@
+// LHAPipeline.h: interface for the LHAPipeline class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#if !defined(AFX_LHAPIPELINE_H__3103AADA_9873_4E82_93AA_423D10ACE96A__INCLUDED_)
+#define AFX_LHAPIPELINE_H__3103AADA_9873_4E82_93AA_423D10ACE96A__INCLUDED_
+
+#if _MSC_VER > 1000
+#pragma once
+#endif // _MSC_VER > 1000
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "LHAListing.h"
+#include "LHAIoQueue.h"
+
+#define PIPELINE_QUEUE_DEPTH    64              /* members in flight */
+#define PIPELINE_BUFFER_LIMIT   (64 << 20)      /* bytes buffered for them */
+
+/*
+ * Extraction for archives on storage where read latency dominates.
+ *
+ * Instead of mapping the archive, open() reads its headers with pread()
+ * into a listing.  extract_all() then reads the packed bytes of upcoming
+ * members ahead through an LHAIoQueue (io_uring where there is one),
+ * decodes them on worker threads, and writes each output with async
+ * writes, batched with whatever else is ready when it is submitted.  No
+ * more than the queue depth of members, and no more than the buffer
+ * limit of packed plus decoded bytes, are in flight at once (a member
+ * bigger than the limit goes through on its own).
+ *
+ *     LHAPipeline p;
+ *     p.open("big.lzh");
+ *     failures = p.extract_all("out", 8);
+ */
+class LHAPipeline
+{
+public:
+	bool open(const char *path);
+	void close();
+	bool is_open() const                    { return fd >= 0; }
+	const LHAListing &listing() const       { return members; }
+
+	void set_queue_depth(unsigned depth)    { this->depth = depth ? depth : 1; }
+	void set_buffer_limit(size_t bytes)     { buffer_limit = bytes; }
+	void set_async(bool async)              { this->async = async; }
+	bool is_async() const                   { return io.is_async(); }  /* after extract_all() */
+
+	int  extract_all(const char *dir, int threads = 0);
+
+	LHAPipeline();
+	virtual ~LHAPipeline();
+private:
+	bool scan(uint64_t length);
+
+	int         fd;
+	LHAListing  members;
+	LHAIoQueue  io;
+	unsigned    depth;
+	size_t      buffer_limit;
+	bool        async;
+
+	LHAPipeline(const LHAPipeline &);
+	LHAPipeline &operator=(const LHAPipeline &);
+};
+
+#endif // !defined(AFX_LHAPIPELINE_H__3103AADA_9873_4E82_93AA_423D10ACE96A__INCLUDED_)
@@ -0,0 +1,213 @@
+// LHAPort.cpp: file mapping, and POSIX versions of the Win32 time functions.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef LHAPACK_STANDALONE
+#include "stdafx.h"
+#endif
+#include "LHAPort.h"
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////
+// LHAFileMap
+//////////////////////////////////////////////////////////////////////
+
+LHAFileMap::LHAFileMap()
+{
+	base    = NULL;
+	length  = 0;
+	mtime   = 0;
+	opened  = false;
+#ifdef _WIN32
+	file    = INVALID_HANDLE_VALUE;
+	mapping = NULL;
+#else
+	fd      = -1;
+#endif
+}
+
+LHAFileMap::~LHAFileMap()
+{
+	close();
+}
+
+bool LHAFileMap::open(const char *path, Access access)
+{
+	close();
+
+#ifdef _WIN32
+	LARGE_INTEGER size;
+	FILETIME      ft;
+
+	file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+	                   access == ACCESS_SEQUENTIAL ? FILE_FLAG_SEQUENTIAL_SCAN
+	                                               : FILE_FLAG_RANDOM_ACCESS, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	if (!GetFileSizeEx(file, &size) || !GetFileTime(file, NULL, NULL, &ft)) {
+		close();
+		return false;
+	}
+	length = (size_t)size.QuadPart;
+	mtime  = ((int64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+	if (length) {
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping == NULL) {
+			close();
+			return false;
+		}
+		base = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (base == NULL) {
+			close();
+			return false;
+		}
+	}
+#else
+	struct stat st;
+
+	fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+	if (fstat(fd, &st) != 0) {
+		close();
+		return false;
+	}
+	length = (size_t)st.st_size;
+#if defined(__APPLE__)
+	mtime  = (int64_t)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+	mtime  = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+	if (length) {
+		void *p = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p == MAP_FAILED) {
+			close();
+			return false;
+		}
+		madvise(p, length, access == ACCESS_SEQUENTIAL ? MADV_SEQUENTIAL : MADV_RANDOM);
+		base = (const char *)p;
+	}
+#endif
+
+	opened = true;
+	return true;
+}
+
+time_t LHAFileMap::modified_time() const
+{
+#ifdef _WIN32
+	return (time_t)((mtime - 116444736000000000LL) / 10000000);
+#else
+	return (time_t)(mtime / 1000000000);
+#endif
+}
+
+void LHAFileMap::close()
+{
+#ifdef _WIN32
+	if (base)
+		UnmapViewOfFile(base);
+	if (mapping)
+		CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+	mapping = NULL;
+	file    = INVALID_HANDLE_VALUE;
+#else
+	if (base)
+		munmap((void *)base, length);
+	if (fd >= 0)
+		::close(fd);
+	fd = -1;
+#endif
+	base   = NULL;
+	length = 0;
+	mtime  = 0;
+	opened = false;
+}
+
+#ifndef _WIN32
+
+#define FILETIME_PER_SECOND     10000000ULL
+#define FILETIME_UNIX_EPOCH     116444736000000000ULL   /* 1970-01-01 00:00:00 */
+#define DAYS_1601_TO_1970       134774
+
+static inline uint64_t filetime_to_u64(const FILETIME *ft)
+{
+    return ((uint64_t)ft->dwHighDateTime << 32) | ft->dwLowDateTime;
+}
+
+/*
+ * Days since 1970-01-01 to a proleptic Gregorian date, valid for the
+ * whole FILETIME range (H. Hinnant's civil_from_days).
+ */
+static void civil_from_days(int64_t z, int *y, unsigned *m, unsigned *d)
+{
+    int64_t  era;
+    unsigned doe, yoe, doy, mp;
+
+    z  += 719468;
+    era = (z >= 0 ? z : z - 146096) / 146097;
+    doe = (unsigned)(z - era * 146097);
+    yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    mp  = (5 * doy + 2) / 153;
+    *d  = doy - (153 * mp + 2) / 5 + 1;
+    *m  = mp < 10 ? mp + 3 : mp - 9;
+    *y  = (int)(yoe + era * 400) + (*m <= 2);
+}
+
+BOOL FileTimeToSystemTime(const FILETIME *lpFileTime, SYSTEMTIME *lpSystemTime)
+{
+    uint64_t t = filetime_to_u64(lpFileTime);
+    uint64_t ms, days, rem;
+    int      y;
+    unsigned m, d;
+
+    if (t >> 63)
+        return FALSE;
+
+    ms   = t / 10000;
+    days = ms / 86400000;
+    rem  = ms % 86400000;
+
+    civil_from_days((int64_t)days - DAYS_1601_TO_1970, &y, &m, &d);
+
+    lpSystemTime->wYear         = (WORD)y;
+    lpSystemTime->wMonth        = (WORD)m;
+    lpSystemTime->wDay          = (WORD)d;
+    lpSystemTime->wDayOfWeek    = (WORD)((days + 1) % 7);     /* 1601-01-01 was a Monday */
+    lpSystemTime->wHour         = (WORD)(rem / 3600000);
+    lpSystemTime->wMinute       = (WORD)(rem / 60000 % 60);
+    lpSystemTime->wSecond       = (WORD)(rem / 1000 % 60);
+    lpSystemTime->wMilliseconds = (WORD)(rem % 1000);
+    return TRUE;
+}
+
+/* local time -> UTC, using the zone's UTC offset at that time */
+BOOL LocalFileTimeToFileTime(const FILETIME *lpLocalFileTime, FILETIME *lpFileTime)
+{
+    uint64_t local = filetime_to_u64(lpLocalFileTime);
+    int64_t  offset;
+    time_t   t;
+    struct tm lt;
+
+    t = (time_t)(((int64_t)local - (int64_t)FILETIME_UNIX_EPOCH) / (int64_t)FILETIME_PER_SECOND);
+    if (localtime_r(&t, &lt) == NULL)
+        return FALSE;
+    offset = lt.tm_gmtoff;
+
+    local -= (uint64_t)(offset * (int64_t)FILETIME_PER_SECOND);
+    lpFileTime->dwLowDateTime  = (DWORD)local;
+    lpFileTime->dwHighDateTime = (DWORD)(local >> 32);
+    return TRUE;
+}
+
+#endif /* !_WIN32 */
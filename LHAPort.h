@@ -0,0 +1,100 @@
+// LHAPort.h: Win32 types, time functions and file mapping used by LHAPack.
+//
+//////////////////////////////////////////////////////////////////////
+
+#if !defined(AFX_LHAPORT_H__3A5CD3BD_C0E4_48AA_9967_31194334AE89__INCLUDED_)
+#define AFX_LHAPORT_H__3A5CD3BD_C0E4_48AA_9967_31194334AE89__INCLUDED_
+
+#if _MSC_VER > 1000
+#pragma once
+#endif // _MSC_VER > 1000
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+#else /* !_WIN32 */
+
+/*
+ * The subset of the Win32 API that LHAPack uses, so the same sources build
+ * on POSIX systems.  Layouts and semantics follow the Win32 definitions.
+ */
+typedef int             BOOL;
+typedef uint16_t        WORD;
+typedef uint32_t        DWORD;
+typedef int64_t         LONGLONG;
+
+#ifndef TRUE
+#define TRUE            1
+#endif
+#ifndef FALSE
+#define FALSE           0
+#endif
+
+typedef struct _SYSTEMTIME {
+    WORD wYear;
+    WORD wMonth;
+    WORD wDayOfWeek;
+    WORD wDay;
+    WORD wHour;
+    WORD wMinute;
+    WORD wSecond;
+    WORD wMilliseconds;
+} SYSTEMTIME;
+
+/* 100-nanosecond intervals since 1601-01-01 00:00:00 */
+typedef struct _FILETIME {
+    DWORD dwLowDateTime;
+    DWORD dwHighDateTime;
+} FILETIME;
+
+#define Int32x32To64(a, b)  ((LONGLONG)(a) * (LONGLONG)(b))
+
+BOOL FileTimeToSystemTime(const FILETIME *lpFileTime, SYSTEMTIME *lpSystemTime);
+BOOL LocalFileTimeToFileTime(const FILETIME *lpLocalFileTime, FILETIME *lpFileTime);
+
+#endif /* _WIN32 */
+
+/*
+ * Read-only mapping of a whole file.  An empty file opens with data()
+ * NULL and size() 0.
+ */
+class LHAFileMap
+{
+public:
+	enum Access {
+	    ACCESS_SEQUENTIAL,      /* read ahead aggressively */
+	    ACCESS_RANDOM           /* only fault in what is touched */
+	};
+
+	bool open(const char *path, Access access);
+	void close();
+	bool is_open() const        { return opened; }
+	const char *data() const    { return base; }
+	size_t size() const         { return length; }
+	int64_t modified() const    { return mtime; }   /* native units, for comparing only */
+	time_t  modified_time() const;                  /* the same as a unix time stamp */
+	LHAFileMap();
+	virtual ~LHAFileMap();
+private:
+	const char  *base;
+	size_t      length;
+	int64_t     mtime;
+	bool        opened;
+#ifdef _WIN32
+	HANDLE      file;
+	HANDLE      mapping;
+#else
+	int         fd;
+#endif
+
+	LHAFileMap(const LHAFileMap &);
+	LHAFileMap &operator=(const LHAFileMap &);
+};
+
+#endif // !defined(AFX_LHAPORT_H__3A5CD3BD_C0E4_48AA_9967_31194334AE89__INCLUDED_)
@@ -0,0 +1,204 @@
+// LHAStats.cpp: implementation of the LHAStats class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef LHAPACK_STANDALONE
+#include "stdafx.h"
+#endif
+#include "LHAStats.h"
+
+#include <string.h>
+#include <mutex>
+
+#ifdef LHAPACK_STATS
+#include <atomic>
+
+/*
+ * One thread's counters.  Only the owner writes them, so an update is a
+ * relaxed load and store rather than a locked add; the atomics only keep
+ * snapshot() from reading a torn value.  Blocks are never freed: when a
+ * thread exits its counts move to `retired' and the block is left for
+ * the next new thread to claim.
+ */
+struct StatBlock {
+    std::atomic<uint64_t>   calls[LHA_STAT_STAGES];
+    std::atomic<uint64_t>   bytes[LHA_STAT_STAGES];
+    std::atomic<uint64_t>   ns[LHA_STAT_STAGES];
+    std::atomic<uint64_t>   crc_failures;
+    std::atomic<bool>       in_use;
+    StatBlock               *next;      /* set before the block is published */
+};
+
+static std::atomic<StatBlock *> blocks(NULL);
+static StatBlock                retired;
+
+static inline void bump(std::atomic<uint64_t> &counter, uint64_t n)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+static void clear_block(StatBlock *b)
+{
+    for (int i = 0; i < LHA_STAT_STAGES; i++) {
+        b->calls[i].store(0, std::memory_order_relaxed);
+        b->bytes[i].store(0, std::memory_order_relaxed);
+        b->ns[i].store(0, std::memory_order_relaxed);
+    }
+    b->crc_failures.store(0, std::memory_order_relaxed);
+}
+
+/* a free block off the list, or a new one pushed onto it */
+static StatBlock *claim_block()
+{
+    StatBlock *b;
+
+    for (b = blocks.load(std::memory_order_acquire); b; b = b->next) {
+        bool free = false;
+        if (!b->in_use.load(std::memory_order_relaxed) &&
+            b->in_use.compare_exchange_strong(free, true, std::memory_order_acquire))
+            return b;
+    }
+
+    b = new StatBlock;
+    clear_block(b);
+    b->in_use.store(true, std::memory_order_relaxed);
+    b->next = blocks.load(std::memory_order_relaxed);
+    while (!blocks.compare_exchange_weak(b->next, b, std::memory_order_release, std::memory_order_relaxed))
+        ;
+    return b;
+}
+
+static void release_block(StatBlock *b)
+{
+    for (int i = 0; i < LHA_STAT_STAGES; i++) {
+        retired.calls[i].fetch_add(b->calls[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        retired.bytes[i].fetch_add(b->bytes[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        retired.ns[i].fetch_add(b->ns[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    retired.crc_failures.fetch_add(b->crc_failures.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    clear_block(b);
+    b->in_use.store(false, std::memory_order_release);
+}
+
+struct ThreadStats {
+    StatBlock *block;
+
+    ThreadStats() : block(NULL) {}
+    ~ThreadStats()
+    {
+        if (block)
+            release_block(block);
+    }
+};
+
+static thread_local ThreadStats thread_stats;
+
+static inline StatBlock *my_block()
+{
+    if (thread_stats.block == NULL)
+        thread_stats.block = claim_block();
+    return thread_stats.block;
+}
+
+static void add_block(LHAStatsSnapshot *s, const StatBlock *b)
+{
+    for (int i = 0; i < LHA_STAT_STAGES; i++) {
+        s->calls[i] += b->calls[i].load(std::memory_order_relaxed);
+        s->bytes[i] += b->bytes[i].load(std::memory_order_relaxed);
+        s->ns[i]    += b->ns[i].load(std::memory_order_relaxed);
+    }
+    s->crc_failures += b->crc_failures.load(std::memory_order_relaxed);
+}
+#endif /* LHAPACK_STATS */
+
+static std::mutex   export_lock;
+static LHAStatsProc export_proc  = NULL;
+static void         *export_param = NULL;
+
+//////////////////////////////////////////////////////////////////////
+// Counting
+//////////////////////////////////////////////////////////////////////
+
+bool LHAStats::enabled()
+{
+#ifdef LHAPACK_STATS
+	return true;
+#else
+	return false;
+#endif
+}
+
+void LHAStats::count(int stage, uint64_t calls, uint64_t bytes, uint64_t ns)
+{
+#ifdef LHAPACK_STATS
+	StatBlock *b = my_block();
+
+	bump(b->calls[stage], calls);
+	bump(b->bytes[stage], bytes);
+	bump(b->ns[stage], ns);
+#else
+	(void)stage;
+	(void)calls;
+	(void)bytes;
+	(void)ns;
+#endif
+}
+
+void LHAStats::crc_failure()
+{
+#ifdef LHAPACK_STATS
+	bump(my_block()->crc_failures, 1);
+#endif
+}
+
+/* the totals over all threads, past and present */
+void LHAStats::snapshot(LHAStatsSnapshot *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+#ifdef LHAPACK_STATS
+	for (const StatBlock *b = blocks.load(std::memory_order_acquire); b; b = b->next)
+		add_block(stats, b);
+	add_block(stats, &retired);
+#endif
+}
+
+const char *LHAStats::stage_name(int stage)
+{
+	switch (stage) {
+	case LHA_STAT_HEADER:   return "header";
+	case LHA_STAT_EXTENDED: return "extended";
+	case LHA_STAT_CRC:      return "crc";
+	case LHA_STAT_DECODE:   return "decode";
+	case LHA_STAT_OUTPUT:   return "output";
+	}
+	return "unknown";
+}
+
+//////////////////////////////////////////////////////////////////////
+// Export
+//////////////////////////////////////////////////////////////////////
+
+/*
+ * Have report() hand the counters to proc (NULL: nobody).  The library
+ * reports at the end of every extract_all().
+ */
+void LHAStats::set_export(LHAStatsProc proc, void *param)
+{
+	std::lock_guard<std::mutex> guard(export_lock);
+
+	export_proc  = proc;
+	export_param = param;
+}
+
+void LHAStats::report()
+{
+#ifdef LHAPACK_STATS
+	std::lock_guard<std::mutex> guard(export_lock);
+	LHAStatsSnapshot            stats;
+
+	if (export_proc == NULL)
+		return;
+	snapshot(&stats);
+	export_proc(export_param, &stats);
+#endif
+}
@@ -0,0 +1,100 @@
+// LHAStats.h: interface for the LHAStats class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#if !defined(AFX_LHASTATS_H__220F3497_EB43_49D0_B9FF_3347EBFD1972__INCLUDED_)
+#define AFX_LHASTATS_H__220F3497_EB43_49D0_B9FF_3347EBFD1972__INCLUDED_
+
+#if _MSC_VER > 1000
+#pragma once
+#endif // _MSC_VER > 1000
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef LHAPACK_STATS
+#include <chrono>
+#endif
+
+/* stages counted; a stage that runs inside another is counted in both */
+enum LHAStatStage {
+    LHA_STAT_HEADER,        /* parsing a header, extended headers included */
+    LHA_STAT_EXTENDED,      /* parsing the extended headers */
+    LHA_STAT_CRC,           /* CRC-16 */
+    LHA_STAT_DECODE,        /* decoding a member, its CRC included */
+    LHA_STAT_OUTPUT,        /* storing extracted members */
+    LHA_STAT_STAGES
+};
+
+typedef struct LHAStatsSnapshot {
+    uint64_t    calls[LHA_STAT_STAGES];     /* headers, CRC runs, members, ... */
+    uint64_t    bytes[LHA_STAT_STAGES];
+    uint64_t    ns[LHA_STAT_STAGES];
+    uint64_t    crc_failures;               /* members that decoded with a wrong CRC */
+} LHAStatsSnapshot;
+
+/* receives the counters from LHAStats::report() */
+typedef void (*LHAStatsProc)(void *param, const LHAStatsSnapshot *stats);
+
+/*
+ * Hot path counters, compiled in only with LHAPACK_STATS defined (the
+ * CMake option of that name).  Without it the LHA_STAT_* macros below
+ * expand to nothing and snapshot() reads all zeros.
+ *
+ * Each thread counts into a block of its own, with plain loads and
+ * stores; snapshot() sums the blocks without stopping anyone, so it may
+ * miss updates made while it runs.  Counts of threads that have exited
+ * are kept.  Times are wall-clock nanoseconds from steady_clock.
+ *
+ *     LHAStats::set_export(push_to_metrics, &ctx);
+ *     archive.extract_all("out");     // reports when done
+ */
+class LHAStats
+{
+public:
+	static bool        enabled();
+	static void        snapshot(LHAStatsSnapshot *stats);
+	static const char *stage_name(int stage);
+
+	static void        set_export(LHAStatsProc proc, void *param);
+	static void        report();
+
+	/* for the LHA_STAT_* macros */
+	static void        count(int stage, uint64_t calls, uint64_t bytes, uint64_t ns);
+	static void        crc_failure();
+};
+
+#ifdef LHAPACK_STATS
+/* times the enclosing block as one call (or LHA_STAT_CALLS()) of `stage' */
+class LHAStatScope
+{
+public:
+	explicit LHAStatScope(int stage) : stage(stage), calls(1), bytes(0), start(std::chrono::steady_clock::now()) {}
+	~LHAStatScope()
+	{
+		LHAStats::count(stage, calls, bytes, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		                std::chrono::steady_clock::now() - start).count());
+	}
+	void add(uint64_t n)        { bytes += n; }
+	void set_calls(uint64_t n)  { calls = n; }
+private:
+	int                                     stage;
+	uint64_t                                calls;
+	uint64_t                                bytes;
+	std::chrono::steady_clock::time_point   start;
+};
+
+#define LHA_STAT_SCOPE(stage)               LHAStatScope lha_stat_scope(stage)
+#define LHA_STAT_BYTES(n)                   lha_stat_scope.add(n)
+#define LHA_STAT_CALLS(n)                   lha_stat_scope.set_calls(n)
+#define LHA_STAT_COUNT(stage, calls, bytes) LHAStats::count(stage, calls, bytes, 0)
+#define LHA_STAT_CRC_FAILURE()              LHAStats::crc_failure()
+#else
+#define LHA_STAT_SCOPE(stage)               ((void)0)
+#define LHA_STAT_BYTES(n)                   ((void)0)
+#define LHA_STAT_CALLS(n)                   ((void)0)
+#define LHA_STAT_COUNT(stage, calls, bytes) ((void)0)
+#define LHA_STAT_CRC_FAILURE()              ((void)0)
+#endif
+
+#endif // !defined(AFX_LHASTATS_H__220F3497_EB43_49D0_B9FF_3347EBFD1972__INCLUDED_)
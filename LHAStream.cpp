@@ -0,0 +1,234 @@
+// LHAStream.cpp: implementation of the LHAStream class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef LHAPACK_STANDALONE
+#include "stdafx.h"
+#endif
+#include "LHAStream.h"
+#include "LHAStats.h"
+
+#include <string.h>
+
+static const LHAStreamHandler no_handler = { NULL, NULL, NULL };
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+LHAStream::LHAStream()
+{
+	begin(NULL, NULL);
+}
+
+LHAStream::~LHAStream()
+{
+
+}
+
+/* start over on a new archive; the handler and param are kept for its members */
+void LHAStream::begin(const LHAStreamHandler *handler, void *param)
+{
+	this->handler = handler ? handler : &no_handler;
+	this->param   = param;
+	state         = STATE_HEADER;
+	hlen          = 0;
+	remaining     = 0;
+	wanted        = false;
+	nfailed       = 0;
+}
+
+/*
+ * The next piece of the archive.  False once the stream has failed: a
+ * header could not be read.  Anything after the end mark is ignored.
+ */
+bool LHAStream::feed(const void *buf, size_t len)
+{
+	const char *p = (const char *)buf;
+
+	while (len) {
+		size_t n;
+
+		switch (state) {
+		case STATE_HEADER:
+			n = take_header(p, len);
+			break;
+		case STATE_DATA:
+		case STATE_SKIP:
+			n = take_data(p, len);
+			break;
+		case STATE_END:
+			return true;
+		default:
+			return false;
+		}
+		p   += n;
+		len -= n;
+	}
+	return state != STATE_ERROR;
+}
+
+/*
+ * The input has ended.  True if it ended at the end mark, or between
+ * members (not all archivers write the mark); a member cut short is
+ * reported failed.
+ */
+bool LHAStream::finish()
+{
+	switch (state) {
+	case STATE_HEADER:
+		if (hlen == 0) {
+			state = STATE_END;
+			return true;
+		}
+		break;
+	case STATE_DATA:
+	case STATE_SKIP:
+		end_member(false);
+		break;
+	case STATE_END:
+		return true;
+	default:
+		break;
+	}
+	state = STATE_ERROR;
+	return false;
+}
+
+/* pull the archive through `proc' until its end, or until it fails */
+bool LHAStream::run(LHAReadProc proc, void *read_param)
+{
+	std::vector<char> buf(LHA_STREAM_READ);
+
+	while (state != STATE_END && state != STATE_ERROR) {
+		ptrdiff_t n = proc(read_param, &buf[0], buf.size());
+
+		if (n == 0)
+			return finish();
+		if (n < 0) {
+			if (state == STATE_DATA || state == STATE_SKIP)
+				end_member(false);
+			state = STATE_ERROR;
+			return false;
+		}
+		feed(&buf[0], (size_t)n);
+	}
+	return state == STATE_END;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Members
+//////////////////////////////////////////////////////////////////////
+
+/*
+ * Gather the header a piece at a time: LHAPack::header_length() says how
+ * many bytes it needs, from those in hand so far.
+ */
+size_t LHAStream::take_header(const char *p, size_t len)
+{
+	size_t used = 0;
+
+	for (;;) {
+		size_t need = LHAPack::header_length(hlen ? &hbuf[0] : NULL, hlen);
+
+		if (need == 0) {
+			state = (hlen && hbuf[0] == 0) ? STATE_END : STATE_ERROR;
+			return used;
+		}
+		if (need <= hlen)
+			break;
+		if (used == len)
+			return used;
+
+		size_t n = need - hlen;
+		if (n > len - used)
+			n = len - used;
+		if (hbuf.size() < need)
+			hbuf.resize(need);
+		memcpy(&hbuf[hlen], p + used, n);
+		hlen += n;
+		used += n;
+	}
+
+	start_member();
+	return used;
+}
+
+void LHAStream::start_member()
+{
+	size_t offset;
+
+	if (!LHAPack::parse_header(&hbuf[0], &hbuf[0] + hlen, &hdr, &offset) || offset != hlen) {
+		state = STATE_ERROR;
+		return;
+	}
+
+	hlen      = 0;
+	remaining = hdr.packed_size;
+	wanted    = handler->header == NULL || handler->header(param, &hdr);
+
+	if (!wanted)
+		state = STATE_SKIP;
+	else if (decoder.begin_stream(LHADecoder::method_number(hdr.method),
+	                              hdr.packed_size, hdr.original_size, output, this))
+		state = STATE_DATA;
+	else
+		state = STATE_SKIP;     /* reported failed when it has passed */
+
+	if (remaining == 0)
+		take_data(NULL, 0);
+}
+
+/*
+ * Packed data of the current member, up to its end.  Once the decoder
+ * fails (or the data proc gives up) the rest of the member is skipped.
+ */
+size_t LHAStream::take_data(const char *p, size_t len)
+{
+	size_t n    = len < remaining ? len : (size_t)remaining;
+	size_t used = 0;
+
+	while (used < n) {
+		if (state == STATE_DATA) {
+			size_t taken;
+
+			if (decoder.stream(p + used, n - used, &taken) && taken) {
+				used += taken;
+				continue;
+			}
+			state = STATE_SKIP;
+		}
+		used = n;
+	}
+	remaining -= used;
+
+	if (remaining == 0) {
+		bool ok = state == STATE_DATA && decoder.end_stream();
+
+		if (ok && hdr.has_crc && decoder.crc != hdr.crc) {
+			LHA_STAT_CRC_FAILURE();
+			ok = false;
+		}
+		end_member(ok);
+	}
+	return used;
+}
+
+void LHAStream::end_member(bool ok)
+{
+	if (wanted) {
+		if (handler->end)
+			handler->end(param, &hdr, ok);
+		if (!ok)
+			nfailed++;
+	}
+	wanted = false;
+	state  = STATE_HEADER;
+}
+
+bool LHAStream::output(void *param, const void *buf, size_t len)
+{
+	LHAStream *s = (LHAStream *)param;
+
+	return s->handler->data == NULL || s->handler->data(s->param, &s->hdr, buf, len);
+}
@@ -0,0 +1,99 @@
+// LHAStream.h: interface for the LHAStream class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#if !defined(AFX_LHASTREAM_H__6EE2C046_1E00_4C21_802B_2FA1CE935CC1__INCLUDED_)
+#define AFX_LHASTREAM_H__6EE2C046_1E00_4C21_802B_2FA1CE935CC1__INCLUDED_
+
+#if _MSC_VER > 1000
+#pragma once
+#endif // _MSC_VER > 1000
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "LHAPack.h"
+#include "LHADecode.h"
+
+#define LHA_STREAM_READ         0x10000 /* bytes run() asks for at a time */
+
+/*
+ * What the stream parser calls, all optional:
+ *   header  a member header has been read; false skips the member.
+ *   data    the next piece of its decoded contents; false gives up on it.
+ *   end     the member is done; ok unless it could not be decoded, failed
+ *           its CRC, was given up on, or the input ended inside it.
+ */
+typedef struct LHAStreamHandler {
+    bool (*header)(void *param, const LHAHeader *hdr);
+    bool (*data)(void *param, const LHAHeader *hdr, const void *buf, size_t len);
+    void (*end)(void *param, const LHAHeader *hdr, bool ok);
+} LHAStreamHandler;
+
+/* reads up to len bytes: the count, 0 at the end of input, < 0 on error */
+typedef ptrdiff_t (*LHAReadProc)(void *param, void *buf, size_t len);
+
+/*
+ * Archive reader for input that cannot be mapped or seeked: a pipe, a
+ * socket.  The archive is pushed in with feed(), in pieces of any size,
+ * or pulled with run(); headers and packed data may be split anywhere.
+ * No more than one header and a decoder's window (see begin_stream() in
+ * LHADecoder) are held at any time.
+ *
+ *     LHAStream s;
+ *     s.begin(&handler, &ctx);
+ *     while ((n = recv(sock, buf, sizeof(buf), 0)) > 0)
+ *         if (!s.feed(buf, n))
+ *             break;
+ *     s.finish();
+ *
+ * Members in methods the decoder cannot stream are reported to `end' as
+ * failed and skipped.  A header that cannot be read stops the stream,
+ * since there is no telling where the next one starts.
+ */
+class LHAStream
+{
+public:
+	void begin(const LHAStreamHandler *handler, void *param);
+	bool feed(const void *buf, size_t len);
+	bool finish();
+	bool run(LHAReadProc proc, void *param);
+
+	bool at_end() const     { return state == STATE_END; }
+	bool failed() const     { return state == STATE_ERROR; }
+	int  failures() const   { return nfailed; }
+
+	LHAStream();
+	virtual ~LHAStream();
+private:
+	enum State {
+	    STATE_HEADER,       /* gathering a header */
+	    STATE_DATA,         /* decoding a member */
+	    STATE_SKIP,         /* passing over a member */
+	    STATE_END,          /* past the end mark; the rest is ignored */
+	    STATE_ERROR
+	};
+
+	size_t take_header(const char *p, size_t len);
+	size_t take_data(const char *p, size_t len);
+	void   start_member();
+	void   end_member(bool ok);
+	static bool output(void *param, const void *buf, size_t len);
+
+	State                   state;
+	const LHAStreamHandler  *handler;
+	void                    *param;
+	std::vector<char>       hbuf;       /* the header being gathered */
+	size_t                  hlen;
+	LHAHeader               hdr;
+	uint64_t                remaining;  /* packed bytes of the member to come */
+	bool                    wanted;     /* the handler took the member */
+	int                     nfailed;
+	LHADecoder              decoder;
+
+	LHAStream(const LHAStream &);
+	LHAStream &operator=(const LHAStream &);
+};
+
+#endif // !defined(AFX_LHASTREAM_H__6EE2C046_1E00_4C21_802B_2FA1CE935CC1__INCLUDED_)
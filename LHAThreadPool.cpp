@@ -0,0 +1,119 @@
+// LHAThreadPool.cpp: implementation of the LHAThreadPool class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef LHAPACK_STANDALONE
+#include "stdafx.h"
+#endif
+#include "LHAThreadPool.h"
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+LHAThreadPool::LHAThreadPool(int threads)
+{
+	if (threads <= 0)
+		threads = (int)std::thread::hardware_concurrency();
+	if (threads <= 0)
+		threads = 1;
+
+	nthreads   = threads;
+	queues     = new Queue[threads];
+	proc       = NULL;
+	param      = NULL;
+	generation = 0;
+	busy       = 0;
+	quit       = false;
+
+	for (int i = 0; i < threads; i++)
+		workers.push_back(std::thread(&LHAThreadPool::worker, this, i));
+}
+
+LHAThreadPool::~LHAThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		quit = true;
+	}
+	wake.notify_all();
+
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+
+	delete[] queues;
+}
+
+/*
+ * Run proc(param, tasks[i], worker) for every task and wait for all of
+ * them.  Tasks should come largest first.
+ */
+void LHAThreadPool::run(Proc proc, void *param, const size_t *tasks, size_t count)
+{
+	size_t i;
+
+	if (count == 0)
+		return;
+
+	for (i = 0; i < count; i++) {
+		Queue &q = queues[i % nthreads];
+		std::lock_guard<std::mutex> guard(q.lock);
+		q.tasks.push_back(tasks[i]);
+	}
+
+	std::unique_lock<std::mutex> guard(lock);
+	this->proc  = proc;
+	this->param = param;
+	busy        = nthreads;
+	generation++;
+	wake.notify_all();
+
+	while (busy)
+		done.wait(guard);
+}
+
+bool LHAThreadPool::next_task(int id, size_t *task)
+{
+	for (int i = 0; i < nthreads; i++) {
+		Queue &q = queues[(id + i) % nthreads];
+		std::lock_guard<std::mutex> guard(q.lock);
+
+		if (!q.tasks.empty()) {
+			*task = q.tasks.front();
+			q.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void LHAThreadPool::worker(int id)
+{
+	unsigned long seen = 0;
+	size_t        task;
+
+	for (;;) {
+		Proc  p;
+		void *arg;
+
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			while (!quit && generation == seen)
+				wake.wait(guard);
+			if (quit)
+				return;
+			seen = generation;
+			p    = proc;
+			arg  = param;
+		}
+
+		while (next_task(id, &task))
+			p(arg, task, id);
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			if (--busy == 0)
+				done.notify_all();
+		}
+	}
+}
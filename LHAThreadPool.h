@@ -0,0 +1,65 @@
+// LHAThreadPool.h: interface for the LHAThreadPool class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#if !defined(AFX_LHATHREADPOOL_H__B4706D96_D861_4C47_8A98_5F05D68D9159__INCLUDED_)
+#define AFX_LHATHREADPOOL_H__B4706D96_D861_4C47_8A98_5F05D68D9159__INCLUDED_
+
+#if _MSC_VER > 1000
+#pragma once
+#endif // _MSC_VER > 1000
+
+#include <stddef.h>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/*
+ * Work-stealing thread pool for batches of independent tasks.
+ *
+ * run() deals the tasks round-robin, in the order given, onto one queue
+ * per worker, so the first (largest) tasks start first everywhere.  A
+ * worker takes from the front of its own queue; once that is empty it
+ * steals the front of the next non-empty queue, so the longest remaining
+ * task is always picked up first and no worker idles while others still
+ * have a backlog.  The workers live as long as the pool; one batch runs
+ * at a time.
+ */
+class LHAThreadPool
+{
+public:
+	typedef void (*Proc)(void *param, size_t task, int worker);
+
+	void run(Proc proc, void *param, const size_t *tasks, size_t count);
+	int  threads() const { return nthreads; }
+	LHAThreadPool(int threads = 0);
+	virtual ~LHAThreadPool();
+private:
+	struct Queue {
+		std::mutex          lock;
+		std::deque<size_t>  tasks;
+	};
+
+	void worker(int id);
+	bool next_task(int id, size_t *task);
+
+	int                         nthreads;
+	Queue                       *queues;
+	std::vector<std::thread>    workers;
+
+	std::mutex                  lock;
+	std::condition_variable     wake;
+	std::condition_variable     done;
+	Proc                        proc;
+	void                        *param;
+	unsigned long               generation;     /* batches started */
+	int                         busy;           /* workers still in the batch */
+	bool                        quit;
+
+	LHAThreadPool(const LHAThreadPool &);
+	LHAThreadPool &operator=(const LHAThreadPool &);
+};
+
+#endif // !defined(AFX_LHATHREADPOOL_H__B4706D96_D861_4C47_8A98_5F05D68D9159__INCLUDED_)
@@ -0,0 +1,554 @@
+// LHAWriter.cpp: implementation of the LHAWriter class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef LHAPACK_STANDALONE
+#include "stdafx.h"
+#endif
+#include "LHAWriter.h"
+#include "LHAEncode.h"
+#include "LHACrc.h"
+#include "LHAThreadPool.h"
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+#ifdef _WIN32
+#include <io.h>
+#define file_seek(fp, off)      _fseeki64(fp, (__int64)(off), SEEK_SET)
+#define file_truncate(fp, len)  (_chsize_s(_fileno(fp), (__int64)(len)) == 0)
+#else
+#include <unistd.h>
+#define file_seek(fp, off)      fseeko(fp, (off_t)(off), SEEK_SET)
+#define file_truncate(fp, len)  (ftruncate(fileno(fp), (off_t)(len)) == 0)
+#endif
+
+#define LHA_PATHSEP             0xff    /* path separator of the filename in lha header */
+#define LEVEL2_SIZE_MAX         0xffffffffULL
+
+#define WRITER_FILE_MODE        0100644 /* regular file, rw-r--r-- */
+#define WRITER_DIR_MODE         0040755 /* directory, rwxr-xr-x */
+
+#define PACK_AHEAD_PER_THREAD   4       /* members packed ahead of the writer, per thread */
+
+static const char *const method_ids[] = {
+    LZHUFF0_METHOD, LZHUFF1_METHOD, LZHUFF2_METHOD, LZHUFF3_METHOD,
+    LZHUFF4_METHOD, LZHUFF5_METHOD, LZHUFF6_METHOD, LZHUFF7_METHOD
+};
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+LHAWriter::LHAWriter()
+{
+	fp            = NULL;
+	encoder       = NULL;
+	hdr           = new LHAHeader;
+	header_size   = 0;
+	method        = LZHUFF5_METHOD_NUM;
+	level         = LZH_LEVEL_DEFAULT;
+	in_member     = false;
+	compressing   = false;
+	failed        = false;
+	header_offset = 0;
+	data_offset   = 0;
+	position      = 0;
+	high_water    = 0;
+	pathname[0]   = '\0';
+}
+
+LHAWriter::~LHAWriter()
+{
+	close();
+	delete encoder;
+	delete hdr;
+}
+
+/* create (or truncate) the archive at path */
+bool LHAWriter::open(const char *path)
+{
+	close();
+
+	fp = fopen(path, "wb");
+	if (fp == NULL)
+		return false;
+
+	in_member  = false;
+	failed     = false;
+	position   = 0;
+	high_water = 0;
+	return true;
+}
+
+/*
+ * Finish the current member, write the end mark and close the file.
+ * Returns false if anything since open() failed.
+ */
+bool LHAWriter::close()
+{
+	bool ok;
+
+	if (fp == NULL)
+		return false;
+
+	if (in_member)
+		end_member();
+
+	put("", 1);                     /* end of archive */
+	if (fflush(fp) != 0)
+		failed = true;
+	if (high_water > position && !file_truncate(fp, position))
+		failed = true;              /* a stored member replaced a longer packed one */
+
+	ok = !failed;
+	if (fclose(fp) != 0)
+		ok = false;
+	fp = NULL;
+	return ok;
+}
+
+/* LZHUFF0_METHOD_NUM (store) or LZHUFF5/6/7_METHOD_NUM; -lh5- by default */
+bool LHAWriter::set_method(int method)
+{
+	if (method != LZHUFF0_METHOD_NUM && !LHAEncoder::method_supported(method))
+		return false;
+	this->method = method;
+	return true;
+}
+
+/* LZH_LEVEL_MIN (fastest) .. LZH_LEVEL_MAX (smallest) */
+void LHAWriter::set_level(int level)
+{
+	this->level = level;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Members
+//////////////////////////////////////////////////////////////////////
+
+/* a whole member from memory */
+bool LHAWriter::add(const char *name, const void *data, size_t size, time_t mtime)
+{
+	if (!begin_member(name, mtime))
+		return false;
+	write(data, size);
+	return finish_member(data);
+}
+
+/* the file at path, under name, with its modification time */
+bool LHAWriter::add_file(const char *name, const char *path)
+{
+	LHAFileMap map;
+
+	if (!map.open(path, LHAFileMap::ACCESS_SEQUENTIAL))
+		return false;
+	return add(name, map.data(), map.size(), map.modified_time());
+}
+
+bool LHAWriter::add_directory(const char *name, time_t mtime)
+{
+	if (!start_member(name, LZHDIRS_METHOD, mtime, WRITER_DIR_MODE))
+		return false;
+	in_member = false;
+	return !failed;
+}
+
+/* start a member whose data follows through write() */
+bool LHAWriter::begin_member(const char *name, time_t mtime)
+{
+	if (!start_member(name, method_ids[method], mtime, WRITER_FILE_MODE))
+		return false;
+
+	compressing = method != LZHUFF0_METHOD_NUM;
+	if (compressing) {
+		if (encoder == NULL)
+			encoder = new LHAEncoder;
+		if (!encoder->begin(method, level, output, this)) {
+			failed    = true;
+			in_member = false;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool LHAWriter::write(const void *buf, size_t len)
+{
+	if (!in_member || failed)
+		return false;
+
+	if (compressing)
+		return encoder->write(buf, len) && !failed;
+
+	hdr->crc            = LHACrc::calccrc(hdr->crc, buf, len);
+	hdr->original_size += len;
+	return put(buf, len);
+}
+
+bool LHAWriter::end_member()
+{
+	return finish_member(NULL);
+}
+
+/*
+ * Write the header of a new member with its sizes and CRC still zero.
+ */
+bool LHAWriter::start_member(const char *name, const char *method_id, time_t mtime, unsigned short mode)
+{
+	if (fp == NULL || in_member || failed || !make_header(name, method_id, mtime, mode))
+		return false;
+
+	header_offset = position;
+	header_size   = pack.write_header_level2(hdr, header, pathname);
+	if (!put(header, header_size))
+		return false;
+
+	data_offset = position;
+	in_member   = true;
+	return true;
+}
+
+/*
+ * Fill hdr and pathname for a new member; name is turned into the
+ * 0xff-separated path of the header.
+ */
+bool LHAWriter::make_header(const char *name, const char *method_id, time_t mtime, unsigned short mode)
+{
+	size_t i, n = 0;
+
+	if (name == NULL)
+		return false;
+
+	while (*name == '/' || *name == '\\')
+		name++;
+	for (i = 0; name[i] && n < sizeof(pathname) - 2; i++)
+		pathname[n++] = (name[i] == '/' || name[i] == '\\') ? (char)LHA_PATHSEP : name[i];
+	if (name[i] || n == 0)
+		return false;               /* too long or empty */
+	if (mode == WRITER_DIR_MODE && (unsigned char)pathname[n - 1] != LHA_PATHSEP)
+		pathname[n++] = (char)LHA_PATHSEP;
+	pathname[n] = '\0';
+
+	memset(hdr, 0, sizeof(LHAHeader));
+	memcpy(hdr->method, method_id, METHOD_TYPE_STORAGE);
+	hdr->attribute                = 0x20;
+	hdr->header_level             = 2;
+	hdr->unix_last_modified_stamp = mtime;
+	hdr->unix_mode                = mode;
+	hdr->has_crc                  = TRUE;
+	return true;
+}
+
+/*
+ * Complete the member: flush the encoder, fall back to storing raw (if
+ * given) when packing did not pay, and rewrite the header.
+ */
+bool LHAWriter::finish_member(const void *raw)
+{
+	if (!in_member)
+		return false;
+	in_member = false;
+
+	if (compressing) {
+		if (!encoder->finish())
+			failed = true;
+		hdr->crc           = encoder->crc;
+		hdr->original_size = (size_t)encoder->original_size;
+		hdr->packed_size   = (size_t)encoder->packed_size;
+
+		if (encoder->original_size > LEVEL2_SIZE_MAX || encoder->packed_size > LEVEL2_SIZE_MAX)
+			failed = true;
+
+		if (!failed && hdr->packed_size >= hdr->original_size &&
+		    (raw != NULL || hdr->original_size == 0)) {
+			memcpy(hdr->method, LZHUFF0_METHOD, METHOD_TYPE_STORAGE);
+			hdr->packed_size = hdr->original_size;
+			if (seek(data_offset))
+				put(raw, hdr->original_size);
+		}
+	}
+	else {
+		hdr->packed_size = hdr->original_size;
+		if (hdr->original_size > LEVEL2_SIZE_MAX)
+			failed = true;
+	}
+
+	return write_header() && !failed;
+}
+
+/* rewrite the current member's header with its final fields */
+bool LHAWriter::write_header()
+{
+	uint64_t end = position;
+
+	if (failed)
+		return false;
+
+	if (pack.write_header_level2(hdr, header, pathname) != header_size) {
+		failed = true;
+		return false;
+	}
+	return seek(header_offset) && put(header, header_size) && seek(end);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Parallel members
+//////////////////////////////////////////////////////////////////////
+
+/* a member packed in memory, waiting for its turn to be written */
+struct PackedMember {
+    bool                        ready;
+    bool                        ok;
+    const char                  *method_id;
+    unsigned int                crc;
+    size_t                      original_size;
+    time_t                      mtime;
+    std::vector<unsigned char>  data;
+};
+
+struct PackJob {
+    LHAWriter                   *writer;
+    const char *const           *names;
+    const char *const           *paths;
+    size_t                      count;
+    int                         method;
+    int                         level;
+    std::mutex                  lock;
+    std::condition_variable     written;        /* next_write moved on */
+    size_t                      next_start;     /* members are started in order */
+    size_t                      next_write;     /* and written in order */
+    bool                        writing;        /* a worker is writing members out */
+    std::vector<PackedMember>   slots;          /* member i packs into slots[i % slots.size()] */
+    int                         failures;
+};
+
+static bool append_output(void *param, const void *buf, size_t len)
+{
+    std::vector<unsigned char> *out = (std::vector<unsigned char> *)param;
+
+    out->insert(out->end(), (const unsigned char *)buf, (const unsigned char *)buf + len);
+    return true;
+}
+
+/* pack the file at path into m; stored when packing does not pay */
+static bool pack_file(LHAEncoder *encoder, int method, int level, const char *path, PackedMember &m)
+{
+    LHAFileMap          map;
+    const unsigned char *data;
+    size_t              size;
+
+    m.data.clear();
+    if (!map.open(path, LHAFileMap::ACCESS_SEQUENTIAL))
+        return false;
+
+    data            = (const unsigned char *)map.data();
+    size            = map.size();
+    m.mtime         = map.modified_time();
+    m.original_size = size;
+    if ((uint64_t)size > LEVEL2_SIZE_MAX)
+        return false;
+
+    if (method != LZHUFF0_METHOD_NUM) {
+        if (!encoder->begin(method, level, append_output, &m.data) ||
+            !encoder->write(data, size) || !encoder->finish())
+            return false;
+        m.method_id = method_ids[method];
+        m.crc       = encoder->crc;
+        if (m.data.size() < size)
+            return true;
+        m.data.clear();
+    }
+
+    m.method_id = LZHUFF0_METHOD;
+    m.crc       = LHACrc::calccrc(0, data, size);
+    m.data.assign(data, data + size);
+    return true;
+}
+
+/*
+ * One worker: take the next member in order, pack it into its slot, and
+ * write out whatever members are complete at the head of the queue.  A
+ * worker may not run further ahead of the writer than there are slots,
+ * so memory stays bounded however many members there are.  Members are
+ * handed out strictly in order, so the oldest unwritten member is always
+ * being packed or written, and a waiting worker is woken when it is out.
+ *
+ * One worker at a time writes (job->writing), and it does so without the
+ * lock: the members it takes stay in their slots until next_write moves
+ * past them, so the others go on claiming and finishing members
+ * meanwhile.  A member finished while somebody is writing is left for
+ * that writer, which looks again before it stops.
+ */
+void LHAWriter::pack_task(void *param, size_t, int)
+{
+	PackJob     *job     = (PackJob *)param;
+	LHAEncoder  *encoder = NULL;
+	size_t      nslots   = job->slots.size();
+	size_t      i;
+	bool        ok;
+
+	if (job->method != LZHUFF0_METHOD_NUM)
+		encoder = new LHAEncoder;
+
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> hold(job->lock);
+			while (job->next_start < job->count && job->next_start >= job->next_write + nslots)
+				job->written.wait(hold);
+			if (job->next_start >= job->count)
+				break;
+			i = job->next_start++;
+		}
+
+		PackedMember &m = job->slots[i % nslots];
+		ok = pack_file(encoder, job->method, job->level, job->paths[i], m);
+
+		{
+			std::lock_guard<std::mutex> hold(job->lock);
+			m.ok    = ok;
+			m.ready = true;
+			if (job->writing)
+				continue;
+			job->writing = true;
+		}
+		write_ready(job);
+	}
+
+	delete encoder;
+}
+
+/* pack_task(): write the run of finished members at the head of the queue, until there is none */
+void LHAWriter::write_ready(PackJob *job)
+{
+	size_t nslots = job->slots.size();
+	size_t from, to, k;
+	int    failures;
+
+	for (;;) {
+		{
+			std::lock_guard<std::mutex> hold(job->lock);
+			from = to = job->next_write;
+			/* one round of the slots at most: past it, a ready slot is still member `from' */
+			while (to < job->count && to < from + nslots && job->slots[to % nslots].ready)
+				to++;
+			if (to == from) {
+				job->writing = false;
+				return;
+			}
+		}
+
+		failures = 0;
+		for (k = from; k < to; k++) {
+			PackedMember &w = job->slots[k % nslots];
+
+			if (!w.ok || !job->writer->put_member(job->names[k], w.method_id, w.mtime, w.crc, w.original_size,
+			                                      w.data.empty() ? NULL : &w.data[0], w.data.size()))
+				failures++;
+		}
+
+		std::lock_guard<std::mutex> hold(job->lock);
+		for (k = from; k < to; k++) {
+			job->slots[k % nslots].ready = false;
+			job->slots[k % nslots].data.clear();
+		}
+		job->next_write = to;
+		job->failures  += failures;
+		job->written.notify_all();
+	}
+}
+
+/*
+ * Add count files, paths[i] under names[i], packing them on `threads'
+ * threads (0: one per CPU).  Each member is packed into memory first, so
+ * its header is written only once with the final sizes and CRC, and the
+ * members appear in the archive in the order given.  Returns the number
+ * of files that could not be added.
+ */
+int LHAWriter::add_files(const char *const *names, const char *const *paths, size_t count, int threads)
+{
+	PackJob             job;
+	std::vector<size_t> loops;
+	int                 i;
+
+	if (fp == NULL || in_member || failed)
+		return (int)count;
+	if (count == 0)
+		return 0;
+
+	LHAThreadPool pool(threads);
+	PackedMember  idle = { false, false, NULL, 0, 0, 0, std::vector<unsigned char>() };
+
+	job.writer     = this;
+	job.names      = names;
+	job.paths      = paths;
+	job.count      = count;
+	job.method     = method;
+	job.level      = level;
+	job.next_start = 0;
+	job.next_write = 0;
+	job.writing    = false;
+	job.failures   = 0;
+	job.slots.assign((size_t)pool.threads() * PACK_AHEAD_PER_THREAD, idle);
+
+	/* one task per worker, each packing members until none are left */
+	for (i = 0; i < pool.threads(); i++)
+		loops.push_back(i);
+	pool.run(pack_task, &job, &loops[0], loops.size());
+
+	return job.failures;
+}
+
+/* a member whose sizes and CRC are already known, header and data in one go */
+bool LHAWriter::put_member(const char *name, const char *method_id, time_t mtime, unsigned int crc,
+                           size_t original_size, const void *data, size_t packed_size)
+{
+	if (fp == NULL || in_member || failed || !make_header(name, method_id, mtime, WRITER_FILE_MODE))
+		return false;
+
+	hdr->crc           = crc;
+	hdr->original_size = original_size;
+	hdr->packed_size   = packed_size;
+
+	header_offset = position;
+	header_size   = pack.write_header_level2(hdr, header, pathname);
+	return put(header, header_size) && put(data, packed_size);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Output
+//////////////////////////////////////////////////////////////////////
+
+bool LHAWriter::output(void *param, const void *buf, size_t len)
+{
+	return ((LHAWriter *)param)->put(buf, len);
+}
+
+bool LHAWriter::put(const void *buf, size_t len)
+{
+	if (failed)
+		return false;
+
+	if (len && fwrite(buf, 1, len, fp) != len) {
+		failed = true;
+		return false;
+	}
+	position += len;
+	if (high_water < position)
+		high_water = position;
+	return true;
+}
+
+bool LHAWriter::seek(uint64_t offset)
+{
+	if (failed)
+		return false;
+
+	if (file_seek(fp, offset) != 0) {
+		failed = true;
+		return false;
+	}
+	position = offset;
+	return true;
+}
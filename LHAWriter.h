@@ -0,0 +1,99 @@
+// LHAWriter.h: interface for the LHAWriter class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#if !defined(AFX_LHAWRITER_H__5DE01F4B_9FE5_4481_A21F_23E253A05A42__INCLUDED_)
+#define AFX_LHAWRITER_H__5DE01F4B_9FE5_4481_A21F_23E253A05A42__INCLUDED_
+
+#if _MSC_VER > 1000
+#pragma once
+#endif // _MSC_VER > 1000
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "LHAPack.h"
+
+class LHAEncoder;
+struct PackJob;
+
+/*
+ * Writes an archive of level 2 headers.
+ *
+ * A member's header goes out first with its sizes and CRC left zero;
+ * the data is compressed straight into the file behind it, and the
+ * header is then rewritten in place.  When compression does not make a
+ * member smaller and its input can be read again (add(), add_file()),
+ * it is stored as -lh0- instead, as LHa does.  Member names may use '/'
+ * or '\\' as separators.
+ *
+ * add_files() packs many files at once on a thread pool; each member is
+ * compressed into its own buffer and written, in order, as soon as all
+ * before it are out, with its header complete the first time.
+ *
+ *     LHAWriter w;
+ *     w.open("out.lzh");
+ *     w.add_file("docs/readme.txt", "readme.txt");
+ *     w.begin_member("log.txt", time(NULL));
+ *     while (...) w.write(buf, n);
+ *     w.end_member();
+ *     w.close();
+ */
+class LHAWriter
+{
+public:
+	bool open(const char *path);
+	bool close();
+	bool is_open() const    { return fp != NULL; }
+	bool set_method(int method);
+	void set_level(int level);
+
+	bool add(const char *name, const void *data, size_t size, time_t mtime);
+	bool add_file(const char *name, const char *path);
+	bool add_directory(const char *name, time_t mtime);
+	int  add_files(const char *const *names, const char *const *paths, size_t count, int threads = 0);
+
+	bool begin_member(const char *name, time_t mtime);
+	bool write(const void *buf, size_t len);
+	bool end_member();
+
+	LHAWriter();
+	virtual ~LHAWriter();
+private:
+	static bool output(void *param, const void *buf, size_t len);
+	static void pack_task(void *param, size_t task, int worker);
+	static void write_ready(PackJob *job);
+	bool start_member(const char *name, const char *method_id, time_t mtime, unsigned short mode);
+	bool make_header(const char *name, const char *method_id, time_t mtime, unsigned short mode);
+	bool put_member(const char *name, const char *method_id, time_t mtime, unsigned int crc,
+	                size_t original_size, const void *data, size_t packed_size);
+	bool finish_member(const void *raw);
+	bool write_header();
+	bool put(const void *buf, size_t len);
+	bool seek(uint64_t offset);
+
+	FILE            *fp;
+	LHAPack         pack;           /* header writer */
+	LHAEncoder      *encoder;       /* created on the first compressed member */
+	LHAHeader       *hdr;
+	char            pathname[FILENAME_LENGTH];
+	char            header[LZHEADER_STORAGE];
+	size_t          header_size;
+
+	int             method;
+	int             level;
+	bool            in_member;
+	bool            compressing;
+	bool            failed;
+
+	uint64_t        header_offset;  /* of the current member */
+	uint64_t        data_offset;
+	uint64_t        position;       /* of the file pointer */
+	uint64_t        high_water;     /* furthest byte written */
+
+	LHAWriter(const LHAWriter &);
+	LHAWriter &operator=(const LHAWriter &);
+};
+
+#endif // !defined(AFX_LHAWRITER_H__5DE01F4B_9FE5_4481_A21F_23E253A05A42__INCLUDED_)
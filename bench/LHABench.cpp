@@ -0,0 +1,448 @@
+// LHABench.cpp: benchmarks for header parsing and writing, CRC-16,
+// decoding and encoding.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <benchmark/benchmark.h>
+
+#include <string.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "LHAPack.h"
+#include "LHAArchive.h"
+#include "LHACrc.h"
+#include "LHADecode.h"
+#include "LHAEncode.h"
+
+#define HEADERS_PER_RUN     1024
+#define SMALL_MEMBER        0x1000      /* 4 KB */
+#define SMALL_MEMBERS       256
+#define LARGE_MEMBER        0x400000    /* 4 MB */
+
+enum {
+    CORPUS_SMALL,
+    CORPUS_LARGE
+};
+
+//////////////////////////////////////////////////////////////////////
+// Test data
+//////////////////////////////////////////////////////////////////////
+
+/* xorshift32, so the data is the same on every run and platform */
+static uint32_t next_random(uint32_t *state)
+{
+    uint32_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+/*
+ * Text-like data: words from a small vocabulary, with the odd run of one
+ * byte and stretch of noise, so that literals, short and long matches
+ * all turn up.
+ */
+static void make_data(std::vector<unsigned char> &out, size_t size, uint32_t seed)
+{
+    static const char *words[] = {
+        "the ", "archive ", "member ", "header ", "level ", "method ",
+        "size ", "crc ", "packed ", "original ", "time ", "name ",
+        "extended ", "directory ", "file ", "data ", "lh5 ", "lh6 ",
+        "lh7 ", "decode ", "encode ", "window ", "match ", "table ",
+        "\n", ", ", ". ", "0 ", "1 ", "1024 ", "65536 ", "\t"
+    };
+    uint32_t state = seed | 1;
+
+    out.clear();
+    out.reserve(size);
+    while (out.size() < size) {
+        uint32_t r = next_random(&state);
+
+        if ((r & 0xff) == 0) {
+            out.insert(out.end(), 16 + (r >> 8) % 200, (unsigned char)(r >> 16));
+        }
+        else if ((r & 0xff) == 1) {
+            for (uint32_t i = 0; i < 16 + (r >> 8) % 64; i++)
+                out.push_back((unsigned char)next_random(&state));
+        }
+        else {
+            const char *w = words[(r >> 8) % (sizeof(words) / sizeof(words[0]))];
+            out.insert(out.end(), w, w + strlen(w));
+        }
+    }
+    out.resize(size);
+}
+
+struct Member {
+    std::vector<unsigned char>  data;
+    std::vector<unsigned char>  packed;
+    unsigned int                crc;
+};
+
+static bool append_output(void *param, const void *buf, size_t len)
+{
+    std::vector<unsigned char> *out = (std::vector<unsigned char> *)param;
+
+    out->insert(out->end(), (const unsigned char *)buf, (const unsigned char *)buf + len);
+    return true;
+}
+
+static bool count_output(void *param, const void *buf, size_t len)
+{
+    (void)buf;
+    *(size_t *)param += len;
+    return true;
+}
+
+/* the corpus of one kind, packed with one method; built once per pair */
+static const std::vector<Member> &corpus(int kind, int method)
+{
+    static std::vector<Member> cache[2][LZHUFF7_METHOD_NUM + 1];
+    std::vector<Member>        &members = cache[kind][method];
+    size_t                     count, size, i;
+
+    if (!members.empty())
+        return members;
+
+    count = kind == CORPUS_SMALL ? SMALL_MEMBERS : 1;
+    size  = kind == CORPUS_SMALL ? SMALL_MEMBER  : LARGE_MEMBER;
+    members.resize(count);
+    for (i = 0; i < count; i++) {
+        Member     &m = members[i];
+        LHAEncoder encoder;
+
+        make_data(m.data, size, (uint32_t)(i + 1) * 2654435761U);
+        encoder.begin(method, LZH_LEVEL_DEFAULT, append_output, &m.packed);
+        encoder.write(&m.data[0], m.data.size());
+        encoder.finish();
+        m.crc = encoder.crc;
+    }
+    return members;
+}
+
+static void make_header(LHAHeader *hdr, int level, int i)
+{
+    memset(hdr, 0, sizeof(LHAHeader));
+    memcpy(hdr->method, LZHUFF5_METHOD, METHOD_TYPE_STORAGE);
+    hdr->packed_size              = 0;      /* headers back to back */
+    hdr->original_size            = 1000 + i;
+    /* 2000 .. 2020, out of order: a time zone's offset changes many times over */
+    hdr->unix_last_modified_stamp = 946684800 + (long)(i * 7919 % HEADERS_PER_RUN) * 615617;
+    hdr->attribute                = 0x20;
+    hdr->header_level             = (unsigned char)level;
+    hdr->unix_mode                = 0100644;
+    hdr->has_crc                  = TRUE;
+    hdr->crc                      = i & 0xffff;
+}
+
+static void make_path(char *path, size_t size, int i)
+{
+    snprintf(path, size, "src%clib%cmodule_%04d.txt", 0xff, 0xff, i);
+}
+
+static void put_le(unsigned char *p, uint32_t v, int n)
+{
+    while (n--) {
+        *p++ = (unsigned char)v;
+        v >>= 8;
+    }
+}
+
+/*
+ * A level 3 header, which LHAPack has no writer for: the 32-byte base,
+ * then name, directory, header crc and UNIX permission records.
+ */
+static size_t write_level3(const LHAHeader *hdr, unsigned char *data, int i)
+{
+    char          name[32], dir[16];
+    unsigned char *p = data + 32;
+    size_t        name_length, dir_length, total;
+
+    name_length = (size_t)snprintf(name, sizeof(name), "module_%04d.txt", i);
+    dir_length  = (size_t)snprintf(dir, sizeof(dir), "src%clib%c", 0xff, 0xff);
+
+    memset(data, 0, 32);
+    put_le(data, 4, 2);
+    memcpy(data + 2, hdr->method, METHOD_TYPE_STORAGE);
+    put_le(data + 7, (uint32_t)hdr->packed_size, 4);
+    put_le(data + 11, (uint32_t)hdr->original_size, 4);
+    put_le(data + 15, (uint32_t)hdr->unix_last_modified_stamp, 4);
+    data[19] = hdr->attribute;
+    data[20] = 3;
+    put_le(data + 21, hdr->crc, 2);
+    data[23] = 'U';
+    put_le(data + 28, (uint32_t)(1 + name_length + 4), 4);
+
+    *p++ = 1;
+    memcpy(p, name, name_length);
+    p += name_length;
+    put_le(p, (uint32_t)(1 + dir_length + 4), 4);
+    p += 4;
+
+    *p++ = 2;
+    memcpy(p, dir, dir_length);
+    p += dir_length;
+    put_le(p, 1 + 2 + 4, 4);
+    p += 4;
+
+    unsigned char *crc_field = p + 1;
+    *p++ = 0;
+    put_le(p, 0, 2);
+    p += 2;
+    put_le(p, 1 + 2 + 4, 4);
+    p += 4;
+
+    *p++ = 0x50;
+    put_le(p, hdr->unix_mode, 2);
+    p += 2;
+    put_le(p, 0, 4);
+    p += 4;
+
+    total = p - data;
+    put_le(data + 24, (uint32_t)total, 4);
+    put_le(crc_field, LHACrc::calccrc(0, data, total), 2);
+    return total;
+}
+
+/* HEADERS_PER_RUN headers of one level, back to back, then the end mark */
+static std::vector<char> make_headers(int level)
+{
+    std::vector<char> out;
+    LHAPack           pack;
+    LHAHeader         hdr;
+    char              path[64];
+    char              data[LZHEADER_STORAGE];
+    size_t            n;
+
+    for (int i = 0; i < HEADERS_PER_RUN; i++) {
+        make_header(&hdr, level, i);
+        make_path(path, sizeof(path), i);
+        if (level == 3)
+            n = write_level3(&hdr, (unsigned char *)data, i);
+        else
+            n = pack.write_header(&hdr, data, path);
+        out.insert(out.end(), data, data + n);
+    }
+    out.push_back(0);
+    return out;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Benchmarks
+//////////////////////////////////////////////////////////////////////
+
+/* args: header level, parse_header() flags */
+static void BM_ParseHeader(benchmark::State &state)
+{
+    std::vector<char> headers = make_headers((int)state.range(0));
+    int               flags   = (int)state.range(1);
+    const char        *end    = &headers[0] + headers.size();
+    LHAHeader         hdr;
+
+    for (auto _ : state) {
+        const char *p = &headers[0];
+        size_t     offset;
+        int        n = 0;
+
+        while (LHAPack::parse_header(p, end, &hdr, &offset, flags)) {
+            p += offset + hdr.packed_size;
+            n++;
+        }
+        if (n != HEADERS_PER_RUN) {
+            state.SkipWithError("headers did not parse");
+            break;
+        }
+        benchmark::DoNotOptimize(hdr.crc);
+    }
+    state.SetItemsProcessed(state.iterations() * HEADERS_PER_RUN);
+    state.SetBytesProcessed(state.iterations() * (int64_t)headers.size());
+}
+BENCHMARK(BM_ParseHeader)
+    ->ArgNames({"level", "flags"})
+    ->ArgsProduct({{0, 1, 2, 3}, {0, LHA_PARSE_LAZY, LHA_PARSE_STRICT}});
+
+/* arg: header level */
+static void BM_WriteHeader(benchmark::State &state)
+{
+    int       level = (int)state.range(0);
+    LHAPack   pack;
+    LHAHeader hdr;
+    char      path[64];
+    char      data[LZHEADER_STORAGE];
+
+    make_header(&hdr, level, 1);
+    make_path(path, sizeof(path), 1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(pack.write_header(&hdr, data, path));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_WriteHeader)->ArgName("level")->DenseRange(0, 2);
+
+/* args: buffer size, LHACrc::Engine */
+static void BM_Crc16(benchmark::State &state)
+{
+    size_t                     size   = (size_t)state.range(0);
+    LHACrc::Engine             engine = (LHACrc::Engine)state.range(1);
+    std::vector<unsigned char> buf;
+
+    if (!LHACrc::engine_supported(engine)) {
+        state.SkipWithError("engine not supported on this CPU");
+        return;
+    }
+    make_data(buf, size, 7);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(LHACrc::calccrc(engine, 0, &buf[0], size));
+    state.SetBytesProcessed(state.iterations() * (int64_t)size);
+    state.SetLabel(LHACrc::engine_name(engine));
+}
+BENCHMARK(BM_Crc16)
+    ->ArgNames({"size", "engine"})
+    ->ArgsProduct({{16, 256, 4 << 10, 64 << 10, 1 << 20},
+                   {LHACrc::CRC_BYTEWISE, LHACrc::CRC_SLICE8, LHACrc::CRC_SLICE16, LHACrc::CRC_PCLMUL}});
+
+/* args: LHADecoder::Kernel; bytes are the damaged bytes scanned for a header */
+static void BM_FindHeader(benchmark::State &state)
+{
+    LHADecoder::Kernel         kernel = (LHADecoder::Kernel)state.range(0);
+    std::vector<unsigned char> buf;
+
+    if (!LHADecoder::kernel_supported(kernel)) {
+        state.SkipWithError("kernel not supported on this CPU");
+        return;
+    }
+    make_data(buf, 16 << 20, 11);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(LHAArchive::find_header((const char *)&buf[0], buf.size(), 0, kernel));
+    state.SetBytesProcessed(state.iterations() * (int64_t)buf.size());
+    state.SetLabel(LHADecoder::kernel_name(kernel));
+}
+BENCHMARK(BM_FindHeader)
+    ->ArgName("kernel")
+    ->DenseRange(LHADecoder::KERNEL_GENERIC, LHADecoder::KERNEL_AVX2)
+    ->Unit(benchmark::kMillisecond);
+
+/* args: method number, corpus; bytes are the decoded bytes */
+static void BM_Decode(benchmark::State &state)
+{
+    int                        method  = (int)state.range(0);
+    const std::vector<Member>  &members = corpus((int)state.range(1), method);
+    std::vector<unsigned char> out(members[0].data.size());
+    LHADecoder                 decoder;
+    int64_t                    bytes = 0;
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < members.size(); i++) {
+            const Member &m = members[i];
+
+            if (!decoder.decode(method, &m.packed[0], m.packed.size(), &out[0], m.data.size()) ||
+                decoder.crc != m.crc) {
+                state.SkipWithError("decode failed");
+                return;
+            }
+            bytes += (int64_t)m.data.size();
+        }
+    }
+    state.SetBytesProcessed(bytes);
+    state.SetLabel(LHADecoder::kernel_name(LHADecoder::best_kernel()));
+}
+
+/* args: method number, corpus; bytes are the input bytes */
+static void BM_Encode(benchmark::State &state)
+{
+    int                       method  = (int)state.range(0);
+    const std::vector<Member> &members = corpus((int)state.range(1), method);
+    LHAEncoder                encoder;
+    int64_t                   bytes = 0, packed = 0;
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < members.size(); i++) {
+            const Member &m = members[i];
+            size_t       n  = 0;
+
+            encoder.begin(method, LZH_LEVEL_DEFAULT, count_output, &n);
+            encoder.write(&m.data[0], m.data.size());
+            if (!encoder.finish()) {
+                state.SkipWithError("encode failed");
+                return;
+            }
+            bytes  += (int64_t)m.data.size();
+            packed += (int64_t)n;
+        }
+    }
+    state.SetBytesProcessed(bytes);
+    state.counters["ratio"] = bytes ? (double)packed / (double)bytes : 0;
+}
+
+/*
+ * args: method number, corpus, pooled; bytes are the decoded bytes.
+ * Streams each member through a decoder of its own: a new LHADecoder
+ * (pooled 0) or an LHADecoderContext (pooled 1), so that the small corpus
+ * shows what setting up a member costs.
+ */
+static void BM_DecodeStream(benchmark::State &state)
+{
+    int                       method  = (int)state.range(0);
+    const std::vector<Member> &members = corpus((int)state.range(1), method);
+    bool                      pooled  = state.range(2) != 0;
+    int64_t                   bytes = 0;
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < members.size(); i++) {
+            const Member      &m = members[i];
+            LHADecoderContext context;
+            LHADecoder        *fresh   = pooled ? NULL : new LHADecoder;
+            LHADecoder        &decoder = pooled ? *context : *fresh;
+            size_t            n = 0, used, done = 0;
+            bool              ok;
+
+            ok = decoder.begin_stream(method, m.packed.size(), m.data.size(), count_output, &n);
+            while (ok && done < m.packed.size()) {
+                ok = decoder.stream(&m.packed[done], m.packed.size() - done, &used) && used;
+                done += used;
+            }
+            ok = ok && decoder.end_stream() && decoder.crc == m.crc;
+            delete fresh;
+            if (!ok) {
+                state.SkipWithError("decode failed");
+                return;
+            }
+            bytes += (int64_t)n;
+        }
+    }
+    state.SetBytesProcessed(bytes);
+}
+
+static void codec_args(benchmark::internal::Benchmark *b)
+{
+    b->ArgNames({"method", "corpus"});
+    b->ArgsProduct({{LZHUFF5_METHOD_NUM, LZHUFF6_METHOD_NUM, LZHUFF7_METHOD_NUM},
+                    {CORPUS_SMALL, CORPUS_LARGE}});
+    b->Unit(benchmark::kMicrosecond);
+}
+BENCHMARK(BM_Decode)->Apply(codec_args);
+BENCHMARK(BM_Encode)->Apply(codec_args);
+BENCHMARK(BM_DecodeStream)
+    ->ArgNames({"method", "corpus", "pooled"})
+    ->ArgsProduct({{LZHUFF5_METHOD_NUM, LZHUFF7_METHOD_NUM}, {CORPUS_SMALL}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+int main(int argc, char **argv)
+{
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    /* in the JSON context, so that runs on different machines are told apart */
+    benchmark::AddCustomContext("crc_engine", LHACrc::engine_name(LHACrc::engine()));
+    benchmark::AddCustomContext("decode_kernel", LHADecoder::kernel_name(LHADecoder::best_kernel()));
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
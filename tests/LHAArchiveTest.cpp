@@ -0,0 +1,666 @@
+// LHAArchiveTest.cpp: walking a mapped archive with LHAArchive::iterator.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <mutex>
+
+#include "LHATest.h"
+#include "LHAArchive.h"
+
+/* the members of `path' as the iterator sees them, each extracted */
+static void check_walk(const std::string &path, const std::vector<LHATestMember> &members)
+{
+    LHAArchive        archive;
+    std::vector<char> buf;
+    size_t            i = 0, next = 0;
+
+    LHA_CHECK(archive.open(path.c_str()));
+    for (LHAArchive::iterator it = archive.begin(); it != archive.end(); ++it, i++) {
+        if (i >= members.size())
+            break;
+        const LHATestMember &m = members[i];
+
+        LHA_CHECK(it->offset == next);
+        LHA_CHECK(it->data == archive.data() + it->offset + it->dataoffset);
+        LHA_CHECK(m.name == lha_test_name(it->header->name));
+        LHA_CHECK(LHADecoder::method_number(it->header->method) == m.method);
+        LHA_CHECK(it->header->original_size == m.data.size());
+        next = it->offset + it->dataoffset + (size_t)it->header->packed_size;
+
+        buf.assign(m.data.size() + 1, 0);
+        LHA_CHECK(archive.extract(*it, &buf[0]));
+        LHA_CHECK(m.data.empty() || memcmp(&buf[0], &m.data[0], m.data.size()) == 0);
+    }
+    LHA_CHECK(i == members.size());
+    LHA_CHECK(next + 1 == archive.size());      /* then the end mark */
+}
+
+LHA_TEST_CASE(archive_iterate)
+{
+    std::string                path = lha_test_path("archive.lzh");
+    std::vector<LHATestMember> members;
+    std::vector<char>          data;
+
+    lha_test_members(members, 40, 20000, 1);
+    for (int level = 0; level <= 2; level++) {
+        LHA_CHECK(lha_test_archive(data, members, level));
+        LHA_CHECK(lha_test_write_file(path, data));
+        check_walk(path, members);
+    }
+    remove(path.c_str());
+}
+
+/* an iterator owns its header: a copy stays put while the original moves on */
+LHA_TEST_CASE(archive_iterator_copy)
+{
+    std::string                path = lha_test_path("archive_copy.lzh");
+    std::vector<LHATestMember> members;
+    std::vector<char>          data;
+    LHAArchive                 archive;
+
+    lha_test_members(members, 5, 1000, 2);
+    LHA_CHECK(lha_test_archive(data, members, 2));
+    LHA_CHECK(lha_test_write_file(path, data));
+    LHA_CHECK(archive.open(path.c_str()));
+
+    LHAArchive::iterator it = archive.begin();
+    LHAArchive::iterator first = it++;
+    LHA_CHECK(first == archive.begin());
+    LHA_CHECK(first != it);
+    LHA_CHECK(members[0].name == lha_test_name(first->header->name));
+    LHA_CHECK(members[1].name == lha_test_name(it->header->name));
+    LHA_CHECK(first->header != it->header);
+
+    archive.close();
+    remove(path.c_str());
+}
+
+LHA_TEST_CASE(archive_empty)
+{
+    std::string       path = lha_test_path("archive_empty.lzh");
+    std::vector<char> data;
+    LHAArchive        archive;
+
+    LHA_CHECK(!archive.open(lha_test_path("no_such_archive.lzh").c_str()));
+    LHA_CHECK(archive.begin() == archive.end());
+
+    for (int i = 0; i < 2; i++) {
+        data.assign(i, 0);      /* nothing at all, or just the end mark */
+        LHA_CHECK(lha_test_write_file(path, data));
+        if (archive.open(path.c_str()))
+            LHA_CHECK(archive.begin() == archive.end());
+        archive.close();
+    }
+    remove(path.c_str());
+}
+
+/* a member running past the end of the file ends the walk before it */
+LHA_TEST_CASE(archive_truncated)
+{
+    std::string                path = lha_test_path("archive_cut.lzh");
+    std::vector<LHATestMember> members;
+    std::vector<char>          data;
+    LHAArchive                 archive;
+    size_t                     count;
+
+    lha_test_members(members, 4, 5000, 3);
+    members[3].method = LZHUFF0_METHOD_NUM;
+    lha_test_data(members[3].data, 3000, 4);
+    LHA_CHECK(lha_test_archive(data, members, 2));
+    data.resize(data.size() - 1000);
+    LHA_CHECK(lha_test_write_file(path, data));
+    LHA_CHECK(archive.open(path.c_str()));
+
+    count = 0;
+    for (LHAArchive::iterator it = archive.begin(); it != archive.end(); ++it)
+        count++;
+    LHA_CHECK(count == 3);
+
+    archive.close();
+    remove(path.c_str());
+}
+
+/* what extract_all() handed over, by header offset */
+struct Extracted {
+    std::mutex                              lock;
+    std::map<size_t, std::pair<bool, std::string> > members;
+    bool                                    null_buf_on_failure;
+    bool                                    null_buf_for_dirs;
+};
+
+static bool collect(void *param, const LHAEntry *entry, const char *buf, bool ok)
+{
+    Extracted   *out = (Extracted *)param;
+    std::string data;
+
+    if (buf)
+        data.assign(buf, entry->header->original_size);
+    std::lock_guard<std::mutex> hold(out->lock);
+    if (!ok && buf)
+        out->null_buf_on_failure = false;
+    if (LHADecoder::method_number(entry->header->method) == LZHDIRS_METHOD_NUM && buf)
+        out->null_buf_for_dirs = false;
+    LHA_CHECK(out->members.count(entry->offset) == 0);
+    out->members[entry->offset] = std::make_pair(ok, data);
+    return true;
+}
+
+/* every member once, whole, on any number of threads */
+LHA_TEST_CASE(archive_extract_all)
+{
+    std::string                path = lha_test_path("archive_all.lzh");
+    std::vector<LHATestMember> members;
+    std::vector<char>          data;
+    LHAArchive                 archive;
+    static const int           threads[] = {1, 3, 0};
+
+    lha_test_members(members, 60, 30000, 5);
+    LHA_CHECK(lha_test_archive(data, members, 2));
+    LHA_CHECK(lha_test_write_file(path, data));
+    LHA_CHECK(archive.open(path.c_str()));
+
+    for (int t = 0; t < 3; t++) {
+        Extracted out;
+        size_t    i = 0;
+
+        out.null_buf_on_failure = out.null_buf_for_dirs = true;
+        LHA_CHECK(archive.extract_all(collect, &out, threads[t]) == 0);
+        LHA_CHECK(out.members.size() == members.size());
+        LHA_CHECK(out.null_buf_for_dirs);
+        for (LHAArchive::iterator it = archive.begin(); it != archive.end(); ++it, i++) {
+            const std::pair<bool, std::string> &got = out.members[it->offset];
+            const std::vector<unsigned char>   &want = members[i].data;
+
+            LHA_CHECK(got.first);
+            LHA_CHECK(got.second.size() == want.size());
+            LHA_CHECK(want.empty() || memcmp(got.second.data(), &want[0], want.size()) == 0);
+        }
+    }
+    archive.close();
+    remove(path.c_str());
+}
+
+/*
+ * A member that decodes to the wrong CRC, and a stored member whose
+ * header claims 4 GB, fail on their own; nothing is allocated for the
+ * claim and the other members come out whole.
+ */
+LHA_TEST_CASE(archive_extract_all_damaged)
+{
+    std::string                path = lha_test_path("archive_damaged.lzh");
+    std::vector<LHATestMember> members;
+    std::vector<char>          data;
+    LHAArchive                 archive;
+    Extracted                  out;
+    size_t                     bad[2], i;
+
+    lha_test_members(members, 8, 20000, 6);
+    LHA_CHECK(lha_test_archive(data, members, 2));
+    LHA_CHECK(lha_test_write_file(path, data));
+    LHA_CHECK(archive.open(path.c_str()));
+    LHAArchive::iterator it = archive.begin();
+    bad[0] = it->offset + it->dataoffset + (size_t)it->header->packed_size / 2;
+    LHA_CHECK(members[0].method == LZHUFF5_METHOD_NUM);
+    for (i = 0; i < 3; i++)
+        ++it;
+    LHA_CHECK(members[3].method == LZHUFF0_METHOD_NUM && it->header->header_level == 2);
+    bad[1] = it->offset + 11;                  /* original size */
+    archive.close();
+
+    data[bad[0]] ^= 0x01;
+    memset(&data[bad[1]], 0xff, 4);
+    LHA_CHECK(lha_test_write_file(path, data));
+    LHA_CHECK(archive.open(path.c_str()));
+
+    out.null_buf_on_failure = out.null_buf_for_dirs = true;
+    LHA_CHECK(archive.extract_all(collect, &out, 2) == 2);
+    LHA_CHECK(out.null_buf_on_failure);
+    i = 0;
+    for (it = archive.begin(); it != archive.end(); ++it, i++) {
+        const std::pair<bool, std::string> &got = out.members[it->offset];
+
+        LHA_CHECK(got.first == (i != 0 && i != 3));
+        if (got.first)
+            LHA_CHECK(got.second.size() == members[i].data.size());
+    }
+    LHA_CHECK(i == members.size());
+
+    archive.close();
+    remove(path.c_str());
+}
+
+LHA_TEST_CASE(archive_extract_all_dir)
+{
+    std::string                path = lha_test_path("archive_dir.lzh");
+    std::string                dir  = lha_test_path("out");
+    std::vector<LHATestMember> members;
+    std::vector<char>          data;
+    LHAArchive                 archive;
+
+    lha_test_members(members, 20, 5000, 7);
+    LHA_CHECK(lha_test_archive(data, members, 1));
+    LHA_CHECK(lha_test_write_file(path, data));
+    LHA_CHECK(archive.open(path.c_str()));
+    LHA_CHECK(archive.extract_all(dir.c_str(), 2) == 0);
+    archive.close();
+
+    lha_test_check_tree(dir, members);
+    remove(path.c_str());
+}
+
+LHA_TEST_CASE(archive_output_path)
+{
+    std::string path;
+
+    LHA_CHECK(LHAArchive::output_path("out", "a/b\\c\xff" "d", &path) && path == "out/a/b/c/d");
+    LHA_CHECK(LHAArchive::output_path("out", "/abs/./file", &path) && path == "out/abs/file");
+    LHA_CHECK(!LHAArchive::output_path("out", "a/../../etc/passwd", &path));
+    LHA_CHECK(!LHAArchive::output_path("out", "c:/file", &path));
+    LHA_CHECK(!LHAArchive::output_path("out", "./", &path));
+    LHA_CHECK(!LHAArchive::output_path("out", "", &path));
+}
+
+/* members by name and by index, decoded whole and streamed */
+LHA_TEST_CASE(archive_open_member)
+{
+    std::string                path = lha_test_path("archive_member.lzh");
+    std::vector<LHATestMember> members;
+    std::vector<char>          data, buf;
+    std::vector<unsigned char> streamed;
+    LHAArchive                 archive;
+    std::string                name;
+
+    LHA_CHECK(archive.open_member("anything") == archive.end());
+    LHA_CHECK(archive.open_member((size_t)0) == archive.end());
+
+    lha_test_members(members, 100, 20000, 26);
+    LHA_CHECK(lha_test_archive(data, members, 2));
+    LHA_CHECK(lha_test_write_file(path, data));
+    LHA_CHECK(archive.open(path.c_str()));
+
+    for (size_t k = 0; k < members.size(); k++) {
+        size_t i = k * 37 % members.size();         /* in no particular order */
+        const LHATestMember &m = members[i];
+
+        LHAArchive::iterator by_index = archive.open_member(i);
+        LHA_CHECK(by_index != archive.end());
+        if (by_index == archive.end())
+            continue;
+        name = by_index->header->name;
+        LHA_CHECK(lha_test_name(name.c_str()) == m.name);
+
+        LHAArchive::iterator by_name = archive.open_member(name.c_str());
+        LHA_CHECK(by_name == by_index);
+        LHA_CHECK(by_name->offset == by_index->offset);
+
+        buf.assign(m.data.size() + 1, 0);
+        LHA_CHECK(archive.extract(*by_name, &buf[0]));
+        LHA_CHECK(m.data.empty() || memcmp(&buf[0], &m.data[0], m.data.size()) == 0);
+        streamed.clear();
+        LHA_CHECK(archive.extract(*by_name, lha_test_append, &streamed));
+        LHA_CHECK(streamed == m.data);
+
+        /* iterating on from a member walks the rest */
+        if (i + 1 < members.size())
+            LHA_CHECK(++by_name == archive.open_member(i + 1));
+    }
+    LHA_CHECK(archive.open_member(members.size()) == archive.end());
+    LHA_CHECK(archive.open_member("dir0/file0.txt") == archive.end());    /* '/' is not 0xff */
+    LHA_CHECK(archive.open_member((const char *)NULL) == archive.end());
+    LHA_CHECK(archive.at(1) == archive.end());
+    LHA_CHECK(archive.at(data.size() - 1) == archive.end());             /* the end mark */
+    LHA_CHECK(archive.at(data.size() + 100) == archive.end());
+    archive.close();
+
+    /* another archive in the same object gets a listing of its own */
+    members.resize(3);
+    members[2].name = "only/in/the/second";
+    LHA_CHECK(lha_test_archive(data, members, 1));
+    LHA_CHECK(lha_test_write_file(path, data));
+    LHA_CHECK(archive.open(path.c_str()));
+    LHA_CHECK(archive.open_member((size_t)3) == archive.end());
+    LHA_CHECK(archive.open_member("only\xff" "in\xff" "the\xff" "second") == archive.open_member((size_t)2));
+    LHA_CHECK(archive.open_member((size_t)2) != archive.end());
+    archive.close();
+    remove(path.c_str());
+}
+
+/* what test_all() reported, by header offset */
+struct Tested {
+    std::mutex                lock;
+    std::map<size_t, int>     results;
+    size_t                    calls;
+    bool                      null_header_on_header;
+};
+
+static void tested(void *param, const LHAEntry *entry, int result)
+{
+    Tested *out = (Tested *)param;
+    std::lock_guard<std::mutex> hold(out->lock);
+
+    if ((result == LHA_TEST_HEADER) != (entry->header == NULL))
+        out->null_header_on_header = false;
+    out->results[entry->offset] = result;
+    out->calls++;
+}
+
+static void check_tested(LHAArchive &archive, int threads, Tested &out, int failures)
+{
+    out.calls = 0;
+    out.null_header_on_header = true;
+    out.results.clear();
+    LHA_CHECK(archive.test_all(tested, &out, threads) == failures);
+    LHA_CHECK(out.calls == out.results.size());
+    LHA_CHECK(out.null_header_on_header);
+}
+
+/* a sound archive passes at every header level on any number of threads */
+LHA_TEST_CASE(archive_test_all)
+{
+    std::string                path = lha_test_path("archive_test.lzh");
+    std::vector<LHATestMember> members;
+    std::vector<char>          data;
+    LHAArchive                 archive;
+    static const int           threads[] = {1, 3, 0};
+
+    lha_test_members(members, 40, 30000, 7);
+    for (int level = 0; level <= 2; level++) {
+        LHA_CHECK(lha_test_archive(data, members, level));
+        LHA_CHECK(lha_test_write_file(path, data));
+        LHA_CHECK(archive.open(path.c_str()));
+
+        for (int t = 0; t < 3; t++) {
+            Tested out;
+
+            check_tested(archive, threads[t], out, 0);
+            LHA_CHECK(out.results.size() == members.size());
+            for (LHAArchive::iterator it = archive.begin(); it != archive.end(); ++it)
+                LHA_CHECK(out.results.count(it->offset) == 1 && out.results[it->offset] == LHA_TEST_OK);
+        }
+        LHA_CHECK(archive.test_all() == 0);
+        archive.close();
+    }
+    remove(path.c_str());
+}
+
+/* recompute a level 0/1 header's checksum after changing it */
+static void fix_checksum(std::vector<char> &data, size_t offset)
+{
+    data[offset + 1] = (char)LHAPack::calc_sum(&data[offset + 2], (unsigned char)data[offset]);
+}
+
+/*
+ * Each kind of damage is reported against its own member: packed data
+ * that does not decode, data that decodes to the wrong CRC, an unknown
+ * method, a header that fails its checksum or header CRC, and one that
+ * cannot be read at all, after which the walk goes on.  At level 2 the
+ * -lhx- member fails its header CRC first.
+ */
+LHA_TEST_CASE(archive_test_all_damaged)
+{
+    std::string                path = lha_test_path("archive_test_bad.lzh");
+    std::vector<LHATestMember> members;
+    std::vector<char>          data;
+    std::vector<size_t>        offsets;
+    LHAArchive                 archive;
+    Tested                     out;
+    size_t                     i;
+
+    lha_test_members(members, 12, 20000, 8);
+    lha_test_data(members[0].data, 20000, 1);
+    LHA_CHECK(members[0].method == LZHUFF5_METHOD_NUM && members[3].method == LZHUFF0_METHOD_NUM);
+
+    for (int level = 1; level <= 2; level++) {
+        LHA_CHECK(lha_test_archive(data, members, level));
+        LHA_CHECK(lha_test_write_file(path, data));
+        LHA_CHECK(archive.open(path.c_str()));
+        offsets.clear();
+        for (LHAArchive::iterator it = archive.begin(); it != archive.end(); ++it)
+            offsets.push_back(it->offset);
+        LHA_CHECK(offsets.size() == members.size());
+        LHAArchive::iterator first = archive.begin();
+        size_t packed = first->dataoffset + (size_t)first->header->packed_size / 2;
+        size_t stored = archive.at(offsets[3])->dataoffset;
+        archive.close();
+
+        data[offsets[0] + packed] ^= 0x01;              /* corrupt, or the wrong CRC */
+        data[offsets[3] + stored + 10] ^= 0x01;         /* the wrong CRC */
+        data[offsets[5] + 15] ^= 0x01;                  /* the time stamp */
+        data[offsets[7] + 5] = 'x';                     /* -lhx- */
+        memset(&data[offsets[9]], 0x01, 8);             /* no header at all */
+        if (level == 1)
+            fix_checksum(data, offsets[7]);
+        LHA_CHECK(lha_test_write_file(path, data));
+        LHA_CHECK(archive.open(path.c_str()));
+
+        check_tested(archive, 3, out, 5);
+        LHA_CHECK(out.results[offsets[0]] == LHA_TEST_CORRUPT || out.results[offsets[0]] == LHA_TEST_CRC);
+        LHA_CHECK(out.results[offsets[3]] == LHA_TEST_CRC);
+        LHA_CHECK(out.results[offsets[5]] == LHA_TEST_HEADER);
+        LHA_CHECK(out.results[offsets[7]] == (level == 1 ? LHA_TEST_METHOD : LHA_TEST_HEADER));
+        LHA_CHECK(out.results[offsets[9]] == LHA_TEST_HEADER);
+        for (i = 0; i < members.size(); i++)
+            if (i != 0 && i != 3 && i != 5 && i != 7 && i != 9)
+                LHA_CHECK(out.results.count(offsets[i]) == 1 && out.results[offsets[i]] == LHA_TEST_OK);
+        LHA_CHECK(out.results.size() == members.size());
+        archive.close();
+    }
+    remove(path.c_str());
+}
+
+/* a member whose header claims 4 GB is tested in the decoder's window, and fails */
+LHA_TEST_CASE(archive_test_all_huge)
+{
+    std::string                path = lha_test_path("archive_test_huge.lzh");
+    std::vector<LHATestMember> members;
+    std::vector<char>          data;
+    LHAArchive                 archive;
+    Tested                     out;
+    size_t                     offset;
+
+    lha_test_members(members, 3, 20000, 9);
+    LHA_CHECK(lha_test_archive(data, members, 1));
+    LHA_CHECK(lha_test_write_file(path, data));
+    LHA_CHECK(archive.open(path.c_str()));
+    offset = (++archive.begin())->offset;
+    archive.close();
+
+    memset(&data[offset + 11], 0xff, 4);                /* original size */
+    fix_checksum(data, offset);
+    LHA_CHECK(lha_test_write_file(path, data));
+    LHA_CHECK(archive.open(path.c_str()));
+
+    check_tested(archive, 2, out, 1);
+    LHA_CHECK(out.results.size() == members.size());
+    LHA_CHECK(out.results[offset] == LHA_TEST_CORRUPT);
+
+    archive.close();
+    remove(path.c_str());
+}
+
+static const LHADecoder::Kernel scan_kernels[] = {
+    LHADecoder::KERNEL_GENERIC, LHADecoder::KERNEL_SSE2, LHADecoder::KERNEL_AVX2
+};
+
+/* find_candidate() one byte at a time */
+static size_t next_candidate(const char *data, size_t length, size_t from, size_t to)
+{
+    size_t at;
+
+    if (to > length)
+        to = length;
+    for (at = from; at < to && at + 20 < length; at++)
+        if (data[at + 2] == '-' && data[at + 3] == 'l' && data[at + 6] == '-' &&
+            (unsigned char)data[at + 20] <= 3)
+            return at;
+    return to;
+}
+
+/*
+ * Every kernel finds the same candidates as a byte-at-a-time scan, with
+ * signatures planted at all alignments, across vector boundaries and
+ * right up to both ends of the data and of the range.
+ */
+LHA_TEST_CASE(archive_find_candidate)
+{
+    std::vector<unsigned char> noise;
+    std::vector<char>          buf;
+    size_t                     at, from, to, want;
+
+    lha_test_data(noise, 3000, 10);
+    buf.assign(noise.begin(), noise.end());
+    for (at = 0; at + 21 < buf.size(); at += at < 200 ? 7 : 61) {
+        memcpy(&buf[at + 2], at % 3 ? "-lh5-" : "-lzs-", 5);
+        buf[at + 20] = (char)(at % 5);      /* a level of 4 is no candidate */
+    }
+    memcpy(&buf[buf.size() - 21 + 2], "-lh7-", 5);     /* the last place a header fits */
+    buf[buf.size() - 1] = 2;
+
+    for (size_t k = 0; k < sizeof(scan_kernels) / sizeof(scan_kernels[0]); k++)
+        for (size_t shift = 0; shift < 3; shift++) {
+            const char *data   = &buf[shift];   /* any alignment */
+            size_t      length = buf.size() - shift;
+
+            for (from = 0; from < length; from += from < 100 ? 1 : 37)
+                for (to = from; to <= length + 5; to += to - from < 40 ? 1 : 301) {
+                    want = next_candidate(data, length, from, to);
+                    LHA_CHECK(LHAArchive::find_candidate(data, length, from, to, scan_kernels[k]) == want);
+                }
+            at = 0;
+            while ((at = LHAArchive::find_candidate(data, length, at, length, scan_kernels[k])) < length) {
+                LHA_CHECK(at == next_candidate(data, length, at, length));
+                at++;
+            }
+        }
+    LHA_CHECK(LHAArchive::find_candidate(NULL, 0, 0, 10) == 0);      /* `to' is cut to the length */
+}
+
+/*
+ * find_header() takes only members with a sound header: planted
+ * signatures and a damaged member are passed over, on every kernel.
+ */
+LHA_TEST_CASE(archive_find_header)
+{
+    std::string                path = lha_test_path("archive_find.lzh");
+    std::vector<LHATestMember> members;
+    std::vector<unsigned char> noise;
+    std::vector<char>          data;
+    std::vector<size_t>        offsets;
+    LHAArchive                 archive;
+    size_t                     i, junk;
+
+    lha_test_members(members, 10, 5000, 11);
+    for (int level = 0; level <= 2; level++) {
+        LHA_CHECK(lha_test_archive(data, members, level));
+
+        /* junk in front, with signatures that lead nowhere */
+        lha_test_data(noise, 1000, 12);
+        for (i = 0; i + 30 < noise.size(); i += 97) {
+            memcpy(&noise[i + 2], "-lh5-", 5);
+            noise[i + 20] = (unsigned char)level;
+        }
+        junk = noise.size();
+        data.insert(data.begin(), noise.begin(), noise.end());
+        LHA_CHECK(lha_test_write_file(path, data));
+        LHA_CHECK(archive.open(path.c_str()));
+
+        offsets.clear();
+        for (LHAArchive::iterator it = archive.recover(0); it != archive.end(); ++it)
+            offsets.push_back(it->offset);
+        LHA_CHECK(offsets.size() == members.size());
+        LHA_CHECK(!offsets.empty() && offsets[0] == junk);
+
+        for (size_t k = 0; k < sizeof(scan_kernels) / sizeof(scan_kernels[0]); k++) {
+            LHA_CHECK(LHAArchive::find_header(archive.data(), archive.size(), 0, scan_kernels[k]) == junk);
+            for (i = 0; i < offsets.size(); i++)
+                LHA_CHECK(LHAArchive::find_header(archive.data(), archive.size(), offsets[i] + 1, scan_kernels[k]) ==
+                          (i + 1 < offsets.size() ? offsets[i + 1] : archive.size()));
+        }
+        archive.close();
+    }
+    remove(path.c_str());
+}
+
+/* a walk stopped by a bad header is picked up again at the next sound one */
+LHA_TEST_CASE(archive_recover)
+{
+    std::string                path = lha_test_path("archive_recover.lzh");
+    std::vector<LHATestMember> members;
+    std::vector<char>          data;
+    std::vector<size_t>        offsets;
+    LHAArchive                 archive;
+    size_t                     count, bad;
+
+    LHA_CHECK(archive.recover(0) == archive.end());
+    lha_test_members(members, 12, 8000, 13);
+    for (int level = 0; level <= 2; level++) {
+        LHA_CHECK(lha_test_archive(data, members, level));
+        LHA_CHECK(lha_test_write_file(path, data));
+        LHA_CHECK(archive.open(path.c_str()));
+        offsets.clear();
+        for (LHAArchive::iterator it = archive.begin(); it != archive.end(); ++it)
+            offsets.push_back(it->offset);
+        archive.close();
+
+        memset(&data[offsets[4]], 0, 3);        /* looks like the end mark */
+        LHA_CHECK(lha_test_write_file(path, data));
+        LHA_CHECK(archive.open(path.c_str()));
+
+        count = 0;
+        LHAArchive::iterator it;
+        for (it = archive.begin(); it != archive.end(); ++it)
+            count++;
+        LHA_CHECK(count == 4);
+
+        bad = offsets[4];
+        it  = archive.recover(bad + 1);
+        LHA_CHECK(it != archive.end() && it->offset == offsets[5]);
+        for (count = 5; it != archive.end(); ++it, count++)
+            LHA_CHECK(members[count].name == lha_test_name(it->header->name));
+        LHA_CHECK(count == members.size());
+        LHA_CHECK(archive.recover(offsets.back() + 1) == archive.end());
+        archive.close();
+    }
+    remove(path.c_str());
+}
+
+/*
+ * An -lh5- member whose header claims 4 GB fails on its own in
+ * extract_all() and extract(), without the memory: the output buffer
+ * grows only with what is decoded.
+ */
+LHA_TEST_CASE(archive_extract_all_huge)
+{
+    std::string                path = lha_test_path("archive_huge.lzh");
+    std::vector<LHATestMember> members;
+    std::vector<char>          data;
+    LHAArchive                 archive;
+    Extracted                  out;
+    size_t                     offset;
+
+    lha_test_members(members, 3, 20000, 17);
+    LHA_CHECK(members[0].method == LZHUFF5_METHOD_NUM);
+    LHA_CHECK(lha_test_archive(data, members, 1));
+    memset(&data[11], 0xff, 4);                         /* original size */
+    fix_checksum(data, 0);
+    LHA_CHECK(lha_test_write_file(path, data));
+    LHA_CHECK(archive.open(path.c_str()));
+
+    out.null_buf_on_failure = out.null_buf_for_dirs = true;
+    LHA_CHECK(archive.extract_all(collect, &out, 2) == 1);
+    LHA_CHECK(out.members.size() == members.size());
+    LHA_CHECK(!out.members[0].first && out.null_buf_on_failure);
+    offset = (++archive.begin())->offset;
+    LHA_CHECK(out.members[offset].first);
+    LHA_CHECK(out.members[offset].second.size() == members[1].data.size());
+
+    std::vector<unsigned char> buf;
+    LHA_CHECK(!archive.extract(*archive.begin(), lha_test_append, &buf));
+    LHA_CHECK(buf.size() <= members[0].data.size() + 0x10000);
+
+    archive.close();
+    remove(path.c_str());
+}
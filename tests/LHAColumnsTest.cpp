@@ -0,0 +1,130 @@
+// LHAColumnsTest.cpp: the columnar batch listing, LHAColumns.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+
+#include "LHATest.h"
+#include "LHAArchive.h"
+#include "LHAListing.h"
+#include "LHAColumns.h"
+
+#define COLUMN_ARCHIVES     9
+
+/* scratch archives of every header level; every fourth path is missing */
+static void make_archives(std::vector<std::string> &paths)
+{
+    std::vector<LHATestMember> members;
+    std::vector<char>          data;
+    char                       name[32];
+
+    paths.clear();
+    for (int i = 0; i < COLUMN_ARCHIVES; i++) {
+        snprintf(name, sizeof(name), "columns%d.lzh", i);
+        paths.push_back(lha_test_path(name));
+        if (i % 4 == 3)
+            continue;
+        lha_test_members(members, 5 + i * 13, 2000, 23 + i);
+        LHA_CHECK(lha_test_archive(data, members, i % 3));
+        LHA_CHECK(lha_test_write_file(paths.back(), data));
+    }
+}
+
+static void remove_archives(const std::vector<std::string> &paths)
+{
+    for (size_t i = 0; i < paths.size(); i++)
+        remove(paths[i].c_str());
+}
+
+/* columns from `first' on hold what a listing of the archive holds */
+static size_t check_archive(const LHAColumns &c, size_t first, uint32_t id, const std::string &path)
+{
+    LHAArchive archive;
+    LHAListing listing;
+    size_t     i;
+
+    LHA_CHECK(archive.open(path.c_str()) && listing.read(archive));
+    for (i = 0; i < listing.size() && first + i < c.size(); i++) {
+        const LHAListEntry &e = listing[i];
+        size_t              j = first + i;
+
+        LHA_CHECK(c.packed_size()[j] == e.packed_size && c.original_size()[j] == e.original_size);
+        LHA_CHECK(c.method_id()[j] == e.method && c.crc()[j] == e.crc);
+        LHA_CHECK(c.mtime()[j] == e.last_modified && c.archive()[j] == id);
+        LHA_CHECK(strcmp(c.name(j), listing.name(i)) == 0);
+        LHA_CHECK(c.name_arena() + c.name_offset()[j] == c.name(j));
+    }
+    LHA_CHECK(i == listing.size());
+    return first + i;
+}
+
+LHA_TEST_CASE(columns_add)
+{
+    std::vector<std::string> paths;
+    LHAColumns               c;
+    size_t                   at = 0, names = 0;
+
+    make_archives(paths);
+    for (size_t i = 0; i < paths.size(); i++) {
+        LHA_CHECK(c.add(paths[i].c_str()) == (i % 4 != 3));
+        LHA_CHECK(c.archives() == i + 1);
+        if (i % 4 != 3)
+            at = check_archive(c, at, (uint32_t)i, paths[i]);
+    }
+    LHA_CHECK(at == c.size());
+    for (size_t j = 0; j < c.size(); j++)
+        names += strlen(c.name(j)) + 1;
+    LHA_CHECK(names == c.name_arena_size());
+
+    LHAArchive archive;
+    LHA_CHECK(!c.add(archive));                     /* not open */
+    LHA_CHECK(archive.open(paths[0].c_str()) && c.add(archive));
+    LHA_CHECK(c.archives() == paths.size() + 2);
+    LHA_CHECK(check_archive(c, at, (uint32_t)paths.size() + 1, paths[0]) == c.size());
+
+    c.clear();
+    LHA_CHECK(c.size() == 0 && c.archives() == 0 && c.name_arena_size() == 0);
+    c.reserve(1000, 10000);
+    LHA_CHECK(c.size() == 0);
+    archive.close();
+    remove_archives(paths);
+}
+
+/* add_all() on any number of threads is add() on each path in turn */
+LHA_TEST_CASE(columns_add_all)
+{
+    std::vector<std::string>  paths;
+    std::vector<const char *> ptrs;
+    LHAColumns                want;
+    static const int          threads[] = {1, 4, 0};
+
+    make_archives(paths);
+    for (size_t i = 0; i < paths.size(); i++) {
+        ptrs.push_back(paths[i].c_str());
+        want.add(ptrs[i]);
+    }
+
+    for (int t = 0; t < 3; t++) {
+        LHAColumns c;
+
+        LHA_CHECK(c.add(ptrs[0]));                  /* appended to what is there */
+        LHA_CHECK(c.add_all(&ptrs[0], ptrs.size(), threads[t]) == COLUMN_ARCHIVES / 4);
+        LHA_CHECK(c.add_all(&ptrs[0], 0, threads[t]) == 0);
+        LHA_CHECK(c.archives() == want.archives() + 1);
+
+        size_t n = c.size() - want.size();
+        LHA_CHECK(n == check_archive(c, 0, 0, paths[0]));
+        LHA_CHECK(c.size() == n + want.size());
+        for (size_t j = 0; j < want.size() && j + n < c.size(); j++) {
+            LHA_CHECK(c.packed_size()[j + n] == want.packed_size()[j]);
+            LHA_CHECK(c.original_size()[j + n] == want.original_size()[j]);
+            LHA_CHECK(c.method_id()[j + n] == want.method_id()[j]);
+            LHA_CHECK(c.crc()[j + n] == want.crc()[j]);
+            LHA_CHECK(c.mtime()[j + n] == want.mtime()[j]);
+            LHA_CHECK(c.archive()[j + n] == want.archive()[j] + 1);
+            LHA_CHECK(strcmp(c.name(j + n), want.name(j)) == 0);
+        }
+    }
+    remove_archives(paths);
+}
@@ -0,0 +1,74 @@
+// LHACrcTest.cpp: CRC-16 engines against a bit at a time reference.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+
+#include "LHATest.h"
+#include "LHACrc.h"
+
+static const LHACrc::Engine engines[] = {
+    LHACrc::CRC_BYTEWISE, LHACrc::CRC_SLICE8, LHACrc::CRC_SLICE16, LHACrc::CRC_PCLMUL
+};
+
+/* CRC-16/ARC, as LHa computes it: reflected, polynomial 0x8005 */
+static unsigned int crc_reference(unsigned int crc, const unsigned char *p, size_t n)
+{
+    while (n--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++)
+            crc = (crc & 1) ? (crc >> 1) ^ 0xa001 : crc >> 1;
+    }
+    return crc;
+}
+
+LHA_TEST_CASE(crc_check_value)
+{
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        if (!LHACrc::engine_supported(engines[e]))
+            continue;
+        LHA_CHECK(LHACrc::calccrc(engines[e], 0, "123456789", 9) == 0xbb3d);
+        LHA_CHECK(LHACrc::calccrc(engines[e], 0x1234, "", 0) == 0x1234);
+    }
+    LHA_CHECK(LHACrc::engine_supported(LHACrc::CRC_BYTEWISE));
+    LHA_CHECK(LHACrc::engine_supported(LHACrc::engine()));
+    LHA_CHECK(LHACrc::calccrc(0, "123456789", 9) == 0xbb3d);
+}
+
+/* every length up to a few blocks, at every alignment, continued from any CRC */
+LHA_TEST_CASE(crc_engines_agree)
+{
+    std::vector<unsigned char> data;
+
+    lha_test_data(data, 4096 + 64, 5);
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        if (!LHACrc::engine_supported(engines[e]))
+            continue;
+        for (size_t align = 0; align < 16; align++)
+            for (size_t n = 0; n < 600; n += (n < 80 ? 1 : 37)) {
+                unsigned int seed = (unsigned int)(n * 2654435761U) & 0xffff;
+
+                LHA_CHECK(LHACrc::calccrc(engines[e], seed, &data[align], n) ==
+                          crc_reference(seed, &data[align], n));
+            }
+        LHA_CHECK(LHACrc::calccrc(engines[e], 0, &data[0], data.size()) ==
+                  crc_reference(0, &data[0], data.size()));
+    }
+}
+
+LHA_TEST_CASE(crc_streaming)
+{
+    std::vector<unsigned char> data;
+    LHACrc crc;
+    size_t done, n;
+
+    lha_test_data(data, 100000, 9);
+    for (done = 0, n = 1; done < data.size(); done += n, n = n * 3 + 1) {
+        if (n > data.size() - done)
+            n = data.size() - done;
+        crc.update(&data[done], n);
+    }
+    LHA_CHECK(crc.value() == crc_reference(0, &data[0], data.size()));
+    crc.reset();
+    LHA_CHECK(crc.value() == 0);
+}
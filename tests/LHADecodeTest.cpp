@@ -0,0 +1,373 @@
+// LHADecodeTest.cpp: -lh5-, -lh6- and -lh7- decoding, whole and
+// streamed, on every match copy kernel.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include <set>
+#include <thread>
+
+#include "LHATest.h"
+#include "LHAPack.h"
+#include "LHADecode.h"
+#include "LHAEncode.h"
+#include "LHAWriter.h"
+
+static const int methods[] = { LZHUFF5_METHOD_NUM, LZHUFF6_METHOD_NUM, LZHUFF7_METHOD_NUM };
+
+static bool decode_whole(LHADecoder &decoder, int method, const std::vector<unsigned char> &packed,
+                         std::vector<unsigned char> &out, size_t original_size)
+{
+    out.assign(original_size + 1, 0);
+    if (!decoder.decode(method, packed.empty() ? NULL : &packed[0], packed.size(), &out[0], original_size))
+        return false;
+    out.resize(original_size);
+    return true;
+}
+
+/* packed data handed over `chunk' bytes at a time */
+static bool decode_stream(LHADecoder &decoder, int method, const std::vector<unsigned char> &packed,
+                          std::vector<unsigned char> &out, size_t original_size, size_t chunk)
+{
+    size_t done = 0, used, len;
+
+    out.clear();
+    if (!decoder.begin_stream(method, packed.size(), original_size, lha_test_append, &out))
+        return false;
+    while (done < packed.size()) {
+        len = packed.size() - done < chunk ? packed.size() - done : chunk;
+        if (!decoder.stream(&packed[done], len, &used) || used == 0)
+            return false;
+        done += used;
+    }
+    return decoder.end_stream();
+}
+
+LHA_TEST_CASE(decode_roundtrip)
+{
+    static const size_t sizes[]  = { 0, 1, 257, 70000, 200000 };
+    static const int    levels[] = { LZH_LEVEL_MIN, LZH_LEVEL_DEFAULT, LZH_LEVEL_MAX };
+    std::vector<unsigned char> data, packed, out;
+    LHADecoder   decoder;
+    unsigned int crc;
+
+    for (size_t m = 0; m < sizeof(methods) / sizeof(methods[0]); m++)
+        for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++)
+            for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+                lha_test_data(data, sizes[s], (uint32_t)(s + 1));
+                LHA_CHECK(lha_test_pack(methods[m], levels[l], data, packed, &crc));
+                LHA_CHECK(decode_whole(decoder, methods[m], packed, out, data.size()));
+                LHA_CHECK(out == data);
+                LHA_CHECK(decoder.crc == crc);
+            }
+}
+
+LHA_TEST_CASE(decode_stream)
+{
+    static const size_t chunks[] = { 1, 13, 4096, 1 << 20 };
+    std::vector<unsigned char> data, packed, out;
+    LHADecoder   decoder;
+    unsigned int crc;
+
+    lha_test_data(data, 300000, 7);
+    for (size_t m = 0; m < sizeof(methods) / sizeof(methods[0]); m++) {
+        LHA_CHECK(lha_test_pack(methods[m], LZH_LEVEL_DEFAULT, data, packed, &crc));
+        for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+            LHA_CHECK(decode_stream(decoder, methods[m], packed, out, data.size(), chunks[c]));
+            LHA_CHECK(out == data);
+            LHA_CHECK(decoder.crc == crc);
+        }
+    }
+}
+
+/* streamed members one after another on a decoder: each starts from spaces */
+LHA_TEST_CASE(decode_stream_reuse)
+{
+    std::vector<unsigned char> data, packed, out;
+    LHADecoder   decoder;
+    unsigned int crc;
+
+    for (int i = 0; i < 6; i++) {
+        int method = methods[i % 3];
+
+        /* a small member, whose matches reach into the initial dictionary */
+        lha_test_data(data, i & 1 ? 100 : 150000, (uint32_t)i + 100);
+        data.insert(data.begin(), 40, ' ');
+        LHA_CHECK(lha_test_pack(method, LZH_LEVEL_DEFAULT, data, packed, &crc));
+        LHA_CHECK(decode_stream(decoder, method, packed, out, data.size(), 4096));
+        LHA_CHECK(out == data);
+        LHA_CHECK(decoder.crc == crc);
+    }
+}
+
+LHA_TEST_CASE(decode_kernels)
+{
+    static const LHADecoder::Kernel kernels[] = {
+        LHADecoder::KERNEL_GENERIC, LHADecoder::KERNEL_SSE2, LHADecoder::KERNEL_AVX2
+    };
+    std::vector<unsigned char> data, packed, out;
+    LHADecoder   decoder;
+    unsigned int crc;
+
+    lha_test_data(data, 250000, 3);
+    for (size_t m = 0; m < sizeof(methods) / sizeof(methods[0]); m++) {
+        LHA_CHECK(lha_test_pack(methods[m], LZH_LEVEL_MAX, data, packed, &crc));
+        for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+            if (!LHADecoder::kernel_supported(kernels[k])) {
+                LHA_CHECK(!decoder.set_kernel(kernels[k]));
+                continue;
+            }
+            LHA_CHECK(decoder.set_kernel(kernels[k]));
+            LHA_CHECK(decode_whole(decoder, methods[m], packed, out, data.size()));
+            LHA_CHECK(out == data);
+            LHA_CHECK(decode_stream(decoder, methods[m], packed, out, data.size(), 5000));
+            LHA_CHECK(out == data);
+        }
+    }
+}
+
+/*
+ * Data for the kernels' edge cases: matches at distances 1 to 40 (the
+ * copies overlap their own output), runs that end the output with a long
+ * match, one byte only (single-code tables), and noise (all literals).
+ */
+static void kernel_data(std::vector<unsigned char> &out, int kind, size_t size)
+{
+    uint32_t x = 12345;
+
+    out.clear();
+    switch (kind) {
+    case 0:
+        while (out.size() < size) {
+            x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+            size_t period = 1 + x % 40, run = 3 + (x >> 8) % 300;
+            out.push_back((unsigned char)(x >> 16));
+            for (size_t i = 0; i < run && out.size() < size; i++)
+                out.push_back(out.size() > period ? out[out.size() - period] : (unsigned char)i);
+        }
+        break;
+    case 1:
+        out.assign(size, 'a');
+        break;
+    default:
+        while (out.size() < size) {
+            x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+            out.push_back((unsigned char)(x >> 24));
+        }
+        break;
+    }
+}
+
+/* every kernel gives the same bytes, into a buffer of exactly their size */
+LHA_TEST_CASE(decode_kernel_edges)
+{
+    static const LHADecoder::Kernel kernels[] = {
+        LHADecoder::KERNEL_GENERIC, LHADecoder::KERNEL_SSE2, LHADecoder::KERNEL_AVX2
+    };
+    static const size_t sizes[] = {1, 2, 31, 32, 33, 100, 4097, 200000};
+    std::vector<unsigned char> data, packed, out;
+    LHADecoder   decoder;
+    unsigned int crc;
+
+    for (int kind = 0; kind < 3; kind++) {
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            kernel_data(data, kind, sizes[s]);
+            for (size_t m = 0; m < sizeof(methods) / sizeof(methods[0]); m++) {
+                LHA_CHECK(lha_test_pack(methods[m], LZH_LEVEL_MAX, data, packed, &crc));
+                for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+                    if (!decoder.set_kernel(kernels[k]))
+                        continue;
+                    out.assign(data.size(), 0);
+                    LHA_CHECK(decoder.decode(methods[m], &packed[0], packed.size(), &out[0], out.size()));
+                    LHA_CHECK(out == data && decoder.crc == crc);
+                    LHA_CHECK(decode_stream(decoder, methods[m], packed, out, data.size(), 777));
+                    LHA_CHECK(out == data);
+                }
+            }
+        }
+    }
+    LHA_CHECK(decoder.set_kernel(LHADecoder::best_kernel()));
+    LHA_CHECK(LHADecoder::kernel_supported(LHADecoder::KERNEL_GENERIC));
+    LHA_CHECK(strcmp(LHADecoder::kernel_name(LHADecoder::KERNEL_GENERIC), "generic") == 0);
+}
+
+/* damage anywhere in the packed data fails, or at worst gives a CRC mismatch */
+LHA_TEST_CASE(decode_corrupt)
+{
+    std::vector<unsigned char> data, packed, bad, out;
+    LHADecoder   decoder;
+    unsigned int crc;
+
+    lha_test_data(data, 50000, 11);
+    LHA_CHECK(lha_test_pack(LZHUFF5_METHOD_NUM, LZH_LEVEL_DEFAULT, data, packed, &crc));
+
+    for (size_t i = 0; i < packed.size(); i += 97) {
+        bad = packed;
+        bad[i] ^= 0x5a;
+        if (decode_whole(decoder, LZHUFF5_METHOD_NUM, bad, out, data.size()))
+            LHA_CHECK(decoder.crc != crc || out == data);
+    }
+
+    /* truncated, or a size the data cannot make */
+    bad.assign(packed.begin(), packed.begin() + packed.size() / 2);
+    LHA_CHECK(!decode_whole(decoder, LZHUFF5_METHOD_NUM, bad, out, data.size()));
+    LHA_CHECK(!decode_stream(decoder, LZHUFF5_METHOD_NUM, bad, out, data.size(), 4096));
+    LHA_CHECK(!decode_stream(decoder, LZHUFF5_METHOD_NUM, packed, out, (size_t)1 << 30, 4096));
+    LHA_CHECK(out.size() < ((size_t)1 << 20));
+}
+
+/* LHAPack::extract() on the member get_header() has just read */
+LHA_TEST_CASE(decode_lhapack)
+{
+    std::string       path = lha_test_path("decode.lzh");
+    std::vector<unsigned char> data[3];
+    std::vector<char> archive, buf;
+    LHAWriter         writer;
+    LHAPack           pack;
+    LHAHeader         hdr;
+    size_t            offset = 0;
+    char              name[32];
+    int               i;
+
+    LHA_CHECK(writer.open(path.c_str()));
+    for (i = 0; i < 3; i++) {
+        lha_test_data(data[i], 10000 * (i + 1), (uint32_t)i + 20);
+        snprintf(name, sizeof(name), "member%d", i);
+        LHA_CHECK(writer.set_method(methods[i]));
+        LHA_CHECK(writer.add(name, &data[i][0], data[i].size(), 1500000000));
+    }
+    LHA_CHECK(writer.close());
+    LHA_CHECK(lha_test_read_file(path, archive));
+    remove(path.c_str());
+
+    for (i = 0; i < 3 && !archive.empty(); i++) {
+        const char *p = &archive[0] + offset;
+
+        LHA_CHECK(pack.get_header(p, &archive[0] + archive.size(), &hdr));
+        LHA_CHECK(LHADecoder::method_number(hdr.method) == methods[i]);
+        LHA_CHECK(hdr.original_size == data[i].size());
+        buf.assign((size_t)hdr.original_size + 1, 0);
+        LHA_CHECK(pack.extract(p, &hdr, &buf[0]));
+        LHA_CHECK(memcmp(&buf[0], &data[i][0], data[i].size()) == 0);
+        offset += pack.dataoffset + (size_t)hdr.packed_size;
+    }
+}
+
+/* a thread gets back the decoder it returned last, and never one in use */
+LHA_TEST_CASE(decode_context_pool)
+{
+    std::vector<LHADecoderContext *> held;
+    std::set<LHADecoder *> seen;
+    LHADecoder *last;
+
+    {
+        LHADecoderContext decoder;
+        last = &*decoder;
+    }
+    {
+        LHADecoderContext decoder, other;
+        LHA_CHECK(&*decoder == last);
+        LHA_CHECK(&*other != last);
+    }
+
+    /* more than the pool keeps, all live at once */
+    for (int i = 0; i < LZH_CONTEXT_POOL + 2; i++) {
+        held.push_back(new LHADecoderContext);
+        seen.insert(&**held.back());
+    }
+    LHA_CHECK(seen.size() == held.size());
+    for (size_t i = 0; !held.empty(); i++) {
+        if (i < LZH_CONTEXT_POOL)
+            last = &**held.back();      /* the rest are freed */
+        delete held.back();
+        held.pop_back();
+    }
+    {
+        LHADecoderContext decoder;
+        LHA_CHECK(&*decoder == last);
+    }
+    LHADecoderContext::trim();
+}
+
+/* one context through members of every size and method, whole and streamed */
+LHA_TEST_CASE(decode_context_members)
+{
+    std::vector<unsigned char> data, packed, out;
+    unsigned int crc;
+
+    for (int i = 0; i < 60; i++) {
+        int    method = methods[i % 3];
+        size_t size   = i % 10 == 9 ? 150000 : (size_t)i * 7;
+        LHADecoderContext decoder;
+
+        lha_test_data(data, size, (uint32_t)i + 200);
+        LHA_CHECK(lha_test_pack(method, LZH_LEVEL_DEFAULT, data, packed, &crc));
+        LHA_CHECK(decode_stream(*decoder, method, packed, out, data.size(), i & 1 ? 64 : 4096));
+        LHA_CHECK(out == data);
+        LHA_CHECK(decoder->crc == crc);
+        LHA_CHECK(decode_whole(*decoder, method, packed, out, data.size()));
+        LHA_CHECK(out == data);
+        LHA_CHECK(decoder->crc == crc);
+    }
+}
+
+/*
+ * An -lzs- member matching into its initial dictionary right after an
+ * -lh7- member slid the window: it must still find spaces there.  The
+ * packed data is a match of 17 bytes at position 0, then a literal 'A'.
+ */
+LHA_TEST_CASE(decode_context_dirty_window)
+{
+    static const unsigned char lzs[] = { 0x00, 0x0f, 0xa0, 0x80 };
+    std::vector<unsigned char> data, packed, out, expect(17, ' ');
+    unsigned int crc;
+
+    expect.push_back('A');
+    lha_test_data(data, 300000, 30);
+    LHA_CHECK(lha_test_pack(LZHUFF7_METHOD_NUM, LZH_LEVEL_DEFAULT, data, packed, &crc));
+    std::vector<unsigned char> small(lzs, lzs + sizeof(lzs));
+
+    for (int i = 0; i < 2; i++) {
+        LHADecoderContext decoder;
+
+        LHA_CHECK(decode_stream(*decoder, LZHUFF7_METHOD_NUM, packed, out, data.size(), 4096));
+        LHA_CHECK(out == data);
+        LHA_CHECK(decode_stream(*decoder, LARC_METHOD_NUM, small, out, expect.size(), 4096));
+        LHA_CHECK(out == expect);
+        LHA_CHECK(decode_whole(*decoder, LARC_METHOD_NUM, small, out, expect.size()));
+        LHA_CHECK(out == expect);
+    }
+}
+
+/* contexts taken per member on several threads at once */
+LHA_TEST_CASE(decode_context_threads)
+{
+    std::vector<unsigned char> data[3], packed[3];
+    std::vector<std::thread> threads;
+    unsigned int crc[3];
+    int          failed[4] = { 0, 0, 0, 0 };
+
+    for (int m = 0; m < 3; m++) {
+        lha_test_data(data[m], 5000 * (m + 1), (uint32_t)m + 40);
+        LHA_CHECK(lha_test_pack(methods[m], LZH_LEVEL_DEFAULT, data[m], packed[m], &crc[m]));
+    }
+    for (int t = 0; t < 4; t++)
+        threads.push_back(std::thread([&, t]() {
+            std::vector<unsigned char> out;
+
+            for (int i = 0; i < 100; i++) {
+                int m = (i + t) % 3;
+                LHADecoderContext decoder;
+
+                if (!decode_stream(*decoder, methods[m], packed[m], out, data[m].size(), 1000) ||
+                    out != data[m] || decoder->crc != crc[m])
+                    failed[t]++;
+            }
+            LHADecoderContext::trim();
+        }));
+    for (size_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+    for (int t = 0; t < 4; t++)
+        LHA_CHECK(failed[t] == 0);
+}
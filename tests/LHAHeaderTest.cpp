@@ -0,0 +1,252 @@
+// LHAHeaderTest.cpp: parsing headers with LHAPack::parse_header.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+#include "LHATest.h"
+#include "LHAPack.h"
+#include "LHADecode.h"
+#include "LHAArchive.h"
+
+/* one member of `size' bytes, then the end mark */
+static void one_member(std::vector<char> &out, const char *name, size_t size, int level)
+{
+    std::vector<LHATestMember> members(1);
+
+    members[0].name   = name;
+    members[0].method = LZHUFF0_METHOD_NUM;
+    members[0].mtime  = 1000000000;
+    lha_test_data(members[0].data, size, 11);
+    LHA_CHECK(lha_test_archive(out, members, level));
+}
+
+/* parse the first `len' bytes of src from a block of exactly that size */
+static bool parse_prefix(const std::vector<char> &src, size_t len, size_t *dataoffset)
+{
+    std::vector<char> copy(src.begin(), src.begin() + len);
+    LHAHeader hdr;
+
+    return LHAPack::parse_header(copy.data(), copy.data() + len, &hdr, dataoffset);
+}
+
+LHA_TEST_CASE(header_levels)
+{
+    std::vector<char> data;
+    LHAHeader         hdr;
+    size_t            offset;
+
+    for (int level = 0; level <= 2; level++) {
+        one_member(data, "dir/file.txt", 100, level);
+        LHA_CHECK(LHAPack::parse_header(data.data(), data.data() + data.size(), &hdr, &offset));
+        LHA_CHECK(hdr.header_level == level);
+        LHA_CHECK(memcmp(hdr.method, LZHUFF0_METHOD, METHOD_TYPE_STORAGE) == 0);
+        LHA_CHECK(hdr.packed_size == 100 && hdr.original_size == 100);
+        LHA_CHECK(offset + 100 + 1 == data.size());
+        LHA_CHECK(strcmp(hdr.name, "dir\xff" "file.txt") == 0);
+    }
+}
+
+/* every header cut anywhere short of its end fails without reading past it */
+LHA_TEST_CASE(header_truncated)
+{
+    static const char *names[] = {"a", "dir/sub/file.txt", NULL};
+    std::string       longname(600, 'n');
+    std::vector<char> data;
+    size_t            offset, len, k;
+
+    names[2] = longname.c_str();
+    for (int level = 0; level <= 2; level++) {
+        for (int n = 0; n < 3; n++) {
+            if (level == 0 && n == 2)
+                continue;                       /* a level 0 name is at most 255 bytes */
+            one_member(data, names[n], 10, level);
+            LHA_CHECK(parse_prefix(data, data.size(), &offset));
+            len = offset;
+            LHA_CHECK(parse_prefix(data, len, &offset) && offset == len);
+            for (k = 1; k < len; k++)
+                LHA_CHECK(!parse_prefix(data, k, &offset));
+        }
+    }
+}
+
+LHA_TEST_CASE(header_bad_range)
+{
+    std::vector<char> data;
+    LHAHeader         hdr;
+    LHAPack           pack;
+    size_t            offset;
+
+    one_member(data, "file", 10, 2);
+    LHA_CHECK(!LHAPack::parse_header(NULL, data.data() + data.size(), &hdr, &offset));
+    LHA_CHECK(!LHAPack::parse_header(data.data(), NULL, &hdr, &offset));
+    LHA_CHECK(!LHAPack::parse_header(data.data(), data.data(), &hdr, &offset));
+    LHA_CHECK(!LHAPack::parse_header(data.data() + 1, data.data(), &hdr, &offset));
+    LHA_CHECK(!pack.get_header(data.data(), data.data() + 20, &hdr));
+    LHA_CHECK(pack.get_header(data.data(), data.data() + data.size(), &hdr));
+
+    /* a level 2 total header size past the end of the file */
+    data[0] = (char)0xff;
+    data[1] = (char)0xff;
+    LHA_CHECK(!LHAPack::parse_header(data.data(), data.data() + data.size(), &hdr, &offset));
+}
+
+/* damaged headers parse or fail, but stay inside their bytes */
+LHA_TEST_CASE(header_damaged)
+{
+    std::vector<char> data, copy;
+    LHAHeader         hdr;
+    size_t            offset, len;
+    uint32_t          x = 2463534242u;
+
+    for (int level = 0; level <= 2; level++) {
+        one_member(data, "dir/sub/file.txt", 0, level);
+        LHA_CHECK(parse_prefix(data, data.size(), &len));
+        for (int i = 0; i < 2000; i++) {
+            copy.assign(data.begin(), data.begin() + len);
+            for (int j = 0; j < 1 + i % 3; j++) {
+                x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+                copy[x % len] = (char)(x >> 8);
+            }
+            if (LHAPack::parse_header(copy.data(), copy.data() + len, &hdr, &offset))
+                LHA_CHECK(offset <= len);
+        }
+    }
+}
+
+/* the header offsets of an archive, walked with parse_header() */
+static std::vector<size_t> header_offsets(const std::vector<char> &data)
+{
+    std::vector<size_t> offsets;
+    LHAHeader           hdr;
+    size_t              at = 0, dataoffset;
+
+    while (at < data.size() && data[at] != 0 &&
+           LHAPack::parse_header(&data[at], data.data() + data.size(), &hdr, &dataoffset)) {
+        offsets.push_back(at);
+        at += dataoffset + hdr.packed_size;
+    }
+    return offsets;
+}
+
+static bool same_header(const LHAHeader &a, const LHAHeader &b)
+{
+    return a.header_size == b.header_size && a.packed_size == b.packed_size &&
+           a.original_size == b.original_size && a.crc == b.crc &&
+           a.attribute == b.attribute && a.unix_mode == b.unix_mode &&
+           a.unix_last_modified_stamp == b.unix_last_modified_stamp &&
+           memcmp(a.method, b.method, METHOD_TYPE_STORAGE) == 0 &&
+           strcmp(a.name, b.name) == 0;
+}
+
+/* parse_header() keeps no state: threads parsing the same bytes agree */
+LHA_TEST_CASE(header_concurrent)
+{
+    std::vector<LHATestMember> members;
+    std::vector<char>          data;
+    std::vector<size_t>        offsets;
+    std::vector<LHAHeader>     want;
+    std::vector<std::thread>   threads;
+    int                        mismatches[4] = {0, 0, 0, 0};
+
+    lha_test_members(members, 300, 200, 8);
+    for (int level = 0; level <= 2; level++) {
+        LHA_CHECK(lha_test_archive(data, members, level));
+        offsets = header_offsets(data);
+        LHA_CHECK(offsets.size() == members.size());
+        want.resize(offsets.size());
+        for (size_t i = 0; i < offsets.size(); i++) {
+            size_t dataoffset;
+            LHA_CHECK(LHAPack::parse_header(&data[offsets[i]], data.data() + data.size(), &want[i], &dataoffset));
+        }
+
+        for (int t = 0; t < 4; t++) {
+            threads.push_back(std::thread([&, t]() {
+                LHAHeader hdr;
+                size_t    dataoffset;
+
+                for (int round = 0; round < 20; round++) {
+                    for (size_t i = t; i < offsets.size(); i += 1 + (size_t)t) {
+                        if (!LHAPack::parse_header(&data[offsets[i]], data.data() + data.size(), &hdr, &dataoffset) ||
+                            !same_header(hdr, want[i]))
+                            mismatches[t]++;
+                    }
+                }
+            }));
+        }
+        for (size_t t = 0; t < threads.size(); t++)
+            threads[t].join();
+        threads.clear();
+        for (int t = 0; t < 4; t++)
+            LHA_CHECK(mismatches[t] == 0);
+    }
+}
+
+/* the fields a lazy parse leaves out come in with read_extended() */
+LHA_TEST_CASE(header_lazy)
+{
+    std::vector<char> data;
+    LHAHeader         eager, lazy;
+    size_t            eager_offset, lazy_offset;
+
+    for (int level = 0; level <= 2; level++) {
+        one_member(data, "dir/sub/file.txt", 10, level);
+        const char *end = data.data() + data.size();
+
+        LHA_CHECK(LHAPack::parse_header(data.data(), end, &eager, &eager_offset));
+        LHA_CHECK(LHAPack::parse_header(data.data(), end, &lazy, &lazy_offset, LHA_PARSE_LAZY));
+        LHA_CHECK(lazy_offset == eager_offset);
+        LHA_CHECK(strcmp(lazy.name, eager.name) == 0);
+        LHA_CHECK(lazy.unix_last_modified_stamp == eager.unix_last_modified_stamp);
+        LHA_CHECK(lazy.packed_size == eager.packed_size && lazy.original_size == eager.original_size);
+        LHA_CHECK(lazy.crc == eager.crc);
+        LHA_CHECK(!eager.extend_pending);
+        LHA_CHECK(lazy.extend_pending == (level != 0));
+
+        LHA_CHECK(LHAPack::read_extended(data.data(), end, &lazy));
+        LHA_CHECK(!lazy.extend_pending);
+        LHA_CHECK(same_header(lazy, eager));
+        LHA_CHECK(lazy.unix_mode == eager.unix_mode && lazy.header_crc == eager.header_crc);
+        LHA_CHECK(LHAPack::read_extended(data.data(), end, &lazy));    /* nothing left */
+
+        /* the extended headers are checked when they are read */
+        if (level == 0)
+            continue;
+        LHA_CHECK(LHAPack::parse_header(data.data(), end, &lazy, &lazy_offset, LHA_PARSE_LAZY));
+        LHA_CHECK(!LHAPack::read_extended(data.data(), data.data() + lazy.extend_offset + 2, &lazy));
+    }
+}
+
+/*
+ * A changed byte the checksum or header CRC covers, here the time stamp,
+ * parses as it is; LHA_PARSE_STRICT and a strict LHAArchive refuse it.
+ */
+LHA_TEST_CASE(header_strict)
+{
+    std::string       path = lha_test_path("header_strict.lzh");
+    std::vector<char> data;
+    LHAHeader         hdr;
+    size_t            offset;
+
+    for (int level = 0; level <= 2; level++) {
+        one_member(data, "file.txt", 10, level);
+        const char *end = data.data() + data.size();
+
+        LHA_CHECK(LHAPack::parse_header(data.data(), end, &hdr, &offset, LHA_PARSE_STRICT));
+        LHA_CHECK(LHAPack::parse_header(data.data(), end, &hdr, &offset, LHA_PARSE_STRICT | LHA_PARSE_LAZY));
+        data[15] ^= 0x01;
+        LHA_CHECK(LHAPack::parse_header(data.data(), end, &hdr, &offset));
+        LHA_CHECK(!LHAPack::parse_header(data.data(), end, &hdr, &offset, LHA_PARSE_STRICT));
+
+        LHAArchive archive;
+        LHA_CHECK(lha_test_write_file(path, data));
+        LHA_CHECK(archive.open(path.c_str()));
+        LHA_CHECK(archive.begin() != archive.end());
+        archive.set_strict(true);
+        LHA_CHECK(archive.begin() == archive.end());
+        archive.close();
+    }
+    remove(path.c_str());
+}
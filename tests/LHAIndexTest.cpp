@@ -0,0 +1,118 @@
+// LHAIndexTest.cpp: the archive index sidecar, LHAIndex.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+
+#include "LHATest.h"
+#include "LHAArchive.h"
+#include "LHAIndex.h"
+
+static void write_archive(const std::string &path, std::vector<LHATestMember> &members,
+                          size_t count, uint32_t seed)
+{
+    std::vector<char> data;
+
+    lha_test_members(members, count, 500, seed);
+    LHA_CHECK(lha_test_archive(data, members, 2));
+    LHA_CHECK(lha_test_write_file(path, data));
+}
+
+/* a reopened index finds what a listing of the archive finds */
+LHA_TEST_CASE(index_build_open)
+{
+    std::string                path  = lha_test_path("index.lzh");
+    std::string                ipath = lha_test_path("index.lzh.idx");
+    std::vector<LHATestMember> members;
+    LHAArchive                 archive;
+    LHAListing                 listing;
+    LHAIndex                   index;
+
+    write_archive(path, members, 1000, 12);
+    LHA_CHECK(archive.open(path.c_str()));
+    LHA_CHECK(!index.open(ipath.c_str(), archive));     /* not built yet */
+    LHA_CHECK(index.build(ipath.c_str(), archive));
+    LHA_CHECK(index.is_open() && index.size() == members.size());
+    index.close();
+    LHA_CHECK(!index.is_open() && index.find(members[0].name.c_str()) == NULL);
+
+    LHA_CHECK(index.open(ipath.c_str(), archive));
+    LHA_CHECK(listing.read(archive));
+    LHA_CHECK(index.size() == listing.size());
+    for (size_t i = 0; i < listing.size(); i++) {
+        const LHAListEntry *e = index.find(listing.name(i));
+
+        LHA_CHECK(e == &index[i]);
+        LHA_CHECK(memcmp(e, &listing[i], sizeof(LHAListEntry)) == 0);
+        LHA_CHECK(strcmp(index.name(*e), listing.name(i)) == 0);
+
+        LHAArchive::iterator it = archive.at((size_t)e->offset);
+        LHA_CHECK(it != archive.end() && strcmp(it->header->name, index.name(i)) == 0);
+    }
+    LHA_CHECK(index.find("no such member") == NULL);
+    LHA_CHECK(index.find("") == NULL);
+
+    index.close();
+    archive.close();
+    remove(ipath.c_str());
+    remove(path.c_str());
+}
+
+/* an index of another state of the archive, or a damaged one, is refused */
+LHA_TEST_CASE(index_stale)
+{
+    std::string                path  = lha_test_path("index_stale.lzh");
+    std::string                ipath = lha_test_path("index_stale.lzh.idx");
+    std::vector<LHATestMember> members;
+    std::vector<char>          good, bad;
+    LHAArchive                 archive;
+    LHAIndex                   index;
+    static const size_t        fields[] = {
+        0,      /* magic */
+        8,      /* byte order */
+        12,     /* version */
+        16,     /* archive size */
+        24,     /* archive modification time */
+        36,     /* number of hash slots */
+        44      /* sizeof(LHAListEntry) */
+    };
+
+    write_archive(path, members, 50, 13);
+    LHA_CHECK(archive.open(path.c_str()));
+    LHA_CHECK(index.build(ipath.c_str(), archive));
+    index.close();
+    LHA_CHECK(lha_test_read_file(ipath, good));
+
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        bad = good;
+        bad[fields[i]] ^= 0x40;
+        LHA_CHECK(lha_test_write_file(ipath, bad));
+        LHA_CHECK(!index.open(ipath.c_str(), archive));
+        LHA_CHECK(!index.is_open());
+    }
+    bad.assign(good.begin(), good.end() - 1);
+    LHA_CHECK(lha_test_write_file(ipath, bad));
+    LHA_CHECK(!index.open(ipath.c_str(), archive));
+    bad.assign(good.begin(), good.begin() + 20);
+    LHA_CHECK(lha_test_write_file(ipath, bad));
+    LHA_CHECK(!index.open(ipath.c_str(), archive));
+
+    LHA_CHECK(lha_test_write_file(ipath, good));
+    LHA_CHECK(index.open(ipath.c_str(), archive));
+    index.close();
+
+    /* the archive grows a member */
+    archive.close();
+    write_archive(path, members, 51, 13);
+    LHA_CHECK(archive.open(path.c_str()));
+    LHA_CHECK(!index.open(ipath.c_str(), archive));
+    LHA_CHECK(index.build(ipath.c_str(), archive));
+    LHA_CHECK(index.size() == 51);
+
+    index.close();
+    archive.close();
+    LHA_CHECK(!index.open(ipath.c_str(), archive));     /* no archive */
+    remove(ipath.c_str());
+    remove(path.c_str());
+}
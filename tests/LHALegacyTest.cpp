@@ -0,0 +1,732 @@
+// LHALegacyTest.cpp: -lh1-, -lzs- and -lz5- decoding against vectors made
+// by LHa's own encoders, and stored -lh0- / -lhd- members.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <mutex>
+
+#include "LHATest.h"
+#include "LHAPack.h"
+#include "LHAArchive.h"
+#include "LHACrc.h"
+#include "LHADecode.h"
+
+/*
+ * Cases 1-3 decode to the bytes below under every method; case 0 is an
+ * empty member and case 4 is 3000 bytes of text with long repeats.
+ */
+static const unsigned char raw_1[] = {
+    0x74
+};
+
+static const unsigned char raw_2[] = {
+    0x1b, 0x20, 0x20, 0x20, 0x20
+};
+
+static const unsigned char raw_3[] = {
+    0x66, 0x6f, 0x78, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x5b, 0x5c, 0x5d, 0x5e,
+    0x5f, 0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e,
+    0x6f, 0x62, 0x72, 0x6f, 0x77, 0x6e, 0x00, 0x00, 0x00, 0x42, 0x94, 0x62, 0x72, 0x6f, 0x77, 0x6e,
+    0x74, 0x68, 0x65, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e,
+    0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e,
+    0x2f, 0x42, 0x66, 0x6f, 0x78, 0x66, 0x6f, 0x78, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d,
+    0x3e, 0x3f, 0x40, 0x41
+};
+
+static const unsigned char lh1_1[] = {
+    0x00
+};
+
+static const unsigned char lh1_2[] = {
+    0xd3, 0xc6, 0xf3, 0x54
+};
+
+static const unsigned char lh1_3[] = {
+    0xf9, 0x7e, 0xc1, 0x3b, 0xdd, 0xff, 0x07, 0x87, 0xc5, 0xe3, 0xf2, 0x79, 0x7c, 0xde, 0x7f, 0x47,
+    0xa7, 0xd5, 0xeb, 0xf6, 0x7b, 0x7d, 0xde, 0xff, 0x87, 0xc7, 0x17, 0xe7, 0xf4, 0xfa, 0xfd, 0xbe,
+    0xff, 0x8f, 0xcf, 0xeb, 0x12, 0xcb, 0xfd, 0x44, 0x0e, 0x9f, 0x19, 0x45, 0x37, 0x9c, 0x41, 0x36,
+    0x9a, 0x95, 0x1c, 0xd0, 0x0a, 0xda, 0xfc, 0xf6, 0x7f, 0x41, 0xa1, 0xd1, 0x68, 0xf4, 0x9a, 0x5d,
+    0x36, 0x9f, 0x51, 0xa9, 0xd5, 0x6a, 0xf5, 0x9a, 0xdd, 0x76, 0xbf, 0x61, 0xb1, 0xd9, 0x6c, 0xf6,
+    0x9b, 0x5d, 0xb6, 0xdf, 0x71, 0xb9, 0xdd, 0x6e, 0xe7, 0xdd, 0x37, 0x87, 0xb2, 0x01, 0x70, 0xb8,
+    0x7c, 0x4e, 0x2f, 0x1b, 0x8f, 0xc8, 0xe4, 0xf2, 0xb9, 0x7c, 0xce, 0x68
+};
+
+static const unsigned char lh1_4[] = {
+    0x7b, 0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0xc5, 0x7c, 0x7d, 0x7e,
+    0x7f, 0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x8b, 0xf0, 0x78, 0x7c,
+    0x5e, 0x3f, 0x27, 0x97, 0xcd, 0xe7, 0xf4, 0x7a, 0x7d, 0x5e, 0xbf, 0x67, 0xb7, 0xdd, 0xef, 0xf8,
+    0x7c, 0x7e, 0x5f, 0x3f, 0xa7, 0xd7, 0xed, 0xf7, 0xfc, 0x7e, 0x7f, 0x5f, 0xbf, 0xe7, 0xf4, 0x02,
+    0x56, 0x62, 0x2c, 0xbc, 0x70, 0x24, 0x56, 0x86, 0x96, 0xa6, 0xb6, 0xc6, 0xd6, 0xe6, 0xfc, 0x4c,
+    0x3c, 0x2c, 0x1c, 0x0b, 0xfb, 0xeb, 0xdb, 0xcb, 0xbf, 0xa1, 0x13, 0xfb, 0xc9, 0xa2, 0xdf, 0x90,
+    0x01, 0xcb, 0xbe, 0x80, 0x22, 0x58, 0xb0, 0xc6, 0x2b, 0xac, 0x7e, 0xcc, 0xd4, 0xdf, 0xf9, 0x88,
+    0x1c, 0x7a, 0xb5, 0x96, 0xfc, 0x7e, 0xb9, 0x9c, 0xf3, 0x07, 0xd8, 0x94, 0x4e, 0x55, 0x2b, 0xc5,
+    0x62, 0xe3, 0x91, 0xdb, 0xb5, 0xde, 0xf1, 0x79, 0x87, 0xfa, 0x99, 0xbd, 0x0d, 0xcf, 0x9c, 0x01,
+    0x9e, 0xcf, 0xe8, 0x34, 0x3a, 0x2d, 0x1e, 0x93, 0x4b, 0xa6, 0xd3, 0xea, 0x35, 0x3a, 0xad, 0x5e,
+    0xb3, 0x5b, 0xae, 0xd7, 0xec, 0x36, 0x3b, 0x2d, 0x9e, 0xd3, 0x6b, 0xb6, 0xdb, 0xee, 0x16, 0x77,
+    0x5b, 0xb7, 0x42, 0x0b, 0x22, 0xf2, 0x70, 0xfb, 0xca, 0x00, 0x20, 0xe2, 0x23, 0xfa, 0x02, 0x34,
+    0xdf, 0x81, 0x10, 0xe5, 0x35, 0xf6, 0x51, 0xc4, 0xee, 0xf3, 0x0e, 0x87, 0xde, 0xaf, 0x7e, 0x68,
+    0x7f, 0xd2, 0xf3, 0x7a, 0xf0, 0x9b, 0x77, 0x7b, 0xad, 0xc6, 0xdf, 0x6d, 0xb5, 0xda, 0x6c, 0xf6,
+    0x5b, 0x1d, 0x86, 0xbf, 0x5d, 0xad, 0xd6, 0x36, 0x35, 0xb5, 0x46, 0x43, 0xff, 0xbf, 0xe4, 0x8c,
+    0x82, 0x10, 0x00, 0x93, 0x0e, 0x33, 0x00, 0x37, 0x98, 0x5d, 0x09, 0x08, 0xc8, 0x88, 0x48, 0x07,
+    0xc7, 0x87, 0x47, 0x06, 0xc6, 0x86, 0x46, 0x05, 0xc5, 0x85, 0x7b, 0xfb, 0xbb, 0x5a, 0x5a, 0x3e,
+    0x59, 0xd9, 0x99, 0x59, 0x18, 0xd8, 0x98, 0x58, 0x19, 0xcf, 0xc0, 0x07, 0x4e, 0xf0, 0xf8, 0x5b,
+    0x7b, 0xdb, 0x81, 0x03, 0x05, 0xf9, 0x0d, 0x09, 0x05, 0x00, 0xff, 0xb8, 0xf7, 0xc4, 0xf0, 0xed,
+    0xa4, 0xd3, 0x15, 0x0a, 0xc5, 0x82, 0xd1, 0x70, 0xbc, 0x60, 0x31, 0x19, 0x0c, 0xc6, 0x83, 0x51,
+    0xb3, 0xd8, 0xe0, 0x72, 0x3a, 0x1d, 0xdd, 0x53, 0x50, 0xb9, 0xfa, 0x00, 0xe8, 0x14, 0xa3, 0x57,
+    0xa7, 0x0e, 0x8d, 0x3f, 0xa8, 0x53, 0x59, 0x88, 0x1d, 0x92, 0x28, 0x00, 0x77, 0x53, 0x6e, 0xae,
+    0xd4, 0x3c, 0xbd, 0x28, 0xa2, 0x8e, 0x59, 0xc6, 0x39, 0x96, 0xf3, 0xa7, 0xf4, 0xfe, 0x39, 0x3f,
+    0x72, 0x53, 0x63, 0xa7, 0xd9, 0x37, 0xa1, 0x2b, 0x97, 0xe7, 0xb6, 0x79, 0x76, 0xb5, 0x95, 0x9f,
+    0x17, 0x18, 0xa4, 0x20, 0x11, 0xe2, 0x38, 0x97, 0xb0, 0x46, 0x48, 0x29, 0x2e, 0x97, 0x59, 0x3d,
+    0x29, 0x04, 0x84, 0x43, 0x22, 0x11, 0x48, 0xc4, 0x72, 0x41, 0x27, 0xb6, 0xed, 0xdb, 0xdb, 0x83,
+    0x43, 0x3b, 0xbd, 0xc1, 0x31, 0x23, 0x93, 0x8f, 0xef, 0xf3, 0xef, 0xa5, 0xd5, 0x70, 0x96, 0x9e,
+    0x3c, 0x65, 0xbf, 0x3f, 0x0e, 0x34, 0xe6, 0xc9, 0x86, 0x4d, 0xf6, 0xaf, 0xb2, 0xed, 0x8e, 0xf6,
+    0xbe, 0xd0, 0xdb, 0x69, 0x93, 0x71, 0x5f, 0x26, 0x2d, 0xdd, 0x76, 0x0b, 0xab, 0x9f, 0x1c, 0xca,
+    0xdb, 0xc0, 0xe9, 0xd2, 0xaf, 0x7d, 0x67, 0x5c, 0x5c, 0x62, 0xd9, 0xd8, 0xbe, 0xbd, 0x76, 0xaf,
+    0x34, 0xcb, 0x09, 0x20, 0xf5, 0xf5, 0xa5, 0x2a, 0xcb, 0x65, 0x83, 0xa8, 0xb6, 0xe1, 0xb7, 0x4f,
+    0x4e, 0xc5, 0x0a, 0xad, 0x2c, 0xd5, 0x29, 0x6d, 0x2a, 0x7f, 0x6e, 0x16, 0x00, 0x2c, 0x96, 0x69,
+    0xb5, 0xc8, 0xa2, 0xb6, 0xaa, 0x82, 0xc4, 0x71, 0x01, 0x7e, 0x1d, 0x86, 0xe1, 0x98, 0x5e, 0x15,
+    0xd1, 0xf4, 0x58, 0x67, 0xed, 0x88, 0x61, 0xbc, 0xd7, 0x37, 0xce, 0x73, 0xbc, 0xf7, 0x3e, 0x18,
+    0xea, 0x7f, 0x5f, 0xde, 0xf9, 0xbe, 0xff, 0xbe, 0xcf, 0xb6, 0xde, 0xb0, 0x2e, 0x8b, 0x10, 0x5a,
+    0x7f, 0x31, 0xb0, 0xd7, 0xeb, 0xb5, 0xba, 0xcd, 0x5e, 0xab, 0x53, 0xa8, 0xb1, 0xd8, 0xa0, 0x60,
+    0x17, 0xd7, 0x97, 0x57, 0x16, 0xde, 0x9e, 0x5e, 0x17, 0xd7, 0x96, 0xe4, 0x2c, 0x35, 0xad, 0xee,
+    0xf3, 0x77, 0xba, 0xdc, 0xee, 0x14, 0xf6, 0xdb, 0x5d, 0xa6, 0xcf, 0x64, 0xa9, 0xa5, 0xe9, 0x5a,
+    0x4e, 0x91, 0x7f, 0x5f, 0xb7, 0xe5, 0xf7, 0x7d, 0x57, 0x6b, 0x95, 0xba, 0xd5, 0x66, 0xb1, 0x57,
+    0xab, 0x05, 0x60, 0x86, 0x43, 0xef, 0xf1, 0x44, 0xf7, 0xef, 0x4b, 0xa3, 0xd0, 0xbb, 0xdd, 0xae,
+    0xa8, 0xa4, 0x4a, 0x8a, 0x6a, 0x8a, 0x6a, 0x8a, 0x6a, 0x8a, 0x6a, 0x8a, 0x6a, 0x8a, 0x6a, 0x8a,
+    0x77, 0xb7, 0x99, 0x64, 0x69, 0xf9, 0x49, 0xc9, 0xba, 0xd5, 0x20, 0x00, 0x4d, 0xcc, 0x01, 0x33,
+    0xe3, 0x2c, 0xbf, 0x05, 0x85, 0x37, 0x41, 0xc1, 0x40, 0xc0, 0x3f, 0xbf, 0x3e, 0xbe, 0x3d, 0xbd,
+    0x3c, 0xbc, 0x3b, 0xbb, 0x3a, 0xba, 0x77, 0xf7, 0x76, 0xb9, 0xb9, 0x76, 0x38, 0xd7, 0xa3, 0xe5,
+    0x4b, 0xf6, 0x96, 0x24, 0x87, 0xf3, 0xe0, 0x5b, 0xef, 0xbe, 0x6e, 0x5e, 0x4e, 0x3e, 0x2e, 0x1e,
+    0x0d, 0xfd, 0xed, 0xdd, 0xca, 0xfc, 0x02, 0xd8, 0xd7, 0xff, 0xd6, 0x70, 0x4c, 0x4b, 0x4a, 0x49,
+    0x48, 0x47, 0xae, 0x56, 0xcb, 0x17, 0xdf, 0x92, 0x52, 0xac, 0x0d, 0x2c, 0xba, 0xe4, 0x29, 0x26,
+    0x14, 0x00, 0x63, 0x65, 0x1f, 0xf6, 0x5c, 0x39, 0x69, 0xa9, 0x6b, 0xa8, 0xff, 0x40, 0x1e, 0x88,
+    0x09, 0xce, 0xf8, 0x5b, 0x28, 0x20, 0xfd, 0x00, 0x13, 0xcf, 0x9e, 0xa7, 0xb1, 0x9a, 0x8b, 0xcc,
+    0x31, 0xed, 0x77, 0xad, 0x37, 0x53, 0xcc, 0xc5, 0x9f, 0xf9, 0xfc, 0x09, 0x89, 0x08, 0xae, 0xf5,
+    0xfa, 0xdd, 0x5e, 0xa0, 0xbc, 0xfc, 0xf4, 0xec, 0xe4, 0xdc, 0xd6, 0xac, 0xc4, 0xbc, 0xb4, 0xac,
+    0xa4, 0x7d, 0xab, 0x74, 0x8e, 0x44, 0x97, 0x5b, 0xaa, 0x6f, 0x36, 0x99, 0xb1, 0x5d, 0x2b, 0x69,
+    0x12, 0xdd, 0x68, 0xb3, 0x80, 0xc8, 0x5f, 0x31, 0xc7, 0x7b, 0xdd, 0x64, 0xdd, 0xea, 0x8b, 0xf5,
+    0x7a, 0xbd, 0x57, 0x19, 0xa9, 0x61, 0x41, 0x33, 0x62, 0x0c, 0x9e, 0xb7, 0x57, 0xa8, 0x27, 0xce,
+    0xe6, 0xf3, 0x03, 0xe4, 0xb2, 0x49, 0x1f, 0x87, 0x89, 0x20, 0x63, 0xb1, 0x98, 0xac, 0x46, 0x1b,
+    0x09, 0x83, 0xf8, 0x60, 0x43, 0xe1, 0xd0, 0xde, 0x7c, 0x32, 0x6d, 0x4d, 0x98, 0xd1, 0x8f, 0x8d,
+    0x00, 0xc0, 0xa3, 0x2f, 0x61, 0x4d, 0xb7, 0x1a, 0x47, 0x0f, 0x0f, 0x11, 0x97, 0x87, 0xe1, 0xe2,
+    0x1a, 0xf0, 0xfc, 0x3c, 0x4e, 0x1a, 0xf9, 0xa1, 0x9c, 0xcc, 0x65, 0x32, 0x40, 0xe0, 0x50, 0x1d,
+    0x1e, 0x8a, 0x8e, 0x09, 0xb1, 0x12, 0x71, 0x8a, 0x31, 0x8c, 0x9e, 0x1a, 0x8c, 0xf6, 0x34, 0x3d,
+    0x5b, 0x8f, 0xd4, 0xea, 0x7d, 0x6c, 0xf0, 0x78, 0xef, 0xf7, 0xdb, 0xdd, 0xe6, 0xef, 0x75, 0x54,
+    0x4a, 0x5f, 0x22, 0xc8, 0x1c, 0x73, 0x01, 0x03, 0x3c, 0xf3, 0xbd, 0x0e, 0x83, 0x3e, 0x74, 0x73,
+    0x9e, 0xce, 0xe7, 0x33, 0x79, 0xac, 0xce, 0x63, 0x2e, 0x71, 0x96, 0xca, 0xe5, 0x32, 0x65, 0x79,
+    0x22, 0xe9, 0x71, 0x64, 0x5a, 0xd9, 0x7d, 0xe3, 0x81, 0x58, 0xde, 0xed, 0x9e, 0x7f, 0xff, 0x9e,
+    0xce, 0xe7, 0x1b, 0x5b, 0x24, 0x66, 0xa5, 0xf8, 0x39, 0x38, 0xb7, 0xf7, 0xb8, 0x39, 0x3d, 0x77,
+    0xf7, 0xb8, 0x25, 0x65, 0x24, 0xb8, 0x78, 0x32, 0x37, 0xf7, 0xbd, 0x32, 0x25, 0xa0, 0x7a, 0xde,
+    0xf5, 0xf0, 0xf7, 0xbe, 0x85, 0x8f, 0x3d, 0x57, 0xbb, 0x05, 0x4f, 0xf5, 0xdc, 0xae, 0x00, 0xa5,
+    0xac, 0xef, 0xbe, 0x75, 0xfb, 0xf8, 0x1e, 0x8a, 0x99, 0xdb, 0x79, 0x66, 0x67, 0x64, 0xfb, 0xf8,
+    0xd6, 0xf7, 0x1e, 0x48, 0x46, 0x44, 0xf4, 0xf3, 0x8e, 0xc6, 0xe3, 0x31, 0x78, 0xac, 0x4b, 0x04,
+    0x49, 0x09, 0x05, 0x00, 0xfc, 0xf8, 0xf4, 0xf2, 0x38, 0x4c, 0x48, 0x46, 0x36, 0x30, 0x42, 0xf0,
+    0xe6, 0x40, 0xe5, 0xe5, 0x99, 0x81, 0xa9, 0xfe, 0x00, 0x62, 0xae, 0x00, 0xff, 0x3e, 0x6b, 0xeb,
+    0xdd, 0x5a, 0xd2, 0xf2, 0x6e, 0x49, 0x5c, 0x61, 0x4b, 0x19, 0x22, 0x58, 0x80, 0x26, 0xf7, 0xa4,
+    0xbd, 0x85, 0x16, 0xb7, 0x5b, 0x59, 0xd3, 0x98, 0x03, 0x79, 0x34, 0x33, 0x14, 0x8a, 0x0e, 0xa8,
+    0x23, 0xd0, 0x8c, 0x50, 0x7a, 0x2f, 0x18, 0xcf, 0x73, 0x33, 0xa1, 0xd4, 0x97, 0x57, 0x25, 0x1a,
+    0x4b, 0xe6, 0x02, 0x4c, 0xa4, 0x3c, 0x95, 0xca, 0xdf, 0x1f, 0x84, 0x9f, 0x21, 0x91, 0x9b, 0x9c,
+    0x55, 0xc0, 0xc0, 0x02, 0x01, 0x23, 0x88, 0x02, 0x0f, 0x49, 0x71, 0xe3, 0x71, 0x24, 0xf1, 0xe7,
+    0xc7, 0x2c, 0xf5, 0xac, 0x82, 0xf9, 0x67, 0xfd, 0x57, 0xfc, 0x2a, 0x29, 0xf3, 0xf9, 0x2f, 0xc4,
+    0xab, 0x7c, 0x8f, 0x48, 0x25, 0xce, 0x43, 0x5e, 0x0e, 0x34, 0xc6, 0x1c, 0x16, 0x51, 0x5c, 0x74,
+    0x83, 0xe4, 0xcd, 0xe0, 0x70, 0x1c, 0xdf, 0x8b, 0xe2, 0x7c, 0x3f, 0x0a, 0x69, 0xd4, 0xf8, 0x77,
+    0x7b, 0x14, 0xc6, 0xb7, 0x60, 0x9a, 0xc4, 0xa6, 0xd6, 0x2a, 0xcf, 0x0c, 0x8d, 0x5a, 0xab, 0x54,
+    0xa9, 0xd4, 0xaa, 0x36, 0x8b, 0x3d, 0x99, 0xad, 0x6c, 0x1d, 0xff, 0xf1, 0x39, 0xce, 0x55, 0xb3,
+    0xce, 0x3f, 0x65, 0x9f, 0x77, 0xb7, 0x78, 0x89, 0x25, 0xce, 0x74, 0xd6, 0x5d, 0x06, 0x9e, 0x77,
+    0xe6, 0x30, 0x39, 0x4c, 0x9e, 0x2b, 0x33, 0x98, 0x4f, 0xe0, 0x53, 0x29, 0xbd, 0x53, 0xc5, 0xec,
+    0xef, 0xf8, 0xbd, 0x8f, 0x0b, 0xf2, 0xab, 0x8b, 0x72, 0x8e, 0xc4, 0x9a, 0xbe, 0x01, 0x78, 0x25,
+    0x89, 0x5d, 0x8b, 0x43, 0xe5, 0x3a, 0x6f, 0x38, 0x01, 0xa6, 0x62, 0xbf, 0x60, 0x00, 0x53, 0x86,
+    0x18, 0x03, 0xa4, 0x06, 0x72, 0x0a, 0xaa, 0xe6, 0xc6, 0x5c, 0xd3, 0x38, 0x56, 0x75, 0xd6, 0x1b,
+    0xc1, 0x57, 0x4b, 0xac, 0x0b, 0x1f, 0x84, 0x46, 0x00, 0x3f, 0xe9, 0xf2, 0xeb, 0x97, 0x10, 0xec,
+    0x18, 0xf5, 0x68, 0xbd, 0x50, 0x01, 0x6e, 0x3d, 0x62, 0xfa, 0x90, 0x3d, 0x21, 0x32, 0x30, 0x3f,
+    0xe1, 0x6a, 0x4a, 0xea, 0xce, 0xd7, 0x60, 0x0f, 0xd4, 0x14, 0x61, 0x7e, 0x3d, 0x9b, 0x94, 0xa7,
+    0x6c, 0x52, 0x8e, 0x00, 0xbf, 0x81, 0x4b, 0xfc, 0x10, 0x03, 0x44, 0x68, 0x5f, 0xc7, 0x7d, 0xde,
+    0xda, 0x1e, 0x1c, 0x0d, 0x00, 0x5f, 0x75, 0xc1, 0xbb, 0x0a, 0x78, 0x66, 0xb6, 0xaa, 0x6a, 0x1a,
+    0x0a, 0x7a, 0x6c, 0x6a, 0x15, 0xfb, 0xbf, 0x1b, 0x8b, 0xc4, 0xc5, 0x63, 0x17, 0x71, 0xa6, 0xc3,
+    0xe3, 0x74, 0xf7, 0x7b, 0x3d, 0x5e, 0x9b, 0x97, 0x9b, 0xcb, 0xdd, 0x15, 0x21, 0x8b, 0x6c, 0x32,
+    0x64, 0xc1, 0xa3, 0x72, 0xdc, 0xfd, 0xff, 0xff, 0x80, 0x45, 0xee, 0xe1, 0x91, 0x6e, 0xbe, 0x03,
+    0xff, 0x43, 0xf2, 0x9c, 0xe0, 0x8f, 0x18, 0xa5, 0x5d, 0xde, 0xd7, 0x5b, 0x62, 0xf4, 0xe8, 0x73,
+    0xb9, 0xaf, 0x37, 0x8e, 0x18, 0xf1, 0x82, 0xfb, 0x53, 0x85, 0x05, 0x05, 0x05, 0x04, 0xdc, 0xd4,
+    0xcd, 0xbc, 0xc4, 0x7d, 0xa4, 0x7f, 0xab, 0xdc, 0xde, 0x0a, 0xe1, 0x8c, 0x47, 0xf0, 0x98, 0xfc,
+    0x15, 0xdf, 0xaa, 0x55, 0x16, 0xb8, 0xab, 0xb9, 0xf7, 0xfa, 0x02, 0xb3, 0xb2, 0xc5, 0x66, 0x65,
+    0xe2, 0xef, 0x76, 0xba, 0xe1, 0x07, 0x7e, 0xe5, 0x04, 0x05, 0x4b, 0xc1, 0xe2, 0xe0, 0x8e, 0xce,
+    0x1f, 0xac, 0x26, 0x13, 0x09, 0xf1, 0x51, 0xc0, 0xe9, 0xa5, 0xae, 0x7d, 0xfa, 0x1e, 0x4d, 0x78,
+    0x4f, 0x82, 0x82, 0x7f, 0xbf, 0xdd, 0x64, 0xb4, 0x4a, 0x3a, 0x3b, 0xc3, 0x6b, 0x80, 0x1b, 0xed,
+    0xb4, 0x41, 0xb1, 0xb2, 0x00, 0x3e, 0x2b, 0x50, 0x06, 0xd8, 0xd4, 0x3a, 0x12, 0x1d, 0x3f, 0x9a,
+    0x21, 0xdc, 0x17, 0x8f, 0x63, 0x8f, 0x73, 0x7e, 0xc8, 0x23, 0x8b, 0xa7, 0xe7, 0xa9, 0x3d, 0x0d,
+    0x23, 0x58, 0x55, 0xac, 0x00, 0x1e, 0xff, 0x7e, 0x1a, 0xc2, 0x5d, 0xb2, 0x37, 0xfc, 0x15, 0xe8,
+    0x8d, 0x1b, 0x7e, 0x69, 0xd4, 0xda, 0x67, 0xe3, 0xe7, 0xf2, 0x53, 0x40, 0xe1, 0x5c, 0x7e, 0xc2,
+    0xdc, 0x4d, 0x7a, 0xc1, 0xcf, 0xa3, 0x7c, 0x09, 0xa9, 0x41, 0x17, 0x79, 0xfb, 0xd1, 0xdf, 0xa9,
+    0x3b, 0x6b, 0xfe, 0x5c, 0x8a, 0x88, 0x97, 0x6b, 0xad, 0xd2, 0xe7, 0x72, 0xb8, 0xdc, 0x31, 0xf8,
+    0xee, 0xa6, 0xff, 0x7d, 0xbd, 0xde, 0x40, 0x33, 0xc1, 0xb3, 0x30, 0xe3, 0x7e, 0xf8, 0xc6, 0x03,
+    0x21, 0x6e, 0xb6, 0x54, 0xaa, 0x15, 0x88, 0x05, 0xdd, 0xfc, 0x00, 0x2c, 0x40, 0x86, 0x7c, 0x03,
+    0xfd, 0x30, 0x73, 0xb4, 0xf3, 0xed, 0x9d, 0xe1, 0x7c, 0xf6, 0xff, 0x4c, 0xbb, 0x5d, 0x6e, 0x97,
+    0x3b, 0x92, 0xea, 0xf5, 0x4e, 0xef, 0xae, 0x27, 0x26, 0xa6, 0x25, 0xa5, 0x4b, 0xa4, 0xa4, 0x5f,
+    0xb9, 0xaa, 0x17, 0x64, 0x4e, 0x17, 0x95, 0xca, 0xfb, 0x5d, 0x21, 0x9f, 0x0a, 0xd5, 0xbf, 0x51,
+    0xc7, 0x47, 0x35, 0xad, 0x95, 0xa3, 0x45, 0x52, 0x26, 0x00, 0x80, 0xc1, 0xb2, 0x02, 0x01, 0x33,
+    0xc9, 0x61, 0x08, 0xae, 0x14, 0xf5, 0xa0, 0x7b, 0x9a, 0x86, 0x31, 0xea, 0x63, 0x4d, 0x40, 0x10,
+    0x11, 0x44, 0x52, 0x02, 0x00, 0x88, 0xef, 0xfb, 0x4b, 0x6d, 0x19, 0xef, 0x7a, 0x6d, 0x69, 0xdc,
+    0xf2, 0x4e, 0x9c, 0x52, 0xa7, 0x26, 0x94, 0xcb, 0xf0, 0xc1, 0x77, 0xd8, 0xe1, 0x47, 0xf0, 0x1c,
+    0x7b, 0xff, 0x4f, 0x0a, 0x8b, 0x98, 0x69, 0x67, 0xb3, 0x59, 0x6c, 0x92, 0xf9, 0x77, 0x37, 0x98,
+    0x33, 0xcb, 0xe5, 0x72, 0x79, 0x1c, 0x7e, 0x31, 0x8a, 0x42, 0xf0, 0x16, 0x22, 0xbb, 0x0b, 0x65,
+    0xeb, 0x78, 0xda, 0xcd, 0x63, 0x2d, 0x57, 0xab, 0x55, 0x6a, 0x99, 0x5a, 0x9d, 0x4b, 0x77, 0xba,
+    0xdc, 0xee, 0x2d, 0x90, 0xca, 0x89, 0xc6, 0x5c, 0xad, 0xaf, 0x50, 0x1e, 0x9d, 0xe9, 0xbf, 0x63,
+    0xdb, 0xcd, 0x75, 0xd6, 0x40, 0x9f, 0xf8, 0x2a, 0x7b, 0xdf, 0xc8, 0xa7, 0xdd, 0xa0
+};
+
+static const unsigned char lzs_1[] = {
+    0xba, 0x00
+};
+
+static const unsigned char lzs_2[] = {
+    0x8d, 0xa0, 0xb1, 0x00
+};
+
+static const unsigned char lzs_3[] = {
+    0xb3, 0x5b, 0xef, 0x15, 0x2a, 0x9d, 0x52, 0xab, 0x56, 0xab, 0xd6, 0x2b, 0x35, 0xaa, 0xdd, 0x72,
+    0xbb, 0x5e, 0xaf, 0xd8, 0x2c, 0x36, 0x2b, 0x1d, 0x92, 0xcb, 0x66, 0xb3, 0xda, 0x2d, 0x36, 0xab,
+    0x5d, 0xb2, 0xdb, 0x6e, 0xb7, 0xd8, 0xae, 0x56, 0xfb, 0xbd, 0xba, 0x00, 0x02, 0xa1, 0x42, 0xca,
+    0x58, 0xae, 0x56, 0xfb, 0xbd, 0xba, 0xe9, 0x68, 0xb2, 0xc4, 0xa2, 0x71, 0x48, 0xac, 0x5a, 0x2f,
+    0x18, 0x8c, 0xc6, 0xa3, 0x71, 0xc8, 0xec, 0x7a, 0x3f, 0x20, 0x90, 0xc8, 0xa4, 0x72, 0x49, 0x2c,
+    0x9a, 0x4f, 0x28, 0x94, 0xca, 0xa5, 0x72, 0xc9, 0x6c, 0xba, 0x5f, 0x42, 0xb3, 0x5b, 0xef, 0x00,
+    0x82, 0x33, 0x69, 0xbc, 0xe2, 0x73, 0x3a, 0x9d, 0xcf, 0x27, 0xb3, 0xe9, 0xfd, 0x02, 0x82
+};
+
+static const unsigned char lzs_4[] = {
+    0xf7, 0xf9, 0x3c, 0xbe, 0x6f, 0x3f, 0xa3, 0xd3, 0xea, 0xf5, 0xfb, 0x3d, 0xbe, 0xef, 0x7f, 0xc3,
+    0xe3, 0xf2, 0xf9, 0xfd, 0x3e, 0xbf, 0x6f, 0xbf, 0xe3, 0xf3, 0xfa, 0xfd, 0xff, 0x3f, 0xbf, 0xef,
+    0xfd, 0x52, 0xab, 0x56, 0xab, 0xd6, 0x2b, 0x35, 0xaa, 0xdd, 0x72, 0xbb, 0x5e, 0xaf, 0xd8, 0x2c,
+    0x36, 0x2b, 0x1d, 0x92, 0xcb, 0x66, 0xb3, 0xda, 0x2d, 0x36, 0xab, 0x5d, 0xb2, 0xdb, 0x6e, 0xb7,
+    0xdc, 0x2e, 0x37, 0x4b, 0x45, 0x97, 0xdf, 0x66, 0xb7, 0xde, 0x3d, 0xfd, 0xce, 0xef, 0x7b, 0xbf,
+    0xe0, 0xf0, 0xf8, 0xbc, 0x7e, 0x4f, 0x2f, 0x9b, 0xcf, 0xe8, 0xf4, 0xfa, 0xbd, 0x7e, 0xcf, 0x6f,
+    0xbb, 0xdf, 0xf0, 0xf8, 0xfc, 0xbe, 0x7f, 0x4f, 0xa8, 0x01, 0x11, 0x11, 0x9f, 0x3c, 0x15, 0x7c,
+    0x16, 0x66, 0x7e, 0x0e, 0x5e, 0x0f, 0x9e, 0x0e, 0x85, 0x74, 0xb4, 0x59, 0x60, 0x01, 0x38, 0x08,
+    0x3c, 0x76, 0x2b, 0x95, 0xbe, 0xef, 0x6e, 0x2b, 0x33, 0xe5, 0x72, 0xf9, 0x9c, 0xde, 0x77, 0x3f,
+    0xa1, 0xd1, 0xe9, 0x74, 0xfa, 0x9d, 0x5e, 0xb7, 0x5f, 0xb1, 0xd9, 0xed, 0x76, 0xfb, 0x9d, 0xde,
+    0xf7, 0x7f, 0xc1, 0xe1, 0xf1, 0x78, 0xfc, 0x9e, 0x5f, 0x37, 0x9e, 0x89, 0x2d, 0x0c, 0xdf, 0x0d,
+    0x76, 0x89, 0x44, 0xe2, 0x91, 0x58, 0xb4, 0x5e, 0x31, 0x19, 0x8d, 0x46, 0xe3, 0x91, 0xd8, 0xf4,
+    0x7e, 0x41, 0x21, 0x91, 0x48, 0xe4, 0x92, 0x59, 0x34, 0x9e, 0x51, 0x29, 0x95, 0x4a, 0xe5, 0x92,
+    0xd9, 0x74, 0xbe, 0x00, 0x20, 0xa1, 0x6c, 0xb4, 0x58, 0x65, 0x62, 0x17, 0xe2, 0x2b, 0x16, 0x6b,
+    0x7d, 0xe0, 0x49, 0xc6, 0x00, 0x25, 0xa1, 0xef, 0xb0, 0xdc, 0xac, 0x76, 0x8b, 0x4d, 0xda, 0xcb,
+    0xaf, 0xd8, 0x6c, 0x76, 0x5b, 0x3d, 0xa6, 0xd7, 0x6d, 0xb7, 0xdc, 0x6e, 0x77, 0x5b, 0xbd, 0xe6,
+    0xf7, 0x7d, 0xbf, 0xe0, 0x70, 0x78, 0x5c, 0x3e, 0x27, 0x17, 0x8d, 0xc7, 0xe4, 0x72, 0x79, 0x5c,
+    0xbe, 0x65, 0xc6, 0xeb, 0x69, 0xb1, 0xda, 0xec, 0x37, 0x2b, 0x1d, 0xa2, 0xd3, 0x76, 0xb2, 0x8a,
+    0xde, 0x5d, 0x2d, 0x16, 0x5d, 0xd6, 0xef, 0x79, 0xbd, 0xdf, 0x6f, 0xf8, 0x1c, 0x1e, 0x17, 0x0f,
+    0x89, 0xc5, 0xe3, 0x71, 0xf9, 0x1c, 0x9e, 0x57, 0x2f, 0x99, 0xcd, 0xe7, 0x73, 0xfa, 0x1d, 0x1e,
+    0x97, 0x4f, 0xa9, 0xd5, 0xeb, 0x75, 0xf5, 0x23, 0x23, 0xfa, 0x9f, 0x7d, 0x8a, 0xe5, 0x6f, 0xbb,
+    0xdb, 0x86, 0x94, 0xee, 0x96, 0x8b, 0x2c, 0x9a, 0x4f, 0x28, 0x94, 0xca, 0xa5, 0x72, 0xc9, 0x6c,
+    0xba, 0x5f, 0x30, 0x98, 0xcc, 0xa6, 0x73, 0x49, 0xac, 0xda, 0x6f, 0x38, 0x9c, 0xce, 0xa7, 0x73,
+    0xc9, 0xec, 0xfa, 0x7f, 0x40, 0xa0, 0xd0, 0xa8, 0x76, 0xcb, 0x45, 0x87, 0x60, 0x3a, 0x7f, 0x71,
+    0xba, 0xda, 0x6c, 0x76, 0xb9, 0x65, 0xd2, 0xd1, 0x65, 0x6a, 0xa3, 0x1e, 0xb1, 0xd2, 0x0f, 0xb7,
+    0x90, 0x07, 0xdb, 0x2d, 0x16, 0x12, 0x68, 0x39, 0xdf, 0xbe, 0x00, 0x44, 0x60, 0x67, 0x67, 0x66,
+    0xb7, 0xde, 0x3d, 0xf6, 0x2b, 0x95, 0xbe, 0xef, 0x6e, 0xf7, 0xda, 0x2d, 0x36, 0xab, 0x5d, 0xb2,
+    0xdb, 0x6e, 0xb7, 0xdc, 0x2e, 0x37, 0x2b, 0x9d, 0xd2, 0xeb, 0x76, 0xbb, 0xde, 0x2f, 0x37, 0xab,
+    0xdd, 0xf2, 0xfb, 0x7e, 0xbf, 0xe0, 0x30, 0x38, 0x2c, 0x1e, 0x13, 0x0b, 0x49, 0xa5, 0x52, 0xe9,
+    0x94, 0xda, 0x75, 0x3e, 0xa1, 0x51, 0xa9, 0x54, 0xea, 0x95, 0x5a, 0xb5, 0x5e, 0xb1, 0x59, 0xad,
+    0x56, 0xeb, 0x95, 0xda, 0xf5, 0x7e, 0xc1, 0x61, 0x01, 0xa3, 0xb3, 0x5b, 0xef, 0x08, 0xa6, 0x76,
+    0x1b, 0x95, 0x8e, 0xd1, 0x69, 0xbb, 0x59, 0x6c, 0xd6, 0xfb, 0xc3, 0x82, 0x1d, 0x8a, 0xe5, 0x6f,
+    0xbb, 0xdb, 0xad, 0x96, 0x8b, 0x08, 0xf9, 0x8c, 0x00, 0xa4, 0xc2, 0xc3, 0x72, 0xb1, 0xda, 0x2d,
+    0x37, 0x6b, 0x2c, 0x00, 0xa7, 0x43, 0xb5, 0xef, 0xb1, 0x5c, 0xad, 0xf7, 0x7b, 0x77, 0xbe, 0xd9,
+    0x68, 0xb0, 0x8d, 0x29, 0xfb, 0xec, 0x37, 0x2b, 0x1d, 0xa2, 0xd3, 0x76, 0xb2, 0x94, 0x98, 0xd9,
+    0xad, 0xf7, 0x8b, 0x15, 0xca, 0xdf, 0x77, 0xb7, 0x5b, 0x2d, 0x16, 0x1c, 0x29, 0x55, 0x9c, 0x00,
+    0xb3, 0x02, 0xe9, 0x68, 0xb2, 0xdf, 0xcb, 0x4a, 0x4a, 0x00, 0x6c, 0x37, 0x2b, 0x1d, 0xa2, 0xd3,
+    0x76, 0xb2, 0xdc, 0x6e, 0xb6, 0x9b, 0x1d, 0xaf, 0x1f, 0x90, 0xc8, 0xe4, 0xb2, 0x79, 0x4c, 0xae,
+    0x5b, 0x2f, 0x98, 0xcc, 0xe6, 0xb3, 0x79, 0xcc, 0xee, 0x7b, 0x3f, 0xa0, 0xd0, 0xe8, 0xb4, 0x7a,
+    0x4d, 0x2e, 0x9b, 0x4f, 0xa8, 0xd4, 0xea, 0xb5, 0x7a, 0xcb, 0xa5, 0xa2, 0xcb, 0x66, 0xb7, 0xde,
+    0x28, 0xf4, 0x8a, 0x4d, 0x2a, 0x97, 0x4c, 0xa6, 0xd3, 0xa9, 0xe4, 0xb5, 0xf6, 0x1b, 0x15, 0x8e,
+    0xc9, 0x79, 0xbd, 0x5e, 0xef, 0x97, 0xdb, 0xf5, 0xff, 0x01, 0x81, 0xc1, 0x60, 0xf0, 0x98, 0x5c,
+    0x36, 0x1f, 0x11, 0x89, 0xc5, 0x62, 0xf1, 0x98, 0xdc, 0x76, 0x3f, 0x21, 0x91, 0xc9, 0x64, 0xcb,
+    0xc8, 0x53, 0xa8, 0xec, 0x57, 0x2b, 0x7d, 0xde, 0xdd, 0x66, 0xb7, 0xde, 0x36, 0x9b, 0x5d, 0xb6,
+    0xdf, 0x71, 0xb9, 0xdd, 0x6e, 0xf7, 0x9b, 0xdd, 0xf6, 0xff, 0x81, 0xc1, 0xe1, 0x70, 0xf8, 0x9c,
+    0x5e, 0x37, 0x1c, 0x60, 0x63, 0xc2, 0x6f, 0x13, 0xb9, 0x38, 0x4c, 0xad, 0x59, 0xad, 0xf7, 0x8b,
+    0x7e, 0xdf, 0x71, 0xb9, 0x17, 0x3f, 0xe5, 0xf3, 0x39, 0xbc, 0xee, 0x7f, 0x43, 0xa3, 0xd2, 0xe9,
+    0xf5, 0x33, 0x48, 0x22, 0x76, 0x1b, 0x95, 0x8e, 0xd1, 0x69, 0xbb, 0x59, 0x5d, 0x64, 0xf7, 0x9b,
+    0xdd, 0xf6, 0xff, 0x81, 0xc1, 0xe1, 0x70, 0xf8, 0x9c, 0x5e, 0x37, 0x1f, 0x91, 0xc9, 0xe5, 0x72,
+    0xf9, 0x9c, 0xde, 0x77, 0x3f, 0xa1, 0xd1, 0xe9, 0x74, 0xfa, 0x9d, 0x5e, 0xb7, 0x5f, 0xb1, 0xd9,
+    0xbd, 0xba, 0xf1, 0xc0, 0x0f, 0xb0, 0x20, 0x76, 0x2b, 0x95, 0xbe, 0xef, 0x6e, 0xc2, 0x1f, 0xaf,
+    0xa0, 0x31, 0xa4, 0xa9, 0xdc, 0x6e, 0xb6, 0x9b, 0x1d, 0xae, 0x00, 0x82, 0xc1, 0x9b, 0x41, 0x9c,
+    0xe1, 0xfb, 0xce, 0x50, 0x6e, 0x96, 0x8b, 0x2d, 0x39, 0x0c, 0x38, 0x29, 0x23, 0xf5, 0xfb, 0xfe,
+    0x7f, 0x7f, 0xdf, 0xfb, 0x11, 0x64, 0x15, 0x26, 0x95, 0x4b, 0xa6, 0x53, 0x69, 0xd4, 0xfa, 0x85,
+    0x46, 0xa5, 0x53, 0xaa, 0x55, 0x6a, 0xd5, 0x7a, 0xc5, 0x66, 0xb5, 0x5b, 0xae, 0x57, 0x6b, 0xd5,
+    0xfb, 0x05, 0x86, 0xc5, 0x63, 0xb2, 0x59, 0x6c, 0xd1, 0x28, 0x9c, 0x52, 0x2b, 0x16, 0x8b, 0xc6,
+    0x23, 0x31, 0xa8, 0xdc, 0x72, 0x3b, 0x1e, 0x8f, 0xc8, 0x24, 0x32, 0x29, 0x1c, 0x92, 0x4b, 0x26,
+    0x93, 0xca, 0x25, 0x32, 0xa9, 0x5c, 0xb2, 0x5b, 0x2e, 0x97, 0xfb, 0xf1, 0xb8, 0xec, 0x7e, 0x43,
+    0x23, 0x92, 0xc9, 0xe5, 0x32, 0xb9, 0x6c, 0xbe, 0x63, 0x33, 0x9a, 0xcd, 0xe7, 0x33, 0xb9, 0xec,
+    0xfe, 0x83, 0x43, 0xa2, 0xd1, 0xe9, 0x34, 0xba, 0x6d, 0x3e, 0xa3, 0x53, 0xaa, 0x71, 0xf3, 0x10,
+    0x60, 0x80, 0x5b, 0x2d, 0x16, 0x14, 0xb6, 0x1b, 0x8d, 0xca, 0xe7, 0x74, 0xba, 0xdd, 0xae, 0xf7,
+    0x8b, 0xcd, 0xea, 0xf7, 0x7c, 0xbe, 0xdf, 0xaf, 0xf8, 0x0c, 0x0e, 0x0b, 0x07, 0x84, 0xc2, 0xe1,
+    0xb0, 0xf8, 0x8c, 0x4e, 0x2b, 0x17, 0x8c, 0xc6, 0xe3, 0x8b, 0x3c, 0x61, 0x8d, 0xea, 0x70, 0x04,
+    0xe6, 0x07, 0x7b, 0x3f, 0x7f, 0xc3, 0xe3, 0xf2, 0xf9, 0xfd, 0x3e, 0xbf, 0x60, 0x03, 0x7a, 0xce,
+    0x02, 0xe3, 0x75, 0xb4, 0xd8, 0xed, 0x6a, 0x02, 0x76, 0x6b, 0x7d, 0xe3, 0x2d, 0x97, 0xcc, 0x66,
+    0x73, 0x59, 0xbc, 0xe6, 0x77, 0x3d, 0x9f, 0xd0, 0x17, 0xfd, 0x6b, 0x75, 0xda, 0xfd, 0x86, 0xc7,
+    0x65, 0xb3, 0x28, 0x83, 0x13, 0xdf, 0xe2, 0xf1, 0xb8, 0xfc, 0x83, 0x6f, 0x7b, 0x88, 0xf3, 0x10,
+    0x82, 0xa5, 0x86, 0xe5, 0x63, 0x3b, 0xf2, 0xfc, 0xab, 0x0f, 0xab, 0x5f, 0xab, 0xe1, 0x5b, 0x2d,
+    0x16, 0x14, 0x11, 0x3f, 0x7d, 0x86, 0xe4, 0x5c, 0x67, 0x62, 0xb9, 0x1a, 0xa2, 0x5f, 0xf0, 0x18,
+    0x14, 0xd0, 0xbc, 0x7e, 0x43, 0x23, 0x92, 0xc9, 0xe5, 0x32, 0xb9, 0x6c, 0xbe, 0x60, 0xbd, 0xca,
+    0x33, 0x66, 0xb7, 0xde, 0x2e, 0x37, 0x5b, 0x4d, 0x8e, 0xd7, 0x4b, 0x5c, 0x7f, 0x5d, 0x1b, 0xb1,
+    0x5c, 0xad, 0xe4, 0x64, 0x16, 0x1b, 0x95, 0x8e, 0xd0, 0x5c, 0xa2, 0xc3, 0xc7, 0x6c, 0xb4, 0x58,
+    0x4a, 0xc6, 0x20, 0x2c, 0x09, 0xec, 0x1c, 0x17, 0x1b, 0xad, 0xa6, 0xc7, 0x6b, 0xb1, 0x1f, 0x89,
+    0x5b, 0x2d, 0x16, 0x1f, 0x7b, 0x11, 0x0c, 0xb6, 0x5d, 0x2f, 0x98, 0x4c, 0x66, 0x53, 0x39, 0xa4,
+    0xd6, 0x6d, 0x37, 0x9c, 0x4e, 0x67, 0x53, 0xb9, 0xe4, 0xf6, 0x7d, 0x3f, 0xa0, 0x50, 0x68, 0x54,
+    0x3a, 0x25, 0x16, 0x8d, 0x47, 0xa4, 0x52, 0x69, 0x53, 0x1b, 0x35, 0xbe, 0xf1, 0x6c, 0x28, 0xe0,
+    0xaa, 0xb2, 0x77, 0xb2, 0xdf, 0x7b, 0xf4, 0x6c, 0xe3, 0xec, 0xf7, 0xb7, 0x4b, 0x41, 0x37, 0x82,
+    0xe0, 0x05, 0x8a, 0xe4, 0xa5, 0xc3, 0x61, 0xb9, 0x58, 0xc5, 0x78, 0x90, 0xa8, 0x6d, 0x96, 0x8b,
+    0x0f, 0xbe, 0x97, 0x4c, 0xa6, 0xd3, 0xa9, 0xf5, 0x0a, 0x8d, 0x48, 0x97, 0x7e, 0xc8, 0x03, 0xa5,
+    0x71, 0xba, 0xda, 0x6c, 0x76, 0xbb, 0x15, 0xca, 0xde, 0x59, 0x40, 0x6a, 0xe2, 0xfb, 0x06, 0xd2,
+    0xa3, 0xdb, 0xee, 0x77, 0x7b, 0xdd, 0xff, 0x07, 0x87, 0xc5, 0xe3, 0xf2, 0x3f, 0x8f, 0xfd, 0xbe,
+    0xff, 0x88, 0x02, 0x5e, 0x02, 0x70, 0x9d, 0xf9, 0xbf, 0x42, 0x01, 0x2b, 0x75, 0x43, 0xbe, 0x38,
+    0xb9, 0x95, 0xf1, 0x96, 0x68, 0x40, 0x22, 0xb1, 0x68, 0xbc, 0x62, 0x33, 0x1a, 0x8d, 0xc7, 0x23,
+    0xb1, 0xe8, 0xfc, 0x82, 0x43, 0x22, 0x91, 0xc9, 0x24, 0xb2, 0x69, 0x3c, 0xa2, 0x53, 0x2a, 0x95,
+    0xcb, 0x25, 0xb2, 0xe9, 0x7c, 0xc2, 0x63, 0x32, 0x7d, 0x03, 0xb0, 0xdc, 0xac, 0x76, 0x8b, 0x4d,
+    0xda, 0xcb, 0x62, 0xb9, 0x5b, 0xee, 0xf6, 0xe6, 0x92, 0x1b, 0x0b, 0x4f, 0x25, 0xb1, 0xd5, 0x5c,
+    0xb8, 0x56, 0xe9, 0x68, 0xb2, 0xaa, 0xb8, 0xdc, 0x6e, 0xb6, 0x95, 0x8e, 0x0b, 0x15, 0xca, 0xdf,
+    0x77, 0x2a, 0xf0, 0xb8, 0xa8, 0x11, 0x58, 0x45, 0x71, 0x1b, 0x59, 0x9e, 0x20, 0x6c, 0x2b, 0xd8,
+    0x9f, 0x98, 0xc3, 0xcb, 0x5f, 0xbd, 0x93, 0xfd, 0x95, 0x36, 0xe9, 0x68, 0xb2, 0x93, 0x88, 0xbb,
+    0xb9, 0xe4, 0x1f, 0x43, 0xee, 0x37, 0x5b, 0x4d, 0x8e, 0xd7, 0x20, 0x5f, 0x22, 0x80, 0x1f, 0x68,
+    0x04, 0xc8, 0x89, 0x50, 0xbf, 0x78, 0xdf, 0x9f, 0xe3, 0xc0, 0x08, 0x7d, 0x3e, 0xaf, 0x5f, 0xb3,
+    0xdb, 0xee, 0xf7, 0xfc, 0x3e, 0x3f, 0x2f, 0x9f, 0xd3, 0xeb, 0xf6, 0xfb, 0xfe, 0x3f, 0x3f, 0xaf,
+    0xdf, 0xf3, 0xfb, 0xfe, 0xff, 0xdf, 0x6c, 0x37, 0x2b, 0x1d, 0xa0, 0xad, 0x47, 0x42, 0x05, 0x9e,
+    0x06, 0xcf, 0x61, 0x02, 0x64, 0x80, 0x02, 0x70, 0x71, 0xb8, 0xfc, 0x8e, 0x4f, 0x2b, 0x97, 0xcc,
+    0xe6, 0xf3, 0xb9, 0xfd, 0x0e, 0x8f, 0x4b, 0xa7, 0xd4, 0xea, 0xf5, 0xba, 0xfd, 0x8e, 0xcf, 0x6b,
+    0xb7, 0xdc, 0xee, 0xf7, 0xbb, 0xfe, 0x0f, 0x0f, 0x8b, 0xc7, 0x71, 0xba, 0xa8, 0x40, 0xdd, 0x2d,
+    0x16, 0x52, 0xc3, 0x15, 0x06, 0x37, 0x46, 0x30, 0x7f, 0x3c, 0x25, 0xd2, 0xd1, 0x65, 0xb1, 0x5c,
+    0xad, 0xf7, 0x7b, 0x71, 0x54, 0x09, 0x6f, 0x0b, 0x7f, 0x9e, 0xab, 0x57, 0xac, 0xd6, 0xeb, 0xb5,
+    0xfb, 0x0d, 0x8e, 0xcb, 0x67, 0xb4, 0xda, 0xed, 0xb6, 0xfb, 0x83, 0x5f, 0xd5, 0x0b, 0x1d, 0x06,
+    0x87, 0x44, 0xa3, 0x7f, 0xb4, 0xda, 0xed, 0xb6, 0xfb, 0x8d, 0xce, 0xeb, 0x77, 0xbc, 0xde, 0x84,
+    0x90, 0xb2, 0x58, 0xf2, 0xb9, 0x7c, 0xce, 0x6f, 0x3b, 0x9f, 0xd0, 0xe8, 0xf4, 0xba, 0x7d, 0x4e,
+    0xaf, 0x5b, 0xaf, 0xd8, 0xec, 0xf6, 0xbb, 0x7d, 0xce, 0xef, 0x7b, 0xbf, 0xe0, 0xf0, 0xf8, 0xbc,
+    0x7e, 0x4f, 0x2f, 0x9b, 0xcf, 0x7a, 0xc8, 0xe4, 0xb2, 0x79, 0x4c, 0xae, 0x5b, 0x2e, 0x93, 0xdf,
+    0xa9, 0x0c, 0x83, 0xba, 0x5a, 0x2c, 0xbc, 0xad, 0x0e, 0x8b, 0x47, 0xa4, 0xd2, 0xa5, 0x61, 0xea,
+    0xf5, 0x9a, 0xd5, 0x26, 0x4d, 0xa6, 0xd7, 0x6d, 0xb7, 0xdc, 0x6e, 0x77, 0x5b, 0xbd, 0xe6, 0xf7,
+    0x7d, 0x11, 0x14, 0x1f, 0x14, 0xba, 0xb0, 0xdc, 0xac, 0x60, 0x50, 0x5c, 0xc1, 0x66, 0xca, 0xf0,
+    0xba, 0xf8, 0xbe, 0x78, 0xc8, 0x15, 0x88, 0x21, 0x4b, 0xdf, 0xd1, 0xcb, 0x61, 0x6e, 0x20, 0xe0,
+    0x56, 0x20, 0x85, 0x26, 0xfd, 0x08, 0x07, 0xbf, 0xde, 0x11, 0xa7, 0x71, 0xba, 0xda, 0x6c, 0x76,
+    0xb2, 0x85, 0x17, 0x0c, 0x07, 0xef, 0x1f, 0x7d, 0x14, 0x71, 0xfc, 0x74, 0x46, 0xcc, 0x03, 0x6f,
+    0x74, 0xb4, 0x59, 0x76, 0x1b, 0x1d, 0x96, 0xcf, 0x68, 0x6b, 0x7f, 0xc6, 0x36, 0xd5, 0xb3, 0x5b,
+    0xef, 0x16, 0xc0, 0x78, 0x5f, 0x7d, 0xb0, 0xa3, 0x82, 0xcd, 0x6f, 0xbc, 0x16, 0x39, 0xf2, 0xd3,
+    0x88, 0x9c, 0xf9, 0xae, 0x83, 0xce, 0x11, 0xd8, 0xf4, 0x7e, 0x41, 0x21, 0x91, 0x39, 0x57, 0x4c,
+    0xe6, 0x93, 0x59, 0xb4, 0xde, 0x71, 0x39, 0x9d, 0x5a, 0x89, 0x33, 0xc9, 0x5b, 0xc9, 0xb0, 0x3d,
+    0xd7, 0x12, 0xe9, 0x2e, 0xb0, 0xdf, 0x1d, 0x88, 0x20, 0x0b, 0x93, 0x66, 0x64, 0x93, 0x3b, 0x73,
+    0xc2, 0xa6, 0xa3, 0xe3, 0xf2, 0x02, 0x03, 0xfa, 0x29, 0x00, 0x4c, 0x16, 0xc1, 0xdc, 0x52, 0xe9,
+    0x75, 0xbb, 0x5d, 0xef, 0x17, 0x9b, 0xd5, 0xee, 0xf9, 0x7d, 0xbf, 0x5f, 0xf0, 0x18, 0x1c, 0x16,
+    0x0f, 0x09, 0x85, 0xc3, 0x61, 0xf1, 0x18, 0x94, 0xd8, 0x3c, 0x7e, 0x43, 0x22, 0xe0, 0xc1, 0x00,
+    0xec, 0xad, 0xf8, 0xdb, 0x16, 0x24, 0x0b, 0x74, 0x46, 0x94, 0xcb, 0x8c, 0xec, 0x37, 0x25, 0x5c,
+    0x38, 0x03, 0x01, 0x05, 0x86, 0xe5, 0x63, 0xb4, 0x5a, 0x6e, 0xd6, 0x58, 0x01, 0x7f, 0x00, 0x3a,
+    0x09, 0x80, 0x8d, 0xc5, 0x54, 0x08, 0xba, 0x0d, 0xc4, 0x45, 0x11, 0x83, 0xdf, 0x6c, 0x62, 0x70,
+    0x6f, 0xd0, 0x80, 0x5c, 0x6e, 0xa0, 0xe2, 0x3e, 0xfb, 0x0d, 0xc8, 0xbb, 0xce, 0xe3, 0x75, 0xb4,
+    0xb6, 0x60, 0x68, 0x51, 0x04, 0xfd, 0xf7, 0x4b, 0x45, 0x96, 0xcd, 0x6f, 0xbc, 0x32, 0x58, 0xdd,
+    0x04, 0x80, 0x2c, 0x57, 0x2b, 0x7d, 0xde, 0xdc, 0xbe, 0xe3, 0xf1, 0xf9, 0x7c, 0xfe, 0x9f, 0x5f,
+    0xb7, 0xdf, 0xf1, 0xf9, 0xfd, 0x7e, 0xff, 0x9f, 0xdf, 0xf7, 0xff, 0x4d, 0x62, 0xb9, 0x1a, 0x20,
+    0xfb, 0xe4, 0xc6, 0xc0, 0x1d, 0x6e, 0xbf, 0x63, 0xb3, 0xda, 0xed, 0xf7, 0x3b, 0xbd, 0xee, 0xff,
+    0x83, 0xc3, 0xe2, 0xf1, 0xf9, 0x3c, 0xbe, 0x6f, 0x3f, 0xa3, 0xd3, 0xea, 0xf5, 0xfb, 0x3d, 0xbe,
+    0xef, 0x7f, 0xc3, 0xe3, 0xf2, 0xf9, 0xd8, 0x6e, 0x56, 0x33, 0x26, 0x2b, 0xa9, 0xc0, 0xac, 0x17,
+    0x11, 0x71, 0xba, 0xda, 0x6c, 0x76, 0xb8, 0x3c, 0x97, 0xde, 0xf0, 0x67, 0xef, 0x4e, 0x61, 0xb9,
+    0x5c, 0xee, 0x97, 0x50
+};
+
+static const unsigned char lz5_1[] = {
+    0x01, 0x74
+};
+
+static const unsigned char lz5_2[] = {
+    0x01, 0x1b, 0xc2, 0xf1
+};
+
+static const unsigned char lz5_3[] = {
+    0xff, 0x66, 0x6f, 0x78, 0x52, 0x53, 0x54, 0x55, 0x56, 0xff, 0x57, 0x58, 0x59, 0x5a, 0x5b, 0x5c,
+    0x5d, 0x5e, 0xff, 0x5f, 0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0xff, 0x67, 0x68, 0x69, 0x6a,
+    0x6b, 0x6c, 0x6d, 0x6e, 0xbf, 0x6f, 0x62, 0x72, 0x6f, 0x77, 0x6e, 0x02, 0xf0, 0x42, 0xff, 0x94,
+    0x62, 0x72, 0x6f, 0x77, 0x6e, 0x74, 0x68, 0xff, 0x65, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18,
+    0xdf, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0xdf, 0x42, 0x66, 0xfb, 0x6f, 0x78, 0x40, 0x00, 0x36,
+    0x37, 0x38, 0x39, 0x3a, 0x7f, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f, 0x40, 0x41
+};
+
+static const unsigned char lz5_4[] = {
+    0xff, 0xef, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xff, 0xeb, 0xec, 0xed, 0xee, 0xef, 0xf0,
+    0xf1, 0xf2, 0xff, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xff, 0xfb, 0xfc, 0xfd, 0xfe,
+    0xff, 0x54, 0x55, 0x56, 0xff, 0x57, 0x58, 0x59, 0x5a, 0x5b, 0x5c, 0x5d, 0x5e, 0xff, 0x5f, 0x60,
+    0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0xff, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0xff,
+    0x6f, 0x70, 0x71, 0x74, 0x68, 0x65, 0xef, 0x66, 0xff, 0x6f, 0x78, 0xef, 0xdc, 0xdd, 0xde, 0xdf,
+    0xe0, 0xff, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0x93, 0xe9, 0xea, 0xf6, 0xfc, 0x8e,
+    0xf2, 0xcf, 0x54, 0x0f, 0x5f, 0x07, 0x3f, 0xfc, 0x71, 0x0f, 0x83, 0x0f, 0x3f, 0x3f, 0x74, 0x68,
+    0x65, 0x00, 0xfb, 0x00, 0x00, 0x82, 0xf2, 0x62, 0x72, 0x6f, 0x77, 0x6e, 0xfe, 0xa0, 0x00, 0x20,
+    0x20, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xff, 0xcf, 0xd0, 0xd1, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xff,
+    0xd7, 0xd8, 0xd9, 0xda, 0xdb, 0xdc, 0xdd, 0xde, 0xff, 0xdf, 0xe0, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5,
+    0xe6, 0xa3, 0xe7, 0x44, 0x51, 0x22, 0xcf, 0x0f, 0xdb, 0x00, 0x12, 0x13, 0xdf, 0x25, 0xff, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0xff, 0x2e, 0x2f, 0x00, 0x00, 0x00, 0x6c, 0x68, 0x61,
+    0x39, 0x2b, 0x0a, 0x1f, 0x15, 0x16, 0x66, 0x6f, 0x78, 0x26, 0x10, 0x21, 0xf0, 0xff, 0xef, 0x61,
+    0x72, 0x63, 0x68, 0x69, 0x76, 0x65, 0xff, 0xaf, 0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xff,
+    0xb7, 0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd, 0xbe, 0xff, 0xbf, 0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xff, 0xc7, 0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0x71, 0x75, 0xff, 0x69, 0x63, 0x6b, 0x61, 0x72,
+    0x63, 0x68, 0x69, 0xfb, 0x76, 0x65, 0x5a, 0x1b, 0x74, 0x68, 0x65, 0xba, 0xbb, 0xff, 0xbc, 0xbd,
+    0xbe, 0xbf, 0xc0, 0xc1, 0xc2, 0xc3, 0xff, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xcb, 0xff,
+    0xcc, 0xcd, 0xce, 0xcf, 0xd0, 0xd1, 0xd2, 0xd3, 0xdf, 0xd4, 0xd5, 0xd6, 0xd7, 0xa9, 0x90, 0x1f,
+    0xef, 0x62, 0xef, 0x72, 0x6f, 0x77, 0x6e, 0xa4, 0x12, 0x74, 0x68, 0x65, 0xff, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0xff, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0xff, 0x36,
+    0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0xff, 0x3e, 0x3f, 0x40, 0x41, 0x42, 0x43, 0x6c, 0x68,
+    0xfb, 0x61, 0xb0, 0xd2, 0x1e, 0x71, 0x75, 0x69, 0x63, 0x6b, 0x4f, 0x2c, 0x74, 0x68, 0x65, 0xbd,
+    0xf2, 0xea, 0x10, 0xa4, 0xf5, 0x1f, 0x6e, 0x00, 0x2d, 0x6c, 0x68, 0x61, 0xbe, 0xf2, 0x3b, 0xef,
+    0x70, 0xf0, 0xde, 0x1b, 0x22, 0x66, 0x6f, 0x78, 0xef, 0xa9, 0x12, 0xef, 0x68, 0xff, 0x69, 0x6a,
+    0x6b, 0x6c, 0x6d, 0x6e, 0x6f, 0x70, 0xff, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0xff,
+    0x79, 0x7a, 0x7b, 0x7c, 0x7d, 0x7e, 0x7f, 0x80, 0xff, 0x81, 0x82, 0x83, 0x84, 0x85, 0x49, 0x4a,
+    0x4b, 0xff, 0x4c, 0x4d, 0x4e, 0x4f, 0x50, 0x51, 0x52, 0x53, 0xff, 0x54, 0x55, 0x56, 0x57, 0x58,
+    0x59, 0x5a, 0x5b, 0xbd, 0x5c, 0x5d, 0xd7, 0x66, 0x6f, 0x78, 0x20, 0x9a, 0xf1, 0x61, 0xbf, 0x72,
+    0x63, 0x68, 0x69, 0x76, 0x65, 0x2a, 0x20, 0x20, 0xfe, 0xd2, 0xf1, 0x62, 0x72, 0x6f, 0x77, 0x6e,
+    0x6c, 0x68, 0xef, 0x61, 0x74, 0x68, 0x65, 0x02, 0xf0, 0x61, 0x72, 0x63, 0xff, 0x68, 0x69, 0x76,
+    0x65, 0x00, 0x00, 0x00, 0xda, 0xff, 0xef, 0x62, 0x72, 0x6f, 0x77, 0x6e, 0xef, 0x6c, 0xff, 0x68,
+    0x61, 0x62, 0x72, 0x6f, 0x77, 0x6e, 0xef, 0x7f, 0x61, 0x72, 0x63, 0x68, 0x69, 0x76, 0x65, 0x44,
+    0xf0, 0xfe, 0x2d, 0x00, 0x62, 0x72, 0x6f, 0x77, 0x6e, 0x6c, 0x68, 0xff, 0x61, 0x85, 0x62, 0x72,
+    0x6f, 0x77, 0x6e, 0x00, 0xbf, 0x00, 0x00, 0x74, 0x68, 0x65, 0x7f, 0xd1, 0x28, 0x66, 0xff, 0x6f,
+    0x78, 0x61, 0x72, 0x63, 0x68, 0x69, 0x76, 0xff, 0x65, 0x71, 0x75, 0x69, 0x63, 0x6b, 0x8f, 0x90,
+    0xff, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0xff, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e,
+    0x9f, 0xa0, 0xff, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xef, 0xa9, 0xaa, 0xab, 0xac,
+    0x98, 0x00, 0x66, 0x6f, 0x78, 0xff, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0xfb, 0x4f,
+    0x50, 0x5a, 0x2f, 0x63, 0x64, 0x79, 0x7a, 0x7b, 0xff, 0x7c, 0x7d, 0x7e, 0x7f, 0x80, 0x81, 0x82,
+    0x83, 0xff, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x8b, 0xff, 0x8c, 0x8d, 0x8e, 0x8f, 0x90,
+    0x91, 0x92, 0x93, 0xef, 0x94, 0x95, 0x96, 0x20, 0x81, 0xf1, 0x62, 0x72, 0x6f, 0xff, 0x77, 0x6e,
+    0x66, 0x6f, 0x78, 0xb4, 0xb5, 0xb6, 0xff, 0xb7, 0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd, 0xbe, 0xff,
+    0xbf, 0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xff, 0xc7, 0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd,
+    0xce, 0x77, 0xcf, 0xd0, 0xd1, 0x70, 0xb7, 0xe1, 0xe1, 0xb9, 0x83, 0x3b, 0xff, 0x5a, 0x66, 0x6f,
+    0x78, 0x6f, 0xb7, 0xb8, 0xb9, 0xff, 0xba, 0xbb, 0xbc, 0xbd, 0xbe, 0xbf, 0xc0, 0xc1, 0xf7, 0xc2,
+    0xc3, 0xc4, 0x6a, 0x3a, 0xd2, 0xd3, 0xd4, 0x9a, 0xfe, 0xc3, 0xf2, 0x61, 0x72, 0x63, 0x68, 0x69,
+    0x76, 0x65, 0x9e, 0xb4, 0xf2, 0xbc, 0xbd, 0xbe, 0xbf, 0x65, 0x3f, 0xb5, 0x05, 0x7b, 0xf9, 0x20,
+    0xa5, 0xf1, 0x14, 0xf0, 0x03, 0x62, 0x72, 0x6f, 0x77, 0xb9, 0x6e, 0xbe, 0x60, 0xf4, 0x3f, 0x84,
+    0x84, 0x20, 0x98, 0xf1, 0x71, 0x8f, 0x75, 0x69, 0x63, 0x6b, 0x47, 0xf0, 0xe5, 0x74, 0x18, 0x45,
+    0xc3, 0xff, 0xef, 0x66, 0x6f, 0x78, 0x74, 0x68, 0x65, 0x4e, 0xbe, 0x2f, 0x4d, 0x62, 0x72, 0x6f,
+    0x77, 0x6e, 0x86, 0xf2, 0xfa, 0xff, 0xfb, 0xfc, 0xfd, 0xfe, 0xff, 0x62, 0x72, 0x6f, 0xef, 0x77,
+    0x6e, 0x49, 0x4a, 0x4b, 0xdf, 0x5d, 0x5e, 0x5f, 0xff, 0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66,
+    0x12, 0xfb, 0x13, 0x14, 0xe9, 0x0f, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0xff, 0x2c, 0x2d, 0x2e, 0x2f,
+    0xef, 0x8d, 0x8e, 0x8f, 0xff, 0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0xff, 0x98, 0x99,
+    0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f, 0xff, 0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0x77,
+    0xa8, 0xa9, 0xaa, 0xe6, 0x35, 0x6c, 0x68, 0x61, 0x28, 0xf0, 0xf7, 0x71, 0x72, 0x73, 0x40, 0x2f,
+    0x86, 0x87, 0x88, 0x89, 0xff, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x74, 0x68, 0x65, 0xf1, 0x0c, 0x8b,
+    0xf2, 0x05, 0xf0, 0x45, 0x42, 0xef, 0xf0, 0xf1, 0xf2, 0x7f, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0x05, 0x03, 0x7f, 0x59, 0x80, 0x71, 0x75, 0x69, 0x63, 0x6b, 0x00, 0x52, 0xff, 0x66, 0x6f,
+    0x78, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xff, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f, 0xa0, 0xa1, 0xa2, 0xff,
+    0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xff, 0xab, 0xac, 0xad, 0xae, 0xaf, 0xb0, 0xb1,
+    0xb2, 0xff, 0xb3, 0x62, 0x72, 0x6f, 0x77, 0x6e, 0xb4, 0xb5, 0xf7, 0xb6, 0xb7, 0xb8, 0xb9, 0xdf,
+    0xcb, 0xcc, 0xcd, 0xce, 0xff, 0xcf, 0xd0, 0xd1, 0x71, 0x75, 0x69, 0x63, 0x6b, 0xff, 0x00, 0x00,
+    0x00, 0x6c, 0x68, 0x61, 0x61, 0x72, 0x3f, 0x63, 0x68, 0x69, 0x76, 0x65, 0xf9, 0x60, 0x5f, 0x6b,
+    0x5f, 0xff, 0xf9, 0xf9, 0x6c, 0x68, 0x61, 0x71, 0x75, 0x69, 0xbf, 0x63, 0x6b, 0xef, 0x61, 0x72,
+    0x63, 0x6b, 0x11, 0x62, 0xfe, 0xf0, 0x31, 0x66, 0x6f, 0x78, 0x7f, 0x80, 0x81, 0x82, 0xff, 0x83,
+    0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0xff, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f, 0x90, 0x91, 0x92,
+    0xff, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xb7, 0x9b, 0x9c, 0x19, 0x93, 0x30, 0x71,
+    0x75, 0x8c, 0x50, 0x4b, 0xf8, 0xc6, 0x5f, 0xd5, 0x59, 0xbd, 0x22, 0x61, 0x72, 0x63, 0x68, 0x69,
+    0xf7, 0x76, 0x65, 0x20, 0x0b, 0x41, 0x6c, 0x68, 0x61, 0x61, 0xbf, 0x72, 0x63, 0x68, 0x69, 0x76,
+    0x65, 0x36, 0xf0, 0x01, 0xee, 0x03, 0x6f, 0x01, 0x71, 0x75, 0xe9, 0x20, 0x62, 0x72, 0x6f, 0xbf,
+    0x77, 0x6e, 0x6c, 0x68, 0x61, 0xef, 0xa7, 0x20, 0x2d, 0xff, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33,
+    0x34, 0x35, 0xff, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0xff, 0x3e, 0x3f, 0x40, 0x41,
+    0x42, 0x43, 0x44, 0x45, 0xff, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x31, 0x66, 0x6f, 0x9f, 0x78, 0x6c,
+    0x68, 0x61, 0x55, 0x4d, 0x6f, 0x58, 0x6c, 0xef, 0xb9, 0xa3, 0x70, 0x6f, 0x7b, 0x6b, 0x74, 0x68,
+    0x65, 0x93, 0x30, 0x62, 0x7f, 0x72, 0x6f, 0x77, 0x6e, 0x61, 0x72, 0x63, 0xed, 0x51, 0xff, 0x66,
+    0x6f, 0x78, 0x6c, 0x68, 0x61, 0xef, 0x4b, 0xff, 0x4c, 0x4d, 0x4e, 0x4f, 0x50, 0x51, 0x52, 0x53,
+    0xff, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x5b, 0xff, 0x5c, 0x5d, 0x5e, 0x5f, 0x60, 0x61,
+    0x62, 0x63, 0xff, 0x64, 0x65, 0x66, 0x67, 0x68, 0x71, 0x75, 0x69, 0xff, 0x63, 0x6b, 0x62, 0x72,
+    0x6f, 0x77, 0x6e, 0x66, 0xf3, 0x6f, 0x78, 0x96, 0xf2, 0xd2, 0x60, 0xdb, 0xdc, 0xdd, 0xde, 0xff,
+    0xdf, 0xe0, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xff, 0xe7, 0xe8, 0xe9, 0xea, 0xeb, 0xec, 0xed,
+    0xee, 0xff, 0xef, 0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xab, 0xf7, 0xf8, 0x7d, 0xf5, 0x7e,
+    0x1a, 0xf0, 0x2b, 0xa8, 0xf2, 0x7c, 0xfc, 0x9e, 0x07, 0x31, 0xf0, 0x15, 0x16, 0x17, 0x18, 0x19,
+    0x1a, 0xbf, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0xf5, 0x0c, 0x30, 0xfb, 0x31, 0x32, 0x4c, 0x32,
+    0x61, 0x72, 0x63, 0x68, 0x69, 0xff, 0x76, 0x65, 0x62, 0x72, 0x6f, 0x77, 0x6e, 0x74, 0xab, 0x68,
+    0x65, 0x95, 0x24, 0x6c, 0x54, 0x76, 0x61, 0x62, 0x13, 0x74, 0xff, 0x68, 0x65, 0x6c, 0x68, 0x61,
+    0x71, 0x75, 0x69, 0xff, 0x63, 0x6b, 0x62, 0x72, 0x6f, 0x77, 0x6e, 0xef, 0x73, 0x71, 0x75, 0x57,
+    0x17, 0x1b, 0x22, 0x66, 0x6f, 0x78, 0x87, 0x70, 0xff, 0x61, 0x72, 0x63, 0x68, 0x69, 0x76, 0x65,
+    0xf9, 0xcd, 0x18, 0x95, 0x7a, 0xef, 0x55, 0xa4, 0x7f, 0xaf, 0x7a, 0x74, 0x68, 0xff, 0x65, 0x66,
+    0x6f, 0x78, 0x71, 0x75, 0x69, 0x63, 0xfb, 0x6b, 0x90, 0xcf, 0x7e, 0x71, 0x75, 0x69, 0x63, 0x6b,
+    0xfc, 0xaf, 0xf2, 0x7a, 0xf0, 0x74, 0x68, 0x65, 0x66, 0x6f, 0x78, 0xfa, 0xee, 0x70, 0x7e, 0xf7,
+    0x7f, 0x7e, 0x7e, 0xe9, 0xea, 0xeb, 0xfe, 0xec, 0xdf, 0xfe, 0xff, 0x7d, 0x61, 0x72, 0x63, 0x68,
+    0xcf, 0x69, 0x76, 0x65, 0xa1, 0x2b, 0x8f, 0x36, 0x85, 0x61, 0x72, 0xfe, 0x60, 0x72, 0x00, 0x00,
+    0x00, 0xc6, 0xc7, 0xc8, 0xc9, 0xef, 0xca, 0xcb, 0xcc, 0xcd, 0x86, 0x17, 0xd8, 0xd9, 0xda, 0x9f,
+    0xdb, 0xdc, 0xdd, 0xde, 0xdf, 0xc3, 0x01, 0x76, 0x72, 0x74, 0xff, 0x68, 0x65, 0x6c, 0x68, 0x61,
+    0x71, 0x75, 0x69, 0xe7, 0x63, 0x6b, 0x62, 0xbe, 0x21, 0x1c, 0x62, 0x84, 0x74, 0x68, 0xff, 0x65,
+    0x62, 0x72, 0x6f, 0x77, 0x6e, 0x6c, 0x68, 0xf7, 0x61, 0x66, 0x6f, 0xd4, 0x63, 0xaa, 0xab, 0xac,
+    0xad, 0xff, 0xae, 0xaf, 0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xbf, 0xb6, 0xb7, 0xb8, 0xb9, 0xba,
+    0xbb, 0x44, 0x19, 0x66, 0xff, 0x6f, 0x78, 0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xff, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xff, 0xae, 0xaf, 0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xff,
+    0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd, 0xf7, 0x6c, 0x68, 0x61, 0xdb, 0x80, 0xca, 0xcb,
+    0xcc, 0xcd, 0xbf, 0xce, 0xcf, 0xd0, 0xd1, 0xd2, 0xd3, 0xb7, 0x0f, 0xe6, 0xdf, 0xe7, 0x7a, 0x91,
+    0x92, 0x93, 0x49, 0x30, 0x97, 0x98, 0xdd, 0x99, 0xf7, 0x2f, 0xac, 0xad, 0xae, 0xdc, 0x40, 0xca,
+    0xa1, 0xff, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xff, 0xaa, 0xab, 0xac, 0xad, 0xae,
+    0xaf, 0xb0, 0xb1, 0xff, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xcb, 0xba, 0xbb, 0xbc,
+    0xd0, 0x11, 0x40, 0x9f, 0x4b, 0x98, 0x61, 0x72, 0xbf, 0x63, 0x68, 0x69, 0x76, 0x65, 0xcc, 0x65,
+    0x9b, 0x5e, 0xfc, 0x74, 0x9f, 0x7f, 0x9f, 0x5e, 0x5e, 0x62, 0x72, 0x6f, 0x77, 0xff, 0x6e, 0xef,
+    0xd1, 0x96, 0x85, 0x71, 0x75, 0x69, 0x7f, 0x63, 0x6b, 0x62, 0x72, 0x6f, 0x77, 0x6e, 0x4d, 0xf0,
+    0x7f, 0xef, 0xef, 0x62, 0x72, 0x6f, 0x77, 0x6e, 0x6b, 0x72, 0xbe, 0x99, 0xf2, 0x74, 0x68, 0x65,
+    0xef, 0x45, 0xc6, 0x9f, 0x45, 0xff, 0x45, 0x66, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xff, 0xfd,
+    0xfe, 0xff, 0x74, 0x68, 0x65, 0xb0, 0xb1, 0xdf, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xdf, 0xc9,
+    0xca, 0xff, 0xcb, 0xcc, 0xcd, 0x66, 0x6f, 0x78, 0x6c, 0x68, 0xff, 0x61, 0x71, 0x75, 0x69, 0x63,
+    0x6b, 0xef, 0x6c, 0xbf, 0x68, 0x61, 0x66, 0x6f, 0x78, 0x62, 0xc7, 0x21, 0xcb, 0xee, 0xa2, 0xf2,
+    0x61, 0x72, 0x63, 0x61, 0x74, 0x1d, 0x1e, 0x1f, 0xef, 0x20, 0x21, 0x22, 0x23, 0xf8, 0x09, 0x30,
+    0x31, 0x32, 0xff, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0xf9, 0x6a, 0x4b, 0xaf, 0x56,
+    0xaf, 0xee, 0x71, 0x75, 0x69, 0x63, 0xbb, 0x6b, 0xd6, 0x0f, 0x71, 0x20, 0x62, 0x72, 0xcf, 0x60,
+    0xc9, 0xbf, 0x66, 0x6f, 0x78, 0x6c, 0x68, 0x61, 0x9e, 0x02, 0x85, 0xff, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x8b, 0x8c, 0x8d, 0xff, 0x8e, 0x8f, 0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x7f, 0x96, 0x97,
+    0x98, 0x99, 0x9a, 0x9b, 0x9c, 0xfa, 0x23, 0xee, 0xaa, 0xf2, 0xb0, 0x62, 0x72, 0x9d, 0x91, 0x74,
+    0x75, 0x76, 0xff, 0x77, 0x78, 0x79, 0x7a, 0x7b, 0x7c, 0x7d, 0x7e, 0xff, 0x7f, 0x80, 0x81, 0x82,
+    0x83, 0x84, 0x85, 0x86, 0xff, 0x87, 0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0xd7, 0x8f, 0x90,
+    0x91, 0x0f, 0xf0, 0xd9, 0xba, 0x80, 0x6c, 0x68, 0x3e, 0xdd, 0x81, 0x71, 0x75, 0x69, 0x63, 0x6b,
+    0xe2, 0xa2, 0xb0, 0x27, 0x7f, 0x61, 0x72, 0x63, 0x68, 0x69, 0x76, 0x65, 0x3c, 0xf0, 0xf7, 0x74,
+    0x68, 0x65, 0x00, 0xb0, 0x71, 0x75, 0x69, 0x63, 0x89, 0x6b, 0x06, 0xb2, 0x96, 0xf2, 0xef, 0x21,
+    0x60, 0x52, 0xf0, 0xe1, 0x72, 0xef, 0xfe, 0x59, 0x54, 0x71, 0x75, 0x69, 0x63, 0x6b, 0xa1, 0x62,
+    0xff, 0x72, 0x6f, 0x77, 0x6e, 0xef, 0x74, 0x68, 0x65, 0xbf, 0x66, 0x6f, 0x78, 0x6c, 0x68, 0x61,
+    0x89, 0x88, 0xf1, 0xff, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0x7f, 0xfa, 0xfb, 0xfc,
+    0xfd, 0xfe, 0xff, 0xa6, 0xa9, 0x12, 0xff, 0xef, 0x26, 0x26, 0x26, 0xd6, 0xd7, 0xd8, 0xd9, 0xfe,
+    0x64, 0x87, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xbd, 0xeb, 0x41, 0x05, 0x61, 0x72, 0x63,
+    0x68, 0x7f, 0x70, 0x75, 0x76, 0x80, 0xb4, 0x05, 0x88, 0x6b, 0x72, 0x07, 0x25, 0xef, 0x90, 0xf2,
+    0x3d, 0xef, 0x2d, 0xf0, 0x72, 0x73, 0x74, 0x75
+};
+
+typedef struct LegacyVector {
+    int                 method;
+    const unsigned char *packed;
+    size_t              packed_size;
+    size_t              original_size;
+    unsigned int        crc;
+    const unsigned char *raw;           /* NULL: only the CRC is known */
+} LegacyVector;
+
+static const LegacyVector vectors[] = {
+    { LZHUFF1_METHOD_NUM,  NULL,      0,    0, 0x0000, NULL   },
+    { LZHUFF1_METHOD_NUM,  lh1_1,     1,    1, 0x2700, raw_1  },
+    { LZHUFF1_METHOD_NUM,  lh1_2,     4,    5, 0x1076, raw_2  },
+    { LZHUFF1_METHOD_NUM,  lh1_3,   108,  100, 0x95c0, raw_3  },
+    { LZHUFF1_METHOD_NUM,  lh1_4,  1918, 3000, 0x0a8e, NULL   },
+    { LARC_METHOD_NUM,     NULL,      0,    0, 0x0000, NULL   },
+    { LARC_METHOD_NUM,     lzs_1,     2,    1, 0x2700, raw_1  },
+    { LARC_METHOD_NUM,     lzs_2,     4,    5, 0x1076, raw_2  },
+    { LARC_METHOD_NUM,     lzs_3,   111,  100, 0x95c0, raw_3  },
+    { LARC_METHOD_NUM,     lzs_4,  2052, 3000, 0x0a8e, NULL   },
+    { LARC5_METHOD_NUM,    NULL,      0,    0, 0x0000, NULL   },
+    { LARC5_METHOD_NUM,    lz5_1,     2,    1, 0x2700, raw_1  },
+    { LARC5_METHOD_NUM,    lz5_2,     4,    5, 0x1076, raw_2  },
+    { LARC5_METHOD_NUM,    lz5_3,    92,  100, 0x95c0, raw_3  },
+    { LARC5_METHOD_NUM,    lz5_4,  2104, 3000, 0x0a8e, NULL   }
+};
+
+#define VECTOR_COUNT (sizeof(vectors) / sizeof(vectors[0]))
+
+static const char *method_id(int method)
+{
+    switch (method) {
+    case LZHUFF0_METHOD_NUM: return LZHUFF0_METHOD;
+    case LZHUFF1_METHOD_NUM: return LZHUFF1_METHOD;
+    case LARC_METHOD_NUM:    return LARC_METHOD;
+    case LARC5_METHOD_NUM:   return LARC5_METHOD;
+    }
+    return LZHDIRS_METHOD;
+}
+
+/* packed data handed over `chunk' bytes at a time */
+static bool decode_stream(LHADecoder &decoder, const LegacyVector &v, size_t original_size,
+                          std::vector<unsigned char> &out, size_t chunk)
+{
+    size_t done = 0, used, len;
+
+    out.clear();
+    if (!decoder.begin_stream(v.method, v.packed_size, original_size, lha_test_append, &out))
+        return false;
+    while (done < v.packed_size) {
+        len = v.packed_size - done < chunk ? v.packed_size - done : chunk;
+        if (!decoder.stream(v.packed + done, len, &used) || used == 0)
+            return false;
+        done += used;
+    }
+    return decoder.end_stream();
+}
+
+/* append one member with the given packed data and sizes to an archive */
+static void add_member(std::vector<char> &out, const char *name, int method, int level,
+                       const unsigned char *packed, size_t packed_size, size_t original_size,
+                       unsigned int crc)
+{
+    LHAPack   pack;
+    LHAHeader hdr;
+    char      header[LZHEADER_STORAGE];
+    char      path[FILENAME_LENGTH];
+    size_t    n;
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.method, method_id(method), METHOD_TYPE_STORAGE);
+    hdr.packed_size              = packed_size;
+    hdr.original_size            = original_size;
+    hdr.unix_last_modified_stamp = 1000000000;
+    hdr.attribute                = method == LZHDIRS_METHOD_NUM ? 0x10 : 0x20;
+    hdr.header_level             = (unsigned char)level;
+    hdr.unix_mode                = method == LZHDIRS_METHOD_NUM ? 040755 : 0100644;
+    hdr.has_crc                  = method != LZHDIRS_METHOD_NUM;
+    hdr.crc                      = crc;
+    strcpy(path, name);
+
+    n = pack.write_header(&hdr, header, path);
+    LHA_CHECK(n != 0);
+    out.insert(out.end(), header, header + n);
+    if (packed_size)
+        out.insert(out.end(), (const char *)packed, (const char *)packed + packed_size);
+}
+
+typedef struct LegacyExtracted {
+    std::mutex                                     lock;
+    std::map<size_t, std::pair<bool, std::string> > members;   /* by offset */
+} LegacyExtracted;
+
+static bool collect(void *param, const LHAEntry *entry, const char *buf, bool ok)
+{
+    LegacyExtracted *out = (LegacyExtracted *)param;
+    std::lock_guard<std::mutex> hold(out->lock);
+
+    out->members[entry->offset] = std::make_pair(ok, buf ? std::string(buf, entry->header->original_size)
+                                                         : std::string());
+    return true;
+}
+
+LHA_TEST_CASE(legacy_vectors)
+{
+    static const size_t chunks[] = { 1, 5, 64, 0 };
+    std::vector<unsigned char> out, streamed;
+    LHADecoder decoder;
+
+    for (size_t i = 0; i < VECTOR_COUNT; i++) {
+        const LegacyVector &v = vectors[i];
+
+        out.assign(v.original_size + 1, 0);
+        LHA_CHECK(decoder.decode(v.method, v.packed, v.packed_size, &out[0], v.original_size));
+        out.resize(v.original_size);
+        LHA_CHECK(decoder.crc == v.crc);
+        LHA_CHECK(v.raw == NULL || memcmp(&out[0], v.raw, v.original_size) == 0);
+
+        for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+            LHA_CHECK(decode_stream(decoder, v, v.original_size, streamed,
+                                    chunks[c] ? chunks[c] : v.packed_size + 1));
+            LHA_CHECK(streamed == out);
+            LHA_CHECK(decoder.crc == v.crc);
+        }
+    }
+}
+
+/* a stream decoder stops at the end of its data, not at the size claimed */
+LHA_TEST_CASE(legacy_huge_size)
+{
+    std::vector<unsigned char> out;
+    LHADecoder decoder;
+
+    for (size_t i = 0; i < VECTOR_COUNT; i++) {
+        const LegacyVector &v = vectors[i];
+
+        if (v.original_size < 3000)
+            continue;
+        LHA_CHECK(!decode_stream(decoder, v, 0xffffffffu, out, v.packed_size));
+        LHA_CHECK(out.size() < v.original_size + 0x10000);
+    }
+}
+
+/* half the packed data fails, or decodes to the wrong CRC */
+LHA_TEST_CASE(legacy_truncated)
+{
+    std::vector<unsigned char> out;
+    LHADecoder decoder;
+
+    for (size_t i = 0; i < VECTOR_COUNT; i++) {
+        LegacyVector v = vectors[i];
+
+        if (v.original_size < 100)
+            continue;
+        v.packed_size /= 2;
+        LHA_CHECK(!decode_stream(decoder, v, v.original_size, out, v.packed_size) || decoder.crc != v.crc);
+
+        out.assign(v.original_size + 1, 0);
+        LHA_CHECK(!decoder.decode(v.method, v.packed, v.packed_size, &out[0], v.original_size) ||
+                  decoder.crc != v.crc);
+    }
+}
+
+/* legacy members next to stored ones, at every header level, through extract_all() and test_all() */
+LHA_TEST_CASE(legacy_archive)
+{
+    std::string       path = lha_test_path("legacy.lzh");
+    std::vector<char> data;
+    LHAArchive        archive;
+    char              name[32];
+    size_t            i, count;
+
+    for (int level = 0; level <= 2; level++) {
+        data.clear();
+        for (i = 0; i < VECTOR_COUNT; i++) {
+            const LegacyVector &v = vectors[i];
+
+            sprintf(name, "v%u", (unsigned)i);
+            add_member(data, name, v.method, level, v.packed, v.packed_size, v.original_size, v.crc);
+        }
+        add_member(data, "stored", LZHUFF0_METHOD_NUM, level, raw_3, sizeof(raw_3), sizeof(raw_3),
+                   LHACrc::calccrc(0, raw_3, sizeof(raw_3)));
+        add_member(data, "dir\xff", LZHDIRS_METHOD_NUM, level, NULL, 0, 0, 0);
+        data.push_back(0);
+        LHA_CHECK(lha_test_write_file(path, data));
+        LHA_CHECK(archive.open(path.c_str()));
+
+        LegacyExtracted out;
+        LHA_CHECK(archive.extract_all(collect, &out, 2) == 0);
+        LHA_CHECK(archive.test_all(NULL, NULL, 2) == 0);
+        count = 0;
+        for (LHAArchive::iterator it = archive.begin(); it != archive.end(); ++it, count++) {
+            const std::pair<bool, std::string> &got = out.members[it->offset];
+
+            LHA_CHECK(got.first);
+            LHA_CHECK(got.second.size() == it->header->original_size);
+            if (count < VECTOR_COUNT && vectors[count].raw)
+                LHA_CHECK(memcmp(got.second.data(), vectors[count].raw, got.second.size()) == 0);
+            if (it->header->has_crc)
+                LHA_CHECK(LHACrc::calccrc(0, got.second.data(), got.second.size()) == it->header->crc);
+        }
+        LHA_CHECK(count == VECTOR_COUNT + 2);
+
+        /* a stored member's data is handed over straight from the mapping */
+        LHAArchive::iterator it = archive.open_member(VECTOR_COUNT);
+        LHA_CHECK(it != archive.end());
+        std::vector<unsigned char> stored;
+        LHA_CHECK(archive.extract(*it, lha_test_append, &stored));
+        LHA_CHECK(stored.size() == sizeof(raw_3) && memcmp(&stored[0], raw_3, sizeof(raw_3)) == 0);
+        archive.close();
+    }
+    remove(path.c_str());
+}
+
+/* a -lh1- member claiming 4 GB fails on its own, without the memory */
+LHA_TEST_CASE(legacy_archive_huge)
+{
+    std::string        path = lha_test_path("legacy_huge.lzh");
+    std::vector<char>  data;
+    LHAArchive         archive;
+    LegacyExtracted    out;
+    const LegacyVector *v = NULL;
+
+    for (size_t i = 0; i < VECTOR_COUNT; i++)
+        if (vectors[i].method == LZHUFF1_METHOD_NUM && vectors[i].original_size >= 3000)
+            v = &vectors[i];
+    LHA_CHECK(v != NULL);
+    if (v == NULL)
+        return;
+
+    add_member(data, "huge", v->method, 2, v->packed, v->packed_size, 0xffffffffu, v->crc);
+    add_member(data, "fine", v->method, 2, v->packed, v->packed_size, v->original_size, v->crc);
+    data.push_back(0);
+    LHA_CHECK(lha_test_write_file(path, data));
+    LHA_CHECK(archive.open(path.c_str()));
+
+    LHA_CHECK(archive.extract_all(collect, &out, 2) == 1);
+    LHA_CHECK(out.members.size() == 2);
+    LHA_CHECK(!out.members[0].first && out.members[0].second.empty());
+    LHAArchive::iterator it = archive.begin();
+    ++it;
+    LHA_CHECK(out.members[it->offset].first);
+    LHA_CHECK(archive.test_all(NULL, NULL, 2) == 1);
+
+    std::vector<unsigned char> buf;
+    LHA_CHECK(!archive.extract(*archive.begin(), lha_test_append, &buf));
+    LHA_CHECK(buf.size() < v->original_size + 0x10000);
+
+    archive.close();
+    remove(path.c_str());
+}
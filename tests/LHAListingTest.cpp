@@ -0,0 +1,203 @@
+// LHAListingTest.cpp: the compact directory of an archive, LHAListing.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+
+#include "LHATest.h"
+#include "LHAArchive.h"
+#include "LHAListing.h"
+
+/* an archive of `members' written to a scratch file and opened */
+static void open_archive(LHAArchive &archive, const std::string &path,
+                         const std::vector<LHATestMember> &members, int level)
+{
+    std::vector<char> data;
+
+    LHA_CHECK(lha_test_archive(data, members, level));
+    LHA_CHECK(lha_test_write_file(path, data));
+    LHA_CHECK(archive.open(path.c_str()));
+}
+
+/* a listing holds what the full headers say */
+LHA_TEST_CASE(listing_read)
+{
+    std::string                path = lha_test_path("listing.lzh");
+    std::vector<LHATestMember> members;
+    LHAListing                 listing;
+
+    LHA_CHECK(sizeof(LHAListEntry) == 56);
+    lha_test_members(members, 50, 3000, 9);
+    for (int level = 0; level <= 2; level++) {
+        LHAArchive archive;
+        size_t     i = 0;
+
+        open_archive(archive, path, members, level);
+        LHA_CHECK(listing.read(archive));
+        LHA_CHECK(listing.size() == members.size());
+        for (LHAArchive::iterator it = archive.begin(); it != archive.end() && i < listing.size(); ++it, i++) {
+            const LHAListEntry &e   = listing[i];
+            const LHAHeader    *hdr = it->header;
+
+            LHA_CHECK(e.offset == it->offset && e.dataoffset == it->dataoffset);
+            LHA_CHECK(e.packed_size == hdr->packed_size && e.original_size == hdr->original_size);
+            LHA_CHECK(e.last_modified == members[i].mtime);
+            LHA_CHECK(e.method == members[i].method);
+            LHA_CHECK(e.header_level == level && e.attribute == hdr->attribute);
+            LHA_CHECK(e.has_crc == (hdr->has_crc ? 1 : 0) && e.crc == hdr->crc);
+            LHA_CHECK(e.unix_mode == hdr->unix_mode);
+            LHA_CHECK(e.name_length == strlen(hdr->name));
+            LHA_CHECK(strcmp(listing.name(i), hdr->name) == 0);
+            LHA_CHECK(listing.name(e) == listing.name(i));
+        }
+        archive.close();
+    }
+    remove(path.c_str());
+}
+
+LHA_TEST_CASE(listing_find)
+{
+    std::string                path = lha_test_path("listing_find.lzh");
+    std::vector<LHATestMember> members;
+    LHAArchive                 archive;
+    LHAListing                 listing;
+
+    lha_test_members(members, 500, 10, 10);
+    members[400].name = members[100].name;      /* the first of the two is found */
+    open_archive(archive, path, members, 2);
+    LHA_CHECK(listing.read(archive));
+
+    for (size_t i = 0; i < listing.size(); i++) {
+        const LHAListEntry *e = listing.find(listing.name(i));
+        LHA_CHECK(e == &listing[i == 400 ? 100 : i]);
+    }
+    LHA_CHECK(listing.find("dir0") == NULL);
+    LHA_CHECK(listing.find("") == NULL);
+    LHA_CHECK(listing.find("no such member") == NULL);
+
+    /* append() drops the name table; the next find() builds it again */
+    LHAHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.method, "-lh0-", METHOD_TYPE_STORAGE);
+    strcpy(hdr.name, "appended");
+    LHA_CHECK(listing.append(&hdr, 12345, 30));
+    LHA_CHECK(listing.find("appended") == &listing[listing.size() - 1]);
+    LHA_CHECK(listing.find("appended")->offset == 12345);
+    LHA_CHECK(listing.find(listing.name(0)) == &listing[0]);
+
+    listing.clear();
+    LHA_CHECK(listing.size() == 0 && listing.find("appended") == NULL);
+    archive.close();
+    LHA_CHECK(!listing.read(archive));
+    remove(path.c_str());
+}
+
+LHA_TEST_CASE(listing_hash_name)
+{
+    LHA_CHECK(LHAListing::hash_name("abc", 3) == LHAListing::hash_name("abcdef", 3));
+    LHA_CHECK(LHAListing::hash_name("abc", 3) != LHAListing::hash_name("abd", 3));
+    LHA_CHECK(LHAListing::hash_name("dir\xff" "a", 5) != LHAListing::hash_name("dir/a", 5));
+}
+
+/* the two listings hold the same members, field for field */
+static bool same_listing(const LHAListing &a, const LHAListing &b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++)
+        if (memcmp(&a[i], &b[i], sizeof(LHAListEntry)) != 0 || strcmp(a.name(i), b.name(i)) != 0)
+            return false;
+    return true;
+}
+
+/*
+ * Enough stored members for read_parallel() to cut the archive into
+ * slices.  Every fifth one carries a whole small archive in its data, so
+ * that the slices hold sound headers that are not members.
+ */
+static void big_members(std::vector<LHATestMember> &members, int level)
+{
+    std::vector<LHATestMember> inner;
+    std::vector<char>          nested;
+
+    lha_test_members(members, 200, 5000, 14);
+    lha_test_members(inner, 8, 2000, 15);
+    LHA_CHECK(lha_test_archive(nested, inner, level));
+    for (size_t i = 0; i < members.size(); i++) {
+        if (members[i].method == LZHDIRS_METHOD_NUM)
+            continue;
+        members[i].method = LZHUFF0_METHOD_NUM;
+        lha_test_data(members[i].data, 40000 + i * 101, (uint32_t)i + 16);
+        if (i % 5 == 0)
+            memcpy(&members[i].data[i], &nested[0], nested.size());
+    }
+}
+
+/* the same listing as read(), on any number of threads */
+LHA_TEST_CASE(listing_read_parallel)
+{
+    std::string                path = lha_test_path("listing_parallel.lzh");
+    std::vector<LHATestMember> members;
+    LHAListing                 serial, parallel;
+    static const int           threads[] = {1, 2, 5, 0};
+
+    for (int level = 0; level <= 2; level++) {
+        LHAArchive archive;
+
+        big_members(members, level);
+        open_archive(archive, path, members, level);
+        LHA_CHECK(archive.size() > (8 << 20));
+        LHA_CHECK(serial.read(archive));
+        LHA_CHECK(serial.size() == members.size());
+        for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+            LHA_CHECK(parallel.read_parallel(archive, threads[t]));
+            LHA_CHECK(same_listing(serial, parallel));
+        }
+        archive.close();
+        LHA_CHECK(!parallel.read_parallel(archive, 2));
+    }
+    remove(path.c_str());
+}
+
+/*
+ * A bad header or a cut-off end stops read_parallel() where it stops
+ * read().  A header that only fails its header CRC is listed by both: the
+ * walk does not check it, and the stitching falls back on the walk's own
+ * parse where the strict one found nothing.
+ */
+LHA_TEST_CASE(listing_read_parallel_damaged)
+{
+    std::string                path = lha_test_path("listing_parallel_bad.lzh");
+    std::vector<LHATestMember> members;
+    std::vector<char>          data;
+    LHAListing                 serial, parallel;
+
+    big_members(members, 2);
+    LHA_CHECK(lha_test_archive(data, members, 2));
+    for (int damage = 0; damage < 3; damage++) {
+        LHAArchive        archive;
+        std::vector<char> bad = data;
+
+        LHA_CHECK(lha_test_write_file(path, bad));
+        LHA_CHECK(archive.open(path.c_str()));
+        LHA_CHECK(serial.read(archive));
+        size_t at = (size_t)serial[120].offset;
+        archive.close();
+
+        if (damage == 0)
+            memset(&bad[at], 0, 3);                 /* looks like the end mark */
+        else if (damage == 1)
+            bad[at + 15] ^= 0x01;                   /* the header CRC fails */
+        else
+            bad.resize(at + 100);                   /* cut off in a member */
+        LHA_CHECK(lha_test_write_file(path, bad));
+        LHA_CHECK(archive.open(path.c_str()));
+        LHA_CHECK(serial.read(archive));
+        LHA_CHECK(parallel.read_parallel(archive, 4));
+        LHA_CHECK(damage == 1 ? serial.size() == members.size() : serial.size() == 120);
+        LHA_CHECK(same_listing(serial, parallel));
+        archive.close();
+    }
+    remove(path.c_str());
+}
@@ -0,0 +1,184 @@
+// LHAPipelineTest.cpp: extraction through LHAPipeline and LHAIoQueue.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+
+#include "LHATest.h"
+#include "LHAPipeline.h"
+#include "LHAIoQueue.h"
+#include "LHADecode.h"
+
+/*
+ * Every member reaches its file whatever the queue depth and buffer
+ * limit, synchronously or async; a limit below the member sizes sends
+ * the members through one at a time.
+ */
+LHA_TEST_CASE(pipeline_extract)
+{
+    static const struct {
+        unsigned depth;
+        size_t   limit;
+        bool     async;
+        int      threads;
+    } runs[] = {
+        { PIPELINE_QUEUE_DEPTH, PIPELINE_BUFFER_LIMIT, true,  0 },
+        { PIPELINE_QUEUE_DEPTH, PIPELINE_BUFFER_LIMIT, false, 3 },
+        { 1,                    PIPELINE_BUFFER_LIMIT, true,  2 },
+        { 8,                    1000,                  true,  4 },
+        { 0,                    0,                     false, 1 },
+    };
+    std::string                path = lha_test_path("pipeline.lzh");
+    std::string                dir  = lha_test_path("pipeline_out");
+    std::vector<LHATestMember> members;
+    std::vector<char>          data;
+
+    lha_test_members(members, 80, 40000, 17);
+    LHA_CHECK(lha_test_archive(data, members, 2));
+    LHA_CHECK(lha_test_write_file(path, data));
+
+    for (size_t r = 0; r < sizeof(runs) / sizeof(runs[0]); r++) {
+        LHAPipeline p;
+
+        LHA_CHECK(p.open(path.c_str()) && p.is_open());
+        LHA_CHECK(p.listing().size() == members.size());
+        p.set_queue_depth(runs[r].depth);
+        p.set_buffer_limit(runs[r].limit);
+        p.set_async(runs[r].async);
+        LHA_CHECK(p.extract_all(dir.c_str(), runs[r].threads) == 0);
+        if (!runs[r].async)
+            LHA_CHECK(!p.is_async());
+        p.close();
+        LHA_CHECK(!p.is_open() && p.listing().size() == 0);
+        lha_test_check_tree(dir, members);
+    }
+    remove(path.c_str());
+}
+
+/* a member that fails its CRC is counted, and is the only one missing */
+LHA_TEST_CASE(pipeline_damaged)
+{
+    std::string                path = lha_test_path("pipeline_bad.lzh");
+    std::string                dir  = lha_test_path("pipeline_bad_out");
+    std::vector<LHATestMember> members;
+    std::vector<char>          data;
+    LHAPipeline                p;
+
+    lha_test_members(members, 10, 40000, 18);
+    LHA_CHECK(lha_test_archive(data, members, 2));
+    LHA_CHECK(lha_test_write_file(path, data));
+    LHA_CHECK(p.open(path.c_str()));
+    const LHAListEntry &e = p.listing()[1];
+    LHA_CHECK(e.method == LZHUFF6_METHOD_NUM && e.packed_size > 100);
+    data[(size_t)(e.offset + e.dataoffset + e.packed_size / 2)] ^= 0x10;
+    p.close();
+    LHA_CHECK(lha_test_write_file(path, data));
+
+    LHA_CHECK(p.open(path.c_str()));
+    LHA_CHECK(p.extract_all(dir.c_str(), 2) == 1);
+    p.close();
+
+    std::string bad = dir + "/" + members[1].name;
+    remove(bad.c_str());        /* if it was written at all */
+    members.erase(members.begin() + 1);
+    lha_test_check_tree(dir, members);
+
+    LHA_CHECK(!p.open(lha_test_path("no_such_archive.lzh").c_str()));
+    LHA_CHECK(p.extract_all(dir.c_str()) == 0);
+    remove(path.c_str());
+}
+
+/*
+ * A member whose header claims 4 GB fails on its own, without the
+ * memory: the decode workers' output grows with what is decoded.
+ */
+LHA_TEST_CASE(pipeline_huge)
+{
+    std::string                path = lha_test_path("pipeline_huge.lzh");
+    std::string                dir  = lha_test_path("pipeline_huge_out");
+    std::vector<LHATestMember> members;
+    std::vector<char>          data;
+
+    lha_test_members(members, 6, 40000, 19);
+    LHA_CHECK(members[0].method == LZHUFF5_METHOD_NUM);
+    LHA_CHECK(lha_test_archive(data, members, 2));
+    memset(&data[11], 0xff, 4);                 /* original size; the header CRC is not checked */
+    LHA_CHECK(lha_test_write_file(path, data));
+
+    for (int async = 0; async < 2; async++) {
+        LHAPipeline p;
+        std::vector<LHATestMember> rest(members.begin() + 1, members.end());
+
+        LHA_CHECK(p.open(path.c_str()));
+        LHA_CHECK(p.listing().size() == members.size());
+        LHA_CHECK(p.listing()[0].original_size == 0xffffffffu);
+        p.set_async(async != 0);
+        LHA_CHECK(p.extract_all(dir.c_str(), 2) == 1);
+        p.close();
+
+        std::string bad = dir + "/" + members[0].name;
+        remove(bad.c_str());
+        lha_test_check_tree(dir, rest);
+    }
+    remove(path.c_str());
+}
+
+/* requests complete with their tags and results, on a ring or without, or are drained */
+LHA_TEST_CASE(pipeline_io_queue)
+{
+    std::string path = lha_test_path("ioqueue.bin");
+    char        out[3][100], in[300];
+    uint64_t    tag, seen;
+    int64_t     result;
+
+    for (int i = 0; i < 3; i++)
+        memset(out[i], 'a' + i, sizeof(out[i]));
+
+    for (int async = 0; async < 2; async++) {
+        LHAIoQueue io;
+        FILE       *fp = fopen(path.c_str(), "w+b");
+        int        fd;
+
+        LHA_CHECK(fp != NULL);
+        if (fp == NULL)
+            return;
+        fd = fileno(fp);
+        LHA_CHECK(io.open(4, async != 0));
+        if (!async)
+            LHA_CHECK(!io.is_async());
+
+        seen = 0;
+        for (int i = 0; i < 3; i++)
+            LHA_CHECK(io.write(fd, out[i], sizeof(out[i]), (uint64_t)i * 100, 10 + i));
+        LHA_CHECK(io.nop(20));
+        LHA_CHECK(io.submit());
+        for (int i = 0; i < 4; i++) {
+            LHA_CHECK(io.wait(&tag, &result));
+            LHA_CHECK(tag == 20 ? result == 0 : result == 100);
+            seen |= (uint64_t)1 << (tag - 10);
+        }
+        LHA_CHECK(seen == ((1 << 0) | (1 << 1) | (1 << 2) | (1 << 10)));
+        LHA_CHECK(!io.poll(&tag, &result));
+
+        LHA_CHECK(io.read(fd, in, sizeof(in), 0, 30));
+        LHA_CHECK(io.submit());
+        LHA_CHECK(io.wait(&tag, &result) && tag == 30 && result == 300);
+        LHA_CHECK(memcmp(in, out[0], 100) == 0 && memcmp(in + 200, out[2], 100) == 0);
+
+        /* drain() takes whatever is outstanding, submitted or not */
+        LHA_CHECK(io.read(fd, in, sizeof(in), 0, 40));
+        LHA_CHECK(io.submit());
+        LHA_CHECK(io.nop(41) && io.nop(42));
+        LHA_CHECK(io.drain());
+        LHA_CHECK(!io.poll(&tag, &result));
+        LHA_CHECK(io.drain());
+
+        LHA_CHECK(LHAIoQueue::read_at(fd, in, 10, 295) == 5);
+        LHA_CHECK(LHAIoQueue::write_at(fd, "xyz", 3, 300) == 3);
+        LHA_CHECK(LHAIoQueue::read_at(fd, in, 10, 298) == 5 && memcmp(in, "ccxyz", 5) == 0);
+        io.close();
+        fclose(fp);
+    }
+    remove(path.c_str());
+}
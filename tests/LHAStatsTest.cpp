@@ -0,0 +1,128 @@
+// LHAStatsTest.cpp: the hot path counters of LHAStats.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+#include "LHATest.h"
+#include "LHAStats.h"
+#include "LHAArchive.h"
+#include "LHACrc.h"
+
+/* counts since `before' */
+static uint64_t calls(const LHAStatsSnapshot &before, const LHAStatsSnapshot &after, int stage)
+{
+    return after.calls[stage] - before.calls[stage];
+}
+
+static uint64_t bytes(const LHAStatsSnapshot &before, const LHAStatsSnapshot &after, int stage)
+{
+    return after.bytes[stage] - before.bytes[stage];
+}
+
+struct Reports {
+    int              count;
+    LHAStatsSnapshot last;
+};
+
+static void on_report(void *param, const LHAStatsSnapshot *stats)
+{
+    Reports *r = (Reports *)param;
+
+    r->count++;
+    r->last = *stats;
+}
+
+static bool ignore(void *, const LHAEntry *, const char *, bool)
+{
+    return true;
+}
+
+/*
+ * Headers, CRC runs, decoded members and stored members are counted with
+ * their bytes, and the failed CRC; report() hands the totals over at the
+ * end of extract_all().  Built without LHAPACK_STATS, all stays zero.
+ */
+LHA_TEST_CASE(stats_extract)
+{
+    std::string                path = lha_test_path("stats.lzh");
+    std::vector<LHATestMember> members;
+    std::vector<char>          data;
+    LHAArchive                 archive;
+    LHAStatsSnapshot           before, after;
+    Reports                    reports;
+    uint64_t                   total = 0;
+    size_t                     files = 0;
+
+    lha_test_members(members, 20, 10000, 24);
+    for (size_t i = 0; i < members.size(); i++) {
+        total += members[i].data.size();
+        files += members[i].method != LZHDIRS_METHOD_NUM;
+    }
+    LHA_CHECK(lha_test_archive(data, members, 2));
+    data[data.size() / 2] ^= 0x20;      /* inside some packed data */
+    LHA_CHECK(lha_test_write_file(path, data));
+    LHA_CHECK(archive.open(path.c_str()));
+
+    memset(&reports, 0, sizeof(reports));
+    LHAStats::set_export(on_report, &reports);
+    LHAStats::snapshot(&before);
+    LHA_CHECK(archive.extract_all(ignore, NULL, 2) == 1);
+    LHAStats::snapshot(&after);
+    LHAStats::set_export(NULL, NULL);
+    LHAStats::report();
+
+    if (!LHAStats::enabled()) {
+        for (int s = 0; s < LHA_STAT_STAGES; s++)
+            LHA_CHECK(after.calls[s] == 0 && after.bytes[s] == 0 && after.ns[s] == 0);
+        LHA_CHECK(after.crc_failures == 0 && reports.count == 0);
+    }
+    else {
+        /* the scan and the tasks each parse every header */
+        LHA_CHECK(calls(before, after, LHA_STAT_HEADER) >= 2 * members.size());
+        LHA_CHECK(calls(before, after, LHA_STAT_EXTENDED) >= 2 * members.size());
+        LHA_CHECK(calls(before, after, LHA_STAT_DECODE) == files);
+        LHA_CHECK(bytes(before, after, LHA_STAT_DECODE) <= total);
+        LHA_CHECK(bytes(before, after, LHA_STAT_DECODE) + 10000 >= total);
+        LHA_CHECK(calls(before, after, LHA_STAT_OUTPUT) == members.size());
+        LHA_CHECK(bytes(before, after, LHA_STAT_OUTPUT) < total);      /* one failed */
+        LHA_CHECK(after.crc_failures - before.crc_failures == 1);
+        LHA_CHECK(reports.count == 1);
+        LHA_CHECK(reports.last.calls[LHA_STAT_OUTPUT] >= after.calls[LHA_STAT_OUTPUT]);
+    }
+    archive.close();
+    remove(path.c_str());
+}
+
+/* what threads counted stays counted after they exit */
+LHA_TEST_CASE(stats_threads)
+{
+    std::vector<unsigned char> data;
+    LHAStatsSnapshot           before, after;
+    std::vector<std::thread>   threads;
+
+    lha_test_data(data, 4096, 25);
+    LHAStats::snapshot(&before);
+    for (int t = 0; t < 4; t++) {
+        threads.push_back(std::thread([&data]() {
+            for (int i = 0; i < 100; i++)
+                LHACrc::calccrc(0, &data[0], data.size());
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+    LHAStats::snapshot(&after);
+
+    if (LHAStats::enabled()) {
+        LHA_CHECK(calls(before, after, LHA_STAT_CRC) == 400);
+        LHA_CHECK(bytes(before, after, LHA_STAT_CRC) == 400 * 4096);
+    }
+    else
+        LHA_CHECK(calls(before, after, LHA_STAT_CRC) == 0);
+
+    LHA_CHECK(strcmp(LHAStats::stage_name(LHA_STAT_HEADER), "header") == 0);
+    LHA_CHECK(strcmp(LHAStats::stage_name(LHA_STAT_OUTPUT), "output") == 0);
+    LHA_CHECK(strcmp(LHAStats::stage_name(LHA_STAT_STAGES), "unknown") == 0);
+}
@@ -0,0 +1,262 @@
+// LHAStreamTest.cpp: archives pushed and pulled through LHAStream.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+
+#include "LHATest.h"
+#include "LHAStream.h"
+
+/* what the handler saw, member by member */
+struct StreamLog {
+    struct Member {
+        std::string                 name;
+        std::vector<unsigned char>  data;
+        bool                        ended;
+        bool                        ok;
+    };
+    std::vector<Member> members;
+    int                 skip_every;     /* refuse every n-th header; 0: none */
+    int                 refuse_data;    /* give up on the data of this member; -1: none */
+    int                 headers;
+};
+
+static bool on_header(void *param, const LHAHeader *hdr)
+{
+    StreamLog *log = (StreamLog *)param;
+    StreamLog::Member m;
+
+    if (log->skip_every && log->headers++ % log->skip_every == 0)
+        return false;
+    m.name  = lha_test_name(hdr->name);
+    m.ended = m.ok = false;
+    log->members.push_back(m);
+    return true;
+}
+
+static bool on_data(void *param, const LHAHeader *, const void *buf, size_t len)
+{
+    StreamLog *log = (StreamLog *)param;
+    StreamLog::Member &m = log->members.back();
+
+    LHA_CHECK(!m.ended);
+    m.data.insert(m.data.end(), (const unsigned char *)buf, (const unsigned char *)buf + len);
+    return (int)log->members.size() - 1 != log->refuse_data;
+}
+
+static void on_end(void *param, const LHAHeader *hdr, bool ok)
+{
+    StreamLog *log = (StreamLog *)param;
+    StreamLog::Member &m = log->members.back();
+
+    LHA_CHECK(!m.ended && m.name == lha_test_name(hdr->name));
+    m.ended = true;
+    m.ok    = ok;
+}
+
+static const LHAStreamHandler handler = { on_header, on_data, on_end };
+
+static void start(LHAStream &s, StreamLog &log)
+{
+    log.members.clear();
+    log.skip_every  = 0;
+    log.refuse_data = -1;
+    log.headers     = 0;
+    s.begin(&handler, &log);
+}
+
+/* the log holds members[first], members[first + step], ..., all whole */
+static void check_log(const StreamLog &log, const std::vector<LHATestMember> &members,
+                      size_t first = 0, size_t step = 1)
+{
+    size_t j = 0;
+
+    for (size_t i = first; i < members.size(); i += step, j++) {
+        if (j >= log.members.size())
+            break;
+        const StreamLog::Member &m = log.members[j];
+
+        LHA_CHECK(m.name == members[i].name);
+        LHA_CHECK(m.ended && m.ok);
+        LHA_CHECK(m.data == members[i].data);
+    }
+    LHA_CHECK(j == log.members.size());
+}
+
+/* headers and data split anywhere; what follows the end mark is ignored */
+LHA_TEST_CASE(stream_feed)
+{
+    static const size_t        chunks[] = {1, 3, 1000, 65536, 0};
+    std::vector<LHATestMember> members;
+    std::vector<char>          data;
+    StreamLog                  log;
+
+    lha_test_members(members, 30, 20000, 19);
+    for (int level = 0; level <= 2; level++) {
+        LHA_CHECK(lha_test_archive(data, members, level));
+        data.insert(data.end(), 100, 'x');
+
+        for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+            size_t    chunk = chunks[c] ? chunks[c] : data.size();
+            LHAStream s;
+
+            start(s, log);
+            for (size_t at = 0; at < data.size(); at += chunk)
+                LHA_CHECK(s.feed(&data[at], at + chunk > data.size() ? data.size() - at : chunk));
+            LHA_CHECK(s.at_end() && !s.failed());
+            LHA_CHECK(s.finish());
+            LHA_CHECK(s.failures() == 0);
+            check_log(log, members);
+        }
+    }
+}
+
+/* input for LHAStream::run(), in ragged pieces, failing at `fail_at' */
+struct Reader {
+    const std::vector<char> *data;
+    size_t                  at;
+    size_t                  fail_at;
+    size_t                  n;
+};
+
+static ptrdiff_t read_piece(void *param, void *buf, size_t len)
+{
+    Reader *r = (Reader *)param;
+    size_t  n = 1 + r->n++ * 7919 % 5000;
+
+    if (r->at >= r->fail_at)
+        return -1;
+    if (n > len)
+        n = len;
+    if (n > r->data->size() - r->at)
+        n = r->data->size() - r->at;
+    memcpy(buf, &(*r->data)[r->at], n);
+    r->at += n;
+    return (ptrdiff_t)n;
+}
+
+LHA_TEST_CASE(stream_run)
+{
+    std::vector<LHATestMember> members;
+    std::vector<char>          data;
+    StreamLog                  log;
+
+    lha_test_members(members, 20, 30000, 20);
+    LHA_CHECK(lha_test_archive(data, members, 2));
+
+    {
+        LHAStream s;
+        Reader    r = { &data, 0, (size_t)-1, 0 };
+
+        start(s, log);
+        LHA_CHECK(s.run(read_piece, &r));
+        LHA_CHECK(s.at_end() && s.failures() == 0);
+        check_log(log, members);
+    }
+    {
+        /* a read error inside a member fails that member and the stream */
+        LHAStream s;
+        Reader    r = { &data, 0, data.size() / 2, 0 };
+
+        start(s, log);
+        LHA_CHECK(!s.run(read_piece, &r));
+        LHA_CHECK(s.failed() && !log.members.empty());
+        LHA_CHECK(log.members.back().ended && !log.members.back().ok);
+    }
+}
+
+/* refused headers are passed over unreported; refused data fails its member only */
+LHA_TEST_CASE(stream_skip)
+{
+    std::vector<LHATestMember> members;
+    std::vector<char>          data;
+    StreamLog                  log;
+
+    lha_test_members(members, 21, 10000, 21);
+    LHA_CHECK(lha_test_archive(data, members, 1));
+
+    {
+        LHAStream s;
+
+        start(s, log);
+        log.skip_every = 3;
+        LHA_CHECK(s.feed(&data[0], data.size()) && s.finish());
+        LHA_CHECK(s.failures() == 0);
+        LHA_CHECK(log.members.size() == 14);
+        for (size_t i = 0, j = 0; i < members.size() && j < log.members.size(); i++) {
+            if (i % 3 == 0)
+                continue;
+            LHA_CHECK(log.members[j].name == members[i].name && log.members[j].data == members[i].data);
+            j++;
+        }
+    }
+    {
+        LHAStream s;
+
+        LHA_CHECK(members[0].data.size() > 0);
+        start(s, log);
+        log.refuse_data = 0;
+        LHA_CHECK(s.feed(&data[0], data.size()) && s.finish());
+        LHA_CHECK(s.failures() == 1);
+        LHA_CHECK(log.members.size() == members.size());
+        LHA_CHECK(log.members[0].ended && !log.members[0].ok);
+        for (size_t i = 1; i < log.members.size(); i++)
+            LHA_CHECK(log.members[i].ok && log.members[i].data == members[i].data);
+    }
+}
+
+/*
+ * Input cut between members ends well (not every archiver writes the end
+ * mark); cut inside one fails it.  A bad header stops the stream, a bad
+ * CRC only its member.
+ */
+LHA_TEST_CASE(stream_damaged)
+{
+    std::vector<LHATestMember> members;
+    std::vector<char>          data, cut;
+    StreamLog                  log;
+    size_t                     second;
+
+    lha_test_members(members, 5, 20000, 22);
+    LHA_CHECK(lha_test_archive(data, members, 2));
+    second = (unsigned char)data[0] | ((unsigned char)data[1] << 8);   /* level 2 header size */
+    {
+        LHAStream s;
+
+        cut.assign(data.begin(), data.end() - 1);       /* no end mark */
+        start(s, log);
+        LHA_CHECK(s.feed(&cut[0], cut.size()));
+        LHA_CHECK(s.finish() && s.failures() == 0);
+        check_log(log, members);
+    }
+    {
+        LHAStream s;
+
+        cut.assign(data.begin(), data.begin() + data.size() / 2);
+        start(s, log);
+        LHA_CHECK(s.feed(&cut[0], cut.size()));
+        LHA_CHECK(!s.finish() && s.failed());
+        LHA_CHECK(s.failures() == 1 && !log.members.back().ok);
+    }
+    {
+        LHAStream s;
+
+        cut = data;
+        cut[second + 10] ^= 0x55;                       /* packed data of the first member */
+        start(s, log);
+        LHA_CHECK(s.feed(&cut[0], cut.size()) && s.finish());
+        LHA_CHECK(s.failures() == 1 && log.members.size() == members.size());
+        LHA_CHECK(!log.members[0].ok && log.members[1].ok);
+    }
+    {
+        LHAStream s;
+
+        cut = data;
+        cut[20] = 7;                                    /* no such header level */
+        start(s, log);
+        LHA_CHECK(!s.feed(&cut[0], cut.size()));
+        LHA_CHECK(s.failed() && !s.finish());
+        LHA_CHECK(log.members.empty());
+    }
+}
@@ -0,0 +1,296 @@
+// LHATest.cpp: the lhapack_tests runner and the helpers the cases share.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include <set>
+
+#include "LHATest.h"
+#include "LHAPack.h"
+#include "LHACrc.h"
+#include "LHAEncode.h"
+
+#define LHA_PATHSEP     0xff    /* path separator of the filename in lha header */
+
+static LHATestCase  *first_case;
+static LHATestCase  **last_case = &first_case;
+static int          failed_checks;
+
+LHATestCase::LHATestCase(const char *name, LHATestFunc func)
+{
+    this->name = name;
+    this->func = func;
+    this->next = NULL;
+    *last_case = this;
+    last_case  = &this->next;
+}
+
+void lha_test_failed(const char *file, int line, const char *expr)
+{
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+    failed_checks++;
+}
+
+/* xorshift32 */
+static uint32_t next_random(uint32_t *state)
+{
+    uint32_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+/*
+ * Words from a small vocabulary, with the odd run of one byte and
+ * stretch of noise, so that literals, short and long matches all turn up
+ * (as in bench/LHABench.cpp).
+ */
+void lha_test_data(std::vector<unsigned char> &out, size_t size, uint32_t seed)
+{
+    static const char *words[] = {
+        "the ", "archive ", "member ", "header ", "level ", "method ",
+        "size ", "crc ", "packed ", "original ", "time ", "name ",
+        "extended ", "directory ", "file ", "data ", "lh5 ", "lh6 ",
+        "lh7 ", "decode ", "encode ", "window ", "match ", "table ",
+        "\n", ", ", ". ", "0 ", "1 ", "1024 ", "65536 ", "\t"
+    };
+    uint32_t state = seed | 1;
+
+    out.clear();
+    out.reserve(size);
+    while (out.size() < size) {
+        uint32_t r = next_random(&state);
+
+        if ((r & 0xff) == 0) {
+            out.insert(out.end(), 16 + (r >> 8) % 200, (unsigned char)(r >> 16));
+        }
+        else if ((r & 0xff) == 1) {
+            for (uint32_t i = 0; i < 16 + (r >> 8) % 64; i++)
+                out.push_back((unsigned char)next_random(&state));
+        }
+        else {
+            const char *w = words[(r >> 8) % (sizeof(words) / sizeof(words[0]))];
+            out.insert(out.end(), w, w + strlen(w));
+        }
+    }
+    out.resize(size);
+}
+
+bool lha_test_append(void *param, const void *buf, size_t len)
+{
+    std::vector<unsigned char> *out = (std::vector<unsigned char> *)param;
+
+    out->insert(out->end(), (const unsigned char *)buf, (const unsigned char *)buf + len);
+    return true;
+}
+
+bool lha_test_pack(int method, int level, const std::vector<unsigned char> &data,
+                   std::vector<unsigned char> &packed, unsigned int *crc)
+{
+    LHAEncoder encoder;
+
+    packed.clear();
+    if (!encoder.begin(method, level, lha_test_append, &packed))
+        return false;
+    if (!data.empty() && !encoder.write(&data[0], data.size()))
+        return false;
+    if (!encoder.finish())
+        return false;
+    *crc = encoder.crc;
+    return true;
+}
+
+std::string lha_test_path(const char *name)
+{
+    return std::string("lhapack_test_") + name;
+}
+
+bool lha_test_read_file(const std::string &path, std::vector<char> &out)
+{
+    FILE    *fp = fopen(path.c_str(), "rb");
+    char    buf[0x10000];
+    size_t  n;
+
+    out.clear();
+    if (fp == NULL)
+        return false;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+        out.insert(out.end(), buf, buf + n);
+    return fclose(fp) == 0;
+}
+
+bool lha_test_write_file(const std::string &path, const std::vector<char> &data)
+{
+    FILE *fp = fopen(path.c_str(), "wb");
+    bool ok;
+
+    if (fp == NULL)
+        return false;
+    ok = data.empty() || fwrite(&data[0], 1, data.size(), fp) == data.size();
+    return fclose(fp) == 0 && ok;
+}
+
+void lha_test_members(std::vector<LHATestMember> &members, size_t count, size_t size, uint32_t seed)
+{
+    static const int methods[] = {
+        LZHUFF5_METHOD_NUM, LZHUFF6_METHOD_NUM, LZHUFF7_METHOD_NUM, LZHUFF0_METHOD_NUM
+    };
+    char name[64];
+
+    members.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        LHATestMember &m = members[i];
+
+        m.mtime = (time_t)(1000000000 + i * 86400 * 37);
+        if (i % 7 == 6) {
+            snprintf(name, sizeof(name), "dir%u/sub%u", (unsigned)(i / 7), (unsigned)i);
+            m.name   = name;
+            m.method = LZHDIRS_METHOD_NUM;
+            m.data.clear();
+            continue;
+        }
+        snprintf(name, sizeof(name), "dir%u/file%u.txt", (unsigned)(i / 7), (unsigned)i);
+        m.name   = name;
+        m.method = methods[i % 4];
+        lha_test_data(m.data, i % 11 == 10 ? 0 : (size_t)((i * 7919 + seed) % (size + 1)), seed + (uint32_t)i);
+    }
+}
+
+void lha_test_check_tree(const std::string &dir, const std::vector<LHATestMember> &members)
+{
+    std::set<std::string> dirs;
+    std::vector<char>     data;
+    std::string           path;
+    size_t                i, slash;
+
+    for (i = 0; i < members.size(); i++) {
+        const LHATestMember &m = members[i];
+
+        path = dir + "/" + m.name;
+        for (slash = path.rfind('/'); slash > dir.size(); slash = path.rfind('/', slash - 1))
+            dirs.insert(path.substr(0, slash));
+        if (m.method == LZHDIRS_METHOD_NUM) {
+            dirs.insert(path);
+            continue;
+        }
+        LHA_CHECK(lha_test_read_file(path, data));
+        LHA_CHECK(data.size() == m.data.size());
+        LHA_CHECK(data.empty() || memcmp(&data[0], &m.data[0], data.size()) == 0);
+        LHA_CHECK(remove(path.c_str()) == 0);
+    }
+    /* deepest first; every one made, and left empty */
+    for (std::set<std::string>::reverse_iterator d = dirs.rbegin(); d != dirs.rend(); ++d)
+        LHA_CHECK(remove(d->c_str()) == 0);
+    LHA_CHECK(remove(dir.c_str()) == 0);
+}
+
+std::string lha_test_name(const char *name)
+{
+    std::string s(name);
+
+    for (size_t i = 0; i < s.size(); i++) {
+        if ((unsigned char)s[i] == LHA_PATHSEP)
+            s[i] = '/';
+    }
+    if (!s.empty() && s[s.size() - 1] == '/')
+        s.erase(s.size() - 1);
+    return s;
+}
+
+bool lha_test_archive(std::vector<char> &out, const std::vector<LHATestMember> &members, int level)
+{
+    static const char *method_ids[] = {
+        LZHUFF0_METHOD, LZHUFF1_METHOD, LZHUFF2_METHOD, LZHUFF3_METHOD, LZHUFF4_METHOD,
+        LZHUFF5_METHOD, LZHUFF6_METHOD, LZHUFF7_METHOD, LARC_METHOD, LARC5_METHOD,
+        LARC4_METHOD, LZHDIRS_METHOD
+    };
+    std::vector<unsigned char> packed;
+    LHAPack   pack;
+    LHAHeader hdr;
+    char      header[LZHEADER_STORAGE];
+    char      path[FILENAME_LENGTH];
+    size_t    n, i;
+
+    out.clear();
+    for (i = 0; i < members.size(); i++) {
+        const LHATestMember &m = members[i];
+        unsigned int crc = 0;
+
+        if (m.method == LZHUFF0_METHOD_NUM || m.method == LZHDIRS_METHOD_NUM) {
+            packed = m.data;
+            crc    = LHACrc::calccrc(0, m.data.empty() ? NULL : &m.data[0], m.data.size());
+        }
+        else if (!lha_test_pack(m.method, LZH_LEVEL_DEFAULT, m.data, packed, &crc))
+            return false;
+
+        for (n = 0; n < m.name.size() && n < sizeof(path) - 2; n++)
+            path[n] = m.name[n] == '/' ? (char)LHA_PATHSEP : m.name[n];
+        if (m.method == LZHDIRS_METHOD_NUM)
+            path[n++] = (char)LHA_PATHSEP;
+        path[n] = '\0';
+
+        memset(&hdr, 0, sizeof(hdr));
+        memcpy(hdr.method, method_ids[m.method], METHOD_TYPE_STORAGE);
+        hdr.packed_size              = packed.size();
+        hdr.original_size            = m.data.size();
+        hdr.unix_last_modified_stamp = m.mtime;
+        hdr.attribute                = m.method == LZHDIRS_METHOD_NUM ? 0x10 : 0x20;
+        hdr.header_level             = (unsigned char)level;
+        hdr.unix_mode                = m.method == LZHDIRS_METHOD_NUM ? 040755 : 0100644;
+        hdr.has_crc                  = m.method != LZHDIRS_METHOD_NUM;
+        hdr.crc                      = crc;
+
+        if ((n = pack.write_header(&hdr, header, path)) == 0)
+            return false;
+        out.insert(out.end(), header, header + n);
+        out.insert(out.end(), packed.begin(), packed.end());
+    }
+    out.push_back(0);
+    return true;
+}
+
+/* a case runs if it is named, or its name starts with a named group and '_' */
+static bool selected(const char *name, int argc, char **argv)
+{
+    int i;
+
+    if (argc < 2)
+        return true;
+    for (i = 1; i < argc; i++) {
+        size_t n = strlen(argv[i]);
+
+        if (strncmp(name, argv[i], n) == 0 && (name[n] == '\0' || name[n] == '_'))
+            return true;
+    }
+    return false;
+}
+
+/* lhapack_tests [group ...]: exit status 1 if a check failed, 2 if nothing ran */
+int main(int argc, char **argv)
+{
+    LHATestCase *t;
+    int         run = 0, failed = 0;
+
+    for (t = first_case; t != NULL; t = t->next) {
+        int before = failed_checks;
+
+        if (!selected(t->name, argc, argv))
+            continue;
+        t->func();
+        run++;
+        if (failed_checks != before) {
+            failed++;
+            printf("%-32s FAILED\n", t->name);
+        }
+        else
+            printf("%-32s ok\n", t->name);
+    }
+
+    printf("%d of %d cases failed\n", failed, run);
+    if (run == 0)
+        return 2;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+// LHATest.h: the test cases and checks of the lhapack_tests runner.
+//
+//////////////////////////////////////////////////////////////////////
+
+#if !defined(AFX_LHATEST_H__985C72D0_7FCE_4380_905C_9DEE4303A1F7__INCLUDED_)
+#define AFX_LHATEST_H__985C72D0_7FCE_4380_905C_9DEE4303A1F7__INCLUDED_
+
+#if _MSC_VER > 1000
+#pragma once
+#endif // _MSC_VER > 1000
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+/*
+ * A test case is a function registered under a name by LHA_TEST_CASE.
+ * `lhapack_tests decode' runs every case named decode or decode_*; CTest
+ * runs one such group per feature (CMakeLists.txt, LHAPACK_TESTS).
+ * A failed LHA_CHECK reports where it failed and the case goes on.
+ *
+ *     LHA_TEST_CASE(crc_empty)
+ *     {
+ *         LHA_CHECK(LHACrc::calccrc(0, "", 0) == 0);
+ *     }
+ */
+typedef void (*LHATestFunc)();
+
+struct LHATestCase {
+    const char      *name;
+    LHATestFunc     func;
+    LHATestCase     *next;
+
+    LHATestCase(const char *name, LHATestFunc func);
+};
+
+#define LHA_TEST_CASE(name) \
+    static void test_##name(); \
+    static LHATestCase test_case_##name(#name, test_##name); \
+    static void test_##name()
+
+#define LHA_CHECK(expr) \
+    ((expr) ? (void)0 : lha_test_failed(__FILE__, __LINE__, #expr))
+
+void lha_test_failed(const char *file, int line, const char *expr);
+
+/* text-like data, the same for a seed on every run and platform */
+void lha_test_data(std::vector<unsigned char> &out, size_t size, uint32_t seed);
+
+/* an LHAOutputProc appending to the std::vector<unsigned char> param */
+bool lha_test_append(void *param, const void *buf, size_t len);
+
+/* compress data with LHAEncoder; false if the encoder fails */
+bool lha_test_pack(int method, int level, const std::vector<unsigned char> &data,
+                   std::vector<unsigned char> &packed, unsigned int *crc);
+
+/* a file name for a case's scratch files, in the working directory */
+std::string lha_test_path(const char *name);
+
+bool lha_test_read_file(const std::string &path, std::vector<char> &out);
+bool lha_test_write_file(const std::string &path, const std::vector<char> &data);
+
+/* a member for lha_test_archive(), and what it should read back as */
+struct LHATestMember {
+    std::string                 name;       /* '/' between directories */
+    int                         method;     /* LZHDIRS_METHOD_NUM: a directory */
+    std::vector<unsigned char>  data;
+    time_t                      mtime;
+};
+
+/*
+ * `count' members of up to `size' bytes: -lh5-, -lh6-, -lh7- and -lh0-
+ * in turn, every seventh a directory, every eleventh empty.
+ */
+void lha_test_members(std::vector<LHATestMember> &members, size_t count, size_t size, uint32_t seed);
+
+/*
+ * The members as extracted below dir: every file and directory there
+ * and holding the right data.  Removes them, and dir, as it goes.
+ */
+void lha_test_check_tree(const std::string &dir, const std::vector<LHATestMember> &members);
+
+/* a parsed member name with '/' for LHA_PATHSEP, and no trailing one */
+std::string lha_test_name(const char *name);
+
+/* the members behind headers of one level (0 .. 2), then the end mark */
+bool lha_test_archive(std::vector<char> &out, const std::vector<LHATestMember> &members, int level);
+
+#endif // !defined(AFX_LHATEST_H__985C72D0_7FCE_4380_905C_9DEE4303A1F7__INCLUDED_)
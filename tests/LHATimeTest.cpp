@@ -0,0 +1,124 @@
+// LHATimeTest.cpp: time stamp conversion, checked against the C library.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "LHATest.h"
+#include "LHAPack.h"
+#include "LHADecode.h"
+
+/*
+ * The time stamp t reads back as from a header of `level'.  dos_only
+ * drops the UNIX extension of a level 0 header, leaving the MS-DOS
+ * stamp to go by, as in archives from MS-DOS and Windows.
+ */
+static time_t round_trip(time_t t, int level, bool dos_only = false)
+{
+    LHAPack   pack;
+    LHAHeader hdr;
+    char      header[LZHEADER_STORAGE];
+    char      path[] = "t";
+    size_t    n, offset;
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.method, LZHUFF0_METHOD, METHOD_TYPE_STORAGE);
+    hdr.header_level             = (unsigned char)level;
+    hdr.attribute                = 0x20;
+    hdr.unix_mode                = 0100644;
+    hdr.unix_last_modified_stamp = t;
+    n = pack.write_header(&hdr, header, path);
+    LHA_CHECK(n > 0);
+    if (dos_only && n > 0) {
+        n = 22 + strlen(path) + 2;              /* up to the file CRC */
+        header[0] = (char)(n - 2);
+        header[1] = (char)LHAPack::calc_sum(header + 2, (int)(n - 2));
+    }
+    if (n == 0 || !LHAPack::parse_header(header, header + n, &hdr, &offset, LHA_PARSE_STRICT))
+        return (time_t)-2;
+    LHA_CHECK(offset == n);
+    return hdr.unix_last_modified_stamp;
+}
+
+/* what the C library makes of the local time at t, to the even second */
+static time_t expected(time_t t)
+{
+    struct tm tm = *localtime(&t);
+
+    tm.tm_sec  &= ~1;
+    tm.tm_isdst = -1;
+    return mktime(&tm);
+}
+
+static bool same_time(time_t t, const SYSTEMTIME &st)
+{
+    struct tm tm = *localtime(&t);
+
+    return st.wYear == tm.tm_year + 1900 && st.wMonth == tm.tm_mon + 1 && st.wDay == tm.tm_mday &&
+           st.wHour == tm.tm_hour && st.wMinute == tm.tm_min && st.wSecond == tm.tm_sec &&
+           st.wDayOfWeek == tm.tm_wday;
+}
+
+/*
+ * An MS-DOS stamp holds the local time: it reads back as mktime() has
+ * it, a repeated hour and a skipped one included.
+ * The sweep covers the whole 1980 .. 2107 range a few days apart, and
+ * every half hour of two years, one of them past 2038.
+ */
+LHA_TEST_CASE(time_generic)
+{
+    static const int years[] = {2021, 2061};
+    time_t           first = 315619200 + 86400;        /* 1980-01-02 UTC */
+    time_t           last  = (time_t)4354819200LL;     /* 2108-01-01 UTC */
+    int              wrong = 0, checked = 0;
+
+    for (time_t t = first; t < last - 2 * 86400; t += 3 * 86400 + 3607, checked++) {
+        wrong += round_trip(t, 0, true) != expected(t);
+        wrong += !same_time(t, LHAPack::unix_to_win32_systemtime(t));
+    }
+    for (int y = 0; y < 2; y++) {
+        struct tm tm;
+
+        memset(&tm, 0, sizeof(tm));
+        tm.tm_year  = years[y] - 1900;
+        tm.tm_mday  = 1;
+        tm.tm_isdst = -1;
+        time_t start = mktime(&tm);
+        for (time_t t = start; t < start + 366 * 86400; t += 1800 + 1, checked++) {
+            wrong += round_trip(t, 0, true) != expected(t);
+            wrong += !same_time(t, LHAPack::unix_to_win32_systemtime(t));
+        }
+    }
+    LHA_CHECK(checked > 30000);
+    LHA_CHECK(wrong == 0);
+}
+
+/* the UNIX extension of level 0 and 1 headers, and level 2 headers, hold the unix time itself */
+LHA_TEST_CASE(time_unix)
+{
+    static const time_t stamps[] = {0, 1, 315532799, 1000000001, 2147483647, (time_t)4294967295LL};
+
+    for (size_t i = 0; i < sizeof(stamps) / sizeof(stamps[0]); i++) {
+        for (int level = 0; level <= 2; level++)
+            LHA_CHECK(round_trip(stamps[i], level) == stamps[i]);
+    }
+}
+
+/* before 1980 a DOS stamp says 1980-01-01 00:00; before 1601, a SYSTEMTIME 1601-01-01 */
+LHA_TEST_CASE(time_out_of_range)
+{
+    struct tm  tm;
+    SYSTEMTIME st;
+
+    memset(&tm, 0, sizeof(tm));
+    tm.tm_year  = 80;
+    tm.tm_mday  = 1;
+    tm.tm_isdst = -1;
+    LHA_CHECK(round_trip(100000, 0, true) == mktime(&tm));
+
+    st = LHAPack::unix_to_win32_systemtime((time_t)-20000000000LL);
+    LHA_CHECK(st.wYear == 1601 && st.wMonth == 1 && st.wDay == 1 && st.wDayOfWeek == 1);
+    LHA_CHECK(st.wHour == 0 && st.wMinute == 0 && st.wSecond == 0 && st.wMilliseconds == 0);
+}
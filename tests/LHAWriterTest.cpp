@@ -0,0 +1,218 @@
+// LHAWriterTest.cpp: archives written with LHAWriter, read back.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+
+#include "LHATest.h"
+#include "LHAWriter.h"
+#include "LHAArchive.h"
+#include "LHAEncode.h"
+
+/* bytes no compressor makes smaller */
+static void noise(std::vector<unsigned char> &out, size_t size, uint32_t seed)
+{
+    uint32_t x = seed | 1;
+
+    out.resize(size);
+    for (size_t i = 0; i < size; i++) {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        out[i] = (unsigned char)(x >> 24);
+    }
+}
+
+/* the member at it holds name, method and data */
+static void check_member(LHAArchive &archive, const LHAArchive::iterator &it, const char *name,
+                         int method, const std::vector<unsigned char> &data, time_t mtime)
+{
+    std::vector<char> buf(data.size() + 1);
+
+    LHA_CHECK(it != archive.end());
+    if (it == archive.end())
+        return;
+    LHA_CHECK(lha_test_name(it->header->name) == name);
+    LHA_CHECK(LHADecoder::method_number(it->header->method) == method);
+    LHA_CHECK(it->header->header_level == 2);
+    LHA_CHECK(it->header->original_size == data.size());
+    LHA_CHECK(mtime == 0 || it->header->unix_last_modified_stamp == mtime);
+    LHA_CHECK(archive.extract(*it, &buf[0]));
+    LHA_CHECK(data.empty() || memcmp(&buf[0], &data[0], data.size()) == 0);
+}
+
+/* every method and level, whole and streamed in odd pieces */
+LHA_TEST_CASE(writer_roundtrip)
+{
+    static const int           methods[] = {LZHUFF5_METHOD_NUM, LZHUFF6_METHOD_NUM, LZHUFF7_METHOD_NUM};
+    static const int           levels[]  = {LZH_LEVEL_MIN, LZH_LEVEL_DEFAULT, LZH_LEVEL_MAX};
+    std::string                path = lha_test_path("writer.lzh");
+    std::vector<unsigned char> text, empty;
+    time_t                     mtime = 1234567890;
+
+    lha_test_data(text, 300000, 14);
+    for (int m = 0; m < 3; m++) {
+        for (int l = 0; l < 3; l++) {
+            LHAWriter  w;
+            LHAArchive archive;
+
+            LHA_CHECK(w.set_method(methods[m]));
+            w.set_level(levels[l]);
+            LHA_CHECK(w.open(path.c_str()));
+            LHA_CHECK(w.add("whole.txt", &text[0], text.size(), mtime));
+            LHA_CHECK(w.add_directory("sub\\dir", mtime));
+            LHA_CHECK(w.begin_member("sub/dir/streamed.txt", mtime + 1));
+            for (size_t at = 0, n = 1; at < text.size(); at += n, n = n * 3 + 1)
+                LHA_CHECK(w.write(&text[at], at + n > text.size() ? text.size() - at : n));
+            LHA_CHECK(w.end_member());
+            LHA_CHECK(w.add("empty", NULL, 0, mtime));
+            LHA_CHECK(w.close());
+
+            LHA_CHECK(archive.open(path.c_str()));
+            LHAArchive::iterator it = archive.begin();
+            check_member(archive, it, "whole.txt", methods[m], text, mtime);
+            check_member(archive, ++it, "sub/dir", LZHDIRS_METHOD_NUM, empty, mtime);
+            check_member(archive, ++it, "sub/dir/streamed.txt", methods[m], text, mtime + 1);
+            check_member(archive, ++it, "empty", LZHUFF0_METHOD_NUM, empty, mtime);
+            LHA_CHECK(++it == archive.end());
+            LHA_CHECK(archive.test_all() == 0);
+            archive.close();
+        }
+    }
+    remove(path.c_str());
+}
+
+/*
+ * Data compression does not shrink is stored when it can be read again,
+ * and stays compressed, but correct, when it was streamed in.
+ */
+LHA_TEST_CASE(writer_incompressible)
+{
+    std::string                path = lha_test_path("writer_noise.lzh");
+    std::vector<unsigned char> data;
+    LHAWriter                  w;
+    LHAArchive                 archive;
+
+    noise(data, 100000, 15);
+    LHA_CHECK(w.open(path.c_str()));
+    LHA_CHECK(w.add("noise", &data[0], data.size(), 0));
+    LHA_CHECK(w.begin_member("noise.streamed", 0));
+    LHA_CHECK(w.write(&data[0], data.size()));
+    LHA_CHECK(w.end_member());
+    LHA_CHECK(w.close());
+
+    LHA_CHECK(archive.open(path.c_str()));
+    LHAArchive::iterator it = archive.begin();
+    check_member(archive, it, "noise", LZHUFF0_METHOD_NUM, data, 0);
+    LHA_CHECK(it->header->packed_size == data.size());
+    check_member(archive, ++it, "noise.streamed", LZHUFF5_METHOD_NUM, data, 0);
+    archive.close();
+    remove(path.c_str());
+}
+
+LHA_TEST_CASE(writer_add_file)
+{
+    std::string                path  = lha_test_path("writer_file.lzh");
+    std::string                input = lha_test_path("writer_input.txt");
+    std::vector<unsigned char> text;
+    LHAWriter                  w;
+    LHAArchive                 archive;
+
+    lha_test_data(text, 50000, 16);
+    LHA_CHECK(lha_test_write_file(input, std::vector<char>(text.begin(), text.end())));
+    LHA_CHECK(w.open(path.c_str()));
+    LHA_CHECK(w.add_file("docs/input.txt", input.c_str()));
+    LHA_CHECK(!w.add_file("missing", lha_test_path("no_such_file").c_str()));
+    LHA_CHECK(w.close());
+
+    LHA_CHECK(archive.open(path.c_str()));
+    LHAArchive::iterator it = archive.begin();
+    check_member(archive, it, "docs/input.txt", LZHUFF5_METHOD_NUM, text, 0);
+    LHA_CHECK(++it == archive.end());
+    archive.close();
+    remove(input.c_str());
+    remove(path.c_str());
+}
+
+LHA_TEST_CASE(writer_misuse)
+{
+    std::string path = lha_test_path("writer_misuse.lzh");
+    LHAWriter   w;
+    char        c = 'x';
+
+    LHA_CHECK(!w.set_method(LZHUFF1_METHOD_NUM));
+    LHA_CHECK(!w.set_method(-1));
+    LHA_CHECK(w.set_method(LZHUFF0_METHOD_NUM));
+    LHA_CHECK(!w.add("closed", &c, 1, 0));
+    LHA_CHECK(!w.write(&c, 1));
+    LHA_CHECK(w.open(path.c_str()));
+    LHA_CHECK(!w.write(&c, 1));             /* no member begun */
+    LHA_CHECK(!w.end_member());
+    LHA_CHECK(w.close());
+    LHA_CHECK(!w.is_open());
+    remove(path.c_str());
+}
+
+/*
+ * add_files() writes the same archive on any number of threads: members
+ * in the order given, a file that cannot be read left out and counted.
+ */
+LHA_TEST_CASE(writer_add_files)
+{
+    const size_t               count = 120;
+    static const int           threads[] = {1, 4, 0};
+    std::string                path = lha_test_path("writer_files.lzh");
+    std::vector<std::string>   names(count), inputs(count);
+    std::vector<const char *>  name_ptrs(count), input_ptrs(count);
+    std::vector<std::vector<unsigned char> > data(count);
+    std::vector<char>          first, archive_bytes;
+    size_t                     i;
+
+    for (i = 0; i < count; i++) {
+        char name[32];
+
+        snprintf(name, sizeof(name), "files/%03u.txt", (unsigned)i);
+        names[i]  = name;
+        snprintf(name, sizeof(name), "writer_in%03u", (unsigned)i);
+        inputs[i] = lha_test_path(name);
+        if (i % 9 == 4)
+            noise(data[i], 5000, (uint32_t)i);
+        else
+            lha_test_data(data[i], i % 13 == 0 ? 0 : i * 997 % 60000, (uint32_t)i);
+        if (i % 17 != 16)       /* the rest do not exist */
+            LHA_CHECK(lha_test_write_file(inputs[i], std::vector<char>(data[i].begin(), data[i].end())));
+        name_ptrs[i]  = names[i].c_str();
+        input_ptrs[i] = inputs[i].c_str();
+    }
+
+    for (int t = 0; t < 3; t++) {
+        LHAWriter  w;
+        LHAArchive archive;
+
+        LHA_CHECK(w.add_files(&name_ptrs[0], &input_ptrs[0], count, threads[t]) == (int)count);
+        LHA_CHECK(w.open(path.c_str()));
+        LHA_CHECK(w.add_files(&name_ptrs[0], &input_ptrs[0], 0, threads[t]) == 0);
+        LHA_CHECK(w.add_files(&name_ptrs[0], &input_ptrs[0], count, threads[t]) == (int)(count / 17));
+        LHA_CHECK(w.close());
+
+        LHA_CHECK(lha_test_read_file(path, archive_bytes));
+        if (t == 0)
+            first = archive_bytes;
+        LHA_CHECK(archive_bytes == first);
+
+        LHA_CHECK(archive.open(path.c_str()));
+        LHAArchive::iterator it = archive.begin();
+        for (i = 0; i < count; i++) {
+            if (i % 17 == 16)
+                continue;
+            check_member(archive, it, names[i].c_str(),
+                         i % 9 == 4 || data[i].empty() ? LZHUFF0_METHOD_NUM : LZHUFF5_METHOD_NUM, data[i], 0);
+            ++it;
+        }
+        LHA_CHECK(it == archive.end());
+        archive.close();
+    }
+
+    for (i = 0; i < count; i++)
+        remove(inputs[i].c_str());
+    remove(path.c_str());
+}